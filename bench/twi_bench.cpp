@@ -0,0 +1,320 @@
+// twi-scanner-bench: throughput / latency benchmarks for FTDevice operations.
+// Works with both the LibFT4222 backend and the mock backend; output is JSON or CSV.
+
+#include "ft4222/ft4222.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef TWI_SCANNER_VERSION
+#define TWI_SCANNER_VERSION "0.1"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string serial;
+    uint32_t index = 0;
+    unsigned iterations = 200;
+    std::string format = "json";
+    std::string outPath;
+    uint8_t i2cAddress = 0x50;
+    std::vector<size_t> spiSizes = {1, 64, 512, 4096};
+    std::vector<unsigned> spiDividers = {4, 16, 64};
+    std::vector<std::string> groups = {"i2c", "spi", "gpio"};
+};
+
+struct Result {
+    std::string name;
+    std::string params;   ///< Параметры случая в виде "key=value;..."
+    size_t bytesPerOp = 0;
+    unsigned iterations = 0;
+    unsigned errors = 0;
+    double totalS = 0;    ///< Общее время всех успешных итераций, с
+    double meanUs = 0, p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0;
+    std::string lastError;
+};
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    const size_t idx = std::min(sorted.size() - 1,
+                                static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[idx];
+}
+
+// Выполнить op iterations раз, собрать латентность каждой итерации
+Result measure(const std::string &name, const std::string &params, size_t bytesPerOp,
+               unsigned iterations, const std::function<void()> &op) {
+    Result r;
+    r.name = name;
+    r.params = params;
+    r.bytesPerOp = bytesPerOp;
+    r.iterations = iterations;
+
+    std::vector<double> lat;
+    lat.reserve(iterations);
+    for (unsigned i = 0; i < iterations; ++i) {
+        const auto t0 = Clock::now();
+        try {
+            op();
+        } catch (const std::exception &ex) {
+            ++r.errors;
+            r.lastError = ex.what();
+            continue;
+        }
+        lat.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+
+    if (!lat.empty()) {
+        double sum = 0;
+        for (double v : lat) sum += v;
+        r.totalS = sum / 1e6;
+        r.meanUs = sum / static_cast<double>(lat.size());
+        std::sort(lat.begin(), lat.end());
+        r.p50Us = percentile(lat, 50);
+        r.p90Us = percentile(lat, 90);
+        r.p99Us = percentile(lat, 99);
+        r.maxUs = lat.back();
+    }
+    return r;
+}
+
+double opsPerSecond(const Result &r) {
+    const unsigned ok = r.iterations - r.errors;
+    return r.totalS > 0 ? ok / r.totalS : 0;
+}
+
+double megabytesPerSecond(const Result &r) {
+    const unsigned ok = r.iterations - r.errors;
+    return r.totalS > 0 ? static_cast<double>(r.bytesPerOp) * ok / r.totalS / 1e6 : 0;
+}
+
+FTDevice::SPIClockDivider toDivider(unsigned div) {
+    switch (div) {
+        case 2: return FTDevice::SPIClockDivider::DIV_2;
+        case 4: return FTDevice::SPIClockDivider::DIV_4;
+        case 8: return FTDevice::SPIClockDivider::DIV_8;
+        case 16: return FTDevice::SPIClockDivider::DIV_16;
+        case 32: return FTDevice::SPIClockDivider::DIV_32;
+        case 64: return FTDevice::SPIClockDivider::DIV_64;
+        case 128: return FTDevice::SPIClockDivider::DIV_128;
+        case 256: return FTDevice::SPIClockDivider::DIV_256;
+        case 512: return FTDevice::SPIClockDivider::DIV_512;
+        default: throw std::invalid_argument("unsupported SPI clock divider " + std::to_string(div));
+    }
+}
+
+bool enabled(const Options &opt, const std::string &group) {
+    return std::find(opt.groups.begin(), opt.groups.end(), group) != opt.groups.end();
+}
+
+void benchI2C(FTDevice &dev, const Options &opt, std::vector<Result> &out) {
+    static const FTDevice::I2CSpeed speeds[] = {FTDevice::I2CSpeed::S100K,
+                                                FTDevice::I2CSpeed::S400K,
+                                                FTDevice::I2CSpeed::S1M};
+    const uint8_t reg[1] = {0x00};
+    std::vector<uint8_t> buf(32);
+
+    for (auto speed : speeds) {
+        dev.initI2CMaster(speed);
+        const std::string sp = "kbps=" + std::to_string(static_cast<int>(speed));
+
+        for (size_t len : {size_t{1}, size_t{16}}) {
+            const std::string params = sp + ";len=" + std::to_string(len);
+            ByteSpan data(buf.data(), len);
+            out.push_back(measure("i2c_write", params, len, opt.iterations, [&] {
+                dev.i2cMasterWrite(opt.i2cAddress, ConstByteSpan(data), START_AND_STOP);
+            }));
+            out.push_back(measure("i2c_read", params, len, opt.iterations, [&] {
+                dev.i2cMasterRead(opt.i2cAddress, data, START_AND_STOP);
+            }));
+            out.push_back(measure("i2c_register_read", params, len, opt.iterations, [&] {
+                dev.i2cReadRegister(opt.i2cAddress, reg, data);
+            }));
+        }
+
+        const unsigned scanIterations = std::max(1u, opt.iterations / 20);
+        out.push_back(measure("i2c_scan", sp + ";probe=read", 0, scanIterations, [&] {
+            I2CScanOptions o;
+            o.fastClock = false;
+            dev.scanI2CBusFast(0x03, 0x77, o);
+        }));
+        out.push_back(measure("i2c_scan_legacy", sp, 0, scanIterations, [&] {
+            dev.scanI2CBus(0x03, 0x77);
+        }));
+    }
+}
+
+void benchSPI(FTDevice &dev, const Options &opt, std::vector<Result> &out) {
+    const size_t maxSize = *std::max_element(opt.spiSizes.begin(), opt.spiSizes.end());
+    std::vector<uint8_t> tx(maxSize, 0xA5), rx(maxSize);
+
+    for (unsigned div : opt.spiDividers) {
+        dev.initSPIMaster(SPI_IO_SINGLE, toDivider(div));
+        for (size_t size : opt.spiSizes) {
+            const std::string params = "div=" + std::to_string(div) + ";len=" + std::to_string(size);
+            ConstByteSpan txs(tx.data(), size);
+            ByteSpan rxs(rx.data(), size);
+            out.push_back(measure("spi_write", params, size, opt.iterations,
+                                  [&] { dev.spiMasterSingleWrite(txs); }));
+            out.push_back(measure("spi_read", params, size, opt.iterations,
+                                  [&] { dev.spiMasterSingleRead(rxs); }));
+            out.push_back(measure("spi_xfer", params, size, opt.iterations,
+                                  [&] { dev.spiMasterSingleReadWrite(rxs, txs); }));
+        }
+    }
+}
+
+void benchGPIO(FTDevice &dev, const Options &opt, std::vector<Result> &out) {
+    dev.initGPIO(GPIO_OUTPUT, GPIO_INPUT, GPIO_INPUT, GPIO_INPUT);
+    bool level = false;
+    out.push_back(measure("gpio_toggle", "port=0", 0, opt.iterations, [&] {
+        level = !level;
+        dev.writeGPIO(GPIO_PORT0, level);
+    }));
+    out.push_back(measure("gpio_read", "port=1", 0, opt.iterations,
+                          [&] { dev.readGPIO(GPIO_PORT1); }));
+}
+
+std::string jsonEscape(const std::string &s) {
+    std::string r;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { r += '\\'; r += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) r += ' ';
+        else r += c;
+    }
+    return r;
+}
+
+void writeJson(std::ostream &os, const Options &opt, const std::vector<Result> &results) {
+#ifdef TWI_MOCK_FT4222
+    const char *backend = "mock";
+#else
+    const char *backend = "ft4222";
+#endif
+    os << "{\n  \"tool\": \"twi-scanner-bench\",\n  \"version\": \"" << TWI_SCANNER_VERSION
+       << "\",\n  \"backend\": \"" << backend << "\",\n  \"device\": \""
+       << jsonEscape(opt.serial.empty() ? "#" + std::to_string(opt.index) : opt.serial)
+       << "\",\n  \"iterations\": " << opt.iterations << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"params\": \"" << r.params
+           << "\", \"bytes\": " << r.bytesPerOp << ", \"iterations\": " << r.iterations
+           << ", \"errors\": " << r.errors << ", \"ops_per_s\": " << opsPerSecond(r)
+           << ", \"mb_per_s\": " << megabytesPerSecond(r) << ", \"lat_us\": {\"mean\": " << r.meanUs
+           << ", \"p50\": " << r.p50Us << ", \"p90\": " << r.p90Us << ", \"p99\": " << r.p99Us
+           << ", \"max\": " << r.maxUs << "}";
+        if (!r.lastError.empty()) os << ", \"last_error\": \"" << jsonEscape(r.lastError) << "\"";
+        os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+void writeCsv(std::ostream &os, const std::vector<Result> &results) {
+    os << "name,params,bytes,iterations,errors,ops_per_s,mb_per_s,mean_us,p50_us,p90_us,p99_us,max_us\n";
+    for (const Result &r : results) {
+        os << r.name << "," << r.params << "," << r.bytesPerOp << "," << r.iterations << ","
+           << r.errors << "," << opsPerSecond(r) << "," << megabytesPerSecond(r) << "," << r.meanUs
+           << "," << r.p50Us << "," << r.p90Us << "," << r.p99Us << "," << r.maxUs << "\n";
+    }
+}
+
+template <typename T>
+std::vector<T> parseList(const std::string &s) {
+    std::vector<T> out;
+    std::istringstream iss(s);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (!item.empty()) out.push_back(static_cast<T>(std::stoul(item, nullptr, 0)));
+    }
+    return out;
+}
+
+void printUsage(const char *prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --device <index>       Open device by index (default 0)\n"
+              << "  --serial <sn>          Open device by serial number\n"
+              << "  --iterations <n>       Iterations per case (default 200)\n"
+              << "  --format json|csv      Output format (default json)\n"
+              << "  --out <file>           Write results to file instead of stdout\n"
+              << "  --i2c-addr <addr>      I2C target address (default 0x50)\n"
+              << "  --spi-sizes <list>     SPI transfer sizes, e.g. 1,64,512,4096\n"
+              << "  --spi-div <list>       SPI clock dividers, e.g. 4,16,64\n"
+              << "  --only <list>          Groups to run: i2c,spi,gpio (default all)\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--help" || arg == "-h") { printUsage(argv[0]); return 0; }
+            else if (arg == "--device") opt.index = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--serial") opt.serial = value();
+            else if (arg == "--iterations") opt.iterations = static_cast<unsigned>(std::stoul(value()));
+            else if (arg == "--format") opt.format = value();
+            else if (arg == "--out") opt.outPath = value();
+            else if (arg == "--i2c-addr") opt.i2cAddress = static_cast<uint8_t>(std::stoul(value(), nullptr, 0));
+            else if (arg == "--spi-sizes") opt.spiSizes = parseList<size_t>(value());
+            else if (arg == "--spi-div") opt.spiDividers = parseList<unsigned>(value());
+            else if (arg == "--only") {
+                opt.groups.clear();
+                std::istringstream iss(value());
+                std::string g;
+                while (std::getline(iss, g, ',')) opt.groups.push_back(g);
+            }
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opt.format != "json" && opt.format != "csv")
+            throw std::invalid_argument("format must be json or csv");
+        if (opt.iterations == 0 || opt.spiSizes.empty() || opt.spiDividers.empty())
+            throw std::invalid_argument("iterations, sizes and dividers must be non-empty");
+    } catch (const std::exception &ex) {
+        std::cerr << "twi-scanner-bench: " << ex.what() << "\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Result> results;
+    try {
+        FTDevice dev;
+        if (opt.serial.empty()) dev.open(opt.index);
+        else dev.openBySerial(opt.serial);
+
+        if (enabled(opt, "i2c")) benchI2C(dev, opt, results);
+        if (enabled(opt, "spi")) benchSPI(dev, opt, results);
+        if (enabled(opt, "gpio")) benchGPIO(dev, opt, results);
+    } catch (const std::exception &ex) {
+        std::cerr << "twi-scanner-bench: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!opt.outPath.empty()) {
+        file.open(opt.outPath);
+        if (!file) {
+            std::cerr << "twi-scanner-bench: cannot open " << opt.outPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream &os = opt.outPath.empty() ? std::cout : file;
+    if (opt.format == "csv") writeCsv(os, results);
+    else writeJson(os, opt, results);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "ByteFormat.hpp"
+
+#include <array>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kDumpWidth = 16;
+// "00000000" + 2 + 16 * 3 + 1 + " |" + 16 + "|\n"
+constexpr size_t kDumpLine = 8 + 2 + kDumpWidth * 3 + 1 + 2 + kDumpWidth + 2;
+
+constexpr std::array<char, 512> makeHexTable() {
+    constexpr char digits[] = "0123456789ABCDEF";
+    std::array<char, 512> table{};
+    for (size_t i = 0; i < 256; ++i) {
+        table[2 * i] = digits[i >> 4];
+        table[2 * i + 1] = digits[i & 0xF];
+    }
+    return table;
+}
+
+constexpr std::array<char, 512> kHex = makeHexTable();
+
+char *putHex(char *p, uint8_t b) {
+    p[0] = kHex[2 * b];
+    p[1] = kHex[2 * b + 1];
+    return p + 2;
+}
+
+void appendHeader(std::string &out, std::string_view label, size_t count, const char *tail) {
+    out.append(label);
+    out += ' ';
+    out += std::to_string(count);
+    out += " bytes:";
+    out += tail;
+}
+
+} // namespace
+
+bool parseOutputMode(std::string_view name, OutputMode &mode) {
+    if (name == "hex") mode = OutputMode::Hex;
+    else if (name == "raw") mode = OutputMode::Raw;
+    else if (name == "json") mode = OutputMode::Json;
+    else if (name == "hexdump") mode = OutputMode::Hexdump;
+    else return false;
+    return true;
+}
+
+const char *outputModeName(OutputMode mode) {
+    switch (mode) {
+    case OutputMode::Raw: return "raw";
+    case OutputMode::Json: return "json";
+    case OutputMode::Hexdump: return "hexdump";
+    default: return "hex";
+    }
+}
+
+void appendHex(std::string &out, ConstByteSpan data, bool spaced) {
+    const size_t step = spaced ? 3 : 2;
+    const size_t old = out.size();
+    out.resize(old + data.size() * step);
+    char *p = out.data() + old;
+    for (auto b : data) {
+        p = putHex(p, b);
+        if (spaced) *p++ = ' ';
+    }
+}
+
+void appendHexdump(std::string &out, ConstByteSpan data, uint64_t baseOffset) {
+    const size_t lines = (data.size() + kDumpWidth - 1) / kDumpWidth;
+    const size_t old = out.size();
+    out.resize(old + lines * kDumpLine);
+    char *p = out.data() + old;
+    for (size_t at = 0; at < data.size(); at += kDumpWidth) {
+        const auto row = data.subspan(at, kDumpWidth);
+        const uint64_t offset = baseOffset + at;
+        for (int shift = 24; shift >= 0; shift -= 8)
+            p = putHex(p, static_cast<uint8_t>(offset >> shift));
+        *p++ = ' ';
+        for (size_t i = 0; i < kDumpWidth; ++i) {
+            if (i == kDumpWidth / 2) *p++ = ' ';
+            *p++ = ' ';
+            if (i < row.size()) {
+                p = putHex(p, row[i]);
+            } else {
+                *p++ = ' ';
+                *p++ = ' ';
+            }
+        }
+        *p++ = ' ';
+        *p++ = ' ';
+        *p++ = '|';
+        for (auto b : row) *p++ = (b >= 0x20 && b < 0x7F) ? static_cast<char>(b) : '.';
+        *p++ = '|';
+        *p++ = '\n';
+    }
+    // Неполная последняя строка короче: ASCII-часть не дополняется
+    out.resize(static_cast<size_t>(p - out.data()));
+}
+
+void formatBytes(std::string &out, OutputMode mode, std::string_view command,
+                 std::string_view label, ConstByteSpan data) {
+    switch (mode) {
+    case OutputMode::Raw:
+        out.append(reinterpret_cast<const char *>(data.data()), data.size());
+        return;
+    case OutputMode::Json:
+        out.reserve(out.size() + command.size() + 2 * data.size() + 48);
+        out += "{\"command\":\"";
+        out.append(command);
+        out += "\",\"bytes\":";
+        out += std::to_string(data.size());
+        out += ",\"data\":\"";
+        appendHex(out, data, false);
+        out += "\"}\n";
+        return;
+    case OutputMode::Hexdump:
+        out.reserve(out.size() + label.size() + 32 +
+                    (data.size() + kDumpWidth - 1) / kDumpWidth * kDumpLine);
+        appendHeader(out, label, data.size(), "\n");
+        appendHexdump(out, data);
+        return;
+    default:
+        out.reserve(out.size() + label.size() + 32 + 3 * data.size());
+        appendHeader(out, label, data.size(), " ");
+        appendHex(out, data);
+        out += '\n';
+        return;
+    }
+}
+
+void printBytes(AppContext &ctx, std::string_view command, std::string_view label,
+                ConstByteSpan data) {
+    std::string text;
+    formatBytes(text, ctx.outputMode, command, label, data);
+    // В raw данные идут в stdout, даже если сообщения команд перенаправлены в stderr
+    const bool toStdout = ctx.output == &std::cout ||
+                          (ctx.outputMode == OutputMode::Raw && ctx.output == &std::cerr);
+    if (toStdout) {
+        std::cout.flush();
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        std::fflush(stdout);
+    } else {
+        ctx.out().write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "context/AppContext.hpp"
+#include "ft4222/ft4222_span.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Имя режима вывода: "hex", "raw", "json", "hexdump". false при неизвестном имени.
+bool parseOutputMode(std::string_view name, OutputMode &mode);
+const char *outputModeName(OutputMode mode);
+
+// Дописать в out байты в hex (верхний регистр): "AA BB CC " или, без разделителя, "AABBCC".
+// Пары цифр берутся из таблицы на 256 значений, без iostream.
+void appendHex(std::string &out, ConstByteSpan data, bool spaced = true);
+
+// Дописать в out дамп по 16 байт в строке: "00000010  AA BB ... 00  |..ascii..|\n".
+// baseOffset — смещение первого байта в подписи строк.
+void appendHexdump(std::string &out, ConstByteSpan data, uint64_t baseOffset = 0);
+
+// Результат команды целиком в out (память выделяется один раз под итоговый размер):
+//   Hex     — "<label> N bytes: AA BB \n";
+//   Raw     — только данные;
+//   Json    — {"command":"<command>","bytes":N,"data":"AABB"}\n;
+//   Hexdump — "<label> N bytes:\n" и дамп.
+void formatBytes(std::string &out, OutputMode mode, std::string_view command,
+                 std::string_view label, ConstByteSpan data);
+
+// Вывести результат команды в ctx.out() одной записью: в stdout — одним fwrite (после
+// сброса std::cout), в другой поток (буфер сессии --serve) — одним ostream::write.
+// В режиме Raw при выводе сообщений в std::cerr данные всё равно пишутся в stdout.
+void printBytes(AppContext &ctx, std::string_view command, std::string_view label,
+                ConstByteSpan data);
@@ -1,8 +1,12 @@
 #include "Cli.hpp"
+#include "ByteFormat.hpp"
 #include "Commands.hpp"
+#include "Script.hpp"
+#include "Server.hpp"
 
 #include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -21,6 +25,8 @@ int Cli::run(int argc, char *argv[]) {
     registerCommands();
 
     std::vector<std::string> batchCommands;
+    std::string scriptPath;
+    std::string servePath;
     bool interactive = true;
 
     for (int i = 1; i < argc; ++i) {
@@ -43,14 +49,59 @@ int Cli::run(int argc, char *argv[]) {
             interactive = false;
             continue;
         }
+        if (arg == "-f" || arg == "--file") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing argument for " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            scriptPath = argv[++i];
+            interactive = false;
+            continue;
+        }
+        if (arg == "--output" || arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing argument for " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            if (!parseOutputMode(argv[++i], m_ctx.outputMode)) {
+                std::cerr << "Unknown output mode: " << argv[i] << " (hex, raw, json, hexdump)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--serve") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing argument for " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            servePath = argv[++i];
+            interactive = false;
+            continue;
+        }
         std::cerr << "Unknown option: " << arg << "\n";
         printUsage(argv[0]);
         return 1;
     }
 
-    if (!batchCommands.empty()) {
-        return runBatch(batchCommands) ? 0 : 1;
-    }
+    // В raw stdout занят только данными: сообщения команд уходят в stderr
+    if (m_ctx.outputMode == OutputMode::Raw && !interactive)
+        m_ctx.output = &std::cerr;
+
+    // -c выполняются до скрипта (например, "connect 0" перед общим сценарием)
+    if (!batchCommands.empty() && !runBatch(batchCommands))
+        return 1;
+    if (!scriptPath.empty() && m_running && !runScript(scriptPath))
+        return 1;
+    // --serve после -c/-f: можно заранее подключиться и настроить устройство
+    if (!servePath.empty())
+        return runServer(servePath);
+    if (!scriptPath.empty())
+        return 0;
+    if (!batchCommands.empty())
+        return 0;
 
     runInteractive();
     return 0;
@@ -66,6 +117,29 @@ bool Cli::runBatch(const std::vector<std::string> &commands) {
     return true;
 }
 
+bool Cli::runScript(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open script: " << path << "\n";
+        return false;
+    }
+
+    ScriptPlan plan;
+    try {
+        plan = ScriptPlan::compile(m_router, file, path);
+    } catch (const ScriptError &ex) {
+        std::cerr << ex.what() << "\n";
+        return false;
+    }
+    plan.run(m_ctx, [this] { return m_running; });
+    return true;
+}
+
+int Cli::runServer(const std::string &socketPath) {
+    SessionServer server(m_router, m_ctx);
+    return server.run(socketPath);
+}
+
 void Cli::runInteractive() {
     std::cout << "FT4222 CLI. Type 'help'\n";
 #ifdef TWI_MOCK_FT4222
@@ -115,38 +189,38 @@ void Cli::registerCommands() {
 
     m_router.registerCommand(
         "clear",
-        [](AppContext &, std::istringstream &) {
-            std::cout << "\033[2J\033[H" << std::flush;
+        [](AppContext &ctx, std::istringstream &) {
+            ctx.out() << "\033[2J\033[H" << std::flush;
         },
         "Clear the screen");
 
     m_router.registerCommand(
         "help",
-        [this](AppContext &, std::istringstream &iss) {
+        [this](AppContext &ctx, std::istringstream &iss) {
             std::string topic;
             iss >> topic;
             if (!topic.empty()) {
                 const std::string *desc = m_router.findDescription(topic);
                 if (!desc) {
-                    std::cout << "Unknown command: " << topic << "\n";
+                    ctx.out() << "Unknown command: " << topic << "\n";
                     return;
                 }
-                std::cout << topic;
+                ctx.out() << topic;
                 if (!desc->empty())
-                    std::cout << " - " << *desc;
-                std::cout << "\n";
+                    ctx.out() << " - " << *desc;
+                ctx.out() << "\n";
                 return;
             }
 
             auto cmds = m_router.listCommands();
-            std::cout << "Available commands:\n";
+            ctx.out() << "Available commands:\n";
             std::sort(cmds.begin(), cmds.end(),
                       [](const auto &a, const auto &b) { return a.first < b.first; });
             for (const auto &c : cmds) {
-                std::cout << "  " << c.first;
+                ctx.out() << "  " << c.first;
                 if (!c.second.empty())
-                    std::cout << " - " << c.second;
-                std::cout << "\n";
+                    ctx.out() << " - " << c.second;
+                ctx.out() << "\n";
             }
         },
         "Show help (usage: help [command])");
@@ -175,7 +249,12 @@ void Cli::printUsage(const char *prog) {
               << "  -h, --help           Show this help\n"
               << "  -V, --version        Show version\n"
               << "  -c, --command <cmd>  Run command and exit (repeatable)\n"
+              << "  -f, --file <script>  Compile and run a script (repeat N { ... } blocks)\n"
+              << "  --serve <socket>     Keep the session open and run commands from a Unix socket\n"
+              << "  -o, --output <mode>  Read data format: hex (default), raw, json, hexdump\n"
               << "\nExamples:\n"
               << "  " << prog << " -c devices\n"
-              << "  " << prog << " -c \"connect 0\" -c \"i2c_init\" -c \"i2c_scan\"\n";
+              << "  " << prog << " -c \"connect 0\" -c \"i2c_init\" -c \"i2c_scan\"\n"
+              << "  " << prog << " -f production.twi\n"
+              << "  " << prog << " -o raw -c \"connect 0\" -c \"spi_init\" -c \"spi_recv 4096\" > dump.bin\n";
 }
@@ -17,6 +17,8 @@ private:
     void registerCommands();
     std::string prompt() const;
     bool runBatch(const std::vector<std::string> &commands);
+    bool runScript(const std::string &path);
+    int runServer(const std::string &socketPath);
     void runInteractive();
     static void printUsage(const char *prog);
 };
@@ -1,9 +1,17 @@
 #include "CommandRouter.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
 void CommandRouter::registerCommand(const std::string &name, CommandFn fn, const std::string &desc) {
-    m_commands[name] = CommandEntry{std::move(fn), desc};
+    m_commands[name] = CommandEntry{std::move(fn), desc, nullptr};
+}
+
+void CommandRouter::registerCompiler(const std::string &name, CompileFn compile) {
+    const auto it = m_commands.find(name);
+    if (it == m_commands.end())
+        throw std::logic_error("registerCompiler: command '" + name + "' is not registered");
+    it->second.compile = std::move(compile);
 }
 
 bool CommandRouter::execute(AppContext &ctx, const std::string &line) {
@@ -16,7 +24,7 @@ bool CommandRouter::execute(AppContext &ctx, const std::string &line) {
 
     const auto it = m_commands.find(cmd);
     if (it == m_commands.end()) {
-        std::cout << "Unknown command: " << cmd << "\n";
+        ctx.out() << "Unknown command: " << cmd << "\n";
         return false;
     }
 
@@ -24,6 +32,30 @@ bool CommandRouter::execute(AppContext &ctx, const std::string &line) {
     return true;
 }
 
+PreparedCommand CommandRouter::compile(const std::string &line) const {
+    std::istringstream iss(line);
+    std::string cmd;
+    iss >> cmd;
+
+    if (cmd.empty())
+        return nullptr;
+
+    const auto it = m_commands.find(cmd);
+    if (it == m_commands.end())
+        throw std::invalid_argument("Unknown command: " + cmd);
+
+    if (it->second.compile)
+        return it->second.compile(iss);
+
+    // Без компилятора: сохраняем текст аргументов и функцию команды
+    std::string args;
+    std::getline(iss, args);
+    return [fn = it->second.fn, args = std::move(args)](AppContext &ctx) {
+        std::istringstream argStream(args);
+        fn(ctx, argStream);
+    };
+}
+
 std::vector<std::pair<std::string, std::string>> CommandRouter::listCommands() const {
     std::vector<std::pair<std::string, std::string>> res;
     res.reserve(m_commands.size());
@@ -10,10 +10,23 @@
 
 using CommandFn = std::function<void(AppContext &, std::istringstream &)>;
 
+// Команда с уже разобранными аргументами (шаг скомпилированного скрипта)
+using PreparedCommand = std::function<void(AppContext &)>;
+
+// Разбор аргументов команды один раз; при ошибке бросает std::invalid_argument
+using CompileFn = std::function<PreparedCommand(std::istringstream &)>;
+
 class CommandRouter {
 public:
     void registerCommand(const std::string &name, CommandFn fn, const std::string &desc = "");
+    // Необязательный компилятор для уже зарегистрированной команды: аргументы
+    // разбираются при компиляции, а не при каждом выполнении
+    void registerCompiler(const std::string &name, CompileFn compile);
     bool execute(AppContext &ctx, const std::string &line);
+    // Подготовить строку к многократному выполнению. Без компилятора команда
+    // получает сохранённый текст аргументов. Пустая строка даёт пустой PreparedCommand.
+    // Бросает std::invalid_argument для неизвестной команды или неверных аргументов.
+    PreparedCommand compile(const std::string &line) const;
     std::vector<std::pair<std::string, std::string>> listCommands() const;
     const std::string *findDescription(const std::string &name) const;
 
@@ -21,6 +34,7 @@ private:
     struct CommandEntry {
         CommandFn fn;
         std::string desc;
+        CompileFn compile;
     };
 
     std::unordered_map<std::string, CommandEntry> m_commands;
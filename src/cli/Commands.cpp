@@ -1,74 +1,629 @@
 #include "Commands.hpp"
+#include "cli/ByteFormat.hpp"
 #include "cli/ParseUtil.hpp"
+#include "engine/ChipSession.hpp"
+#include "engine/Crc32.hpp"
+#include "engine/DeviceCache.hpp"
+#include "engine/FlashPipeline.hpp"
+#include "engine/GpioWave.hpp"
+#include "engine/I2CEeprom.hpp"
+#include "engine/I2CPoll.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/MultiDevice.hpp"
+#include "engine/SpiStream.hpp"
+#include "engine/TraceReplay.hpp"
 #include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_clock.hpp"
+#include "ft4222/ft4222_stats.hpp"
+#include "ft4222/ft4222_trace.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
+#include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+
 using namespace std;
 
 static bool requireConnection(const AppContext &ctx) {
     if (!ctx.isConnected()) {
-        cout << "Not connected. Use 'connect <index>' or 'connect --serial <sn>' first.\n";
+        ctx.out() << "Not connected. Use 'connect <index>' or 'connect --serial <sn>' first.\n";
         return false;
     }
     return true;
 }
 
+static string formatMs(uint64_t us) {
+    ostringstream oss;
+    oss << fixed << setprecision(3) << us / 1000.0;
+    return oss.str();
+}
+
+// Размер в байтах с необязательным суффиксом K/M (десятичное число: "4096", "64K", "16M")
+static uint64_t parseByteCount(const string &text) {
+    size_t pos = 0;
+    const uint64_t value = stoull(text, &pos, 10);
+    const string suffix = text.substr(pos);
+    if (suffix.empty()) return value;
+    if (suffix == "K" || suffix == "k") return value * 1024;
+    if (suffix == "M" || suffix == "m") return value * 1024 * 1024;
+    throw invalid_argument("bad size '" + text + "'");
+}
+
+// Частота в Гц с необязательным суффиксом k/M ("400k", "2.5M", "20000000")
+static uint32_t parseFrequencyHz(const string &text) {
+    size_t pos = 0;
+    const double value = stod(text, &pos);
+    const string suffix = text.substr(pos);
+    double hz = value;
+    if (suffix == "k" || suffix == "K") hz *= 1e3;
+    else if (suffix == "M" || suffix == "m") hz *= 1e6;
+    else if (!suffix.empty()) throw invalid_argument("bad frequency '" + text + "'");
+    if (!(hz >= 1 && hz <= 4e9)) throw invalid_argument("bad frequency '" + text + "'");
+    return static_cast<uint32_t>(hz);
+}
+
+// Длительность "<n>ms" или "<n>s" в миллисекундах; 0, если это не длительность
+static uint64_t parseDurationMs(const string &text) {
+    if (text.size() > 2 && text.compare(text.size() - 2, 2, "ms") == 0)
+        return stoull(text.substr(0, text.size() - 2), nullptr, 10);
+    if (text.size() > 1 && text.back() == 's')
+        return stoull(text.substr(0, text.size() - 1), nullptr, 10) * 1000;
+    return 0;
+}
+
+// Разбор одной операции i2c_batch: "w[:flag] <addr> <bytes...>", "r[:flag] <addr> <len>",
+// "wr[:flag] <addr> <len> <bytes...>", "rr <addr> <len> <reg...>" (повторный START).
+// Бросает std::invalid_argument при ошибке.
+static void parseBatchOp(const string &text, I2CBatch &batch) {
+    istringstream iss(text);
+    string kind, addrStr;
+    if (!(iss >> kind >> addrStr)) throw invalid_argument("expected <kind> <addr> ...");
+
+    uint8_t flag = 0x06;
+    const auto colon = kind.find(':');
+    if (colon != string::npos) {
+        flag = static_cast<uint8_t>(parseNumber(kind.substr(colon + 1)));
+        kind.resize(colon);
+    }
+    const auto addr = static_cast<uint8_t>(parseNumber(addrStr));
+
+    unsigned long readLen = 0;
+    if (kind == "r" || kind == "wr" || kind == "rr") {
+        string lenStr;
+        if (!(iss >> lenStr)) throw invalid_argument("missing read length");
+        readLen = parseNumber(lenStr);
+        if (readLen == 0 || readLen > 0xFFFF) throw invalid_argument("read length must be 1..65535");
+    } else if (kind != "w") {
+        throw invalid_argument("unknown op kind '" + kind + "'");
+    }
+
+    vector<uint8_t> bytes;
+    string rest, error;
+    getline(iss, rest);
+    if (!parseByteList(rest, bytes, &error)) throw invalid_argument(error);
+
+    if (kind == "r") {
+        if (!bytes.empty()) throw invalid_argument("read op takes no data bytes");
+        batch.read(addr, static_cast<uint16_t>(readLen), flag);
+    } else if (kind == "w") {
+        if (bytes.empty()) throw invalid_argument("write op needs data bytes");
+        batch.write(addr, bytes, flag);
+    } else if (kind == "rr") {
+        if (bytes.empty()) throw invalid_argument("rr op needs register bytes");
+        batch.readRegister(addr, bytes, static_cast<uint16_t>(readLen));
+    } else {
+        if (bytes.empty()) throw invalid_argument("wr op needs data bytes");
+        batch.writeRead(addr, bytes, static_cast<uint16_t>(readLen), flag);
+    }
+}
+
+// Остаток строки как байтовая нагрузка (числа, hex-блобы, aa:bb, @file);
+// сообщение исключения — готовый текст для пользователя
+static void parseDataBytes(istringstream &iss, vector<uint8_t> &out) {
+    string rest, error;
+    getline(iss, rest);
+    if (!parseByteList(rest, out, &error)) throw invalid_argument(error);
+}
+
+// Команда с раздельными фазами разбора и выполнения. При вводе строки аргументы
+// разбираются при каждом вызове; в скрипте (-f) — один раз при компиляции плана.
+// parse бросает std::invalid_argument с текстом для пользователя.
+template <typename Args>
+static void registerParsedCommand(CommandRouter &router, const string &name,
+                                  Args (*parse)(istringstream &),
+                                  void (*run)(AppContext &, const Args &), const string &desc) {
+    router.registerCommand(name,
+        [parse, run](AppContext &ctx, istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            Args args;
+            try { args = parse(iss); } catch (const invalid_argument &ex) { ctx.out() << ex.what() << "\n"; return; }
+            run(ctx, args);
+        },
+        desc);
+    router.registerCompiler(name, [parse, run](istringstream &iss) -> PreparedCommand {
+        return [args = parse(iss), run](AppContext &ctx) { run(ctx, args); };
+    });
+}
+
+// Нагрузка bulk-команды: байты токенов и, если последний токен — @file, путь к файлу.
+// Файл отображается только при выполнении (loadPayload), в том числе в скрипте (-f):
+// строка видит файл таким, каким его оставили предыдущие строки.
+struct Payload {
+    vector<uint8_t> head;
+    string path;
+
+    bool empty() const { return head.empty() && path.empty(); }
+};
+
+// Нагрузка на время одной команды: файл отображён в память и уходит в FTDevice как есть,
+// без разбора и копии в vector
+struct LoadedPayload {
+    const vector<uint8_t> &head;
+    unique_ptr<const MappedFile> file; // nullptr — файла нет или он пустой
+
+    size_t size() const { return head.size() + (file ? file->size() : 0); }
+    bool empty() const { return size() == 0; }
+};
+
+// Бросает std::runtime_error, если файл не отображается или нагрузка пуста
+static LoadedPayload loadPayload(const Payload &p) {
+    LoadedPayload loaded{p.head, nullptr};
+    if (!p.path.empty()) {
+        loaded.file = make_unique<const MappedFile>(p.path);
+        if (loaded.file->size() == 0) loaded.file.reset();
+    }
+    if (loaded.empty()) throw runtime_error("No data to send");
+    return loaded;
+}
+
+// Приёмник ">file" (или "> file") последним аргументом: прочитанное принимается прямо
+// в отображение файла, а не выводится
+struct Sink {
+    string path;
+    bool empty() const { return path.empty(); }
+};
+
+// Остаток строки — токены и (при sink != nullptr) приёмник; бросает std::invalid_argument
+static vector<string> splitRedirect(istringstream &iss, Sink *sink) {
+    vector<string> tokens;
+    string token;
+    while (iss >> token) {
+        if (sink && token[0] == '>') {
+            sink->path = token.substr(1);
+            if (sink->path.empty() && !(iss >> sink->path)) throw invalid_argument("Missing file after '>'");
+            if (iss >> token) throw invalid_argument("Output redirect must be the last argument");
+            break;
+        }
+        tokens.push_back(std::move(token));
+    }
+    return tokens;
+}
+
+static Payload parsePayload(istringstream &iss, Sink *sink = nullptr) {
+    auto tokens = splitRedirect(iss, sink);
+    Payload p;
+    if (!tokens.empty() && tokens.back().size() > 1 && tokens.back()[0] == '@') {
+        p.path = tokens.back().substr(1);
+        tokens.pop_back();
+    }
+    string error;
+    for (const auto &t : tokens)
+        if (!appendBytes(t, p.head, &error)) throw invalid_argument(error);
+    return p;
+}
+
+static Sink parseSink(istringstream &iss, const char *usage) {
+    Sink sink;
+    if (!splitRedirect(iss, &sink).empty()) throw invalid_argument(usage);
+    return sink;
+}
+
+// Один и тот же файл (в том числе через другой путь или жёсткую ссылку)
+static bool sameFile(const string &a, const string &b) {
+    struct stat sa {}, sb {};
+    return ::stat(a.c_str(), &sa) == 0 && ::stat(b.c_str(), &sb) == 0 &&
+           sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+// Принять count байт: в память с выводом printBytes или, при sink, прямо в отображённый
+// файл. read(ByteSpan) возвращает число принятых байт; при ошибке файл удаляется.
+template <typename Read>
+static void receive(AppContext &ctx, const char *command, const char *label, size_t count,
+                    const Sink &sink, Read &&read) {
+    if (sink.empty()) {
+        vector<uint8_t> data(count);
+        data.resize(read(ByteSpan(data)));
+        printBytes(ctx, command, label, data);
+        return;
+    }
+    MappedFile file = MappedFile::create(sink.path, count);
+    try {
+        file.truncate(read(file.writableBytes()));
+    } catch (...) {
+        std::remove(sink.path.c_str());
+        throw;
+    }
+    ctx.out() << label << " " << file.size() << " bytes to " << sink.path << "\n";
+}
+
+struct AddrPayloadArgs {
+    uint8_t addr = 0;
+    Payload data;
+};
+
+struct AddrCountArgs {
+    uint8_t addr = 0;
+    size_t count = 0;
+    vector<uint8_t> reg;
+    Sink sink;
+};
+
+struct PayloadArgs {
+    Payload data;
+    Sink sink;
+};
+
+struct CountArgs {
+    size_t count = 0;
+    Sink sink;
+};
+
+struct GpioArgs {
+    int port = 0;
+    int value = 0;
+};
+
+// i2c_send <addr> <bytes...> [@file]
+static AddrPayloadArgs parseI2CSend(istringstream &iss) {
+    AddrPayloadArgs a;
+    string addrStr;
+    if (!(iss >> addrStr)) throw invalid_argument("Usage: i2c_send <addr> <hex-bytes...>");
+    a.data = parsePayload(iss);
+    if (a.data.empty()) throw invalid_argument("No data to send");
+    try { a.addr = static_cast<uint8_t>(parseNumber(addrStr)); }
+    catch (const exception &) { throw invalid_argument("Invalid address: " + addrStr); }
+    return a;
+}
+
+static void runI2CSend(AppContext &ctx, const AddrPayloadArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        const LoadedPayload p = loadPayload(a.data);
+        if (!p.file) {
+            ctx.device.i2cMasterWrite(a.addr, p.head);
+        } else if (p.head.empty()) {
+            ctx.device.i2cMasterWrite(a.addr, p.file->bytes());
+        } else {
+            // Одна транзакция не длиннее I2C_MAX_TRANSFER: склейка с префиксом дешевле
+            // второй транзакции без START
+            vector<uint8_t> data(p.head);
+            data.insert(data.end(), p.file->bytes().begin(), p.file->bytes().end());
+            ctx.device.i2cMasterWrite(a.addr, data);
+        }
+        ctx.out() << "Wrote " << p.size() << " bytes to 0x" << hex << (int)a.addr << dec << "\n";
+    } catch (const exception &ex) {
+        ctx.out() << "i2c_send failed: " << ex.what() << "\n";
+    }
+}
+
+// i2c_recv <addr> <count> [>file]
+static AddrCountArgs parseI2CRecv(istringstream &iss) {
+    const char *usage = "Usage: i2c_recv <addr> <count> [>file]";
+    AddrCountArgs a;
+    string addrStr;
+    if (!(iss >> addrStr >> a.count)) throw invalid_argument(usage);
+    a.sink = parseSink(iss, usage);
+    try { a.addr = static_cast<uint8_t>(parseNumber(addrStr)); }
+    catch (const exception &) { throw invalid_argument("Invalid address: " + addrStr); }
+    return a;
+}
+
+static void runI2CRecv(AppContext &ctx, const AddrCountArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        receive(ctx, "i2c_recv", "Read", a.count, a.sink,
+                [&](ByteSpan buffer) { return ctx.device.i2cMasterRead(a.addr, buffer); });
+    } catch (const exception &ex) {
+        ctx.out() << "i2c_recv failed: " << ex.what() << "\n";
+    }
+}
+
+// i2c_rr <addr> <count> <reg-bytes...>
+static AddrCountArgs parseI2CReadRegister(istringstream &iss) {
+    const char *usage = "Usage: i2c_rr <addr> <count> <reg-bytes...>";
+    AddrCountArgs a;
+    string addrStr, countStr;
+    if (!(iss >> addrStr >> countStr)) throw invalid_argument(usage);
+    parseDataBytes(iss, a.reg);
+    if (a.reg.empty()) throw invalid_argument(usage);
+    try {
+        a.addr = static_cast<uint8_t>(parseNumber(addrStr));
+        a.count = parseNumber(countStr);
+    } catch (const exception &) {
+        throw invalid_argument(usage);
+    }
+    return a;
+}
+
+static void runI2CReadRegister(AppContext &ctx, const AddrCountArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        auto data = ctx.device.i2cReadRegister(a.addr, a.reg, a.count);
+        printBytes(ctx, "i2c_rr", "Read", data);
+    } catch (const exception &ex) {
+        ctx.out() << "i2c_rr failed: " << ex.what() << "\n";
+    }
+}
+
+// spi_send <bytes...> [@file] / spi_xfer <bytes...> [@file] [>file]
+static PayloadArgs parseSpiPayload(istringstream &iss, const char *usage, bool withSink) {
+    PayloadArgs a;
+    a.data = parsePayload(iss, withSink ? &a.sink : nullptr);
+    if (a.data.empty()) throw invalid_argument(usage);
+    return a;
+}
+
+static PayloadArgs parseSpiSend(istringstream &iss) {
+    return parseSpiPayload(iss, "Usage: spi_send <hex-bytes...> [@file]", false);
+}
+
+static PayloadArgs parseSpiXfer(istringstream &iss) {
+    return parseSpiPayload(iss, "Usage: spi_xfer <hex-bytes...> [@file] [>file]", true);
+}
+
+// Префикс и файл — одна транзакция: CS держится между ними
+static void runSpiSend(AppContext &ctx, const PayloadArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        const LoadedPayload p = loadPayload(a.data);
+        if (!p.head.empty()) ctx.device.spiMasterSingleWrite(p.head, !p.file);
+        if (p.file) ctx.device.spiMasterSingleWrite(p.file->bytes(), true);
+        ctx.out() << "SPI wrote " << p.size() << " bytes\n";
+    } catch (const exception &ex) { ctx.out() << "spi_send failed: " << ex.what() << "\n"; }
+}
+
+static void runSpiXfer(AppContext &ctx, const PayloadArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        const LoadedPayload p = loadPayload(a.data);
+        // create() усекает приёмник, пока источник ещё отображён: на шину ушли бы нули
+        if (p.file && !a.sink.empty() && sameFile(p.file->path(), a.sink.path))
+            throw runtime_error("output file is the same as the input file");
+        receive(ctx, "spi_xfer", "Received", p.size(), a.sink, [&](ByteSpan rx) {
+            size_t got = 0;
+            if (!p.head.empty())
+                got += ctx.device.spiMasterSingleReadWrite(rx.subspan(0, p.head.size()), p.head, !p.file);
+            if (p.file)
+                got += ctx.device.spiMasterSingleReadWrite(rx.subspan(p.head.size()), p.file->bytes(), true);
+            return got;
+        });
+    } catch (const exception &ex) { ctx.out() << "spi_xfer failed: " << ex.what() << "\n"; }
+}
+
+// spi_recv <count> [>file]
+static CountArgs parseSpiRecv(istringstream &iss) {
+    const char *usage = "Usage: spi_recv <count> [>file]";
+    CountArgs a;
+    if (!(iss >> a.count)) throw invalid_argument(usage);
+    a.sink = parseSink(iss, usage);
+    return a;
+}
+
+static void runSpiRecv(AppContext &ctx, const CountArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try {
+        receive(ctx, "spi_recv", "Read", a.count, a.sink,
+                [&](ByteSpan buffer) { return ctx.device.spiMasterSingleRead(buffer); });
+    } catch (const exception &ex) { ctx.out() << "spi_recv failed: " << ex.what() << "\n"; }
+}
+
+// gpio_read <port> / gpio_write <port> <0|1>
+static GpioArgs parseGpioRead(istringstream &iss) {
+    GpioArgs a;
+    if (!(iss >> a.port)) throw invalid_argument("Usage: gpio_read <port 0-3>");
+    return a;
+}
+
+static GpioArgs parseGpioWrite(istringstream &iss) {
+    GpioArgs a;
+    if (!(iss >> a.port >> a.value)) throw invalid_argument("Usage: gpio_write <port 0-3> <0|1>");
+    return a;
+}
+
+static void runGpioRead(AppContext &ctx, const GpioArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try { bool v = ctx.device.readGPIO(static_cast<GPIO_Port>(a.port)); ctx.out() << "GPIO" << a.port << " = " << (v?"1":"0") << "\n"; } catch (const exception &ex) { ctx.out() << "gpio_read failed: " << ex.what() << "\n"; }
+}
+
+static void runGpioWrite(AppContext &ctx, const GpioArgs &a) {
+    if (!requireConnection(ctx)) return;
+    try { ctx.device.writeGPIO(static_cast<GPIO_Port>(a.port), a.value?true:false); ctx.out() << "GPIO" << a.port << " set to " << a.value << "\n"; } catch (const exception &ex) { ctx.out() << "gpio_write failed: " << ex.what() << "\n"; }
+}
+
 void registerDeviceCommands(CommandRouter &router) {
-    // list devices
+    // devices [--refresh] [--ttl ms] - список из кэша (без обращения к USB, пока снимок свежий)
     router.registerCommand("devices",
-        [](AppContext &, istringstream &) {
-            DeviceEnumerator::printDevices();
+        [](AppContext &ctx, istringstream &iss) {
+            auto &cache = DeviceCache::instance();
+            bool force = false;
+            string opt;
+            while (iss >> opt) {
+                string n;
+                if (opt == "--refresh") {
+                    force = true;
+                } else if (opt == "--ttl" && iss >> n) {
+                    try {
+                        cache.setTtl(chrono::milliseconds(stoul(n)));
+                    } catch (const exception &) {
+                        ctx.out() << "Invalid TTL: " << n << "\n";
+                        return;
+                    }
+                } else {
+                    ctx.out() << "Usage: devices [--refresh] [--ttl ms]\n";
+                    return;
+                }
+            }
+            try {
+                DeviceEnumerator::printDevices(cache.devices(force), ctx.out());
+            } catch (const exception &ex) {
+                ctx.out() << "devices failed: " << ex.what() << "\n";
+            }
+        },
+        "devices [--refresh] [--ttl ms] - list FT4222 devices (cached, TTL " +
+            to_string(DeviceCache::instance().ttl().count()) + " ms by default)");
+
+    // chips: интерфейсы, сгруппированные по физическому чипу
+    router.registerCommand("chips",
+        [](AppContext &ctx, istringstream &) {
+            try {
+                const auto chips = ChipSession::groupChips(DeviceCache::instance().devices());
+                if (chips.empty()) ctx.out() << "No FT4222 devices found\n";
+                for (const auto &chip : chips) {
+                    ctx.out() << (chip.serial.empty() ? "(no serial)" : chip.serial) << ":";
+                    for (const auto &i : chip.interfaces) {
+                        const char letter = ChipSession::interfaceLetter(i);
+                        ctx.out() << " " << (letter ? string(1, letter) : string("-")) << "#" << i.index;
+                    }
+                    ctx.out() << "\n";
+                }
+            } catch (const exception &ex) {
+                ctx.out() << "chips failed: " << ex.what() << "\n";
+            }
         },
-        "List FT4222 devices");
+        "chips - list FT4222 chips with their USB interfaces (letter#index)");
 
     router.registerCommand("connect",
         [](AppContext &ctx, istringstream &iss) {
             string arg1;
             if (!(iss >> arg1)) {
-                cout << "Usage: connect <index> | connect --serial <sn> | connect s:<sn>\n";
+                ctx.out() << "Usage: connect <index> | connect --serial <sn> | connect s:<sn> | connect --loc <id> | connect l:<id>\n";
                 return;
             }
 
+            auto connectLocation = [&](uint32_t location) {
+                ctx.device.openByLocation(location);
+                ctx.mode = DeviceMode::None;
+            };
+
+            // Серийный номер ищется в кэше списка и открывается по Location ID —
+            // без повторного перечисления в драйвере; при промахе — обычный FT_OpenEx по номеру
             auto connectSerial = [&](const string &serial) {
                 try {
+                    if (const auto info = DeviceCache::instance().findBySerial(serial)) {
+                        try {
+                            connectLocation(info->locationId);
+                            ctx.out() << "Connected to device serial " << serial
+                                      << " (location " << info->locationId << ")\n";
+                            return;
+                        } catch (const FtException &) {
+                            // Снимок мог устареть (адаптер переподключён в другой порт)
+                        }
+                    }
                     ctx.device.openBySerial(serial);
                     ctx.mode = DeviceMode::None;
-                    cout << "Connected to device serial " << serial << "\n";
+                    ctx.out() << "Connected to device serial " << serial << "\n";
                 } catch (const exception &ex) {
-                    cout << "Failed to connect: " << ex.what() << "\n";
+                    ctx.out() << "Failed to connect: " << ex.what() << "\n";
+                }
+            };
+
+            auto connectLocationArg = [&](const string &text) {
+                try {
+                    const auto location = static_cast<uint32_t>(parseNumber(text));
+                    connectLocation(location);
+                    ctx.out() << "Connected to device location " << location << "\n";
+                } catch (const exception &ex) {
+                    ctx.out() << "Failed to connect: " << ex.what() << "\n";
                 }
             };
 
             if (arg1 == "--serial" || arg1 == "serial") {
                 string serial;
                 if (!(iss >> serial)) {
-                    cout << "Usage: connect --serial <serial>\n";
+                    ctx.out() << "Usage: connect --serial <serial>\n";
                     return;
                 }
                 connectSerial(serial);
                 return;
             }
 
+            if (arg1 == "--loc" || arg1 == "loc") {
+                string location;
+                if (!(iss >> location)) {
+                    ctx.out() << "Usage: connect --loc <location id>\n";
+                    return;
+                }
+                connectLocationArg(location);
+                return;
+            }
+
             if (arg1.size() >= 2 && arg1.compare(0, 2, "s:") == 0) {
                 connectSerial(arg1.substr(2));
                 return;
             }
 
+            if (arg1.size() >= 2 && arg1.compare(0, 2, "l:") == 0) {
+                connectLocationArg(arg1.substr(2));
+                return;
+            }
+
             try {
                 const unsigned long idx = parseNumber(arg1);
                 ctx.device.open(static_cast<uint32_t>(idx));
                 ctx.mode = DeviceMode::None;
-                cout << "Connected to device index " << idx << "\n";
+                ctx.out() << "Connected to device index " << idx << "\n";
             } catch (const exception &ex) {
-                cout << "Failed to connect: " << ex.what() << "\n";
+                ctx.out() << "Failed to connect: " << ex.what() << "\n";
+            }
+        },
+        "Connect: connect <index> | connect --serial <sn> | connect s:<sn> | connect --loc <id> | connect l:<id>");
+
+    // hotplug on [interval_ms] | off - фоновое отслеживание подключения/отключения адаптеров
+    router.registerCommand("hotplug",
+        [](AppContext &ctx, istringstream &iss) {
+            auto &cache = DeviceCache::instance();
+            string action;
+            if (!(iss >> action)) {
+                ctx.out() << "Hot-plug watcher: " << (cache.watching() ? "on" : "off") << "\n";
+                return;
+            }
+            if (action == "off") {
+                cache.stopWatcher();
+                ctx.out() << "Hot-plug watcher: off\n";
+                return;
+            }
+            if (action != "on") {
+                ctx.out() << "Usage: hotplug [on [interval_ms] | off]\n";
+                return;
+            }
+            unsigned long intervalMs = 500;
+            string n;
+            if (iss >> n) {
+                try {
+                    intervalMs = stoul(n);
+                } catch (const exception &) {
+                    intervalMs = 0;
+                }
+                if (intervalMs == 0) { ctx.out() << "Invalid interval: " << n << "\n"; return; }
             }
+            // События приходят из фонового потока, поэтому пишутся в stderr, а не в ctx.out()
+            cache.startWatcher(chrono::milliseconds(intervalMs), [](const DeviceCache::Event &ev) {
+                cerr << "[hotplug] "
+                     << (ev.type == DeviceCache::Event::Type::Added ? "added   " : "removed ")
+                     << MultiDeviceRunner::keyFor(ev.info) << " (location " << ev.info.locationId << ")\n";
+            });
+            ctx.out() << "Hot-plug watcher: on (every " << intervalMs << " ms)\n";
         },
-        "Connect: connect <index> | connect --serial <sn> | connect s:<sn>");
+        "hotplug [on [interval_ms] | off] - watch for FT4222 add/remove and keep the device cache current");
 
     router.registerCommand("disconnect",
         [](AppContext &ctx, istringstream &) {
@@ -78,18 +633,18 @@ void registerDeviceCommands(CommandRouter &router) {
                 cerr << "disconnect warning: " << ex.what() << "\n";
             }
             ctx.reset();
-            cout << "Disconnected\n";
+            ctx.out() << "Disconnected\n";
         },
         "Disconnect from device");
 
     router.registerCommand("status",
         [](AppContext &ctx, istringstream &) {
-            cout << "Connected: " << (ctx.isConnected() ? "yes" : "no") << "\n";
+            ctx.out() << "Connected: " << (ctx.isConnected() ? "yes" : "no") << "\n";
             if (!ctx.isConnected()) return;
             try {
-                cout << "Version: " << ctx.device.getVersionString() << "\n";
+                ctx.out() << "Version: " << ctx.device.getVersionString() << "\n";
             } catch (const exception &e) {
-                cout << "Version: (error) " << e.what() << "\n";
+                ctx.out() << "Version: (error) " << e.what() << "\n";
             }
 
             try {
@@ -101,119 +656,699 @@ void registerDeviceCommands(CommandRouter &router) {
                     case FTDevice::Mode::GPIO: s = "GPIO"; break;
                     default: s = "Unknown"; break;
                 }
-                cout << "Device mode: " << s << "\n";
+                ctx.out() << "Device mode: " << s << "\n";
             } catch (const exception &e) {
-                cout << "Device mode: (error) " << e.what() << "\n";
+                ctx.out() << "Device mode: (error) " << e.what() << "\n";
             }
         },
         "Show device connection status");
 
+    // stats [reset|json] - счётчики и латентность операций FTDevice (общие для процесса)
+    router.registerCommand("stats",
+        [](AppContext &ctx, istringstream &iss) {
+            string arg;
+            iss >> arg;
+            if (arg == "reset") {
+                ft4222stats::reset();
+                ctx.out() << "Statistics reset\n";
+                return;
+            }
+            if (!arg.empty() && arg != "json") {
+                ctx.out() << "Usage: stats [reset|json]\n";
+                return;
+            }
+
+            const auto ops = ft4222stats::snapshot();
+            const auto rec = ft4222stats::recovery();
+            if (arg == "json") {
+                ctx.out() << "{\"ops\":[";
+                for (size_t i = 0; i < ops.size(); ++i) {
+                    const auto &op = ops[i];
+                    ctx.out() << (i ? "," : "") << "{\"op\":\"" << ft4222stats::opName(op.op)
+                              << "\",\"calls\":" << op.calls << ",\"errors\":" << op.errors
+                              << ",\"bytes\":" << op.bytes << ",\"mean_ns\":" << op.totalNs / op.calls
+                              << ",\"p50_ns\":" << op.p50Ns << ",\"p90_ns\":" << op.p90Ns
+                              << ",\"p99_ns\":" << op.p99Ns << ",\"max_ns\":" << op.maxNs
+                              << ",\"errors_by_status\":{";
+                    for (size_t e = 0; e < op.errorsByStatus.size(); ++e)
+                        ctx.out() << (e ? "," : "") << "\"" << op.errorsByStatus[e].first
+                                  << "\":" << op.errorsByStatus[e].second;
+                    ctx.out() << "}}";
+                }
+                ctx.out() << "],\"i2c_recovery\":{\"retries\":" << rec.retries
+                          << ",\"bus_resets\":" << rec.busResets << ",\"chip_resets\":" << rec.chipResets
+                          << ",\"recovered\":" << rec.recovered << ",\"exhausted\":" << rec.exhausted << "}}\n";
+                return;
+            }
+
+            if (ops.empty()) { ctx.out() << "No device operations recorded\n"; return; }
+            // formatMs делит на 1000: для наносекунд это микросекунды с тремя знаками
+            const auto us = formatMs;
+            ctx.out() << left << setw(14) << "op" << right << setw(9) << "calls" << setw(8) << "errors"
+                      << setw(12) << "bytes" << setw(12) << "mean_us" << setw(12) << "p50_us"
+                      << setw(12) << "p90_us" << setw(12) << "p99_us" << setw(12) << "max_us" << "\n";
+            for (const auto &op : ops) {
+                ctx.out() << left << setw(14) << ft4222stats::opName(op.op) << right << setw(9) << op.calls
+                          << setw(8) << op.errors << setw(12) << op.bytes << setw(12) << us(op.totalNs / op.calls)
+                          << setw(12) << us(op.p50Ns) << setw(12) << us(op.p90Ns) << setw(12) << us(op.p99Ns)
+                          << setw(12) << us(op.maxNs) << "\n";
+                if (op.errorsByStatus.empty()) continue;
+                ctx.out() << "    errors:";
+                for (const auto &e : op.errorsByStatus) {
+                    if (e.first < 0) ctx.out() << " other x" << e.second;
+                    else ctx.out() << " status " << e.first << " x" << e.second;
+                }
+                ctx.out() << "\n";
+            }
+            if (!rec.empty())
+                ctx.out() << "i2c recovery: " << rec.retries << " retries, " << rec.busResets << " bus resets, "
+                          << rec.chipResets << " chip resets, " << rec.recovered << " recovered, "
+                          << rec.exhausted << " exhausted\n";
+        },
+        "stats [reset|json] - per-operation call counts, bytes, errors and latency percentiles");
+
+    // trace start <file> [--ring size] | trace stop | trace replay <file> [--max|--speed X]
+    router.registerCommand("trace",
+        [](AppContext &ctx, istringstream &iss) {
+            string action;
+            iss >> action;
+            if (action.empty()) {
+                const auto rec = ctx.device.traceRecorder();
+                if (!rec) { ctx.out() << "Trace: off\n"; return; }
+                ctx.out() << "Trace: " << rec->path() << ", " << rec->recorded() << " record(s), "
+                          << rec->dropped() << " dropped" << (rec->writeFailed() ? ", write failed" : "")
+                          << "\n";
+                return;
+            }
+
+            if (action == "start") {
+                string path, opt;
+                if (!(iss >> path)) { ctx.out() << "Usage: trace start <file> [--ring size]\n"; return; }
+                size_t ringBytes = ft4222trace::Recorder::kDefaultRingBytes;
+                while (iss >> opt) {
+                    string n;
+                    if (opt == "--ring" && iss >> n) {
+                        try { ringBytes = static_cast<size_t>(parseByteCount(n)); } catch (const exception &) { ringBytes = 0; }
+                        if (ringBytes < 4096) { ctx.out() << "Invalid ring size: " << n << "\n"; return; }
+                    } else { ctx.out() << "Unknown option: " << opt << "\n"; return; }
+                }
+                if (ctx.device.traceRecorder()) { ctx.out() << "Trace already running; use 'trace stop' first\n"; return; }
+                try {
+                    ctx.device.setTraceRecorder(make_shared<ft4222trace::Recorder>(path, ringBytes));
+                    ctx.out() << "Tracing to " << path << "\n";
+                } catch (const exception &ex) { ctx.out() << "trace start failed: " << ex.what() << "\n"; }
+                return;
+            }
+
+            if (action == "stop") {
+                const auto rec = ctx.device.traceRecorder();
+                if (!rec) { ctx.out() << "Trace not running\n"; return; }
+                // Отключить под мьютексом устройства: после этого в кольцо никто не пишет
+                ctx.device.setTraceRecorder(nullptr);
+                // Ошибка записи файла уходит исключением: команда завершается неуспехом
+                rec->stop();
+                ctx.out() << "Trace stopped: " << rec->recorded() << " record(s), " << rec->dropped()
+                          << " dropped, " << rec->bytesWritten() << " bytes written to " << rec->path() << "\n";
+                return;
+            }
+
+            if (action == "replay") {
+                if (!requireConnection(ctx)) return;
+                string path, opt;
+                if (!(iss >> path)) { ctx.out() << "Usage: trace replay <file> [--max | --speed X]\n"; return; }
+                TraceReplayOptions options;
+                while (iss >> opt) {
+                    string n;
+                    if (opt == "--max") {
+                        options.maxSpeed = true;
+                    } else if (opt == "--speed" && iss >> n) {
+                        try { options.speed = stod(n); } catch (const exception &) { options.speed = 0; }
+                        if (!(options.speed > 0)) { ctx.out() << "Invalid speed: " << n << "\n"; return; }
+                    } else { ctx.out() << "Unknown option: " << opt << "\n"; return; }
+                }
+                ifstream file(path, ios::binary);
+                if (!file) { ctx.out() << "Cannot open " << path << "\n"; return; }
+                try {
+                    const TraceReplayStats st = TraceReplayer::run(ctx.device, file, options);
+                    ctx.out() << "Replayed " << st.replayed << "/" << st.records << " record(s) in "
+                              << formatMs(st.elapsedUs) << " ms";
+                    if (!options.maxSpeed) ctx.out() << " (max late " << formatMs(st.maxLateUs) << " ms)";
+                    ctx.out() << ": " << st.mismatches << " mismatch(es), " << st.errors << " error(s), "
+                              << st.skipped << " skipped\n";
+                    for (const auto &m : st.reported)
+                        ctx.out() << "  #" << m.index << " " << ft4222stats::opName(m.op) << ": " << m.what << "\n";
+                    if (st.mismatches > st.reported.size())
+                        ctx.out() << "  ... " << st.mismatches - st.reported.size() << " more\n";
+                } catch (const exception &ex) { ctx.out() << "trace replay failed: " << ex.what() << "\n"; }
+                return;
+            }
+
+            ctx.out() << "Usage: trace [start <file> [--ring size] | stop | replay <file> [--max | --speed X]]\n";
+        },
+        "trace start <file> [--ring size] | stop | replay <file> [--max|--speed X] - record/replay a binary bus trace");
+
+    // log [off|error|info|debug|trace]
+    router.registerCommand("log",
+        [](AppContext &ctx, istringstream &iss) {
+            static const pair<const char *, FTDevice::LogLevel> levels[] = {
+                {"off", FTDevice::LogLevel::Off},     {"error", FTDevice::LogLevel::Error},
+                {"info", FTDevice::LogLevel::Info},   {"debug", FTDevice::LogLevel::Debug},
+                {"trace", FTDevice::LogLevel::Trace},
+            };
+            string name;
+            if (!(iss >> name)) {
+                const auto current = ctx.device.logEnabled(FTDevice::LogLevel::Error)
+                                         ? ctx.device.getLogLevel()
+                                         : FTDevice::LogLevel::Off;
+                for (const auto &l : levels)
+                    if (l.second == current) ctx.out() << "Log level: " << l.first << "\n";
+                return;
+            }
+            transform(name.begin(), name.end(), name.begin(),
+                      [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            for (const auto &l : levels) {
+                if (name != l.first) continue;
+                if (l.second == FTDevice::LogLevel::Off) {
+                    ctx.device.setLogger(nullptr);
+                } else {
+                    ctx.device.setLogger([](const string &msg) { cerr << "[ft4222] " << msg << "\n"; });
+                }
+                ctx.device.setLogLevel(l.second);
+                ctx.out() << "Log level: " << l.first << "\n";
+                return;
+            }
+            ctx.out() << "Usage: log [off|error|info|debug|trace]\n";
+        },
+        "log [off|error|info|debug|trace] - set device log level (messages go to stderr)");
+
+    // output [hex|raw|json|hexdump]
+    router.registerCommand("output",
+        [](AppContext &ctx, istringstream &iss) {
+            string name;
+            if (!(iss >> name)) {
+                ctx.out() << "Output mode: " << outputModeName(ctx.outputMode) << "\n";
+                return;
+            }
+            if (!parseOutputMode(name, ctx.outputMode)) {
+                ctx.out() << "Usage: output [hex|raw|json|hexdump]\n";
+                return;
+            }
+            ctx.out() << "Output mode: " << name << "\n";
+        },
+        "output [hex|raw|json|hexdump] - format of data printed by i2c_recv, i2c_rr, spi_recv, spi_xfer");
+
     // I2C init
     router.registerCommand("i2c_init",
         [](AppContext &ctx, istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            string speedStr;
-            if (!(iss >> speedStr)) {
-                // default
-                speedStr = "400";
+            string speedStr = "400", hzStr, token;
+            bool force = false;
+            while (iss >> token) {
+                if (token == "--force") force = true;
+                else if (token == "--hz" && iss >> hzStr) continue;
+                else speedStr = token;
             }
             try {
-                unsigned long s = parseNumber(speedStr);
+                const unsigned long s = hzStr.empty() ? parseNumber(speedStr) : 0;
                 FTDevice::I2CSpeed speed = FTDevice::I2CSpeed::S400K;
                 if (s == 100) speed = FTDevice::I2CSpeed::S100K;
                 else if (s == 400) speed = FTDevice::I2CSpeed::S400K;
                 else if (s == 1000) speed = FTDevice::I2CSpeed::S1M;
                 else {
-                    cout << "Unsupported speed, use 100, 400, 1000\n";
+                    // Прочие скорости — через планировщик частот
+                    const uint32_t target = hzStr.empty() ? static_cast<uint32_t>(s * 1000) : parseFrequencyHz(hzStr);
+                    const uint32_t hz = ctx.device.initI2CMasterHz(target, force);
+                    ctx.mode = DeviceMode::I2C;
+                    ctx.out() << "I2C initialized at " << hz << " Hz (requested " << target << ", sys "
+                              << ft4222clock::systemClockHz(ctx.device.getClockRate()) / 1000000 << " MHz)\n";
                     return;
                 }
 
-                ctx.device.initI2CMaster(speed);
+                const bool applied = ctx.device.initI2CMaster(speed, force);
                 ctx.mode = DeviceMode::I2C;
-                cout << "I2C initialized at " << s << " kbps\n";
+                ctx.out() << (applied ? "I2C initialized at " : "I2C already initialized at ") << s
+                          << " kbps\n";
             } catch (const exception &ex) {
-                cout << "i2c_init failed: " << ex.what() << "\n";
+                ctx.out() << "i2c_init failed: " << ex.what() << "\n";
             }
         },
-        "Initialize I2C master [speed: 100|400|1000]");
+        "Initialize I2C master [speed kbps: 100|400|1000|other] [--hz freq] [--force] (skipped if already configured)");
+
+    registerParsedCommand<AddrPayloadArgs>(router, "i2c_send", parseI2CSend, runI2CSend,
+        "i2c_send <addr> <hex bytes...> [@file] - send data to I2C device (a trailing @file is memory-mapped)");
+
+    registerParsedCommand<AddrCountArgs>(router, "i2c_recv", parseI2CRecv, runI2CRecv,
+        "i2c_recv <addr> <count> [>file] - read <count> bytes from I2C device (>file: straight into a mapped file)");
+
+    registerParsedCommand<AddrCountArgs>(router, "i2c_rr", parseI2CReadRegister, runI2CReadRegister,
+        "i2c_rr <addr> <count> <reg-bytes...> - read register (write reg, repeated START, read, STOP)");
+
+    // i2c_dump <addr> <offset> <len> <file> [--addr-bytes 1|2] - чтение EEPROM/регистровой карты в файл
+    router.registerCommand("i2c_dump",
+        [](AppContext &ctx, istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            const char *usage = "Usage: i2c_dump <addr> <offset> <len> <file> [--addr-bytes 1|2]\n";
+            string addrStr, offsetStr, lenStr, path, opt;
+            if (!(iss >> addrStr >> offsetStr >> lenStr >> path)) { ctx.out() << usage; return; }
+            uint8_t addr = 0;
+            uint32_t offset = 0;
+            size_t len = 0;
+            unsigned addressBytes = 0;
+            try {
+                addr = static_cast<uint8_t>(parseNumber(addrStr));
+                offset = static_cast<uint32_t>(parseNumber(offsetStr));
+                try { len = static_cast<size_t>(parseByteCount(lenStr)); }
+                catch (const exception &) { len = parseNumber(lenStr); }
+                while (iss >> opt) {
+                    string n;
+                    if (opt == "--addr-bytes" && iss >> n) addressBytes = static_cast<unsigned>(parseNumber(n));
+                    else { ctx.out() << "Unknown option: " << opt << "\n"; return; }
+                }
+            } catch (const exception &) { ctx.out() << usage; return; }
+            if (len == 0) { ctx.out() << usage; return; }
+            // Без --addr-bytes: однобайтовый адрес ячейки для карт до 256 байт, иначе двухбайтовый
+            EepromGeometry geometry;
+            geometry.addressBytes = addressBytes ? addressBytes : (offset + len <= 256 ? 1 : 2);
+
+            try {
+                I2CEeprom eeprom(ctx.device, addr, geometry);
+                // Чтение прямо в отображение файла; при ошибке файла не остаётся
+                MappedFile file = MappedFile::create(path, len);
+                EepromReadStats st;
+                try { st = eeprom.read(offset, file.writableBytes()); }
+                catch (...) { std::remove(path.c_str()); throw; }
+                ctx.out() << "Dumped " << st.bytes << " bytes from 0x" << hex << (int)addr << dec << " to " << path
+                          << " in " << formatMs(st.elapsedUs) << " ms (" << st.transfers << " transfer(s), "
+                          << fixed << setprecision(1)
+                          << (st.elapsedUs ? st.bytes * 1000.0 / static_cast<double>(st.elapsedUs) : 0.0)
+                          << " KB/s)" << defaultfloat << "\n";
+            } catch (const exception &ex) { ctx.out() << "i2c_dump failed: " << ex.what() << "\n"; }
+        },
+        "i2c_dump <addr> <offset> <len> <file> [--addr-bytes 1|2] - read EEPROM/register map with max-size sequential reads");
 
-    // i2c_send <addr> <bytes...>
-    router.registerCommand("i2c_send",
+    // i2c_program <addr> <file> [page] [--offset N] [--addr-bytes 1|2] [--timeout ms] [--no-verify]
+    router.registerCommand("i2c_program",
         [](AppContext &ctx, istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            string addrStr;
-            if (!(iss >> addrStr)) { cout << "Usage: i2c_send <addr> <hex-bytes...>\n"; return; }
-            vector<unsigned long> bytes;
-            string token;
-            while (iss >> token) {
-                try {
-                    bytes.push_back(parseNumber(token));
-                } catch (const exception &e) {
-                    cout << "Invalid byte: " << token << "\n"; return;
+            const char *usage =
+                "Usage: i2c_program <addr> <file> [page] [--offset N] [--addr-bytes 1|2] [--timeout ms] [--no-verify]\n";
+            string addrStr, path, token;
+            if (!(iss >> addrStr >> path)) { ctx.out() << usage; return; }
+            uint8_t addr = 0;
+            uint32_t offset = 0;
+            unsigned addressBytes = 0;
+            unsigned timeoutMs = 50;
+            bool verify = true;
+            EepromGeometry geometry;
+            try {
+                addr = static_cast<uint8_t>(parseNumber(addrStr));
+                while (iss >> token) {
+                    string n;
+                    if (token == "--no-verify") verify = false;
+                    else if (token == "--offset" && iss >> n) offset = static_cast<uint32_t>(parseNumber(n));
+                    else if (token == "--addr-bytes" && iss >> n) addressBytes = static_cast<unsigned>(parseNumber(n));
+                    else if (token == "--timeout" && iss >> n) timeoutMs = static_cast<unsigned>(parseNumber(n));
+                    else if (token[0] != '-') geometry.pageSize = parseNumber(token);
+                    else { ctx.out() << "Unknown option: " << token << "\n"; return; }
+                }
+            } catch (const exception &) { ctx.out() << usage; return; }
+
+            try {
+                const MappedFile image(path);
+                if (image.size() == 0) { ctx.out() << path << " is empty\n"; return; }
+                geometry.addressBytes = addressBytes ? addressBytes : (offset + image.size() <= 256 ? 1 : 2);
+                I2CEeprom eeprom(ctx.device, addr, geometry);
+                const EepromWriteStats st = eeprom.write(offset, image.bytes(), verify, timeoutMs);
+                ctx.out() << "Programmed " << st.bytes << " bytes (" << st.pages << " page(s) of "
+                          << geometry.pageSize << ") in " << formatMs(st.elapsedUs) << " ms, max write cycle "
+                          << formatMs(st.maxCycleUs) << " ms, " << st.polls << " ACK poll(s)\n";
+                if (verify) ctx.out() << "Verified in " << formatMs(st.verifyUs) << " ms\n";
+            } catch (const exception &ex) { ctx.out() << "i2c_program failed: " << ex.what() << "\n"; }
+        },
+        "i2c_program <addr> <file> [page] [--offset N] [--addr-bytes 1|2] [--timeout ms] [--no-verify] - page-write EEPROM with ACK polling and verify");
+
+    // poll <duration> <file> <addr>:<reg|->:<len>@<rate> ... [--bin] [--ring N] - опрос датчиков по расписанию
+    router.registerCommand("poll",
+        [](AppContext &ctx, istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            const char *usage =
+                "Usage: poll <duration> <file> <addr>:<reg|->:<len>@<rate> [...] [--bin] [--ring N]\n"
+                "Example: poll 10s imu.csv 0x68:3B:14@1k 0x48:00:2@10\n";
+            string durationStr, path, token;
+            if (!(iss >> durationStr >> path)) { ctx.out() << usage; return; }
+            uint64_t durationMs = 0;
+            vector<PollJob> jobs;
+            PollOptions options;
+            PollFormat format = PollFormat::Csv;
+            try {
+                durationMs = parseDurationMs(durationStr);
+                if (durationMs == 0) throw invalid_argument(durationStr);
+                while (iss >> token) {
+                    string n;
+                    if (token == "--bin") { format = PollFormat::Binary; continue; }
+                    if (token == "--ring" && iss >> n) { options.ringCapacity = static_cast<size_t>(parseNumber(n)); continue; }
+                    // <addr>:<reg|->:<len>@<rate>
+                    const auto at = token.rfind('@');
+                    const auto c1 = token.find(':');
+                    const auto c2 = token.find(':', c1 == string::npos ? c1 : c1 + 1);
+                    if (at == string::npos || c1 == string::npos || c2 == string::npos || c2 > at)
+                        throw invalid_argument(token);
+                    PollJob job;
+                    job.address = static_cast<uint8_t>(parseNumber(token.substr(0, c1)));
+                    const string reg = token.substr(c1 + 1, c2 - c1 - 1);
+                    if (reg != "-" && !appendBytes(reg, job.reg)) throw invalid_argument(token);
+                    job.length = static_cast<uint16_t>(parseNumber(token.substr(c2 + 1, at - c2 - 1)));
+                    const uint32_t hz = parseFrequencyHz(token.substr(at + 1));
+                    if (hz > 100000) throw invalid_argument(token);
+                    job.periodUs = 1000000 / hz;
+                    jobs.push_back(std::move(job));
+                }
+                if (jobs.empty()) throw invalid_argument("no jobs");
+            } catch (const exception &) { ctx.out() << usage; return; }
+
+            ofstream file(path, ios::binary | ios::trunc);
+            if (!file) { ctx.out() << "Cannot open " << path << "\n"; return; }
+            try {
+                I2CPoller poller(ctx.device, jobs, options);
+                PollWriter writer(file, format, poller.jobs());
+                const auto write = [&](const PollSample &sample) { writer.write(sample); };
+                uint64_t written = 0;
+                const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(durationMs);
+                poller.start();
+                // Поток команды — потребитель кольца: пишет файл, пока планировщик опрашивает
+                while (chrono::steady_clock::now() < deadline && poller.running()) {
+                    written += poller.drain(write);
+                    this_thread::sleep_for(chrono::milliseconds(2));
+                }
+                const PollStats st = poller.stop();
+                written += poller.drain(write);
+                file.flush();
+
+                ctx.out() << "Polled " << jobs.size() << " job(s) for " << formatMs(st.elapsedUs) << " ms in "
+                          << st.batches << " batch(es), " << written << " sample(s) to " << path << "\n";
+                for (size_t i = 0; i < jobs.size(); ++i) {
+                    const PollJob &job = jobs[i];
+                    const PollJobStats &js = st.jobs[i];
+                    ctx.out() << "  0x" << hex << setw(2) << setfill('0') << (int)job.address << dec << setfill(' ')
+                              << " reg ";
+                    string reg;
+                    appendHex(reg, job.reg, false);
+                    ctx.out() << (reg.empty() ? "-" : reg) << " x" << job.length << ": " << fixed << setprecision(1)
+                              << js.achievedHz << " Hz (requested " << job.requestedHz() << ")" << defaultfloat
+                              << ", " << js.samples << " sample(s), " << js.errors << " error(s), " << js.missed
+                              << " missed, max late " << formatMs(js.maxLateUs) << " ms";
+                    if (js.dropped) ctx.out() << ", " << js.dropped << " dropped";
+                    ctx.out() << "\n";
+                }
+            } catch (const exception &ex) { ctx.out() << "poll failed: " << ex.what() << "\n"; }
+        },
+        "poll <duration> <file> <addr>:<reg|->:<len>@<rate> [...] [--bin] [--ring N] - fixed-rate I2C sensor polling to CSV/binary");
+
+    // i2c_scan [start] [end] [--fast] [--write] [--keep-speed]
+    router.registerCommand("i2c_scan",
+        [](AppContext &ctx, istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            uint8_t start = 0x03, end = 0x77;
+            bool fast = false;
+            I2CScanOptions options;
+            try {
+                string token;
+                int positional = 0;
+                while (iss >> token) {
+                    if (token == "--fast") fast = true;
+                    else if (token == "--write") { fast = true; options.writeProbe = true; }
+                    else if (token == "--keep-speed") { fast = true; options.fastClock = false; }
+                    else if (positional == 0) { start = static_cast<uint8_t>(parseNumber(token)); ++positional; }
+                    else if (positional == 1) { end = static_cast<uint8_t>(parseNumber(token)); ++positional; }
+                    else { ctx.out() << "Usage: i2c_scan [start] [end] [--fast] [--write] [--keep-speed]\n"; return; }
+                }
+            } catch (const exception &) {
+                ctx.out() << "Usage: i2c_scan [start] [end] [--fast] [--write] [--keep-speed]\n"; return;
+            }
+            try {
+                if (fast) {
+                    auto res = ctx.device.scanI2CBusFast(start, end, options);
+                    if (res.devices.empty()) ctx.out() << "No devices found\n";
+                    else {
+                        ctx.out() << "Found devices: ";
+                        for (const auto &d : res.devices)
+                            ctx.out() << "0x" << hex << setw(2) << setfill('0') << (int)d.address
+                                 << dec << setfill(' ') << " (" << d.latencyUs << " us) ";
+                        ctx.out() << "\n";
+                    }
+                    ctx.out() << "Scanned " << res.probed << " address(es) in " << formatMs(res.elapsedUs)
+                         << " ms, max probe " << res.maxProbeUs << " us\n";
+                    return;
+                }
+
+                const auto t0 = chrono::steady_clock::now();
+                auto found = ctx.device.scanI2CBus(start, end);
+                const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+                if (found.empty()) ctx.out() << "No devices found\n";
+                else {
+                    ctx.out() << "Found devices: ";
+                    ctx.out() << hex;
+                    for (auto a : found) ctx.out() << "0x" << setw(2) << setfill('0') << (int)a << " ";
+                    ctx.out() << dec << setfill(' ') << "\n";
+                }
+                ctx.out() << "Scan took " << formatMs(static_cast<uint64_t>(us)) << " ms\n";
+            } catch (const exception &ex) {
+                ctx.out() << "i2c_scan failed: " << ex.what() << "\n";
+            }
+        },
+        "i2c_scan [start] [end] [--fast] [--write] [--keep-speed] - scan I2C bus for devices");
+
+    // i2c_scan_all [start] [end] [speed] - параллельно на всех адаптерах
+    router.registerCommand("i2c_scan_all",
+        [](AppContext &ctx, istringstream &iss) {
+            uint8_t start = 0x03, end = 0x77;
+            FTDevice::I2CSpeed speed = FTDevice::I2CSpeed::S400K;
+            string sstart, send, sspeed;
+            try {
+                if (iss >> sstart) start = static_cast<uint8_t>(parseNumber(sstart));
+                if (iss >> send) end = static_cast<uint8_t>(parseNumber(send));
+                if (iss >> sspeed) {
+                    const unsigned long s = parseNumber(sspeed);
+                    if (s == 100) speed = FTDevice::I2CSpeed::S100K;
+                    else if (s == 400) speed = FTDevice::I2CSpeed::S400K;
+                    else if (s == 1000) speed = FTDevice::I2CSpeed::S1M;
+                    else { ctx.out() << "Unsupported speed, use 100, 400, 1000\n"; return; }
                 }
+            } catch (const exception &) {
+                ctx.out() << "Usage: i2c_scan_all [start] [end] [speed]\n"; return;
             }
-            if (bytes.empty()) { cout << "No data to send\n"; return; }
 
             try {
-                uint8_t addr = static_cast<uint8_t>(parseNumber(addrStr));
-                vector<uint8_t> data;
-                data.reserve(bytes.size());
-                for (auto b : bytes) data.push_back(static_cast<uint8_t>(b & 0xFF));
-                ctx.device.i2cMasterWrite(addr, data);
-                cout << "Wrote " << data.size() << " bytes to 0x" << hex << (int)addr << dec << "\n";
+                const auto devices = DeviceCache::instance().devices();
+                if (devices.empty()) { ctx.out() << "No FT4222 devices found\n"; return; }
+
+                const auto t0 = chrono::steady_clock::now();
+                auto results = MultiDeviceRunner::run(devices,
+                    [&](FTDevice &device, const DeviceInfo &, ostream &out) {
+                        device.initI2CMaster(speed);
+                        const auto res = device.scanI2CBusFast(start, end);
+                        if (res.devices.empty()) out << "no devices";
+                        out << hex << setfill('0');
+                        for (const auto &d : res.devices) out << "0x" << setw(2) << (int)d.address << " ";
+                    });
+                const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+
+                ctx.out() << "Scanned " << results.size() << " adapter(s) in "
+                          << formatMs(static_cast<uint64_t>(us)) << " ms\n";
+                for (const auto &r : results) {
+                    ctx.out() << r.first << ": ";
+                    if (r.second.ok) ctx.out() << r.second.output;
+                    else ctx.out() << "error: " << r.second.error;
+                    ctx.out() << " (" << formatMs(r.second.elapsedUs) << " ms)\n";
+                }
             } catch (const exception &ex) {
-                cout << "i2c_send failed: " << ex.what() << "\n";
+                ctx.out() << "i2c_scan_all failed: " << ex.what() << "\n";
             }
         },
-        "i2c_send <addr> <hex bytes...>  - send data to I2C device");
+        "i2c_scan_all [start] [end] [speed] - scan I2C bus on every FT4222 in parallel");
 
-    // i2c_recv <addr> <count>
-    router.registerCommand("i2c_recv",
+    // flash_all <image> [--offset N] [--hz freq] [--verify] [--no-erase] - один образ в SPI NOR на всех адаптерах
+    router.registerCommand("flash_all",
         [](AppContext &ctx, istringstream &iss) {
-            if (!requireConnection(ctx)) return;
-            string addrStr; size_t count = 0;
-            if (!(iss >> addrStr >> count)) { cout << "Usage: i2c_recv <addr> <count>\n"; return; }
-            try {
-                uint8_t addr = static_cast<uint8_t>(parseNumber(addrStr));
-                auto data = ctx.device.i2cMasterRead(addr, count);
-                cout << "Read " << data.size() << " bytes: ";
-                cout << hex;
-                for (auto b : data) cout << uppercase << setw(2) << setfill('0') << (int)b << " ";
-                cout << dec << setfill(' ') << "\n";
+            const char *usage = "Usage: flash_all <image> [--offset N] [--hz freq] [--verify] [--no-erase]\n";
+            string path, token;
+            if (!(iss >> path)) { ctx.out() << usage; return; }
+            FlashOptions options;
+            try {
+                while (iss >> token) {
+                    string n;
+                    if (token == "--verify") options.verify = true;
+                    else if (token == "--no-erase") options.erase = false;
+                    else if (token == "--offset" && iss >> n) options.offset = static_cast<uint32_t>(parseNumber(n));
+                    else if (token == "--hz" && iss >> n) options.spiHz = parseFrequencyHz(n);
+                    else { ctx.out() << usage; return; }
+                }
+            } catch (const exception &) { ctx.out() << usage; return; }
+
+            try {
+                const MappedFile image(path);
+                if (image.size() == 0) { ctx.out() << path << " is empty\n"; return; }
+                const auto devices = DeviceCache::instance().devices();
+                const auto targets = FlashPipeline::targets(devices);
+                if (targets.empty()) { ctx.out() << "No FT4222 devices found\n"; return; }
+
+                ctx.out() << "Flashing " << path << " (" << image.size() << " bytes, crc32 0x" << hex
+                          << setw(8) << setfill('0') << crc32(image.bytes()) << ") at 0x"
+                          << options.offset << dec << setfill(' ') << " to " << targets.size()
+                          << " adapter(s)\n";
+                const auto t0 = chrono::steady_clock::now();
+                const auto results = FlashPipeline::run(devices, image.bytes(), options);
+                const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+
+                size_t ok = 0;
+                for (const auto &r : results) {
+                    const FlashResult &fr = r.second;
+                    ctx.out() << r.first << ": ";
+                    if (fr.ok) {
+                        ++ok;
+                        ctx.out() << "ok, JEDEC 0x" << hex << setw(6) << setfill('0') << fr.jedecId << dec
+                                  << setfill(' ') << ", " << fr.write.pages << " page(s)";
+                        if (fr.write.skippedPages) ctx.out() << " + " << fr.write.skippedPages << " blank";
+                        ctx.out() << ", erase " << formatMs(fr.erase.elapsedUs) << " ms, program "
+                                  << formatMs(fr.write.elapsedUs) << " ms, " << fixed << setprecision(1)
+                                  << fr.bytesPerSecond() / 1024.0 << " KB/s" << defaultfloat;
+                        if (fr.verified) ctx.out() << ", verified in " << formatMs(fr.verifyUs) << " ms";
+                        ctx.out() << " @ " << fr.sclkHz << " Hz";
+                    } else {
+                        ctx.out() << "error: " << fr.error;
+                    }
+                    ctx.out() << " (" << formatMs(fr.elapsedUs) << " ms)\n";
+                }
+                ctx.out() << ok << "/" << results.size() << " adapter(s) flashed in "
+                          << formatMs(static_cast<uint64_t>(us)) << " ms\n";
             } catch (const exception &ex) {
-                cout << "i2c_recv failed: " << ex.what() << "\n";
+                ctx.out() << "flash_all failed: " << ex.what() << "\n";
             }
         },
-        "i2c_recv <addr> <count> - read <count> bytes from I2C device");
+        "flash_all <image> [--offset N] [--hz freq] [--verify] [--no-erase] - program one image into SPI NOR flash on every FT4222 in parallel");
 
-    // i2c_scan [start] [end]
-    router.registerCommand("i2c_scan",
+    // run_all <cmd> [; <cmd> ...] - сценарий на каждом адаптере в своём потоке
+    router.registerCommand("run_all",
+        [&router](AppContext &ctx, istringstream &iss) {
+            string rest;
+            getline(iss, rest);
+            vector<string> script;
+            istringstream parts(rest);
+            string part;
+            while (getline(parts, part, ';')) {
+                const auto b = part.find_first_not_of(" \t");
+                if (b == string::npos) continue;
+                const auto e = part.find_last_not_of(" \t");
+                script.push_back(part.substr(b, e - b + 1));
+            }
+            if (script.empty()) { ctx.out() << "Usage: run_all <cmd> [; <cmd> ...]\n"; return; }
+
+            try {
+                const auto devices = DeviceCache::instance().devices();
+                if (devices.empty()) { ctx.out() << "No FT4222 devices found\n"; return; }
+
+                const auto t0 = chrono::steady_clock::now();
+                auto results = MultiDeviceRunner::run(devices,
+                    [&](FTDevice &device, const DeviceInfo &, ostream &out) {
+                        AppContext local;
+                        local.device = std::move(device);
+                        local.output = &out;
+                        for (const auto &line : script) {
+                            if (!router.execute(local, line)) break;
+                        }
+                        device = std::move(local.device);
+                    });
+                const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+
+                ctx.out() << "Ran " << script.size() << " command(s) on " << results.size()
+                          << " adapter(s) in " << formatMs(static_cast<uint64_t>(us)) << " ms\n";
+                for (const auto &r : results) {
+                    ctx.out() << "=== " << r.first << " (index " << r.second.info.index << ", "
+                              << formatMs(r.second.elapsedUs) << " ms) ===\n";
+                    if (r.second.ok) ctx.out() << r.second.output;
+                    else ctx.out() << "error: " << r.second.error << "\n";
+                }
+            } catch (const exception &ex) {
+                ctx.out() << "run_all failed: " << ex.what() << "\n";
+            }
+        },
+        "run_all <cmd> [; <cmd> ...] - run commands on every FT4222 in parallel");
+
+    // i2c_batch <op> [; <op> ...] | i2c_batch @file
+    router.registerCommand("i2c_batch",
         [](AppContext &ctx, istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            string sstart, send;
-            uint8_t start = 0x03, end = 0x77;
-            if (iss >> sstart) start = static_cast<uint8_t>(parseNumber(sstart));
-            if (iss >> send) end = static_cast<uint8_t>(parseNumber(send));
+            string rest;
+            getline(iss, rest);
+            const auto b = rest.find_first_not_of(" \t");
+            if (b == string::npos) {
+                ctx.out() << "Usage: i2c_batch <op> [; <op> ...] | i2c_batch @<file>\n"
+                          << "  op: w[:flag] <addr> <bytes...> | r[:flag] <addr> <len> | wr[:flag] <addr> <len> <bytes...>"
+                          << " | rr <addr> <len> <reg...>\n";
+                return;
+            }
+            rest.erase(0, b);
+
+            // Операции из файла (по одной на строку, '#' - комментарий) или через ';'
+            vector<string> lines;
+            if (rest[0] == '@') {
+                const auto e = rest.find_last_not_of(" \t\r");
+                ifstream in(rest.substr(1, e));
+                if (!in) { ctx.out() << "Cannot open " << rest.substr(1, e) << "\n"; return; }
+                string line;
+                while (getline(in, line)) lines.push_back(line.substr(0, line.find('#')));
+            } else {
+                istringstream parts(rest);
+                string part;
+                while (getline(parts, part, ';')) lines.push_back(part);
+            }
+
+            I2CBatch batch;
+            for (size_t i = 0; i < lines.size(); ++i) {
+                if (lines[i].find_first_not_of(" \t\r") == string::npos) continue;
+                try {
+                    parseBatchOp(lines[i], batch);
+                } catch (const exception &ex) {
+                    ctx.out() << "i2c_batch: op " << i + 1 << ": " << ex.what() << "\n";
+                    return;
+                }
+            }
+            if (batch.empty()) { ctx.out() << "No ops to run\n"; return; }
+
             try {
-                auto found = ctx.device.scanI2CBus(start, end);
-                if (found.empty()) { cout << "No devices found\n"; return; }
-                cout << "Found devices: ";
-                cout << hex;
-                for (auto a : found) cout << "0x" << setw(2) << setfill('0') << (int)a << " ";
-                cout << dec << setfill(' ') << "\n";
+                const auto t0 = chrono::steady_clock::now();
+                const auto res = ctx.device.runI2CBatch(batch);
+                const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+
+                ctx.out() << "Batch: " << batch.size() << " op(s), " << res.failed << " failed, "
+                          << formatMs(static_cast<uint64_t>(us)) << " ms\n";
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    const auto &op = batch.ops()[i];
+                    const auto &st = res.ops[i];
+                    if (st.ok && op.readLength == 0) continue;
+                    ctx.out() << "[" << i << "] 0x" << hex << setw(2) << setfill('0') << (int)op.address;
+                    if (!st.ok) {
+                        ctx.out() << dec << setfill(' ') << " failed (status=" << st.status
+                                  << ", written=" << st.written << ", read=" << st.read << ")\n";
+                        continue;
+                    }
+                    ctx.out() << ":" << uppercase;
+                    for (auto v : res.readData(i)) ctx.out() << " " << setw(2) << (int)v;
+                    ctx.out() << dec << nouppercase << setfill(' ') << "\n";
+                }
             } catch (const exception &ex) {
-                cout << "i2c_scan failed: " << ex.what() << "\n";
+                ctx.out() << "i2c_batch failed: " << ex.what() << "\n";
             }
         },
-        "i2c_scan [start] [end] - scan I2C bus for devices");
+        "i2c_batch <op>[; <op>...] | @file - run I2C ops under one lock (op: w/r/wr[:flag]|rr <addr> ...)");
 
     router.registerCommand("i2c_status",
         [](AppContext &ctx, istringstream &) {
             if (!requireConnection(ctx)) return;
             try {
                 uint8_t st = ctx.device.i2cMasterGetStatus();
-                cout << "I2C controller status: 0x" << hex << (int)st << dec << "\n";
-            } catch (const exception &ex) { cout << "i2c_status failed: " << ex.what() << "\n"; }
+                ctx.out() << "I2C controller status: 0x" << hex << (int)st << dec << "\n";
+            } catch (const exception &ex) { ctx.out() << "i2c_status failed: " << ex.what() << "\n"; }
         },
         "Show I2C controller status");
 
@@ -222,16 +1357,69 @@ void registerDeviceCommands(CommandRouter &router) {
             if (!requireConnection(ctx)) return;
             try {
                 ctx.device.i2cMasterResetBus();
-                cout << "I2C bus reset\n";
-            } catch (const exception &ex) { cout << "i2c_reset failed: " << ex.what() << "\n"; }
+                ctx.out() << "I2C bus reset\n";
+            } catch (const exception &ex) { ctx.out() << "i2c_reset failed: " << ex.what() << "\n"; }
         },
         "Reset I2C bus");
+
+    // i2c_recovery [off | <retries> [--backoff us] [--max-backoff us] [--no-bus-reset] [--chip-reset]]
+    router.registerCommand("i2c_recovery",
+        [](AppContext &ctx, istringstream &iss) {
+            const char *usage =
+                "Usage: i2c_recovery [off | <retries> [--backoff us] [--max-backoff us] [--no-bus-reset] "
+                "[--chip-reset]]\n";
+            string first;
+            if (iss >> first) {
+                I2CRecoveryPolicy policy;
+                if (first != "off") {
+                    try {
+                        policy.maxRetries = static_cast<unsigned>(parseNumber(first));
+                        string token;
+                        while (iss >> token) {
+                            string value;
+                            if (token == "--backoff" && iss >> value)
+                                policy.backoffUs = static_cast<unsigned>(parseNumber(value));
+                            else if (token == "--max-backoff" && iss >> value)
+                                policy.maxBackoffUs = static_cast<unsigned>(parseNumber(value));
+                            else if (token == "--no-bus-reset") policy.resetBus = false;
+                            else if (token == "--chip-reset") policy.resetChip = true;
+                            else throw invalid_argument("unknown option '" + token + "'");
+                        }
+                    } catch (const exception &) { ctx.out() << usage; return; }
+                }
+                ctx.device.setI2CRecoveryPolicy(policy);
+            }
+
+            const I2CRecoveryPolicy policy = ctx.device.i2cRecoveryPolicy();
+            if (!policy.enabled()) { ctx.out() << "I2C recovery: off\n"; return; }
+            ctx.out() << "I2C recovery: " << policy.maxRetries << " retries, backoff " << policy.backoffUs
+                      << ".." << policy.maxBackoffUs << " us, bus reset " << (policy.resetBus ? "on" : "off")
+                      << ", chip reset " << (policy.resetChip ? "on" : "off") << "\n";
+        },
+        "i2c_recovery [off | <retries> [--backoff us] [--max-backoff us] [--no-bus-reset] [--chip-reset]] - "
+        "retry failed I2C transfers after a bus/chip reset");
     // SPI commands
     router.registerCommand("spi_init",
         [](AppContext &ctx, std::istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            std::string modeStr = "single", clkStr = "512", polStr = "low", phaseStr = "leading";
-            iss >> modeStr >> clkStr >> polStr >> phaseStr;
+            std::string modeStr = "single", clkStr = "512", polStr = "low", phaseStr = "leading", hzStr;
+            bool force = false;
+            {
+                std::vector<std::string> positional;
+                std::string token;
+                while (iss >> token) {
+                    if (token == "--force") force = true;
+                    else if (token == "--hz" && iss >> hzStr) continue;
+                    else positional.push_back(token);
+                }
+                // С --hz делитель не задаётся: mode [pol] [phase]
+                std::string *slots[] = {&modeStr, &clkStr, &polStr, &phaseStr};
+                size_t slot = 0;
+                for (const auto &p : positional) {
+                    if (slot == 1 && !hzStr.empty()) ++slot;
+                    if (slot < 4) *slots[slot++] = p;
+                }
+            }
             try {
                 FT4222_SPIMode mode = SPI_IO_SINGLE;
                 if (!modeStr.empty()) {
@@ -240,6 +1428,23 @@ void registerDeviceCommands(CommandRouter &router) {
                     else if (c == 'q') mode = SPI_IO_QUAD;
                 }
 
+                FT4222_SPICPOL pol = CLK_IDLE_LOW;
+                if (!polStr.empty() && std::tolower(static_cast<unsigned char>(polStr[0])) == 'h') pol = CLK_IDLE_HIGH;
+
+                FT4222_SPICPHA pha = CLK_LEADING;
+                if (!phaseStr.empty() && (std::tolower(static_cast<unsigned char>(phaseStr[0])) == 't' || phaseStr[0] == '1')) pha = CLK_TRAILING;
+
+                if (!hzStr.empty()) {
+                    const uint32_t target = parseFrequencyHz(hzStr);
+                    const uint32_t hz = ctx.device.initSPIMasterHz(target, mode, pol, pha, force);
+                    const auto plan = ft4222clock::planSpi(target, ctx.device.getClockRate());
+                    ctx.mode = DeviceMode::SPI;
+                    ctx.out() << "SPI initialized: mode=" << modeStr << " sclk=" << hz << " Hz (requested "
+                              << target << ", sys " << ft4222clock::systemClockHz(plan.clock) / 1000000
+                              << " MHz / " << ft4222clock::spiDividerValue(plan.divider) << ")\n";
+                    return;
+                }
+
                 unsigned long cd = parseNumber(clkStr);
                 FTDevice::SPIClockDivider div = FTDevice::SPIClockDivider::DIV_512;
                 switch (cd) {
@@ -252,72 +1457,112 @@ void registerDeviceCommands(CommandRouter &router) {
                     case 128: div = FTDevice::SPIClockDivider::DIV_128; break;
                     case 256: div = FTDevice::SPIClockDivider::DIV_256; break;
                     case 512: div = FTDevice::SPIClockDivider::DIV_512; break;
-                    default: cout << "Unsupported clock divider, use 2/4/8/16/32/64/128/256/512\n"; return;
+                    default: ctx.out() << "Unsupported clock divider, use 2/4/8/16/32/64/128/256/512\n"; return;
                 }
 
-                FT4222_SPICPOL pol = CLK_IDLE_LOW;
-                if (!polStr.empty() && std::tolower(static_cast<unsigned char>(polStr[0])) == 'h') pol = CLK_IDLE_HIGH;
-
-                FT4222_SPICPHA pha = CLK_LEADING;
-                if (!phaseStr.empty() && (std::tolower(static_cast<unsigned char>(phaseStr[0])) == 't' || phaseStr[0] == '1')) pha = CLK_TRAILING;
-
-                ctx.device.initSPIMaster(mode, div, pol, pha);
+                const bool applied = ctx.device.initSPIMaster(mode, div, pol, pha, force);
                 ctx.mode = DeviceMode::SPI;
-                cout << "SPI initialized: mode=" << modeStr << " clkDiv=" << cd << "\n";
+                ctx.out() << (applied ? "SPI initialized: mode=" : "SPI already initialized: mode=")
+                          << modeStr << " clkDiv=" << cd << "\n";
             } catch (const exception &ex) {
-                cout << "spi_init failed: " << ex.what() << "\n";
+                ctx.out() << "spi_init failed: " << ex.what() << "\n";
             }
         },
-        "Initialize SPI master [mode: single|dual|quad] [clkDiv: 2..512] [pol: low|high] [phase: leading|trailing]");
+        "Initialize SPI master [mode: single|dual|quad] [clkDiv: 2..512 | --hz freq] [pol: low|high] [phase: leading|trailing] [--force]");
+
+    registerParsedCommand<PayloadArgs>(router, "spi_send", parseSpiSend, runSpiSend,
+        "spi_send <hex-bytes...> [@file] - write data over SPI (a trailing @file is memory-mapped, CS held across)");
 
-    router.registerCommand("spi_send",
+    registerParsedCommand<CountArgs>(router, "spi_recv", parseSpiRecv, runSpiRecv,
+        "spi_recv <count> [>file] - read <count> bytes from SPI (>file: straight into a mapped file)");
+
+    router.registerCommand("spi_stream",
         [](AppContext &ctx, std::istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            std::vector<unsigned long> bytes;
-            std::string token;
-            while (iss >> token) {
-                try { bytes.push_back(parseNumber(token)); } catch (const exception &) { cout << "Invalid byte: " << token << "\n"; return; }
+            std::string chunkStr, limitStr, path, opt;
+            if (!(iss >> chunkStr >> limitStr >> path)) {
+                ctx.out() << "Usage: spi_stream <chunk> <total|duration> <file> [--buffers N]\n";
+                return;
             }
-            if (bytes.empty()) { cout << "Usage: spi_send <hex-bytes...>\n"; return; }
+            SpiStreamOptions options;
             try {
-                std::vector<uint8_t> data; data.reserve(bytes.size()); for (auto b : bytes) data.push_back(static_cast<uint8_t>(b & 0xFF));
-                ctx.device.spiMasterSingleWrite(data);
-                cout << "SPI wrote " << data.size() << " bytes\n";
-            } catch (const exception &ex) { cout << "spi_send failed: " << ex.what() << "\n"; }
-        },
-        "spi_send <hex-bytes...> - write data over SPI");
+                options.chunkSize = static_cast<size_t>(parseByteCount(chunkStr));
+                options.durationMs = parseDurationMs(limitStr);
+                if (options.durationMs == 0) options.totalBytes = parseByteCount(limitStr);
+                while (iss >> opt) {
+                    std::string n;
+                    if (opt == "--buffers" && iss >> n) options.bufferCount = static_cast<size_t>(std::stoul(n));
+                    else { ctx.out() << "Unknown option: " << opt << "\n"; return; }
+                }
+                if (options.chunkSize == 0 || options.chunkSize > 16 * 1024 * 1024) {
+                    ctx.out() << "Chunk size must be 1..16M\n";
+                    return;
+                }
+            } catch (const exception &) {
+                ctx.out() << "Invalid size or duration (examples: 4096, 64K, 16M, 500ms, 10s)\n";
+                return;
+            }
 
-    router.registerCommand("spi_recv",
-        [](AppContext &ctx, std::istringstream &iss) {
-            if (!requireConnection(ctx)) return;
-            size_t count = 0;
-            if (!(iss >> count)) { cout << "Usage: spi_recv <count>\n"; return; }
-            try {
-                auto data = ctx.device.spiMasterSingleRead(count);
-                cout << "Read " << data.size() << " bytes: ";
-                cout << std::hex;
-                for (auto b : data) cout << std::uppercase << std::setw(2) << std::setfill('0') << (int)b << " ";
-                cout << std::dec << std::setfill(' ') << "\n";
-            } catch (const exception &ex) { cout << "spi_recv failed: " << ex.what() << "\n"; }
+            try {
+                // Известный объём — захват прямо в отображённый файл; по времени — кольцо
+                // буферов и поток записи
+                SpiStreamStats st;
+                if (options.totalBytes) {
+                    MappedFile file = MappedFile::create(path, static_cast<size_t>(options.totalBytes));
+                    try { st = SpiStreamCapture::run(ctx.device, file.writableBytes(), options); }
+                    catch (...) { std::remove(path.c_str()); throw; }
+                    file.truncate(static_cast<size_t>(st.bytesWritten));
+                } else {
+                    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                    if (!file) { ctx.out() << "Cannot open " << path << "\n"; return; }
+                    st = SpiStreamCapture::run(ctx.device, file, options);
+                }
+                ctx.out() << "Captured " << st.bytesWritten << " bytes to " << path << " in "
+                          << formatMs(st.elapsedUs) << " ms (" << std::fixed << std::setprecision(2)
+                          << st.megabytesPerSecond() << std::defaultfloat << " MB/s)\n"
+                          << "Chunks: " << st.chunks << ", short: " << st.shortChunks
+                          << ", dropped: " << st.droppedChunks << "\n";
+            } catch (const exception &ex) { ctx.out() << "spi_stream failed: " << ex.what() << "\n"; }
         },
-        "spi_recv <count> - read <count> bytes from SPI");
+        "spi_stream <chunk> <total|duration> <file> [--buffers N] - capture SPI reads to a binary file");
+
+    registerParsedCommand<PayloadArgs>(router, "spi_xfer", parseSpiXfer, runSpiXfer,
+        "spi_xfer <hex-bytes...> [@file] [>file] - write and read simultaneously over SPI");
 
-    router.registerCommand("spi_xfer",
+    router.registerCommand("spi_mxfer",
         [](AppContext &ctx, std::istringstream &iss) {
             if (!requireConnection(ctx)) return;
-            std::vector<unsigned long> bytes; std::string token;
-            while (iss >> token) { try { bytes.push_back(parseNumber(token)); } catch (const exception &) { cout << "Invalid byte: " << token << "\n"; return; } }
-            if (bytes.empty()) { cout << "Usage: spi_xfer <hex-bytes...>\n"; return; }
-            try {
-                std::vector<uint8_t> data; data.reserve(bytes.size()); for (auto b : bytes) data.push_back(static_cast<uint8_t>(b & 0xFF));
-                auto out = ctx.device.spiMasterSingleReadWrite(data);
-                cout << "Received " << out.size() << " bytes: ";
-                cout << std::hex;
-                for (auto b : out) cout << std::uppercase << std::setw(2) << std::setfill('0') << (int)b << " ";
-                cout << std::dec << std::setfill(' ') << "\n";
-            } catch (const exception &ex) { cout << "spi_xfer failed: " << ex.what() << "\n"; }
+            const char *usage = "Usage: spi_mxfer <cmd-bytes...> [-d <dummy-cycles>] [-w <data-bytes...>] [-r <read-len>]\n";
+            std::vector<uint8_t> single, multi;
+            std::vector<uint8_t> *target = &single;
+            unsigned long dummy = 0, readLen = 0;
+            std::string token;
+            try {
+                while (iss >> token) {
+                    if (token == "-d" || token == "-r") {
+                        std::string n;
+                        if (!(iss >> n)) { ctx.out() << usage; return; }
+                        (token == "-d" ? dummy : readLen) = std::stoul(n);
+                    } else if (token == "-w") {
+                        target = &multi;
+                    } else {
+                        std::string error;
+                        if (!appendBytes(token, *target, &error)) { ctx.out() << error << "\n"; return; }
+                    }
+                }
+            } catch (const exception &) { ctx.out() << "Invalid argument: " << token << "\n"; return; }
+            if (single.empty() && multi.empty() && readLen == 0) { ctx.out() << usage; return; }
+            try {
+                auto out = ctx.device.spiMasterMultiReadWrite(single, multi, readLen,
+                                                              static_cast<unsigned>(dummy));
+                ctx.out() << "Multi-I/O: sent " << single.size() << "+" << multi.size()
+                          << " bytes, received " << out.size() << " bytes";
+                if (!out.empty()) ctx.out() << ": " << std::hex;
+                for (auto b : out) ctx.out() << std::uppercase << std::setw(2) << std::setfill('0') << (int)b << " ";
+                ctx.out() << std::dec << std::setfill(' ') << "\n";
+            } catch (const exception &ex) { ctx.out() << "spi_mxfer failed: " << ex.what() << "\n"; }
         },
-        "spi_xfer <hex-bytes...> - write and read simultaneously over SPI");
+        "spi_mxfer <cmd-bytes...> [-d cycles] [-w <bytes...>] [-r len] - dual/quad SPI transfer (command on one line, data on 2/4)");
 
     router.registerCommand("spi_status",
         [](AppContext &ctx, std::istringstream &) {
@@ -331,9 +1576,9 @@ void registerDeviceCommands(CommandRouter &router) {
                     case FTDevice::Mode::GPIO: s = "GPIO"; break;
                     default: s = "Unknown"; break;
                 }
-                cout << "Device mode: " << s << "\n";
-                cout << "Version: " << ctx.device.getVersionString() << "\n";
-            } catch (const exception &ex) { cout << "spi_status failed: " << ex.what() << "\n"; }
+                ctx.out() << "Device mode: " << s << "\n";
+                ctx.out() << "Version: " << ctx.device.getVersionString() << "\n";
+            } catch (const exception &ex) { ctx.out() << "spi_status failed: " << ex.what() << "\n"; }
         },
         "Show SPI/device status");
 
@@ -346,44 +1591,116 @@ void registerDeviceCommands(CommandRouter &router) {
                 char c = std::tolower(static_cast<unsigned char>(s[0]));
                 return (c == 'o' || c == '1') ? GPIO_OUTPUT : GPIO_INPUT;
             };
-            std::string d0,d1,d2,d3;
-            iss >> d0 >> d1 >> d2 >> d3;
+            std::string d[4], token;
+            bool force = false;
+            size_t n = 0;
+            while (iss >> token) {
+                if (token == "--force") force = true;
+                else if (n < 4) d[n++] = token;
+            }
             try {
-                ctx.device.initGPIO(parseDir(d0), parseDir(d1), parseDir(d2), parseDir(d3));
+                const bool applied = ctx.device.initGPIO(parseDir(d[0]), parseDir(d[1]), parseDir(d[2]),
+                                                         parseDir(d[3]), force);
                 ctx.mode = DeviceMode::GPIO;
-                cout << "GPIO initialized\n";
-            } catch (const exception &ex) { cout << "gpio_init failed: " << ex.what() << "\n"; }
+                ctx.out() << (applied ? "GPIO initialized\n" : "GPIO already initialized\n");
+            } catch (const exception &ex) { ctx.out() << "gpio_init failed: " << ex.what() << "\n"; }
         },
-        "gpio_init [d0 d1 d2 d3] - each: in/out (default in)");
+        "gpio_init [d0 d1 d2 d3] [--force] - each: in/out (default in)");
 
-    router.registerCommand("gpio_read",
-        [](AppContext &ctx, std::istringstream &iss) {
-            if (!requireConnection(ctx)) return;
-            int port = 0; if (!(iss >> port)) { cout << "Usage: gpio_read <port 0-3>\n"; return; }
-            try { bool v = ctx.device.readGPIO(static_cast<GPIO_Port>(port)); cout << "GPIO" << port << " = " << (v?"1":"0") << "\n"; } catch (const exception &ex) { cout << "gpio_read failed: " << ex.what() << "\n"; }
-        },
+    registerParsedCommand<GpioArgs>(router, "gpio_read", parseGpioRead, runGpioRead,
         "gpio_read <port> - read GPIO port (0-3)");
 
-    router.registerCommand("gpio_write",
-        [](AppContext &ctx, std::istringstream &iss) {
-            if (!requireConnection(ctx)) return;
-            int port; int val; if (!(iss >> port >> val)) { cout << "Usage: gpio_write <port 0-3> <0|1>\n"; return; }
-            try { ctx.device.writeGPIO(static_cast<GPIO_Port>(port), val?true:false); cout << "GPIO" << port << " set to " << val << "\n"; } catch (const exception &ex) { cout << "gpio_write failed: " << ex.what() << "\n"; }
-        },
+    registerParsedCommand<GpioArgs>(router, "gpio_write", parseGpioWrite, runGpioWrite,
         "gpio_write <port> <0|1> - set GPIO port (0-3)");
 
     router.registerCommand("gpio_status",
         [](AppContext &ctx, std::istringstream &) {
             if (!requireConnection(ctx)) return;
             try {
-                cout << "GPIO states: ";
-                for (int p = 0; p < 4; ++p) {
-                    bool v = ctx.device.readGPIO(static_cast<GPIO_Port>(p));
-                    cout << "P" << p << ":" << (v?"1":"0") << " ";
-                }
-                cout << "\n";
-            } catch (const exception &ex) { cout << "gpio_status failed: " << ex.what() << "\n"; }
+                const uint8_t levels = ctx.device.readGPIOPorts();
+                ctx.out() << "GPIO states: ";
+                for (int p = 0; p < 4; ++p)
+                    ctx.out() << "P" << p << ":" << ((levels >> p) & 1) << " ";
+                ctx.out() << "\n";
+            } catch (const exception &ex) { ctx.out() << "gpio_status failed: " << ex.what() << "\n"; }
         },
         "gpio_status - read all gpio ports");
+
+    // gpio_sample <rate|max> <duration> <file> - выборка всех выводов по расписанию в файл
+    router.registerCommand("gpio_sample",
+        [](AppContext &ctx, std::istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            std::string rateStr, durationStr, path;
+            if (!(iss >> rateStr >> durationStr >> path)) {
+                ctx.out() << "Usage: gpio_sample <rate Hz|10k|max> <duration ms|s> <file>\n";
+                return;
+            }
+            GpioSampleOptions options;
+            try {
+                if (rateStr == "max") {
+                    options.rateHz = 0;
+                } else {
+                    size_t pos = 0;
+                    unsigned long rate = std::stoul(rateStr, &pos, 10);
+                    const std::string suffix = rateStr.substr(pos);
+                    if (suffix == "k" || suffix == "K") rate *= 1000;
+                    else if (!suffix.empty()) throw invalid_argument(rateStr);
+                    if (rate == 0 || rate > 10000000) throw invalid_argument(rateStr);
+                    options.rateHz = static_cast<uint32_t>(rate);
+                }
+                options.durationMs = parseDurationMs(durationStr);
+                if (options.durationMs == 0) throw invalid_argument(durationStr);
+            } catch (const exception &) {
+                ctx.out() << "Invalid rate or duration (examples: 1000, 10k, max; 500ms, 10s)\n";
+                return;
+            }
+
+            try {
+                const GpioCapture cap = GpioSampler::run(ctx.device, options);
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                if (!file) { ctx.out() << "Cannot open " << path << "\n"; return; }
+                cap.write(file);
+                ctx.out() << "Sampled " << cap.size() << " x 4 ports to " << path << " in "
+                          << formatMs(cap.elapsedUs) << " ms: " << std::fixed << std::setprecision(1)
+                          << cap.achievedHz() << " Hz";
+                if (options.rateHz) ctx.out() << " (requested " << options.rateHz << ")";
+                ctx.out() << "\nJitter: mean " << cap.jitter.meanUs << " us, rms " << cap.jitter.rmsUs
+                          << " us, max " << cap.jitter.maxUs << " us" << std::defaultfloat
+                          << ", missed slots: " << cap.missedSlots << "\n";
+            } catch (const exception &ex) { ctx.out() << "gpio_sample failed: " << ex.what() << "\n"; }
+        },
+        "gpio_sample <rate|max> <duration> <file> - sample all GPIO ports into a binary file (rate, jitter report)");
+
+    // gpio_play <pattern-file> [--loop N] - воспроизведение временной диаграммы на выходах
+    router.registerCommand("gpio_play",
+        [](AppContext &ctx, std::istringstream &iss) {
+            if (!requireConnection(ctx)) return;
+            std::string path, opt;
+            if (!(iss >> path)) {
+                ctx.out() << "Usage: gpio_play <pattern-file> [--loop N]\n";
+                return;
+            }
+            unsigned long loops = 1;
+            while (iss >> opt) {
+                std::string n;
+                if (opt == "--loop" && iss >> n) {
+                    try { loops = std::stoul(n); } catch (const exception &) { loops = 0; }
+                    if (loops == 0) { ctx.out() << "Invalid loop count: " << n << "\n"; return; }
+                } else { ctx.out() << "Unknown option: " << opt << "\n"; return; }
+            }
+
+            std::ifstream file(path);
+            if (!file) { ctx.out() << "Cannot open " << path << "\n"; return; }
+            try {
+                const GpioPattern pattern = GpioPattern::parse(file, path);
+                if (pattern.steps.empty()) { ctx.out() << "Pattern is empty\n"; return; }
+                const GpioPlayStats st = GpioPlayer::run(ctx.device, pattern, static_cast<unsigned>(loops));
+                ctx.out() << "Played " << st.steps << " step(s) in " << formatMs(st.elapsedUs) << " ms"
+                          << std::fixed << std::setprecision(1)
+                          << "\nJitter: mean " << st.jitter.meanUs << " us, rms " << st.jitter.rmsUs
+                          << " us, max " << st.jitter.maxUs << " us" << std::defaultfloat << "\n";
+            } catch (const exception &ex) { ctx.out() << "gpio_play failed: " << ex.what() << "\n"; }
+        },
+        "gpio_play <pattern-file> [--loop N] - replay timed GPIO output pattern (\"<time> <port>=<0|1> ...\")");
 }
 
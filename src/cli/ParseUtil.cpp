@@ -1,19 +1,156 @@
 #include "ParseUtil.hpp"
 
 #include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 
+namespace {
+
+bool isHexDigit(char c) {
+    return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+bool hasHexPrefix(std::string_view s) {
+    return s.size() > 1 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Ровно два (или одна) hex-цифры -> байт
+bool parseHexByte(std::string_view s, uint8_t &byte) {
+    if (s.empty() || s.size() > 2) return false;
+    unsigned v = 0;
+    for (char c : s) {
+        const int d = hexValue(c);
+        if (d < 0) return false;
+        v = (v << 4) | static_cast<unsigned>(d);
+    }
+    byte = static_cast<uint8_t>(v);
+    return true;
+}
+
+bool fail(std::string *error, std::string message) {
+    if (error) *error = std::move(message);
+    return false;
+}
+
+bool appendFile(std::string_view path, std::vector<uint8_t> &out, std::string *error) {
+    std::ifstream file(std::string(path), std::ios::binary | std::ios::ate);
+    if (!file) return fail(error, "Cannot open " + std::string(path));
+    const std::streamoff size = file.tellg();
+    file.seekg(0);
+    const size_t old = out.size();
+    out.resize(old + static_cast<size_t>(size));
+    if (size > 0 && !file.read(reinterpret_cast<char *>(out.data() + old), size)) {
+        out.resize(old);
+        return fail(error, "Cannot read " + std::string(path));
+    }
+    return true;
+}
+
+} // namespace
+
+bool tryParseNumber(std::string_view s, unsigned long &value) noexcept {
+    if (s.empty()) return false;
+    bool hex = hasHexPrefix(s);
+    if (hex) {
+        s.remove_prefix(2);
+    } else {
+        for (char c : s) {
+            if (std::isalpha(static_cast<unsigned char>(c))) {
+                hex = true;
+                break;
+            }
+        }
+    }
+    if (s.empty()) return false;
+    const auto res = std::from_chars(s.data(), s.data() + s.size(), value, hex ? 16 : 10);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
 unsigned long parseNumber(const std::string &s) {
     if (s.empty()) throw std::invalid_argument("empty");
-    bool hasHexChar = false;
-    for (char c : s) {
-        if (std::isalpha(static_cast<unsigned char>(c))) {
-            hasHexChar = true;
-            break;
+    unsigned long value = 0;
+    if (tryParseNumber(s, value)) return value;
+    // Отличаем переполнение от неверного формата, как std::stoul
+    std::string_view digits(s);
+    if (hasHexPrefix(digits)) digits.remove_prefix(2);
+    bool allDigits = !digits.empty();
+    for (char c : digits) allDigits = allDigits && isHexDigit(c);
+    if (allDigits) throw std::out_of_range("number out of range: " + s);
+    throw std::invalid_argument("invalid number: " + s);
+}
+
+bool appendBytes(std::string_view token, std::vector<uint8_t> &out, std::string *error) {
+    if (token.empty()) return fail(error, "Invalid byte: (empty)");
+
+    if (token[0] == '@') return appendFile(token.substr(1), out, error);
+
+    const size_t old = out.size();
+    if (token.find(':') != std::string_view::npos) {
+        std::string_view rest = token;
+        for (;;) {
+            const size_t colon = rest.find(':');
+            uint8_t byte = 0;
+            if (!parseHexByte(rest.substr(0, colon), byte)) {
+                out.resize(old);
+                return fail(error, "Invalid byte: " + std::string(token));
+            }
+            out.push_back(byte);
+            if (colon == std::string_view::npos) break;
+            rest.remove_prefix(colon + 1);
+        }
+        return true;
+    }
+
+    std::string_view digits = token;
+    const bool prefixed = hasHexPrefix(digits);
+    if (prefixed) digits.remove_prefix(2);
+    bool hasLetter = false;
+    bool allHex = !digits.empty();
+    for (char c : digits) {
+        allHex = allHex && isHexDigit(c);
+        hasLetter = hasLetter || std::isalpha(static_cast<unsigned char>(c));
+    }
+
+    // Hex-блоб: "DEADBEEF", "0x0102"; короткие и десятичные токены — одиночные числа
+    if (allHex && (prefixed || hasLetter) && digits.size() > 2) {
+        if (digits.size() % 2 != 0)
+            return fail(error, "Hex blob needs an even number of digits: " + std::string(token));
+        out.reserve(old + digits.size() / 2);
+        for (size_t i = 0; i < digits.size(); i += 2)
+            out.push_back(static_cast<uint8_t>((hexValue(digits[i]) << 4) | hexValue(digits[i + 1])));
+        return true;
+    }
+
+    unsigned long value = 0;
+    if (!tryParseNumber(token, value)) return fail(error, "Invalid byte: " + std::string(token));
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    return true;
+}
+
+bool parseByteList(std::string_view text, std::vector<uint8_t> &out, std::string *error) {
+    const size_t old = out.size();
+    // Верхняя оценка для обычных токенов: каждый байт занимает хотя бы два символа с разделителем
+    out.reserve(old + text.size() / 2 + 1);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+        size_t end = pos;
+        while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))) ++end;
+        if (end > pos && !appendBytes(text.substr(pos, end - pos), out, error)) {
+            out.resize(old);
+            return false;
         }
+        pos = end;
     }
-    const int base = hasHexChar || (s.size() > 1 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
-                         ? 16
-                         : 10;
-    return std::stoul(s, nullptr, base);
+    return true;
 }
@@ -1,5 +1,24 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
+// Число: десятичное, либо шестнадцатеричное, если есть буква или префикс 0x.
+// Бросает std::invalid_argument (пусто/неверный формат) или std::out_of_range.
 unsigned long parseNumber(const std::string &s);
+
+// То же без исключений: false при пустой строке, лишних символах или переполнении.
+bool tryParseNumber(std::string_view s, unsigned long &value) noexcept;
+
+// Дописать в out байты одного токена полезной нагрузки:
+//   "42", "ff", "0x1F"   — число как у parseNumber, в out идёт младший байт;
+//   "DEADBEEF", "0xdead" — hex-блоб (есть буква или 0x и больше двух цифр), байты по порядку;
+//   "de:ad:be:ef"        — байты в hex через двоеточие;
+//   "@file.bin"          — содержимое файла как есть.
+// При ошибке возвращает false, out остаётся прежним, в error (если задан) — текст ошибки.
+bool appendBytes(std::string_view token, std::vector<uint8_t> &out, std::string *error = nullptr);
+
+// Разобрать все токены text (через пробелы) функцией appendBytes в один проход.
+bool parseByteList(std::string_view text, std::vector<uint8_t> &out, std::string *error = nullptr);
@@ -0,0 +1,110 @@
+#include "Script.hpp"
+
+#include <limits>
+
+namespace {
+
+std::string trim(const std::string &s) {
+    const auto first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return {};
+    const auto last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+} // namespace
+
+ScriptPlan ScriptPlan::compile(const CommandRouter &router, std::istream &text,
+                               const std::string &source) {
+    ScriptPlan plan;
+    std::vector<std::pair<size_t, size_t>> open; // (индекс RepeatBegin, строка)
+    std::string raw;
+    size_t lineNo = 0;
+
+    while (std::getline(text, raw)) {
+        ++lineNo;
+        const auto hash = raw.find('#');
+        const std::string line = trim(hash == std::string::npos ? raw : raw.substr(0, hash));
+        if (line.empty())
+            continue;
+
+        if (line == "}") {
+            if (open.empty())
+                throw ScriptError(source, lineNo, "unexpected '}'");
+            const size_t begin = open.back().first;
+            open.pop_back();
+            plan.m_ops.push_back({OpKind::RepeatEnd, static_cast<uint32_t>(begin), 0});
+            plan.m_ops[begin].jump = static_cast<uint32_t>(plan.m_ops.size());
+            continue;
+        }
+
+        std::istringstream iss(line);
+        std::string word;
+        iss >> word;
+        if (word == "repeat") {
+            std::string countStr, brace, extra;
+            if (!(iss >> countStr >> brace) || brace != "{" || (iss >> extra))
+                throw ScriptError(source, lineNo, "expected 'repeat <N> {'");
+            unsigned long count = 0;
+            try {
+                size_t pos = 0;
+                count = std::stoul(countStr, &pos, 10);
+                if (pos != countStr.size())
+                    throw std::invalid_argument(countStr);
+            } catch (const std::exception &) {
+                throw ScriptError(source, lineNo, "invalid repeat count '" + countStr + "'");
+            }
+            if (count > std::numeric_limits<uint32_t>::max())
+                throw ScriptError(source, lineNo, "repeat count is too large");
+            open.emplace_back(plan.m_ops.size(), lineNo);
+            plan.m_ops.push_back({OpKind::RepeatBegin, static_cast<uint32_t>(count), 0});
+            continue;
+        }
+
+        PreparedCommand cmd;
+        try {
+            cmd = router.compile(line);
+        } catch (const std::exception &ex) {
+            throw ScriptError(source, lineNo, ex.what());
+        }
+        plan.m_ops.push_back({OpKind::Command, static_cast<uint32_t>(plan.m_commands.size()), 0});
+        plan.m_commands.push_back(std::move(cmd));
+    }
+
+    if (!open.empty())
+        throw ScriptError(source, open.back().second, "'repeat' block is not closed");
+    return plan;
+}
+
+void ScriptPlan::run(AppContext &ctx, const std::function<bool()> &keepRunning) const {
+    // Оставшееся число проходов для каждого активного repeat (по глубине вложенности)
+    std::vector<uint32_t> remaining;
+    size_t pc = 0;
+    while (pc < m_ops.size()) {
+        const Op &op = m_ops[pc];
+        switch (op.kind) {
+        case OpKind::Command:
+            m_commands[op.arg](ctx);
+            if (keepRunning && !keepRunning())
+                return;
+            ++pc;
+            break;
+        case OpKind::RepeatBegin:
+            if (op.arg == 0) {
+                pc = op.jump;
+            } else {
+                remaining.push_back(op.arg);
+                ++pc;
+            }
+            break;
+        case OpKind::RepeatEnd:
+            if (--remaining.back() != 0) {
+                pc = op.arg + 1;
+            } else {
+                remaining.pop_back();
+                ++pc;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CommandRouter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Ошибка компиляции скрипта; what() содержит "<source>:<line>: <message>"
+class ScriptError : public std::runtime_error {
+public:
+    ScriptError(const std::string &source, size_t line, const std::string &message)
+        : std::runtime_error(source + ":" + std::to_string(line) + ": " + message), m_line(line) {}
+
+    size_t line() const { return m_line; }
+
+private:
+    size_t m_line;
+};
+
+// Скомпилированный скрипт: команды разобраны один раз, блоки repeat развёрнуты
+// в переходы по индексам, поэтому выполнение не трогает текст.
+//
+// Синтаксис: одна команда на строку, '#' — комментарий до конца строки,
+//   repeat <N> {
+//       ...
+//   }
+class ScriptPlan {
+public:
+    // Разобрать и проверить весь скрипт; бросает ScriptError с номером строки
+    static ScriptPlan compile(const CommandRouter &router, std::istream &text,
+                              const std::string &source = "<script>");
+
+    // Выполнить план; keepRunning проверяется после каждой команды (например, после exit)
+    void run(AppContext &ctx, const std::function<bool()> &keepRunning = nullptr) const;
+
+    // Количество команд в плане (без учёта повторов)
+    size_t commandCount() const { return m_commands.size(); }
+
+private:
+    enum class OpKind : uint8_t { Command, RepeatBegin, RepeatEnd };
+
+    struct Op {
+        OpKind kind;
+        uint32_t arg;   // Command: индекс в m_commands; RepeatBegin: N; RepeatEnd: индекс RepeatBegin
+        uint32_t jump;  // RepeatBegin: индекс после соответствующего RepeatEnd
+    };
+
+    std::vector<Op> m_ops;
+    std::vector<PreparedCommand> m_commands;
+};
@@ -0,0 +1,211 @@
+#include "Server.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+std::atomic<bool> g_signalled{false};
+
+void onSignal(int) {
+    g_signalled = true;
+}
+
+std::string jsonEscape(const std::string &s) {
+    std::string out;
+    out.reserve(s.size() + 8);
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+bool SessionServer::sendAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool SessionServer::handleLine(int fd, const std::string &line, Mode &mode) {
+    if (line == "exit" || line == "quit") return false;
+    if (line == ".mode json") { mode = Mode::Json; return true; }
+    if (line == ".mode binary") { mode = Mode::Binary; return true; }
+    if (line == ".shutdown") {
+        m_stop = true;
+        return false;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::ostringstream out;
+    bool ok = true;
+    const auto start = Clock::now();
+    if (line != ".ping") {
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+        std::ostream *saved = m_ctx.output;
+        m_ctx.output = &out;
+        try {
+            ok = m_router.execute(m_ctx, line);
+        } catch (const std::exception &ex) {
+            out << "error: " << ex.what() << "\n";
+            ok = false;
+        }
+        m_ctx.output = saved;
+    }
+    const auto elapsedUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+    return sendReply(fd, mode, ok, out.str(), elapsedUs);
+}
+
+bool SessionServer::sendReply(int fd, Mode mode, bool ok, const std::string &text,
+                              long long elapsedUs) {
+    if (mode == Mode::Binary) {
+        const uint32_t len = static_cast<uint32_t>(text.size());
+        const char header[5] = {static_cast<char>(len & 0xFF), static_cast<char>((len >> 8) & 0xFF),
+                                static_cast<char>((len >> 16) & 0xFF),
+                                static_cast<char>((len >> 24) & 0xFF), static_cast<char>(ok ? 1 : 0)};
+        return sendAll(fd, header, sizeof(header)) && sendAll(fd, text.data(), text.size());
+    }
+
+    std::string reply = std::string("{\"ok\":") + (ok ? "true" : "false") + ",\"output\":\"" +
+                        jsonEscape(text) + "\",\"elapsed_us\":" + std::to_string(elapsedUs) + "}\n";
+    return sendAll(fd, reply.data(), reply.size());
+}
+
+void SessionServer::serveClient(int fd) {
+    Mode mode = Mode::Json;
+    std::string pending;
+    char buf[4096];
+
+    while (!m_stop) {
+        pollfd pfd{fd, POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, 200);
+        if (ready < 0) break;
+        if (ready == 0) continue;
+
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        pending.append(buf, static_cast<size_t>(n));
+
+        size_t start = 0;
+        bool keep = true;
+        for (size_t nl; keep && (nl = pending.find('\n', start)) != std::string::npos; start = nl + 1) {
+            std::string line = pending.substr(start, nl - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            keep = handleLine(fd, line, mode);
+        }
+        pending.erase(0, start);
+        if (!keep) break;
+        if (pending.size() > kMaxLineBytes) {
+            sendReply(fd, mode, false, "error: command line exceeds " +
+                                           std::to_string(kMaxLineBytes) + " bytes\n", 0);
+            break;
+        }
+    }
+    ::close(fd);
+}
+
+int SessionServer::run(const std::string &path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path is too long: " << path << "\n";
+        return 1;
+    }
+
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path.c_str());
+    if (::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listenFd, 16) < 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        ::close(listenFd);
+        return 1;
+    }
+
+    g_signalled = false;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cerr << "Serving on " << path << " (Ctrl+C or .shutdown to stop)\n";
+
+    struct Client {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Client> clients;
+
+    while (!m_stop && !g_signalled) {
+        // Завершившиеся соединения убираем сразу, чтобы короткие клиенты не копились
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (*it->done) {
+                it->thread.join();
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd pfd{listenFd, POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, 200);
+        if (ready <= 0) continue;
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        clients.push_back({std::thread([this, fd, done] {
+                               serveClient(fd);
+                               *done = true;
+                           }),
+                           done});
+    }
+
+    // Клиентские потоки замечают m_stop в течение одного интервала poll
+    m_stop = true;
+    for (auto &c : clients) c.thread.join();
+    ::close(listenFd);
+    ::unlink(path.c_str());
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CommandRouter.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Сервер сессии: держит одно открытое и настроенное устройство (AppContext) и
+// выполняет команды CommandRouter от многих клиентов через Unix-сокет.
+//
+// Протокол: клиент шлёт строки команд, завершённые '\n'. Служебные строки:
+//   .mode json    — ответ: одна строка {"ok":true,"output":"...","elapsed_us":N}\n (по умолчанию)
+//   .mode binary  — ответ: uint32 LE длина вывода, uint8 статус (1 — ok), затем вывод
+//   .ping         — пустой успешный ответ (проверка связи)
+//   .shutdown     — остановить сервер
+//   exit / quit   — закрыть своё соединение
+// Строка длиннее kMaxLineBytes без '\n' получает ответ-ошибку, и соединение закрывается.
+// Каждый клиент обслуживается своим потоком; команды выполняются по одной под
+// мьютексом сессии, поэтому устройство никогда не используется параллельно.
+class SessionServer {
+public:
+    // Наибольшая длина строки команды; больше — клиент не получает бесконечного буфера
+    static constexpr size_t kMaxLineBytes = 64 * 1024;
+
+    SessionServer(CommandRouter &router, AppContext &ctx) : m_router(router), m_ctx(ctx) {}
+
+    // Слушать path до .shutdown или SIGINT/SIGTERM; возвращает код завершения процесса
+    int run(const std::string &path);
+
+    void stop() { m_stop = true; }
+
+private:
+    enum class Mode { Json, Binary };
+
+    void serveClient(int fd);
+    // Выполнить строку; возвращает false, если соединение нужно закрыть
+    bool handleLine(int fd, const std::string &line, Mode &mode);
+    // Ответ в формате режима (JSON-строка или двоичный заголовок + вывод)
+    static bool sendReply(int fd, Mode mode, bool ok, const std::string &text, long long elapsedUs);
+    static bool sendAll(int fd, const char *data, size_t size);
+
+    CommandRouter &m_router;
+    AppContext &m_ctx;
+    std::mutex m_sessionMutex;
+    std::atomic<bool> m_stop{false};
+};
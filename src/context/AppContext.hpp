@@ -2,6 +2,8 @@
 
 #include "ft4222/ft4222.hpp"
 
+#include <iostream>
+
 enum class DeviceMode {
     None,
     I2C,
@@ -9,11 +11,23 @@ enum class DeviceMode {
     GPIO
 };
 
+// Формат вывода прочитанных данных (i2c_recv, i2c_rr, spi_recv, spi_xfer)
+enum class OutputMode {
+    Hex,    // "Read N bytes: AA BB CC"
+    Raw,    // байты как есть, без текста (для конвейера в другие программы)
+    Json,   // одна строка JSON на команду
+    Hexdump // смещение, 16 байт и ASCII в строке, как hexdump -C
+};
+
 struct AppContext {
     FTDevice device;
     DeviceMode mode = DeviceMode::None;
+    OutputMode outputMode = OutputMode::Hex;
+    std::ostream *output = &std::cout; // куда команды пишут результат (stdout или буфер)
 
     bool isConnected() const { return device.isOpen(); }
 
+    std::ostream &out() const { return *output; }
+
     void reset() { mode = DeviceMode::None; }
 };
@@ -0,0 +1,102 @@
+#include "AsyncDevice.hpp"
+
+#include <chrono>
+
+AsyncDevice::AsyncDevice(FTDevice &device, size_t queueCapacity)
+    : m_device(device), m_queue(queueCapacity) {
+    m_worker = std::thread([this] { workerLoop(); });
+}
+
+AsyncDevice::~AsyncDevice() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stop.store(true, std::memory_order_seq_cst);
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+void AsyncDevice::enqueue(std::unique_ptr<Job> job) {
+    m_submitted.fetch_add(1, std::memory_order_acq_rel);
+    while (!m_queue.tryPush(std::move(job))) {
+        // Очередь заполнена: ждём, пока рабочий поток заберёт операцию
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_progress.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    // Пара fence с workerLoop: либо поток увидит новый элемент, либо мы увидим флаг сна
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_workerSleeping.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_one();
+    }
+}
+
+void AsyncDevice::workerLoop() {
+    std::unique_ptr<Job> job;
+    for (;;) {
+        if (m_queue.tryPop(job)) {
+            job->run(m_device);
+            job.reset();
+            m_completed.fetch_add(1, std::memory_order_acq_rel);
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+            }
+            m_progress.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_workerSleeping.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_wake.wait(lock, [this] { return !m_queue.empty() || m_stop.load(); });
+        m_workerSleeping.store(false, std::memory_order_relaxed);
+        if (m_queue.empty() && m_stop.load()) return;
+    }
+}
+
+void AsyncDevice::flush() {
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_progress.wait(lock, [this] { return pending() == 0; });
+}
+
+std::future<std::vector<uint8_t>> AsyncDevice::submitI2CRead(uint8_t address, size_t length,
+                                                             uint8_t flag) {
+    return submit([=](FTDevice &d) { return d.i2cMasterRead(address, length, flag); });
+}
+
+std::future<void> AsyncDevice::submitI2CWrite(uint8_t address, std::vector<uint8_t> data,
+                                              uint8_t flag) {
+    return submit([address, flag, data = std::move(data)](FTDevice &d) {
+        d.i2cMasterWrite(address, data, flag);
+    });
+}
+
+std::future<std::vector<uint8_t>> AsyncDevice::submitI2CReadRegister(uint8_t address,
+                                                                     std::vector<uint8_t> regBytes,
+                                                                     size_t length) {
+    return submit([address, length, reg = std::move(regBytes)](FTDevice &d) {
+        return d.i2cReadRegister(address, reg, length);
+    });
+}
+
+std::future<I2CBatchResult> AsyncDevice::submitI2CBatch(I2CBatch batch) {
+    return submit([batch = std::move(batch)](FTDevice &d) { return d.runI2CBatch(batch); });
+}
+
+std::future<std::vector<uint8_t>> AsyncDevice::submitSpiRead(size_t length, bool endTransaction) {
+    return submit([=](FTDevice &d) { return d.spiMasterSingleRead(length, endTransaction); });
+}
+
+std::future<void> AsyncDevice::submitSpiWrite(std::vector<uint8_t> data, bool endTransaction) {
+    return submit([endTransaction, data = std::move(data)](FTDevice &d) {
+        d.spiMasterSingleWrite(data, endTransaction);
+    });
+}
+
+std::future<std::vector<uint8_t>> AsyncDevice::submitSpiXfer(std::vector<uint8_t> data,
+                                                             bool endTransaction) {
+    return submit([endTransaction, data = std::move(data)](FTDevice &d) {
+        return d.spiMasterSingleReadWrite(data, endTransaction);
+    });
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "engine/SpscQueue.hpp"
+#include "ft4222/ft4222.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Асинхронный доступ к FTDevice через выделенный поток ввода-вывода
+ *
+ * Операции ставятся в очередь SpscQueue и выполняются рабочим потоком строго в
+ * порядке отправки; результат возвращается через std::future или callback
+ * (callback вызывается в рабочем потоке). Пока USB-транзакция в полёте, поток
+ * вызывающей стороны свободен — в том числе для работы с другими адаптерами.
+ *
+ * @note  Очередь рассчитана на одного производителя: методы submit и post вызываются
+ *        из одного потока (владельца AsyncDevice). При заполненной очереди отправка
+ *        ждёт освобождения места. FTDevice должен жить дольше AsyncDevice;
+ *        синхронные вызовы из других потоков по-прежнему сериализуются deviceMutex.
+ */
+class AsyncDevice {
+public:
+    /**
+     * @brief Запустить поток ввода-вывода для устройства
+     * @param device Открытое устройство
+     * @param queueCapacity Ёмкость очереди отправки (округляется до степени двойки)
+     */
+    explicit AsyncDevice(FTDevice &device, size_t queueCapacity = 256);
+
+    /// Выполняет уже отправленные операции и останавливает поток
+    ~AsyncDevice();
+
+    AsyncDevice(const AsyncDevice &) = delete;
+    AsyncDevice &operator=(const AsyncDevice &) = delete;
+
+    /**
+     * @brief Отправить произвольную операцию над устройством
+     * @param fn Вызываемый объект fn(FTDevice&) -> R
+     * @return future с результатом или исключением fn
+     */
+    template <typename Fn>
+    auto submit(Fn &&fn) -> std::future<std::invoke_result_t<Fn &, FTDevice &>> {
+        using R = std::invoke_result_t<Fn &, FTDevice &>;
+        auto job = std::make_unique<PromiseJob<R, std::decay_t<Fn>>>(std::forward<Fn>(fn));
+        auto future = job->promise.get_future();
+        enqueue(std::move(job));
+        return future;
+    }
+
+    /**
+     * @brief Отправить операцию с обратным вызовом вместо future
+     * @param fn Операция fn(FTDevice&) -> R
+     * @param done Вызывается в рабочем потоке: done(R result, std::exception_ptr error)
+     *
+     * @note  При ошибке result — значение по умолчанию, error не пуст.
+     */
+    template <typename Fn, typename Done>
+    void post(Fn &&fn, Done &&done) {
+        enqueue(std::make_unique<CallbackJob<std::decay_t<Fn>, std::decay_t<Done>>>(
+            std::forward<Fn>(fn), std::forward<Done>(done)));
+    }
+
+    std::future<std::vector<uint8_t>> submitI2CRead(uint8_t address, size_t length,
+                                                    uint8_t flag = 0x02);
+    std::future<void> submitI2CWrite(uint8_t address, std::vector<uint8_t> data,
+                                     uint8_t flag = 0x02);
+    std::future<std::vector<uint8_t>> submitI2CReadRegister(uint8_t address,
+                                                            std::vector<uint8_t> regBytes,
+                                                            size_t length);
+    std::future<I2CBatchResult> submitI2CBatch(I2CBatch batch);
+    std::future<std::vector<uint8_t>> submitSpiRead(size_t length, bool endTransaction = true);
+    std::future<void> submitSpiWrite(std::vector<uint8_t> data, bool endTransaction = true);
+    std::future<std::vector<uint8_t>> submitSpiXfer(std::vector<uint8_t> data,
+                                                    bool endTransaction = true);
+
+    /// Дождаться выполнения всех отправленных операций
+    void flush();
+
+    /// Количество отправленных, но ещё не завершённых операций
+    size_t pending() const {
+        return m_submitted.load(std::memory_order_acquire) -
+               m_completed.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Job {
+        virtual ~Job() = default;
+        virtual void run(FTDevice &device) = 0;
+    };
+
+    template <typename R, typename Fn>
+    struct PromiseJob : Job {
+        explicit PromiseJob(Fn f) : fn(std::move(f)) {}
+        void run(FTDevice &device) override {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    fn(device);
+                    promise.set_value();
+                } else {
+                    promise.set_value(fn(device));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+        Fn fn;
+        std::promise<R> promise;
+    };
+
+    template <typename Fn, typename Done>
+    struct CallbackJob : Job {
+        CallbackJob(Fn f, Done d) : fn(std::move(f)), done(std::move(d)) {}
+        void run(FTDevice &device) override {
+            using R = std::invoke_result_t<Fn &, FTDevice &>;
+            if constexpr (std::is_void_v<R>) {
+                std::exception_ptr error;
+                try { fn(device); } catch (...) { error = std::current_exception(); }
+                done(error);
+            } else {
+                R result{};
+                std::exception_ptr error;
+                try { result = fn(device); } catch (...) { error = std::current_exception(); }
+                done(std::move(result), error);
+            }
+        }
+        Fn fn;
+        Done done;
+    };
+
+    void enqueue(std::unique_ptr<Job> job);
+    void workerLoop();
+
+    FTDevice &m_device;
+    SpscQueue<std::unique_ptr<Job>> m_queue;
+    std::atomic<size_t> m_submitted{0};
+    std::atomic<size_t> m_completed{0};
+    std::atomic<bool> m_stop{false};
+    std::atomic<bool> m_workerSleeping{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;     ///< Пробуждение рабочего потока
+    std::condition_variable m_progress; ///< Освободилось место / операция завершена
+    std::thread m_worker;
+};
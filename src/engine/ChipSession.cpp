@@ -0,0 +1,163 @@
+#include "ChipSession.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Серийный номер без буквы интерфейса
+std::string chipSerial(const DeviceInfo &info) {
+    const char letter = ChipSession::interfaceLetter(info);
+    if (letter != 0 && !info.serial.empty() && info.serial.back() == letter)
+        return info.serial.substr(0, info.serial.size() - 1);
+    return info.serial;
+}
+
+} // namespace
+
+char ChipSession::interfaceLetter(const DeviceInfo &info) {
+    // "FT4222 A", "FT4222 B (mock)", ...: буква — первое слово после "FT4222"
+    const std::string &d = info.description;
+    const auto at = d.find("FT4222 ");
+    if (at == std::string::npos || at + 7 >= d.size()) return 0;
+    const char letter = d[at + 7];
+    const bool alone = at + 8 == d.size() || d[at + 8] == ' ';
+    return letter >= 'A' && letter <= 'D' && alone ? letter : 0;
+}
+
+std::vector<ChipInfo> ChipSession::groupChips(const std::vector<DeviceInfo> &devices) {
+    std::vector<ChipInfo> chips;
+    for (const auto &info : devices) {
+        const std::string serial = chipSerial(info);
+        auto it = std::find_if(chips.begin(), chips.end(),
+                               [&](const ChipInfo &c) { return c.serial == serial; });
+        // Одиночные устройства без буквы не объединяются, даже при совпадении номеров
+        if (it == chips.end() || interfaceLetter(info) == 0) {
+            chips.push_back({serial, {}});
+            it = chips.end() - 1;
+        }
+        it->interfaces.push_back(info);
+    }
+    for (auto &chip : chips)
+        std::stable_sort(chip.interfaces.begin(), chip.interfaces.end(),
+                         [](const DeviceInfo &a, const DeviceInfo &b) {
+                             return interfaceLetter(a) < interfaceLetter(b);
+                         });
+    return chips;
+}
+
+void ChipSession::open(const ChipInfo &chip) {
+    if (chip.interfaces.empty()) throw std::runtime_error("Chip has no interfaces");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_interfaces.empty()) throw std::runtime_error("Chip session is already open");
+
+    // Все или ничего: при ошибке уже открытые интерфейсы закрываются деструкторами
+    std::vector<Interface> opened;
+    opened.reserve(chip.interfaces.size());
+    for (const auto &info : chip.interfaces) {
+        opened.emplace_back();
+        opened.back().device.openByLocation(info.locationId);
+    }
+    m_chipMode = opened.front().device.getChipMode();
+    m_interfaces = std::move(opened);
+    m_chip = chip;
+    m_modeSwitches = 0;
+}
+
+void ChipSession::openBySerial(const std::string &serial) {
+    for (const auto &chip : groupChips(DeviceEnumerator::listDevices())) {
+        const bool match = chip.serial == serial ||
+                           std::any_of(chip.interfaces.begin(), chip.interfaces.end(),
+                                       [&](const DeviceInfo &i) { return i.serial == serial; });
+        if (match) {
+            open(chip);
+            return;
+        }
+    }
+    throw std::runtime_error("No FT4222 chip with serial " + serial);
+}
+
+void ChipSession::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_interfaces.clear();
+    m_chip = ChipInfo{};
+    m_chipMode = 0;
+}
+
+bool ChipSession::isOpen() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_interfaces.empty();
+}
+
+uint64_t ChipSession::modeSwitches() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_modeSwitches;
+}
+
+FTDevice &ChipSession::at(size_t i) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (i >= m_interfaces.size()) throw std::out_of_range("No such chip interface");
+    return m_interfaces[i].device;
+}
+
+template <typename Init>
+FTDevice &ChipSession::configure(size_t interface, FTDevice::Mode role, uint32_t params,
+                                 Init &&init) {
+    if (m_interfaces.empty()) throw std::runtime_error("Chip session is not open");
+    if (interface >= m_interfaces.size())
+        throw std::out_of_range("Interface " + std::string(1, static_cast<char>('A' + interface)) +
+                                " is not present in chip mode " + std::to_string(m_chipMode));
+    Interface &iface = m_interfaces[interface];
+    if (iface.role == role && iface.params == params) return iface.device;
+
+    if (iface.role != FTDevice::Mode::Unknown) ++m_modeSwitches;
+    iface.role = FTDevice::Mode::Unknown;
+    init(iface.device);
+    iface.role = role;
+    iface.params = params;
+    return iface.device;
+}
+
+FTDevice &ChipSession::i2c(FTDevice::I2CSpeed speed) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return configure(0, FTDevice::Mode::I2C_Master, static_cast<uint32_t>(speed),
+                     [&](FTDevice &d) { d.initI2CMaster(speed); });
+}
+
+FTDevice &ChipSession::spi(size_t cs, FT4222_SPIMode mode, FTDevice::SPIClockDivider clockDiv,
+                           FT4222_SPICPOL polarity, FT4222_SPICPHA phase) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // В режимах 1 и 2 у каждой линии SS свой интерфейс, в 0 и 3 — только SS0O на A
+    const size_t lines = m_chipMode == 1 ? 3 : m_chipMode == 2 ? 4 : 1;
+    if (cs >= lines)
+        throw std::out_of_range("SPI CS" + std::to_string(cs) + " is not available in chip mode " +
+                                std::to_string(m_chipMode));
+    const uint32_t params = static_cast<uint32_t>(mode) |
+                            static_cast<uint32_t>(clockDiv) << 8 |
+                            static_cast<uint32_t>(polarity) << 16 |
+                            static_cast<uint32_t>(phase) << 24;
+    return configure(cs, FTDevice::Mode::SPI_Master, params,
+                     [&](FTDevice &d) { d.initSPIMaster(mode, clockDiv, polarity, phase); });
+}
+
+size_t ChipSession::gpioInterface() const {
+    if (m_interfaces.size() == 1) return 0;
+    switch (m_chipMode) {
+    case 0: return 1;
+    case 1: return 3;
+    case 3: return 0;
+    default:
+        throw std::out_of_range("GPIO is not available in chip mode " + std::to_string(m_chipMode));
+    }
+}
+
+FTDevice &ChipSession::gpio(GPIO_Dir dir0, GPIO_Dir dir1, GPIO_Dir dir2, GPIO_Dir dir3) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_interfaces.empty()) throw std::runtime_error("Chip session is not open");
+    const uint32_t params = (dir0 == GPIO_OUTPUT ? 1u : 0u) | (dir1 == GPIO_OUTPUT ? 2u : 0u) |
+                            (dir2 == GPIO_OUTPUT ? 4u : 0u) | (dir3 == GPIO_OUTPUT ? 8u : 0u);
+    return configure(gpioInterface(), FTDevice::Mode::GPIO, params,
+                     [&](FTDevice &d) { d.initGPIO(dir0, dir1, dir2, dir3); });
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Один физический FT4222H и его USB-интерфейсы
+ *
+ * @note  В режимах чипа 0–2 LibFT4222 перечисляет чип несколькими устройствами:
+ *        описание "FT4222 A", "FT4222 B", ..., серийный номер с той же буквой в конце.
+ *        serial — номер без буквы; interfaces упорядочены по букве.
+ */
+struct ChipInfo {
+    std::string serial;
+    std::vector<DeviceInfo> interfaces;
+};
+
+/**
+ * @brief Сессия на все интерфейсы одного чипа
+ *
+ * Каждый интерфейс открывается отдельным FTDevice (свой хэндл и свой deviceMutex) и
+ * остаётся в режиме, в котором его инициализировали: i2c(), spi() и gpio() возвращают
+ * уже настроенный интерфейс и повторяют init только при смене роли или параметров.
+ * Потоки, работающие с разными интерфейсами, не блокируют друг друга.
+ *
+ * Назначение интерфейсов по режиму чипа (FT4222H datasheet, CFG0/CFG1):
+ * - режим 0: A — I2C/SPI, B — GPIO;
+ * - режим 1: A, B, C — SPI Master на SS0O..SS2O, D — GPIO;
+ * - режим 2: A, B, C, D — SPI Master на SS0O..SS3O;
+ * - режим 3: A — I2C/SPI/GPIO.
+ * I2C всегда на интерфейсе A, поэтому одновременные I2C и SPI возможны в режиме 1
+ * (spi(1) / spi(2)); в режимах 0 и 3 они делят интерфейс A и переключают его режим
+ * (счётчик modeSwitches()).
+ *
+ * @note  Методы сессии потокобезопасны; возвращённые ссылки действительны до close().
+ */
+class ChipSession {
+public:
+    ChipSession() = default;
+    ChipSession(const ChipSession &) = delete;
+    ChipSession &operator=(const ChipSession &) = delete;
+    ~ChipSession() = default;
+
+    /**
+     * @brief Сгруппировать перечисленные устройства по чипам
+     * @param devices Список устройств (обычно DeviceEnumerator::listDevices())
+     * @return Чипы в порядке первого интерфейса в списке
+     */
+    static std::vector<ChipInfo> groupChips(const std::vector<DeviceInfo> &devices);
+
+    /**
+     * @brief Буква интерфейса ('A'..'D') или 0, если чип перечислен одним устройством
+     */
+    static char interfaceLetter(const DeviceInfo &info);
+
+    /**
+     * @brief Открыть все интерфейсы чипа (по Location ID)
+     * @param chip Чип из groupChips()
+     * @throw std::runtime_error Если сессия уже открыта или интерфейс не открывается
+     *        (уже открытые при этом закрываются)
+     */
+    void open(const ChipInfo &chip);
+
+    /**
+     * @brief Найти чип по серийному номеру (с буквой интерфейса или без) и открыть
+     * @throw std::runtime_error Если чип не найден или не открывается
+     */
+    void openBySerial(const std::string &serial);
+
+    /// Закрыть все интерфейсы
+    void close();
+
+    bool isOpen() const;
+
+    /// Описание открытого чипа (пустое, если сессия закрыта)
+    const ChipInfo &chip() const { return m_chip; }
+
+    /// Режим чипа, прочитанный при открытии
+    uint8_t chipMode() const { return m_chipMode; }
+
+    /// Число открытых интерфейсов
+    size_t size() const { return m_interfaces.size(); }
+
+    /**
+     * @brief Интерфейс по номеру (0 — A) как есть, без инициализации
+     * @throw std::out_of_range Если номера нет
+     */
+    FTDevice &at(size_t i);
+
+    /**
+     * @brief Интерфейс I2C Master (A), инициализированный на speed
+     * @throw std::runtime_error Если сессия закрыта или при ошибке инициализации
+     */
+    FTDevice &i2c(FTDevice::I2CSpeed speed = FTDevice::I2CSpeed::S400K);
+
+    /**
+     * @brief Интерфейс SPI Master для линии выбора cs, инициализированный с этими параметрами
+     * @throw std::out_of_range Если в режиме чипа нет такой линии
+     * @throw std::runtime_error Если сессия закрыта или при ошибке инициализации
+     */
+    FTDevice &spi(size_t cs = 0, FT4222_SPIMode mode = SPI_IO_SINGLE,
+                  FTDevice::SPIClockDivider clockDiv = FTDevice::SPIClockDivider::DIV_512,
+                  FT4222_SPICPOL polarity = CLK_IDLE_LOW, FT4222_SPICPHA phase = CLK_LEADING);
+
+    /**
+     * @brief Интерфейс GPIO, инициализированный с направлениями выводов
+     * @throw std::out_of_range Если в режиме 2 (GPIO недоступен)
+     * @throw std::runtime_error Если сессия закрыта или при ошибке инициализации
+     */
+    FTDevice &gpio(GPIO_Dir dir0 = GPIO_INPUT, GPIO_Dir dir1 = GPIO_INPUT,
+                   GPIO_Dir dir2 = GPIO_INPUT, GPIO_Dir dir3 = GPIO_INPUT);
+
+    /// Повторных init уже используемого интерфейса в другой роли или с другими параметрами
+    uint64_t modeSwitches() const;
+
+private:
+    // Роль и параметры последнего init интерфейса (Mode::Unknown — ещё не инициализирован)
+    struct Interface {
+        FTDevice device;
+        FTDevice::Mode role = FTDevice::Mode::Unknown;
+        uint32_t params = 0;
+    };
+
+    // Проверить, что interface уже в role с params; иначе вызвать init и запомнить.
+    // Вызывается под m_mutex.
+    template <typename Init>
+    FTDevice &configure(size_t interface, FTDevice::Mode role, uint32_t params, Init &&init);
+
+    size_t gpioInterface() const;
+
+    mutable std::mutex m_mutex;
+    ChipInfo m_chip;
+    uint8_t m_chipMode = 0;
+    std::vector<Interface> m_interfaces;
+    uint64_t m_modeSwitches = 0;
+};
@@ -0,0 +1,47 @@
+#include "engine/Crc32.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace {
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Tables makeTables() {
+    Tables t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+        t[0][i] = c;
+    }
+    // t[k][i] — CRC байта i, за которым следуют k нулевых байт
+    for (size_t k = 1; k < t.size(); ++k)
+        for (size_t i = 0; i < 256; ++i)
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    return t;
+}
+
+constexpr Tables kTables = makeTables();
+
+static_assert(kTables[0][1] == 0x77073096u, "CRC-32 table");
+
+} // namespace
+
+uint32_t crc32(ConstByteSpan data, uint32_t crc) noexcept {
+    const uint8_t *p = data.data();
+    size_t n = data.size();
+    crc = ~crc;
+    while (n >= 8) {
+        const uint32_t lo = crc ^ (uint32_t{p[0]} | uint32_t{p[1]} << 8 | uint32_t{p[2]} << 16 |
+                                   uint32_t{p[3]} << 24);
+        crc = kTables[7][lo & 0xFF] ^ kTables[6][(lo >> 8) & 0xFF] ^
+              kTables[5][(lo >> 16) & 0xFF] ^ kTables[4][lo >> 24] ^ kTables[3][p[4]] ^
+              kTables[2][p[5]] ^ kTables[1][p[6]] ^ kTables[0][p[7]];
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        crc = (crc >> 8) ^ kTables[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ft4222/ft4222_span.hpp"
+
+#include <cstdint>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, полином 0xEDB88320, как у zlib crc32())
+ * @param data Данные
+ * @param crc CRC предыдущих частей (0 — начало), для подсчёта по кускам
+ * @return CRC данных вместе с предыдущими частями
+ *
+ * @note  Slicing-by-8: восемь байт за шаг по таблицам, построенным при компиляции.
+ */
+uint32_t crc32(ConstByteSpan data, uint32_t crc = 0) noexcept;
@@ -0,0 +1,165 @@
+#include "engine/DeviceCache.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Адаптер считается тем же, если совпадают серийный номер и порт подключения
+bool sameDevice(const DeviceInfo &a, const DeviceInfo &b) {
+    return a.serial == b.serial && a.locationId == b.locationId;
+}
+
+void appendMissing(const std::vector<DeviceInfo> &from, const std::vector<DeviceInfo> &in,
+                   DeviceCache::Event::Type type, std::vector<DeviceCache::Event> &events) {
+    for (const auto &dev : from) {
+        const bool present = std::any_of(in.begin(), in.end(),
+                                         [&](const DeviceInfo &d) { return sameDevice(d, dev); });
+        if (!present)
+            events.push_back({type, dev});
+    }
+}
+
+} // namespace
+
+DeviceCache::DeviceCache(std::chrono::milliseconds ttl, Lister lister)
+    : lister_(std::move(lister)), ttl_(ttl) {}
+
+DeviceCache::~DeviceCache() {
+    stopWatcher();
+}
+
+DeviceCache &DeviceCache::instance() {
+    static DeviceCache cache;
+    return cache;
+}
+
+bool DeviceCache::fresh() const {
+    return valid_ && Clock::now() - refreshedAt_ < ttl_;
+}
+
+std::vector<DeviceInfo> DeviceCache::devices(bool forceRefresh) {
+    if (!forceRefresh) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fresh())
+            return devices_;
+    }
+    refresh();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_;
+}
+
+std::vector<DeviceCache::Event> DeviceCache::refresh() {
+    std::vector<Event> events;
+    std::lock_guard<std::mutex> refreshLock(refreshMutex_);
+    auto current = lister_();
+    enumerations_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (valid_) {
+        appendMissing(devices_, current, Event::Type::Removed, events);
+        appendMissing(current, devices_, Event::Type::Added, events);
+    }
+    devices_ = std::move(current);
+    refreshedAt_ = Clock::now();
+    valid_ = true;
+    // Обработчик вызывает только поток наблюдателя, даже если перечислял другой поток
+    if (listener_)
+        pendingEvents_.insert(pendingEvents_.end(), events.begin(), events.end());
+    return events;
+}
+
+template <typename Pred>
+std::optional<DeviceInfo> DeviceCache::find(Pred pred) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fresh()) {
+            const auto it = std::find_if(devices_.begin(), devices_.end(), pred);
+            if (it != devices_.end())
+                return *it;
+        }
+    }
+
+    // Снимок устарел или адаптер не найден — одно перечисление и повторный поиск
+    const auto list = devices(true);
+    const auto it = std::find_if(list.begin(), list.end(), pred);
+    if (it != list.end())
+        return *it;
+    return std::nullopt;
+}
+
+std::optional<DeviceInfo> DeviceCache::findBySerial(const std::string &serial) {
+    return find([&](const DeviceInfo &d) { return d.serial == serial; });
+}
+
+std::optional<DeviceInfo> DeviceCache::findByLocation(uint32_t locationId) {
+    return find([&](const DeviceInfo &d) { return d.locationId == locationId; });
+}
+
+void DeviceCache::setTtl(std::chrono::milliseconds ttl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = ttl;
+}
+
+std::chrono::milliseconds DeviceCache::ttl() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ttl_;
+}
+
+void DeviceCache::startWatcher(std::chrono::milliseconds interval, Listener listener) {
+    stopWatcher();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listener_ = std::move(listener);
+    }
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex_);
+        stopRequested_ = false;
+    }
+    watcherRunning_.store(true, std::memory_order_release);
+    watcher_ = std::thread([this, interval] { watcherLoop(interval); });
+}
+
+void DeviceCache::stopWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex_);
+        stopRequested_ = true;
+    }
+    watcherCv_.notify_all();
+    if (watcher_.joinable())
+        watcher_.join();
+    watcherRunning_.store(false, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    listener_ = nullptr;
+    pendingEvents_.clear();
+}
+
+void DeviceCache::deliverEvents() {
+    std::vector<Event> events;
+    Listener listener;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events.swap(pendingEvents_);
+        listener = listener_;
+    }
+    if (listener) {
+        for (const auto &event : events)
+            listener(event);
+    }
+}
+
+void DeviceCache::watcherLoop(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(watcherMutex_);
+    while (!stopRequested_) {
+        lock.unlock();
+        try {
+            refresh();
+        } catch (...) {
+            // Ошибка перечисления (например, адаптер отключают прямо сейчас) — повторим позже
+        }
+        deliverEvents();
+        lock.lock();
+        watcherCv_.wait_for(lock, interval, [this] { return stopRequested_; });
+    }
+}
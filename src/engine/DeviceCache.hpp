@@ -0,0 +1,157 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Кэш списка FT4222 с ограниченным временем жизни и наблюдателем hot-plug
+ *
+ * DeviceEnumerator::listDevices() на каждый вызов выполняет FT_CreateDeviceInfoList +
+ * FT_GetDeviceInfoList; на хабе с десятком адаптеров это заметно. Кэш отдаёт снимок
+ * списка без обращения к USB, пока тот не старше TTL, а поиск по серийному номеру
+ * или Location ID позволяет открыть устройство напрямую через FTDevice::openByLocation().
+ *
+ * Наблюдатель (startWatcher) периодически перечитывает список в фоновом потоке и
+ * сообщает о подключённых и отключённых адаптерах — тогда кэш остаётся актуальным
+ * и без истечения TTL.
+ *
+ * @note  Методы потокобезопасны. Перечисления сериализуются: D2XX не допускает
+ *        параллельных вызовов FT_CreateDeviceInfoList.
+ */
+class DeviceCache {
+public:
+    /// Источник списка устройств (по умолчанию DeviceEnumerator::listDevices)
+    using Lister = std::function<std::vector<DeviceInfo>()>;
+
+    /// Изменение состава устройств между двумя перечислениями
+    struct Event {
+        enum class Type { Added, Removed };
+        Type type;       ///< Устройство подключено или отключено
+        DeviceInfo info; ///< Описание устройства (для Removed — из предыдущего снимка)
+    };
+
+    /// Обработчик событий; вызывается в потоке наблюдателя вне внутренних блокировок
+    using Listener = std::function<void(const Event &event)>;
+
+    /**
+     * @brief Создать кэш
+     * @param ttl Время жизни снимка; 0 — перечитывать при каждом обращении
+     * @param lister Источник списка устройств
+     */
+    explicit DeviceCache(std::chrono::milliseconds ttl = std::chrono::milliseconds(2000),
+                         Lister lister = &DeviceEnumerator::listDevices);
+
+    /// Останавливает наблюдатель, если он запущен
+    ~DeviceCache();
+
+    DeviceCache(const DeviceCache &) = delete;
+    DeviceCache &operator=(const DeviceCache &) = delete;
+
+    /**
+     * @brief Общий для процесса кэш (используется CLI)
+     * @return Ссылка на единственный экземпляр
+     */
+    static DeviceCache &instance();
+
+    /**
+     * @brief Получить список устройств
+     * @param forceRefresh Перечитать список независимо от TTL
+     * @return Снимок списка
+     * @throw FtException При ошибке перечисления (снимок при этом не меняется)
+     */
+    std::vector<DeviceInfo> devices(bool forceRefresh = false);
+
+    /**
+     * @brief Перечитать список немедленно
+     * @return События относительно предыдущего снимка
+     * @throw FtException При ошибке перечисления
+     *
+     * @note  Первое перечисление событий не порождает — предыдущего снимка нет. При
+     *        запущенном наблюдателе события также ставятся в очередь его обработчику:
+     *        они доставляются из потока наблюдателя, а не из вызывающего потока.
+     */
+    std::vector<Event> refresh();
+
+    /**
+     * @brief Найти устройство по серийному номеру
+     * @param serial Серийный номер
+     * @return Описание устройства или std::nullopt
+     *
+     * @note  При промахе список перечитывается один раз (адаптер мог быть только что
+     *        подключён); при попадании в свежий снимок обращения к USB нет.
+     */
+    std::optional<DeviceInfo> findBySerial(const std::string &serial);
+
+    /**
+     * @brief Найти устройство по Location ID
+     * @param locationId Идентификатор местоположения (порт хаба)
+     * @return Описание устройства или std::nullopt
+     */
+    std::optional<DeviceInfo> findByLocation(uint32_t locationId);
+
+    /// Установить время жизни снимка
+    void setTtl(std::chrono::milliseconds ttl);
+
+    /// Текущее время жизни снимка
+    std::chrono::milliseconds ttl() const;
+
+    /**
+     * @brief Запустить фоновый наблюдатель hot-plug
+     * @param interval Период перечисления
+     * @param listener Обработчик событий (вызывается только в потоке наблюдателя)
+     *
+     * @note  Повторный вызов перезапускает наблюдатель с новыми параметрами. Ошибки
+     *        перечисления в потоке наблюдателя пропускаются до следующего периода.
+     *        События перечислений из других потоков (devices, findBySerial, ...)
+     *        доставляются обработчику в ближайший период наблюдателя.
+     */
+    void startWatcher(std::chrono::milliseconds interval, Listener listener);
+
+    /// Остановить наблюдатель (ждёт завершения потока)
+    void stopWatcher();
+
+    /// Запущен ли наблюдатель
+    bool watching() const noexcept { return watcherRunning_.load(std::memory_order_acquire); }
+
+    /// Число выполненных перечислений (для диагностики и тестов)
+    uint64_t enumerations() const noexcept { return enumerations_.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Pred>
+    std::optional<DeviceInfo> find(Pred pred);
+
+    bool fresh() const;
+    void watcherLoop(std::chrono::milliseconds interval);
+    void deliverEvents(); ///< Передать накопленные события обработчику (поток наблюдателя)
+
+    Lister lister_;
+    std::mutex refreshMutex_; ///< Сериализует вызовы lister_
+
+    mutable std::mutex mutex_; ///< Защищает снимок, TTL и обработчик
+    std::vector<DeviceInfo> devices_;
+    Clock::time_point refreshedAt_{};
+    bool valid_ = false;
+    std::chrono::milliseconds ttl_;
+    Listener listener_;
+    std::vector<Event> pendingEvents_; ///< События для обработчика наблюдателя
+
+    std::atomic<uint64_t> enumerations_{0};
+
+    std::thread watcher_;
+    std::mutex watcherMutex_;
+    std::condition_variable watcherCv_;
+    bool stopRequested_ = false;
+    std::atomic<bool> watcherRunning_{false};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+// Мелкие общие функции модулей engine: отсчёт времени, двоичная запись, оформление сообщений
+
+/**
+ * @brief Интервал между двумя моментами steady_clock
+ * @param start Начало интервала
+ * @param t Конец интервала
+ * @return Длительность, мкс
+ */
+inline uint64_t sinceUs(std::chrono::steady_clock::time_point start,
+                        std::chrono::steady_clock::time_point t) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(t - start).count());
+}
+
+/**
+ * @brief Время, прошедшее с момента start
+ * @param start Начало интервала
+ * @return Длительность до текущего момента, мкс
+ */
+inline uint64_t sinceUs(std::chrono::steady_clock::time_point start) {
+    return sinceUs(start, std::chrono::steady_clock::now());
+}
+
+/**
+ * @brief Записать целое в little-endian
+ * @param out Поток (двоичный)
+ * @param value Значение
+ * @param bytes Число младших байт value (1–8)
+ */
+inline void putLE(std::ostream &out, uint64_t value, int bytes) {
+    char buf[8];
+    for (int i = 0; i < bytes; ++i) buf[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    out.write(buf, bytes);
+}
+
+/**
+ * @brief Смещение для сообщений об ошибках
+ * @param offset Смещение или адрес
+ * @return Строка вида "0x1F00"
+ */
+inline std::string hexOffset(uint64_t offset) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "0x%llX", static_cast<unsigned long long>(offset));
+    return buf;
+}
@@ -0,0 +1,97 @@
+#include "engine/FlashPipeline.hpp"
+#include "engine/ChipSession.hpp"
+#include "engine/EngineUtil.hpp"
+#include "engine/MultiDevice.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void verify(SpiNorFlash &flash, uint32_t offset, ConstByteSpan image) {
+    std::vector<uint8_t> back(std::min(image.size(), FTDevice::SPI_MAX_CHUNK));
+    for (size_t done = 0; done < image.size();) {
+        const auto expected = image.subspan(done, back.size());
+        const ByteSpan got(back.data(), expected.size());
+        flash.read(offset + static_cast<uint32_t>(done), got);
+        if (std::memcmp(expected.data(), got.data(), got.size()) != 0) {
+            const auto diff = std::mismatch(expected.begin(), expected.end(), got.begin());
+            char buf[96];
+            std::snprintf(buf, sizeof(buf), "SPI flash verify failed at 0x%llX: wrote 0x%02X, read 0x%02X",
+                          static_cast<unsigned long long>(offset + done + (diff.first - expected.begin())),
+                          *diff.first, *diff.second);
+            throw std::runtime_error(buf);
+        }
+        done += got.size();
+    }
+}
+
+} // namespace
+
+std::vector<DeviceInfo> FlashPipeline::targets(const std::vector<DeviceInfo> &devices) {
+    std::vector<DeviceInfo> out;
+    for (const auto &chip : ChipSession::groupChips(devices))
+        if (!chip.interfaces.empty()) out.push_back(chip.interfaces.front());
+    return out;
+}
+
+void FlashPipeline::flash(FTDevice &device, ConstByteSpan image, const FlashOptions &options,
+                          FlashResult &result) {
+    if (static_cast<uint64_t>(options.offset) + image.size() > SpiNorFlash::kAddressLimit)
+        throw std::invalid_argument("image does not fit into 3-byte addressed SPI flash");
+
+    result.sclkHz = device.initSPIMasterHz(options.spiHz, SPI_IO_SINGLE, CLK_IDLE_LOW, CLK_LEADING);
+    SpiNorFlash flash(device, options.timeoutMs);
+    result.jedecId = flash.readJedecId();
+    // Нет ответа по MISO: кристалл не подключён или не запитан
+    if (result.jedecId == 0x000000 || result.jedecId == 0xFFFFFF)
+        throw std::runtime_error("no SPI flash detected (JEDEC ID reads as all zeros or ones)");
+
+    if (options.erase) result.erase = flash.erase(options.offset, image.size());
+    // Пустые страницы пропускаются только в только что стёртой области
+    result.write = flash.program(options.offset, image, options.erase);
+    if (options.verify) {
+        const auto start = Clock::now();
+        verify(flash, options.offset, image);
+        result.verifyUs = sinceUs(start);
+        result.verified = true;
+    }
+}
+
+std::map<std::string, FlashResult> FlashPipeline::run(const std::vector<DeviceInfo> &devices,
+                                                      ConstByteSpan image,
+                                                      const FlashOptions &options) {
+    std::mutex mutex;
+    std::map<std::string, FlashResult> results;
+
+    const auto jobs = MultiDeviceRunner::run(targets(devices),
+        [&](FTDevice &device, const DeviceInfo &info, std::ostream &) {
+            FlashResult r;
+            try {
+                flash(device, image, options, r);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[MultiDeviceRunner::keyFor(info)] = r;
+                throw;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            results[MultiDeviceRunner::keyFor(info)] = r;
+        });
+
+    // Ошибка открытия не доходит до задания: запись результата создаётся здесь
+    for (const auto &job : jobs) {
+        FlashResult &r = results[job.first];
+        r.info = job.second.info;
+        r.ok = job.second.ok;
+        r.error = job.second.error;
+        r.elapsedUs = job.second.elapsedUs;
+    }
+    return results;
+}
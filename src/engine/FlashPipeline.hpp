@@ -0,0 +1,86 @@
+#pragma once
+
+#include "engine/SpiFlash.hpp"
+#include "ft4222/ft4222.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Параметры прошивки
+ */
+struct FlashOptions {
+    uint32_t offset = 0;           ///< Адрес образа во flash
+    uint32_t spiHz = 10'000'000;   ///< Наибольшая частота SCLK
+    bool erase = true;             ///< Стереть область перед программированием
+    bool verify = false;           ///< Прочитать записанное и сравнить с образом
+    unsigned timeoutMs = 3000;     ///< Предел одного программирования / стирания, мс
+};
+
+/**
+ * @brief Итог прошивки одного адаптера
+ */
+struct FlashResult {
+    DeviceInfo info;               ///< Интерфейс, через который шла прошивка
+    bool ok = false;               ///< Прошивка (и сверка) завершились без ошибок
+    std::string error;             ///< Текст ошибки (если ok == false)
+    uint32_t sclkHz = 0;           ///< Достигнутая частота SCLK, Гц
+    uint32_t jedecId = 0;          ///< JEDEC ID кристалла
+    SpiFlashEraseStats erase;      ///< Стирание
+    SpiFlashWriteStats write;      ///< Программирование
+    bool verified = false;         ///< Сверка выполнена и совпала
+    uint64_t verifyUs = 0;         ///< Время сверки, мкс
+    uint64_t elapsedUs = 0;        ///< Общее время, включая открытие устройства, мкс
+
+    /// Скорость стирания и программирования, байт/с (0 — ничего не записано)
+    double bytesPerSecond() const {
+        const uint64_t us = erase.elapsedUs + write.elapsedUs;
+        return us == 0 ? 0.0 : static_cast<double>(write.bytes) * 1e6 / static_cast<double>(us);
+    }
+};
+
+/**
+ * @brief Параллельная прошивка одного образа в SPI NOR flash на всех адаптерах
+ *
+ * Образ передаётся как буфер только для чтения (обычно MappedFile) и не копируется:
+ * все рабочие потоки читают одни и те же страницы. Каждый чип получает свой поток
+ * (MultiDeviceRunner) и прошивается через SPI Master интерфейса A; остальные интерфейсы
+ * того же чипа (GPIO, другие CS) пропускаются, чтобы один чип не прошивался дважды.
+ *
+ * Сверка читает flash кусками по FTDevice::SPI_MAX_CHUNK (одна транзакция USB на
+ * кусок) и сравнивает их с образом memcmp.
+ */
+class FlashPipeline {
+public:
+    /**
+     * @brief Интерфейсы, через которые прошиваются чипы: A каждого чипа
+     * @param devices Список устройств (обычно DeviceEnumerator::listDevices())
+     */
+    static std::vector<DeviceInfo> targets(const std::vector<DeviceInfo> &devices);
+
+    /**
+     * @brief Прошить образ через одно открытое устройство
+     * @param device Открытое устройство (переводится в SPI Master, режим 0)
+     * @param image Образ
+     * @param options Параметры
+     * @param result Заполняется по мере выполнения (частично — при исключении)
+     * @throw std::invalid_argument Если образ не помещается в адресуемую область
+     * @throw std::runtime_error При ошибке устройства, таймауте или расхождении при
+     *        сверке (с указанием смещения)
+     */
+    static void flash(FTDevice &device, ConstByteSpan image, const FlashOptions &options,
+                      FlashResult &result);
+
+    /**
+     * @brief Прошить образ на всех чипах одновременно
+     * @param devices Список устройств
+     * @param image Образ
+     * @param options Параметры
+     * @return Результаты по серийному номеру интерфейса (MultiDeviceRunner::keyFor)
+     */
+    static std::map<std::string, FlashResult> run(const std::vector<DeviceInfo> &devices,
+                                                  ConstByteSpan image,
+                                                  const FlashOptions &options = {});
+};
@@ -0,0 +1,198 @@
+#include "engine/GpioWave.hpp"
+#include "engine/EngineUtil.hpp"
+#include "engine/Pacing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class JitterAccumulator {
+public:
+    void add(double errorUs) {
+        const double a = std::fabs(errorUs);
+        sum_ += a;
+        sumSq_ += errorUs * errorUs;
+        if (a > max_) max_ = a;
+        ++n_;
+    }
+
+    GpioJitter result() const {
+        GpioJitter j;
+        if (n_ == 0) return j;
+        j.meanUs = sum_ / static_cast<double>(n_);
+        j.rmsUs = std::sqrt(sumSq_ / static_cast<double>(n_));
+        j.maxUs = max_;
+        return j;
+    }
+
+private:
+    double sum_ = 0, sumSq_ = 0, max_ = 0;
+    uint64_t n_ = 0;
+};
+
+// "250", "250us", "10ms", "2s" -> мкс
+uint64_t parseTimeUs(const std::string &text) {
+    size_t pos = 0;
+    const uint64_t value = std::stoull(text, &pos, 10);
+    const std::string unit = text.substr(pos);
+    if (unit.empty() || unit == "us") return value;
+    if (unit == "ms") return value * 1000;
+    if (unit == "s") return value * 1000000;
+    throw std::invalid_argument("bad time unit '" + unit + "'");
+}
+
+} // namespace
+
+double GpioCapture::achievedHz() const {
+    if (timestampsUs.size() < 2 || timestampsUs.back() == timestampsUs.front()) return 0.0;
+    return static_cast<double>(timestampsUs.size() - 1) * 1e6 /
+           static_cast<double>(timestampsUs.back() - timestampsUs.front());
+}
+
+void GpioCapture::write(std::ostream &sink) const {
+    sink.write("TWIGPIO1", 8);
+    putLE(sink, requestedHz, 4);
+    putLE(sink, timestampsUs.size(), 8);
+    for (const uint32_t t : timestampsUs) putLE(sink, t, 4);
+    sink.write(reinterpret_cast<const char *>(packed.data()),
+               static_cast<std::streamsize>(packed.size()));
+    if (!sink) throw std::runtime_error("write to GPIO capture file failed");
+}
+
+GpioCapture GpioSampler::run(FTDevice &device, const GpioSampleOptions &options) {
+    if (options.durationMs == 0) throw std::invalid_argument("sample duration must be non-zero");
+    if (options.maxSamples == 0) throw std::invalid_argument("sample limit must be non-zero");
+
+    GpioCapture cap;
+    cap.requestedHz = options.rateHz;
+
+    // Буферы под всю выборку заранее: в цикле не должно быть выделений памяти
+    size_t expected = options.maxSamples;
+    if (options.rateHz) {
+        const uint64_t n = options.durationMs * options.rateHz / 1000 + 1;
+        if (n < expected) expected = static_cast<size_t>(n);
+    }
+    cap.timestampsUs.reserve(expected);
+    cap.packed.reserve((expected + 1) / 2);
+
+    const std::chrono::nanoseconds period(options.rateHz ? 1000000000ull / options.rateHz : 0);
+    const auto duration = std::chrono::milliseconds(options.durationMs);
+
+    const auto start = Clock::now();
+    uint64_t slot = 0;
+    while (cap.timestampsUs.size() < options.maxSamples) {
+        if (period.count()) waitUntil(start + period * slot);
+        const auto t = Clock::now();
+        if (t - start >= duration) break;
+
+        const uint8_t levels = device.readGPIOPorts();
+        const size_t i = cap.timestampsUs.size();
+        cap.timestampsUs.push_back(static_cast<uint32_t>(sinceUs(start, t)));
+        if (i & 1) cap.packed.back() |= static_cast<uint8_t>(levels << 4);
+        else cap.packed.push_back(levels);
+
+        if (period.count()) {
+            ++slot;
+            const auto current = static_cast<uint64_t>((Clock::now() - start) / period);
+            if (current > slot) {
+                cap.missedSlots += current - slot;
+                slot = current;
+            }
+        }
+    }
+    cap.elapsedUs = sinceUs(start, Clock::now());
+
+    // Джиттер — отклонение интервалов между выборками от периода
+    // (для максимальной частоты — от среднего интервала)
+    const size_t n = cap.timestampsUs.size();
+    if (n >= 2) {
+        double nominalUs = options.rateHz ? 1e6 / options.rateHz : 0.0;
+        if (!options.rateHz)
+            nominalUs = static_cast<double>(cap.timestampsUs.back() - cap.timestampsUs.front()) /
+                        static_cast<double>(n - 1);
+        JitterAccumulator acc;
+        for (size_t i = 1; i < n; ++i) {
+            const double interval = static_cast<double>(cap.timestampsUs[i] - cap.timestampsUs[i - 1]);
+            // Интервал, накрывший пропущенные слоты, сравнивается с кратным периодом
+            const double slots = nominalUs > 0 ? std::max(1.0, std::round(interval / nominalUs)) : 1.0;
+            acc.add(interval - slots * nominalUs);
+        }
+        cap.jitter = acc.result();
+    }
+    return cap;
+}
+
+GpioPattern GpioPattern::parse(std::istream &in, const std::string &source) {
+    GpioPattern pattern;
+    std::string line;
+    size_t lineNo = 0;
+    uint64_t last = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNo;
+        const auto hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+
+        std::istringstream iss(line);
+        std::string timeTok;
+        if (!(iss >> timeTok)) continue;
+
+        auto fail = [&](const std::string &msg) {
+            return std::invalid_argument(source + ":" + std::to_string(lineNo) + ": " + msg);
+        };
+
+        Step step;
+        try {
+            const bool relative = timeTok[0] == '+';
+            const uint64_t t = parseTimeUs(relative ? timeTok.substr(1) : timeTok);
+            step.atUs = relative ? last + t : t;
+        } catch (const std::exception &) {
+            throw fail("bad time '" + timeTok + "'");
+        }
+        if (step.atUs < last) throw fail("time goes backwards");
+
+        std::string tok;
+        while (iss >> tok) {
+            if (tok.size() != 3 || tok[1] != '=' || tok[0] < '0' || tok[0] > '3' ||
+                (tok[2] != '0' && tok[2] != '1'))
+                throw fail("expected <port 0-3>=<0|1>, got '" + tok + "'");
+            const auto bit = static_cast<uint8_t>(1u << (tok[0] - '0'));
+            step.mask |= bit;
+            if (tok[2] == '1') step.values |= bit;
+            else step.values &= static_cast<uint8_t>(~bit);
+        }
+
+        last = step.atUs;
+        pattern.steps.push_back(step);
+    }
+    return pattern;
+}
+
+GpioPlayStats GpioPlayer::run(FTDevice &device, const GpioPattern &pattern, unsigned loops) {
+    GpioPlayStats stats;
+    JitterAccumulator acc;
+    const auto periodUs = std::chrono::microseconds(pattern.durationUs());
+
+    const auto start = Clock::now();
+    for (unsigned loop = 0; loop < loops; ++loop) {
+        const auto base = start + periodUs * loop;
+        for (const auto &step : pattern.steps) {
+            const auto deadline = base + std::chrono::microseconds(step.atUs);
+            waitUntil(deadline);
+            const auto t = Clock::now();
+            if (step.mask) device.writeGPIOPorts(step.mask, step.values);
+            acc.add(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(t - deadline).count()) / 1000.0);
+            ++stats.steps;
+        }
+    }
+    stats.elapsedUs = sinceUs(start, Clock::now());
+    stats.jitter = acc.result();
+    return stats;
+}
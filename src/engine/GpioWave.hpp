@@ -0,0 +1,142 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Отклонение моментов обращения к GPIO от расписания
+ */
+struct GpioJitter {
+    double meanUs = 0; ///< Среднее абсолютное отклонение, мкс
+    double rmsUs = 0;  ///< Среднеквадратичное отклонение, мкс
+    double maxUs = 0;  ///< Максимальное абсолютное отклонение, мкс
+};
+
+/**
+ * @brief Параметры выборки GPIO
+ */
+struct GpioSampleOptions {
+    uint32_t rateHz = 1000;             ///< Частота выборки; 0 — так быстро, как позволяет USB
+    uint64_t durationMs = 1000;         ///< Длительность выборки, мс
+    size_t maxSamples = 4 * 1024 * 1024; ///< Предел числа выборок (буфер выделяется заранее)
+};
+
+/**
+ * @brief Результат выборки: уровни четырёх выводов с отметками времени
+ *
+ * Уровни упакованы по две выборки в байт: выборка 2k — младшая тетрада, 2k+1 —
+ * старшая; бит n тетрады — GPIOn.
+ */
+struct GpioCapture {
+    uint32_t requestedHz = 0;           ///< Запрошенная частота (0 — максимальная)
+    std::vector<uint32_t> timestampsUs; ///< Время каждой выборки от начала, мкс
+    std::vector<uint8_t> packed;        ///< Упакованные уровни
+    uint64_t elapsedUs = 0;             ///< Длительность выборки, мкс
+    uint64_t missedSlots = 0;           ///< Пропущенные слоты расписания (USB не успевал)
+    GpioJitter jitter;                  ///< Отклонение интервалов от периода
+
+    /// Число выборок
+    size_t size() const { return timestampsUs.size(); }
+
+    /// Уровни выборки i (бит n — GPIOn)
+    uint8_t levels(size_t i) const {
+        return static_cast<uint8_t>((packed[i / 2] >> ((i & 1) * 4)) & 0x0F);
+    }
+
+    /// Фактическая частота выборки, Гц
+    double achievedHz() const;
+
+    /**
+     * @brief Записать выборку в двоичный поток
+     * @param sink Приёмник (std::ofstream в режиме binary)
+     * @throw std::runtime_error При ошибке записи
+     *
+     * Формат (little-endian): "TWIGPIO1", u32 requestedHz, u64 count,
+     * u32 timestampsUs[count], u8 packed[(count + 1) / 2].
+     */
+    void write(std::ostream &sink) const;
+};
+
+/**
+ * @brief Выборка всех четырёх GPIO в плотном цикле по расписанию
+ *
+ * Буферы выделяются до начала, в цикле нет ввода-вывода кроме чтения выводов.
+ * Ожидание до очередного слота — сон до последней миллисекунды, затем активное
+ * ожидание. Если чтение заняло больше периода, просроченные слоты пропускаются и
+ * учитываются в missedSlots, а не копятся в растущую задержку.
+ */
+class GpioSampler {
+public:
+    /**
+     * @brief Выполнить выборку
+     * @param device Устройство после initGPIO
+     * @param options Параметры выборки
+     * @return Снятые уровни и статистика
+     * @throw std::invalid_argument При нулевой длительности или пределе выборок
+     * @throw std::runtime_error При ошибке устройства
+     */
+    static GpioCapture run(FTDevice &device, const GpioSampleOptions &options);
+};
+
+/**
+ * @brief Временная диаграмма для воспроизведения на GPIO
+ *
+ * Текстовый формат — по шагу на строку: "<время> <порт>=<0|1> ...", например
+ * "0 0=0 1=1", "+10ms 0=1", "2500us 1=0". Время — от начала диаграммы (с префиксом
+ * "+" — от предыдущего шага), суффиксы us/ms/s, без суффикса — мкс. Строка только
+ * со временем задаёт паузу до этого момента (длину периода при повторе).
+ * "#" — комментарий.
+ */
+struct GpioPattern {
+    struct Step {
+        uint64_t atUs = 0;  ///< Момент шага от начала диаграммы, мкс
+        uint8_t mask = 0;   ///< Изменяемые выводы (бит n — GPIOn)
+        uint8_t values = 0; ///< Новые уровни
+    };
+
+    std::vector<Step> steps; ///< Шаги в порядке возрастания времени
+
+    /// Длительность одного прохода (время последнего шага), мкс
+    uint64_t durationUs() const { return steps.empty() ? 0 : steps.back().atUs; }
+
+    /**
+     * @brief Разобрать диаграмму
+     * @param in Текст диаграммы
+     * @param source Имя источника для сообщений об ошибках
+     * @return Диаграмма
+     * @throw std::invalid_argument "source:line: ..." при синтаксической ошибке
+     *        или убывающем времени
+     */
+    static GpioPattern parse(std::istream &in, const std::string &source = "<pattern>");
+};
+
+/**
+ * @brief Итог воспроизведения диаграммы
+ */
+struct GpioPlayStats {
+    uint64_t steps = 0;     ///< Выполнено шагов (по всем повторам)
+    uint64_t elapsedUs = 0; ///< Общее время, мкс
+    GpioJitter jitter;      ///< Отклонение момента записи от расписания
+};
+
+/**
+ * @brief Воспроизведение временной диаграммы на выходах GPIO
+ */
+class GpioPlayer {
+public:
+    /**
+     * @brief Воспроизвести диаграмму
+     * @param device Устройство после initGPIO (нужные выводы — выходы)
+     * @param pattern Диаграмма
+     * @param loops Число повторов (проходы идут встык с периодом durationUs())
+     * @return Статистика
+     * @throw std::runtime_error При ошибке устройства
+     */
+    static GpioPlayStats run(FTDevice &device, const GpioPattern &pattern, unsigned loops = 1);
+};
@@ -0,0 +1,139 @@
+#include "engine/I2CEeprom.hpp"
+#include "engine/EngineUtil.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Адрес устройства может нести до трёх бит выбора блока
+constexpr uint64_t kMaxBlocks = 8;
+
+} // namespace
+
+I2CEeprom::I2CEeprom(FTDevice &device, uint8_t address, const EepromGeometry &geometry)
+    : m_device(device), m_address(address), m_geometry(geometry) {
+    if (address > 0x7F) throw std::invalid_argument("I2C address must be 7-bit");
+    if (geometry.addressBytes != 1 && geometry.addressBytes != 2)
+        throw std::invalid_argument("EEPROM address width must be 1 or 2 bytes");
+    const size_t page = geometry.pageSize;
+    if (page == 0 || (page & (page - 1)) != 0 || page > blockSize() ||
+        page + geometry.addressBytes > FTDevice::I2C_MAX_TRANSFER)
+        throw std::invalid_argument("EEPROM page size must be a power of two within one block");
+}
+
+uint8_t I2CEeprom::deviceAddressFor(uint32_t offset) const {
+    return static_cast<uint8_t>(m_address | (offset / blockSize()));
+}
+
+size_t I2CEeprom::encodeOffset(uint32_t offset, uint8_t *out) const {
+    const auto cell = static_cast<uint32_t>(offset % blockSize());
+    if (m_geometry.addressBytes == 2) {
+        out[0] = static_cast<uint8_t>(cell >> 8);
+        out[1] = static_cast<uint8_t>(cell);
+        return 2;
+    }
+    out[0] = static_cast<uint8_t>(cell);
+    return 1;
+}
+
+EepromReadStats I2CEeprom::read(uint32_t offset, ByteSpan out) {
+    if (static_cast<uint64_t>(offset) + out.size() > kMaxBlocks * blockSize())
+        throw std::invalid_argument("EEPROM range exceeds addressable size");
+
+    EepromReadStats stats;
+    const auto start = Clock::now();
+    size_t done = 0;
+    while (done < out.size()) {
+        const uint32_t at = offset + static_cast<uint32_t>(done);
+        const size_t n = std::min({out.size() - done, FTDevice::I2C_MAX_TRANSFER,
+                                   blockSize() - at % blockSize()});
+        uint8_t cell[2];
+        const size_t cellBytes = encodeOffset(at, cell);
+        const size_t got = m_device.i2cReadRegister(deviceAddressFor(at), ConstByteSpan(cell, cellBytes),
+                                                    out.subspan(done, n));
+        ++stats.transfers;
+        if (got != n)
+            throw std::runtime_error("EEPROM read incomplete at " + hexOffset(at) + ": " +
+                                     std::to_string(got) + "/" + std::to_string(n) + " bytes");
+        done += n;
+    }
+    stats.bytes = done;
+    stats.elapsedUs = sinceUs(start);
+    return stats;
+}
+
+// Чтение одного байта, пока EEPROM не подтвердит адрес: во время внутреннего цикла
+// записи устройство не отвечает на свой адрес. Чтение лишь сдвигает указатель ячейки,
+// который следующая страница всё равно задаёт заново
+uint64_t I2CEeprom::waitWriteCycle(uint8_t deviceAddress, unsigned timeoutMs, uint64_t &polls) {
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(timeoutMs);
+    uint8_t probe = 0;
+    for (;;) {
+        ++polls;
+        const I2CResult r = m_device.tryI2CRead(deviceAddress, ByteSpan(&probe, 1), START_AND_STOP);
+        if (r.error == I2CError::Device)
+            throw std::runtime_error(std::string(r.what) + " failed with FT4222_STATUS: " +
+                                     std::to_string(r.status));
+        if (!r.ok()) throw std::runtime_error(r.what);
+        if (r.bytes == 1) return sinceUs(start);
+        if (Clock::now() > deadline)
+            throw std::runtime_error("EEPROM at " + hexOffset(deviceAddress) +
+                                     " did not finish its write cycle within " +
+                                     std::to_string(timeoutMs) + " ms");
+    }
+}
+
+EepromWriteStats I2CEeprom::write(uint32_t offset, ConstByteSpan data, bool verify,
+                                  unsigned cycleTimeoutMs) {
+    if (static_cast<uint64_t>(offset) + data.size() > kMaxBlocks * blockSize())
+        throw std::invalid_argument("EEPROM range exceeds addressable size");
+
+    EepromWriteStats stats;
+    const size_t page = m_geometry.pageSize;
+    std::vector<uint8_t> frame;
+    frame.reserve(m_geometry.addressBytes + page);
+
+    const auto start = Clock::now();
+    size_t done = 0;
+    while (done < data.size()) {
+        const uint32_t at = offset + static_cast<uint32_t>(done);
+        // Не дальше конца страницы: иначе EEPROM завернёт запись на её начало
+        const size_t n = std::min(data.size() - done, page - at % page);
+        uint8_t cell[2];
+        const size_t cellBytes = encodeOffset(at, cell);
+        frame.assign(cell, cell + cellBytes);
+        frame.insert(frame.end(), data.begin() + done, data.begin() + done + n);
+
+        const uint8_t deviceAddress = deviceAddressFor(at);
+        m_device.i2cMasterWrite(deviceAddress, ConstByteSpan(frame), START_AND_STOP);
+        ++stats.pages;
+        stats.maxCycleUs =
+            std::max(stats.maxCycleUs, waitWriteCycle(deviceAddress, cycleTimeoutMs, stats.polls));
+        done += n;
+    }
+    stats.bytes = done;
+    stats.elapsedUs = sinceUs(start);
+
+    if (verify && !data.empty()) {
+        const auto verifyStart = Clock::now();
+        std::vector<uint8_t> back(data.size());
+        read(offset, back);
+        const auto diff = std::mismatch(data.begin(), data.end(), back.begin());
+        if (diff.first != data.end()) {
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), ": wrote 0x%02X, read 0x%02X", *diff.first, *diff.second);
+            throw std::runtime_error("EEPROM verify failed at " +
+                                     hexOffset(offset + (diff.first - data.begin())) + buf);
+        }
+        stats.verifyUs = sinceUs(verifyStart);
+    }
+    return stats;
+}
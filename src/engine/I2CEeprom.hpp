@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Геометрия I2C EEPROM / регистровой карты
+ *
+ * @note  Старшие биты смещения сверх addressBytes байт уходят в младшие биты адреса
+ *        устройства, как у 24C04..24C16 (1 байт, блоки по 256) и 24CM01/24CM02
+ *        (2 байта, блоки по 64 КБ). Чтение и запись не пересекают границу блока.
+ */
+struct EepromGeometry {
+    unsigned addressBytes = 2; ///< Байт адреса ячейки (1 или 2)
+    size_t pageSize = 8;       ///< Страница записи, байт (степень двойки; 8 подходит любой 24Cxx)
+};
+
+/**
+ * @brief Итог чтения
+ */
+struct EepromReadStats {
+    size_t bytes = 0;       ///< Прочитано байт
+    size_t transfers = 0;   ///< I2C-транзакций чтения
+    uint64_t elapsedUs = 0; ///< Время, мкс
+};
+
+/**
+ * @brief Итог программирования
+ */
+struct EepromWriteStats {
+    size_t bytes = 0;         ///< Записано байт
+    size_t pages = 0;         ///< Страничных транзакций записи
+    uint64_t polls = 0;       ///< Опросов ACK всего
+    uint64_t maxCycleUs = 0;  ///< Наибольшее время цикла записи по ACK polling, мкс
+    uint64_t elapsedUs = 0;   ///< Время записи, мкс
+    uint64_t verifyUs = 0;    ///< Время сверки, мкс (0 — без сверки)
+};
+
+/**
+ * @brief Последовательное чтение и постраничная запись I2C EEPROM
+ *
+ * Чтение — номер ячейки записью без STOP и чтение с повторным START транзакциями до
+ * FTDevice::I2C_MAX_TRANSFER байт (EEPROM сам ведёт указатель), поэтому скорость
+ * ограничена шиной, а не числом обращений к USB. Запись — по странице за транзакцию,
+ * выровненно по границам страниц; завершение цикла записи определяется ACK polling
+ * (чтение одного байта, пока устройство не подтвердит адрес), без фиксированных пауз.
+ */
+class I2CEeprom {
+public:
+    /**
+     * @param device Устройство в режиме I2C Master
+     * @param address 7-битный адрес EEPROM (с нулевыми битами выбора блока)
+     * @param geometry Геометрия
+     * @throw std::invalid_argument При недопустимой геометрии
+     */
+    I2CEeprom(FTDevice &device, uint8_t address, const EepromGeometry &geometry = {});
+
+    /**
+     * @brief Прочитать область
+     * @param offset Смещение первой ячейки
+     * @param out Буфер назначения (читается out.size() байт)
+     * @return Статистика
+     * @throw std::runtime_error При ошибке устройства или неполном чтении
+     */
+    EepromReadStats read(uint32_t offset, ByteSpan out);
+
+    /**
+     * @brief Записать область постранично и (по желанию) сверить
+     * @param offset Смещение первой ячейки
+     * @param data Данные
+     * @param verify Прочитать записанное и сравнить
+     * @param cycleTimeoutMs Предел ожидания одного цикла записи, мс
+     * @return Статистика
+     * @throw std::runtime_error При ошибке устройства, таймауте цикла записи или
+     *        расхождении при сверке (с указанием смещения)
+     */
+    EepromWriteStats write(uint32_t offset, ConstByteSpan data, bool verify = true,
+                           unsigned cycleTimeoutMs = 50);
+
+private:
+    uint8_t deviceAddressFor(uint32_t offset) const;
+    size_t blockSize() const { return size_t{1} << (8 * m_geometry.addressBytes); }
+    size_t encodeOffset(uint32_t offset, uint8_t *out) const;
+    uint64_t waitWriteCycle(uint8_t deviceAddress, unsigned timeoutMs, uint64_t &polls);
+
+    FTDevice &m_device;
+    uint8_t m_address;
+    EepromGeometry m_geometry;
+};
@@ -0,0 +1,212 @@
+#include "engine/I2CPoll.hpp"
+#include "engine/EngineUtil.hpp"
+#include "engine/Pacing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void appendHex(std::string &out, const uint8_t *data, size_t size) {
+    static const char kDigits[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < size; ++i) {
+        out.push_back(kDigits[data[i] >> 4]);
+        out.push_back(kDigits[data[i] & 0x0F]);
+    }
+}
+
+// Ожидание слота с проверкой остановки не реже раза в 10 мс (периоды до 100 мс и больше)
+void waitSlot(Clock::time_point deadline, const std::atomic<bool> &stop) {
+    while (!stop.load(std::memory_order_relaxed)) {
+        const auto now = Clock::now();
+        if (now >= deadline) return;
+        waitUntil(std::min(deadline, now + std::chrono::milliseconds(10)));
+    }
+}
+
+} // namespace
+
+I2CPoller::I2CPoller(FTDevice &device, std::vector<PollJob> jobs, const PollOptions &options)
+    : m_device(device), m_jobs(std::move(jobs)), m_options(options),
+      m_ring(options.ringCapacity) {
+    if (m_jobs.empty()) throw std::invalid_argument("no poll jobs");
+    if (m_jobs.size() > 0xFFFF) throw std::invalid_argument("too many poll jobs");
+    for (const auto &job : m_jobs) {
+        if (job.address > 0x7F) throw std::invalid_argument("I2C address must be 7-bit");
+        if (job.periodUs == 0) throw std::invalid_argument("poll period must be non-zero");
+        if (job.length == 0 || job.length > PollSample::kMaxBytes)
+            throw std::invalid_argument("poll length must be 1.." +
+                                        std::to_string(PollSample::kMaxBytes) + " bytes");
+        if (job.reg.size() > 0xFF) throw std::invalid_argument("register number is too long");
+    }
+}
+
+I2CPoller::~I2CPoller() {
+    if (!m_thread.joinable()) return;
+    m_stop.store(true);
+    m_thread.join();
+}
+
+void I2CPoller::start() {
+    if (m_thread.joinable()) throw std::logic_error("poller is already running");
+    m_stop.store(false);
+    m_running.store(true, std::memory_order_release);
+    m_error = nullptr;
+    m_stats = PollStats{};
+    m_stats.jobs.resize(m_jobs.size());
+    m_thread = std::thread([this] {
+        try {
+            schedule();
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+        m_running.store(false, std::memory_order_release);
+    });
+}
+
+PollStats I2CPoller::stop() {
+    if (m_thread.joinable()) {
+        m_stop.store(true);
+        m_thread.join();
+    }
+    if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+    return m_stats;
+}
+
+size_t I2CPoller::drain(const std::function<void(const PollSample &)> &sink) {
+    size_t n = 0;
+    PollSample sample;
+    while (m_ring.tryPop(sample)) {
+        sink(sample);
+        ++n;
+    }
+    return n;
+}
+
+void I2CPoller::schedule() {
+    const size_t n = m_jobs.size();
+    std::vector<std::chrono::microseconds> periods(n);
+    std::vector<uint64_t> slots(n, 0);
+    std::vector<Clock::time_point> due(n);
+    std::vector<uint64_t> first(n, 0), last(n, 0);
+    for (size_t i = 0; i < n; ++i) periods[i] = std::chrono::microseconds(m_jobs[i].periodUs);
+
+    // Буферы пакета и результата переиспользуются: в цикле нет выделений памяти
+    I2CBatch batch;
+    I2CBatchResult result;
+    std::vector<size_t> members;
+    members.reserve(n);
+
+    const auto start = Clock::now();
+    std::fill(due.begin(), due.end(), start);
+    const auto window = std::chrono::microseconds(m_options.mergeWindowUs);
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        waitSlot(*std::min_element(due.begin(), due.end()), m_stop);
+        if (m_stop.load(std::memory_order_relaxed)) break;
+
+        const auto horizon = Clock::now() + window;
+        batch.clear();
+        members.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (due[i] > horizon) continue;
+            const PollJob &job = m_jobs[i];
+            if (job.reg.empty()) batch.read(job.address, job.length);
+            else batch.readRegister(job.address, job.reg, job.length);
+            members.push_back(i);
+        }
+
+        const auto batchStart = Clock::now();
+        m_device.runI2CBatch(batch, result);
+        ++m_stats.batches;
+        const auto batchEnd = Clock::now();
+        const uint64_t current = sinceUs(start, batchEnd);
+
+        for (size_t k = 0; k < members.size(); ++k) {
+            const size_t i = members[k];
+            const auto &op = result.ops[k];
+            PollJobStats &st = m_stats.jobs[i];
+
+            PollSample sample;
+            sample.timeUs = sinceUs(start, batchStart);
+            sample.lateUs = batchStart > due[i] ? static_cast<uint32_t>(sinceUs(due[i], batchStart)) : 0;
+            sample.job = static_cast<uint16_t>(i);
+            sample.ok = op.ok;
+            sample.length = static_cast<uint8_t>(op.read);
+            std::copy_n(result.data.begin() + static_cast<std::ptrdiff_t>(op.readOffset), op.read,
+                        sample.data.begin());
+
+            if (st.samples == 0) first[i] = sample.timeUs;
+            last[i] = sample.timeUs;
+            ++st.samples;
+            if (!op.ok) ++st.errors;
+            st.maxLateUs = std::max<uint64_t>(st.maxLateUs, sample.lateUs);
+            if (!m_ring.tryPush(std::move(sample))) ++st.dropped;
+
+            // Следующий слот; целиком прошедшие за время пакета — пропущены
+            ++slots[i];
+            const uint64_t reached = current / static_cast<uint64_t>(periods[i].count());
+            if (reached > slots[i]) {
+                st.missed += reached - slots[i];
+                slots[i] = reached;
+            }
+            due[i] = start + periods[i] * slots[i];
+        }
+    }
+
+    m_stats.elapsedUs = sinceUs(start, Clock::now());
+    // Частота — по интервалу между первой и последней выборкой, как в GpioCapture
+    for (size_t i = 0; i < n; ++i) {
+        PollJobStats &st = m_stats.jobs[i];
+        if (st.samples >= 2 && last[i] > first[i])
+            st.achievedHz = static_cast<double>(st.samples - 1) * 1e6 / static_cast<double>(last[i] - first[i]);
+    }
+}
+
+PollWriter::PollWriter(std::ostream &out, PollFormat format, const std::vector<PollJob> &jobs)
+    : m_out(out), m_format(format), m_jobs(jobs) {
+    if (format == PollFormat::Csv) {
+        m_out << "time_us,job,address,register,ok,late_us,data\n";
+    } else {
+        m_out.write("TWIPOLL1", 8);
+        putLE(m_out, jobs.size(), 4);
+        for (const auto &job : jobs) {
+            putLE(m_out, job.address, 1);
+            putLE(m_out, job.reg.size(), 1);
+            m_out.write(reinterpret_cast<const char *>(job.reg.data()),
+                        static_cast<std::streamsize>(job.reg.size()));
+            putLE(m_out, job.length, 2);
+            putLE(m_out, job.periodUs, 4);
+        }
+    }
+    if (!m_out) throw std::runtime_error("write to poll output failed");
+}
+
+void PollWriter::write(const PollSample &s) {
+    if (m_format == PollFormat::Csv) {
+        const PollJob &job = m_jobs[s.job];
+        std::string line = std::to_string(s.timeUs) + "," + std::to_string(s.job) + ",0x";
+        appendHex(line, &job.address, 1);
+        line += ',';
+        appendHex(line, job.reg.data(), job.reg.size());
+        line += s.ok ? ",1," : ",0,";
+        line += std::to_string(s.lateUs);
+        line += ',';
+        appendHex(line, s.data.data(), s.length);
+        line += '\n';
+        m_out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    } else {
+        putLE(m_out, s.timeUs, 8);
+        putLE(m_out, s.lateUs, 4);
+        putLE(m_out, s.job, 2);
+        putLE(m_out, s.ok ? 1 : 0, 1);
+        putLE(m_out, s.length, 1);
+        m_out.write(reinterpret_cast<const char *>(s.data.data()), s.length);
+    }
+    if (!m_out) throw std::runtime_error("write to poll output failed");
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "engine/SpscQueue.hpp"
+#include "ft4222/ft4222.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Периодический опрос одного регистра
+ */
+struct PollJob {
+    uint8_t address = 0;      ///< 7-битный адрес устройства
+    std::vector<uint8_t> reg; ///< Номер регистра (пусто — чтение без записи номера)
+    uint16_t length = 1;      ///< Байт за опрос (1..PollSample::kMaxBytes)
+    uint32_t periodUs = 1000; ///< Период опроса, мкс
+
+    double requestedHz() const { return periodUs ? 1e6 / periodUs : 0.0; }
+};
+
+/**
+ * @brief Одна выборка: фиксированного размера, чтобы кольцо не выделяло память
+ */
+struct PollSample {
+    static constexpr size_t kMaxBytes = 32;
+
+    uint64_t timeUs = 0;  ///< Начало пакета, в котором выполнен опрос, от старта, мкс
+    uint32_t lateUs = 0;  ///< Опоздание относительно слота расписания, мкс
+    uint16_t job = 0;     ///< Номер задания
+    bool ok = false;      ///< Чтение выполнено полностью
+    uint8_t length = 0;   ///< Прочитано байт
+    std::array<uint8_t, kMaxBytes> data{};
+};
+
+/**
+ * @brief Итог опроса по заданию
+ */
+struct PollJobStats {
+    uint64_t samples = 0;   ///< Выполнено опросов
+    uint64_t errors = 0;    ///< Опросов с NACK / неполным чтением
+    uint64_t missed = 0;    ///< Пропущенные слоты расписания (пакет не успевал)
+    uint64_t dropped = 0;   ///< Выборки, не поместившиеся в кольцо (потребитель не успевал)
+    uint64_t maxLateUs = 0; ///< Наибольшее опоздание относительно слота, мкс
+    double achievedHz = 0;  ///< Фактическая частота опроса
+};
+
+/**
+ * @brief Итог опроса
+ */
+struct PollStats {
+    std::vector<PollJobStats> jobs; ///< По заданиям, в порядке заданий
+    uint64_t batches = 0;           ///< Выполнено пакетов (захватов устройства)
+    uint64_t elapsedUs = 0;         ///< Длительность опроса, мкс
+};
+
+/**
+ * @brief Параметры планировщика
+ */
+struct PollOptions {
+    size_t ringCapacity = 8192;  ///< Ёмкость кольца выборок (округляется до степени двойки)
+    uint32_t mergeWindowUs = 100; ///< Задания, чей слот наступит в пределах окна, идут тем же пакетом
+};
+
+/**
+ * @brief Опрос I2C-датчиков с фиксированными частотами в фоновом потоке
+ *
+ * Поток планировщика ждёт ближайший слот по steady_clock (сон, затем активное
+ * ожидание — waitUntil), собирает все наступившие задания в один I2CBatch и выполняет
+ * его одним runI2CBatch, то есть одним захватом устройства. Слоты считаются от старта
+ * (start + k·period), поэтому задержки не накапливаются; слоты, целиком прошедшие за
+ * время пакета, пропускаются и учитываются в missed. Выборки с отметкой времени
+ * пишутся в кольцо SpscQueue без блокировок; их забирает drain() в потоке потребителя.
+ *
+ * @note  Устройство должно быть в режиме I2C Master. Пока опрос идёт, другие вызовы
+ *        FTDevice из других потоков допустимы, но сдвигают расписание.
+ */
+class I2CPoller {
+public:
+    /**
+     * @param device Устройство в режиме I2C Master (должно жить дольше опроса)
+     * @param jobs Задания
+     * @param options Параметры
+     * @throw std::invalid_argument При пустом списке, нулевом периоде, длине вне
+     *        1..PollSample::kMaxBytes или адресе больше 0x7F
+     */
+    I2CPoller(FTDevice &device, std::vector<PollJob> jobs, const PollOptions &options = {});
+    I2CPoller(const I2CPoller &) = delete;
+    I2CPoller &operator=(const I2CPoller &) = delete;
+
+    /// Останавливает опрос, если он идёт
+    ~I2CPoller();
+
+    /**
+     * @brief Запустить поток планировщика
+     * @throw std::logic_error Если опрос уже идёт
+     */
+    void start();
+
+    /**
+     * @brief Остановить опрос и дождаться потока
+     * @return Статистика
+     * @throw std::runtime_error Ошибка устройства, остановившая планировщик
+     *
+     * @note  Выборки, оставшиеся в кольце, после остановки по-прежнему доступны drain().
+     */
+    PollStats stop();
+
+    /**
+     * @brief Передать все накопленные выборки в sink (только из одного потока-потребителя)
+     * @return Число выборок
+     */
+    size_t drain(const std::function<void(const PollSample &)> &sink);
+
+    /// Планировщик работает (false после stop() или ошибки устройства)
+    bool running() const { return m_running.load(std::memory_order_acquire); }
+    const std::vector<PollJob> &jobs() const { return m_jobs; }
+
+private:
+    void schedule();
+
+    FTDevice &m_device;
+    std::vector<PollJob> m_jobs;
+    PollOptions m_options;
+    SpscQueue<PollSample> m_ring;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<bool> m_running{false};
+    std::exception_ptr m_error;
+    PollStats m_stats;
+};
+
+/**
+ * @brief Формат файла выборок
+ */
+enum class PollFormat {
+    Csv,   ///< "time_us,job,address,register,ok,late_us,data"
+    Binary ///< См. PollWriter
+};
+
+/**
+ * @brief Запись выборок в поток
+ *
+ * Двоичный формат (little-endian): "TWIPOLL1", u32 число заданий; по заданию —
+ * u8 адрес, u8 длина номера регистра, номер регистра, u16 length, u32 periodUs;
+ * затем записи: u64 timeUs, u32 lateUs, u16 job, u8 ok, u8 length, data[length].
+ */
+class PollWriter {
+public:
+    /**
+     * @brief Записать заголовок
+     * @throw std::runtime_error При ошибке записи
+     */
+    PollWriter(std::ostream &out, PollFormat format, const std::vector<PollJob> &jobs);
+
+    /**
+     * @brief Записать выборку
+     * @throw std::runtime_error При ошибке записи
+     */
+    void write(const PollSample &sample);
+
+private:
+    std::ostream &m_out;
+    PollFormat m_format;
+    const std::vector<PollJob> &m_jobs;
+};
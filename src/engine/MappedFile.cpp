@@ -0,0 +1,110 @@
+#include "engine/MappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error fileError(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Отобразить size байт fd; при ошибке дескриптор закрывается
+uint8_t *mapOrClose(int fd, size_t size, int prot, int flags, const std::string &path) {
+    void *p = ::mmap(nullptr, size, prot, flags, fd, 0);
+    if (p == MAP_FAILED) {
+        const auto err = fileError("Cannot map", path);
+        ::close(fd);
+        throw err;
+    }
+    // Файл читается и пишется от начала к концу: ядро может читать с опережением
+    ::madvise(p, size, MADV_SEQUENTIAL);
+    return static_cast<uint8_t *>(p);
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string &path) : m_path(path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw fileError("Cannot open", path);
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        const auto err = fileError("Cannot stat", path);
+        ::close(fd);
+        throw err;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("Not a regular file: " + path);
+    }
+
+    m_size = m_mapped = static_cast<size_t>(st.st_size);
+    if (m_size != 0) m_data = mapOrClose(fd, m_size, PROT_READ, MAP_PRIVATE, path);
+    // Отображение остаётся действительным и после закрытия дескриптора
+    ::close(fd);
+}
+
+MappedFile MappedFile::create(const std::string &path, size_t size) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw fileError("Cannot create", path);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        const auto err = fileError("Cannot resize", path);
+        ::close(fd);
+        throw err;
+    }
+    MappedFile file;
+    file.m_path = path;
+    if (size != 0) file.m_data = mapOrClose(fd, size, PROT_READ | PROT_WRITE, MAP_SHARED, path);
+    file.m_size = file.m_mapped = size;
+    file.m_fd = fd;
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_path(std::move(other.m_path)), m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)), m_mapped(std::exchange(other.m_mapped, 0)),
+      m_fd(std::exchange(other.m_fd, -1)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_path = std::move(other.m_path);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_mapped = std::exchange(other.m_mapped, 0);
+        m_fd = std::exchange(other.m_fd, -1);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+ByteSpan MappedFile::writableBytes() {
+    if (!writable()) throw std::logic_error("MappedFile is read-only: " + m_path);
+    return ByteSpan(m_data, m_size);
+}
+
+void MappedFile::truncate(size_t size) {
+    if (!writable()) throw std::logic_error("MappedFile is read-only: " + m_path);
+    if (size >= m_size) return;
+    if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0) throw fileError("Cannot resize", m_path);
+    m_size = size;
+}
+
+void MappedFile::unmap() noexcept {
+    if (m_data) ::munmap(m_data, m_mapped);
+    if (m_fd >= 0) ::close(m_fd);
+    m_data = nullptr;
+    m_size = m_mapped = 0;
+    m_fd = -1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ft4222/ft4222_span.hpp"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Файл, отображённый в память (mmap)
+ *
+ * Содержимое не копируется: страницы подгружаются ядром по мере обращения и
+ * разделяются всеми потоками процесса, поэтому один образ можно отдавать нескольким
+ * рабочим потокам без копий и без синхронизации. Файл, созданный create(), отображается
+ * для записи (MAP_SHARED): данные, принятые прямо в writableBytes(), попадают в файл
+ * без промежуточного буфера.
+ *
+ * @note  Пустой файл не отображается: bytes() возвращает пустой буфер.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Отобразить файл
+     * @param path Путь к файлу
+     * @throw std::runtime_error Если файл не открывается, не является обычным файлом
+     *        или не отображается
+     */
+    explicit MappedFile(const std::string &path);
+
+    /**
+     * @brief Создать (или перезаписать) файл размером size байт и отобразить для записи
+     * @param path Путь к файлу
+     * @param size Размер файла
+     * @throw std::runtime_error Если файл не создаётся или не отображается
+     */
+    static MappedFile create(const std::string &path, size_t size);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    ~MappedFile();
+
+    ConstByteSpan bytes() const noexcept { return ConstByteSpan(m_data, m_size); }
+    size_t size() const noexcept { return m_size; }
+    const std::string &path() const noexcept { return m_path; }
+    bool writable() const noexcept { return m_fd >= 0; }
+
+    /**
+     * @brief Буфер для записи в файл
+     * @throw std::logic_error Если файл открыт только для чтения
+     */
+    ByteSpan writableBytes();
+
+    /**
+     * @brief Укоротить созданный файл (например, после неполного чтения)
+     * @param size Новый размер (не больше size())
+     * @throw std::logic_error Если файл открыт только для чтения
+     * @throw std::runtime_error При ошибке ftruncate
+     */
+    void truncate(size_t size);
+
+private:
+    MappedFile() = default;
+    void unmap() noexcept;
+
+    std::string m_path;
+    uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped = 0; ///< Длина отображения (truncate не меняет)
+    int m_fd = -1;       ///< Дескриптор созданного файла; -1 — только чтение
+};
@@ -0,0 +1,66 @@
+#include "MultiDevice.hpp"
+
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// Список может прийти из кэша DeviceCache: индекс D2XX после hot-plug уже другой, а
+// Location ID и серийный номер остаются за тем же адаптером
+void openDevice(FTDevice &device, const DeviceInfo &info) {
+    if (info.locationId != 0)
+        device.openByLocation(info.locationId);
+    else if (!info.serial.empty())
+        device.openBySerial(info.serial);
+    else
+        device.open(info.index);
+}
+
+} // namespace
+
+std::string MultiDeviceRunner::keyFor(const DeviceInfo &info) {
+    return info.serial.empty() ? "#" + std::to_string(info.index) : info.serial;
+}
+
+std::map<std::string, DeviceJobResult>
+MultiDeviceRunner::run(const std::vector<DeviceInfo> &devices, const Job &job) {
+    // Каждый поток пишет только в свой элемент, поэтому синхронизация не нужна
+    std::vector<DeviceJobResult> results(devices.size());
+    std::vector<std::thread> workers;
+    workers.reserve(devices.size());
+
+    for (size_t i = 0; i < devices.size(); ++i) {
+        workers.emplace_back([&, i] {
+            using Clock = std::chrono::steady_clock;
+            DeviceJobResult &res = results[i];
+            res.info = devices[i];
+
+            std::ostringstream out;
+            const auto start = Clock::now();
+            try {
+                FTDevice device;
+                openDevice(device, devices[i]);
+                job(device, devices[i], out);
+                res.ok = true;
+            } catch (const std::exception &ex) {
+                res.error = ex.what();
+            } catch (...) {
+                res.error = "unknown error";
+            }
+            res.elapsedUs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+            res.output = out.str();
+        });
+    }
+
+    for (auto &w : workers) w.join();
+
+    std::map<std::string, DeviceJobResult> merged;
+    for (auto &res : results) {
+        std::string key = keyFor(res.info);
+        merged.emplace(std::move(key), std::move(res));
+    }
+    return merged;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Результат выполнения задания на одном адаптере
+ */
+struct DeviceJobResult {
+    DeviceInfo info;        ///< Устройство, на котором выполнялось задание
+    bool ok = false;        ///< Задание завершилось без исключений
+    std::string error;      ///< Текст ошибки (если ok == false)
+    std::string output;     ///< Текстовый вывод задания
+    uint64_t elapsedUs = 0; ///< Время от открытия устройства до завершения задания, мкс
+};
+
+/**
+ * @brief Параллельный запуск задания на нескольких FT4222
+ *
+ * @note  Каждое устройство открывается в собственном рабочем потоке собственным
+ *        экземпляром FTDevice (у каждого свой Impl::deviceMutex), поэтому общее
+ *        время прохода определяется самым медленным адаптером, а не суммой.
+ */
+class MultiDeviceRunner {
+public:
+    /// Задание, выполняемое на открытом устройстве; вывод пишется в out
+    using Job = std::function<void(FTDevice &device, const DeviceInfo &info, std::ostream &out)>;
+
+    /**
+     * @brief Выполнить задание на всех переданных устройствах одновременно
+     * @param devices Список устройств (обычно DeviceEnumerator::listDevices())
+     * @param job Задание; исключения перехватываются и попадают в DeviceJobResult::error
+     * @return Результаты, упорядоченные по серийному номеру
+     *
+     * @note  Устройство без серийного номера получает ключ вида "#<index>". Адаптер
+     *        открывается по Location ID (без него — по серийному номеру), а не по индексу,
+     *        поэтому список из DeviceCache остаётся верным и после hot-plug.
+     */
+    static std::map<std::string, DeviceJobResult> run(const std::vector<DeviceInfo> &devices,
+                                                      const Job &job);
+
+    /**
+     * @brief Ключ результата для устройства
+     * @param info Описание устройства
+     * @return Серийный номер или "#<index>", если он пуст
+     */
+    static std::string keyFor(const DeviceInfo &info);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+/**
+ * @brief Дождаться момента времени с точностью до микросекунд
+ * @param deadline Момент по steady_clock
+ *
+ * Сон до последней миллисекунды, затем активное ожидание — планировщик ОС
+ * просыпается с точностью порядка сотен микросекунд, слоты расписания (GPIO,
+ * воспроизведение трассы) бывают короче этого.
+ */
+inline void waitUntil(std::chrono::steady_clock::time_point deadline) {
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return;
+        const auto left = deadline - now;
+        if (left > std::chrono::milliseconds(2))
+            std::this_thread::sleep_for(left - std::chrono::milliseconds(1));
+    }
+}
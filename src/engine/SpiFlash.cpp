@@ -0,0 +1,137 @@
+#include "engine/SpiFlash.hpp"
+#include "engine/EngineUtil.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kReadId = 0x9F;
+constexpr uint8_t kReadStatus = 0x05;
+constexpr uint8_t kWriteEnable = 0x06;
+constexpr uint8_t kRead = 0x03;
+constexpr uint8_t kPageProgram = 0x02;
+constexpr uint8_t kSectorErase = 0x20;
+constexpr uint8_t kBlockErase = 0xD8;
+
+constexpr uint8_t kStatusBusy = 0x01;
+
+void checkRange(uint32_t offset, size_t size) {
+    if (static_cast<uint64_t>(offset) + size > SpiNorFlash::kAddressLimit)
+        throw std::invalid_argument("SPI flash range exceeds 3-byte addressing");
+}
+
+bool erased(ConstByteSpan data) {
+    return std::all_of(data.begin(), data.end(), [](uint8_t b) { return b == 0xFF; });
+}
+
+} // namespace
+
+uint32_t SpiNorFlash::readJedecId() {
+    const uint8_t tx[4] = {kReadId, 0, 0, 0};
+    uint8_t rx[4] = {};
+    m_device.spiMasterSingleReadWrite(rx, tx, true);
+    return uint32_t{rx[1]} << 16 | uint32_t{rx[2]} << 8 | rx[3];
+}
+
+uint8_t SpiNorFlash::readStatus() {
+    const uint8_t tx[2] = {kReadStatus, 0};
+    uint8_t rx[2] = {};
+    m_device.spiMasterSingleReadWrite(rx, tx, true);
+    return rx[1];
+}
+
+void SpiNorFlash::command(uint8_t opcode) {
+    const uint8_t tx[1] = {opcode};
+    m_device.spiMasterSingleWrite(tx, true);
+}
+
+// Команда, 3 байта адреса и данные одной транзакцией
+void SpiNorFlash::addressed(uint8_t opcode, uint32_t address, ConstByteSpan data) {
+    uint8_t frame[4 + kPageSize];
+    frame[0] = opcode;
+    frame[1] = static_cast<uint8_t>(address >> 16);
+    frame[2] = static_cast<uint8_t>(address >> 8);
+    frame[3] = static_cast<uint8_t>(address);
+    std::copy(data.begin(), data.end(), frame + 4);
+    m_device.spiMasterSingleWrite(ConstByteSpan(frame, 4 + data.size()), true);
+}
+
+void SpiNorFlash::waitReady(uint64_t &polls) {
+    const auto deadline = Clock::now() + std::chrono::milliseconds(m_timeoutMs);
+    for (;;) {
+        ++polls;
+        if ((readStatus() & kStatusBusy) == 0) return;
+        if (Clock::now() > deadline)
+            throw std::runtime_error("SPI flash stayed busy for more than " +
+                                     std::to_string(m_timeoutMs) + " ms");
+    }
+}
+
+SpiFlashEraseStats SpiNorFlash::erase(uint32_t offset, size_t size) {
+    checkRange(offset, size);
+    SpiFlashEraseStats stats;
+    const auto start = Clock::now();
+    uint64_t at = offset - offset % kSectorSize;
+    const uint64_t end = static_cast<uint64_t>(offset) + size;
+    while (at < end) {
+        const bool block = at % kBlockSize == 0 && end - at >= kBlockSize;
+        command(kWriteEnable);
+        addressed(block ? kBlockErase : kSectorErase, static_cast<uint32_t>(at));
+        waitReady(stats.polls);
+        if (block) {
+            ++stats.blocks;
+            at += kBlockSize;
+        } else {
+            ++stats.sectors;
+            at += kSectorSize;
+        }
+    }
+    stats.elapsedUs = sinceUs(start);
+    return stats;
+}
+
+SpiFlashWriteStats SpiNorFlash::program(uint32_t offset, ConstByteSpan data, bool skipBlank) {
+    checkRange(offset, data.size());
+    SpiFlashWriteStats stats;
+    const auto start = Clock::now();
+    size_t done = 0;
+    while (done < data.size()) {
+        const uint32_t at = offset + static_cast<uint32_t>(done);
+        // Не дальше конца страницы: иначе кристалл завернёт запись на её начало
+        const auto chunk = data.subspan(done, kPageSize - at % kPageSize);
+        done += chunk.size();
+        if (skipBlank && erased(chunk)) {
+            ++stats.skippedPages;
+            continue;
+        }
+        command(kWriteEnable);
+        addressed(kPageProgram, at, chunk);
+        ++stats.pages;
+        try {
+            waitReady(stats.polls);
+        } catch (const std::runtime_error &ex) {
+            throw std::runtime_error("SPI flash program at " + hexOffset(at) + ": " + ex.what());
+        }
+    }
+    stats.bytes = done;
+    stats.elapsedUs = sinceUs(start);
+    return stats;
+}
+
+void SpiNorFlash::read(uint32_t offset, ByteSpan out) {
+    checkRange(offset, out.size());
+    if (out.empty()) return;
+    const uint8_t cmd[4] = {kRead, static_cast<uint8_t>(offset >> 16),
+                            static_cast<uint8_t>(offset >> 8), static_cast<uint8_t>(offset)};
+    m_device.spiMasterSingleWrite(cmd, false);
+    const size_t got = m_device.spiMasterSingleRead(out, true);
+    if (got != out.size())
+        throw std::runtime_error("SPI flash read incomplete at " + hexOffset(offset) + ": " +
+                                 std::to_string(got) + "/" + std::to_string(out.size()) + " bytes");
+}
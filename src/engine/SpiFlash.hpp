@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Итог стирания
+ */
+struct SpiFlashEraseStats {
+    size_t sectors = 0;     ///< Стёрто секторов 4 КБ
+    size_t blocks = 0;      ///< Стёрто блоков 64 КБ
+    uint64_t polls = 0;     ///< Чтений регистра статуса
+    uint64_t elapsedUs = 0; ///< Время, мкс
+};
+
+/**
+ * @brief Итог программирования
+ */
+struct SpiFlashWriteStats {
+    size_t bytes = 0;        ///< Байт образа
+    size_t pages = 0;        ///< Запрограммировано страниц
+    size_t skippedPages = 0; ///< Пропущено страниц из одних 0xFF (только при skipBlank)
+    uint64_t polls = 0;      ///< Чтений регистра статуса
+    uint64_t elapsedUs = 0;  ///< Время, мкс
+};
+
+/**
+ * @brief SPI NOR flash (25-я серия: W25Q, MX25, IS25, ...) на SPI Master одного интерфейса
+ *
+ * Общий для этих кристаллов набор команд с 3-байтовым адресом: RDID 0x9F, RDSR 0x05,
+ * WREN 0x06, READ 0x03, PAGE PROGRAM 0x02 (страница 256 байт), SECTOR ERASE 0x20 (4 КБ),
+ * BLOCK ERASE 0xD8 (64 КБ). Каждая команда — отдельная транзакция с CS от начала до
+ * конца; окончание программирования и стирания определяется опросом бита WIP.
+ *
+ * @note  Устройство должно быть в режиме SPI Master (SPI_IO_SINGLE, режим 0 или 3).
+ *        Адресуются первые 16 МБ.
+ */
+class SpiNorFlash {
+public:
+    static constexpr size_t kPageSize = 256;
+    static constexpr size_t kSectorSize = 0x1000;
+    static constexpr size_t kBlockSize = 0x10000;
+    static constexpr uint64_t kAddressLimit = 0x1000000;
+
+    /**
+     * @param device Устройство в режиме SPI Master
+     * @param timeoutMs Предел ожидания одного программирования или стирания, мс
+     */
+    explicit SpiNorFlash(FTDevice &device, unsigned timeoutMs = 3000)
+        : m_device(device), m_timeoutMs(timeoutMs) {}
+
+    /**
+     * @brief JEDEC ID: производитель, тип, ёмкость (0xEF4018 — W25Q128)
+     * @throw std::runtime_error При ошибке устройства
+     */
+    uint32_t readJedecId();
+
+    /// Регистр статуса 1 (бит 0 — WIP, бит 1 — WEL)
+    uint8_t readStatus();
+
+    /**
+     * @brief Стереть область, покрывающую [offset, offset + size)
+     * @return Статистика
+     * @throw std::invalid_argument Если область выходит за kAddressLimit
+     * @throw std::runtime_error При ошибке устройства или таймауте стирания
+     *
+     * @note  Стирается с точностью до сектора; выровненные 64 КБ внутри области стираются
+     *        одной командой блока.
+     */
+    SpiFlashEraseStats erase(uint32_t offset, size_t size);
+
+    /**
+     * @brief Запрограммировать стёртую область постранично
+     * @param offset Смещение
+     * @param data Данные
+     * @param skipBlank Не программировать страницы из одних 0xFF — только если область
+     *        только что стёрта, иначе в них остаётся прежнее содержимое
+     * @return Статистика
+     * @throw std::invalid_argument Если область выходит за kAddressLimit
+     * @throw std::runtime_error При ошибке устройства или таймауте программирования
+     */
+    SpiFlashWriteStats program(uint32_t offset, ConstByteSpan data, bool skipBlank = false);
+
+    /**
+     * @brief Прочитать область одной командой READ
+     * @param offset Смещение
+     * @param out Буфер (читается out.size() байт)
+     * @throw std::invalid_argument Если область выходит за kAddressLimit
+     * @throw std::runtime_error При ошибке устройства или неполном чтении
+     */
+    void read(uint32_t offset, ByteSpan out);
+
+private:
+    void command(uint8_t opcode);
+    void addressed(uint8_t opcode, uint32_t address, ConstByteSpan data = {});
+    void waitReady(uint64_t &polls);
+
+    FTDevice &m_device;
+    unsigned m_timeoutMs;
+};
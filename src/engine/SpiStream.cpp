@@ -0,0 +1,145 @@
+#include "SpiStream.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+SpiStreamStats SpiStreamCapture::run(FTDevice &device, std::ostream &sink,
+                                     const SpiStreamOptions &options) {
+    using Clock = std::chrono::steady_clock;
+
+    if (options.chunkSize == 0) throw std::invalid_argument("chunk size must be positive");
+    if (options.bufferCount < 2) throw std::invalid_argument("at least two buffers are required");
+    if (options.totalBytes == 0 && options.durationMs == 0)
+        throw std::invalid_argument("either total bytes or duration must be set");
+
+    struct Slot {
+        std::vector<uint8_t> data;
+        size_t length = 0;
+    };
+
+    // Кольцо с одним производителем (этот поток) и одним потребителем (писатель):
+    // produced/consumed только растут, слот produced % N свободен, пока produced - consumed < N
+    std::vector<Slot> slots(options.bufferCount);
+    for (auto &slot : slots) slot.data.resize(options.chunkSize);
+    std::vector<uint8_t> scratch(options.chunkSize);
+
+    std::atomic<uint64_t> produced{0}, consumed{0};
+    std::atomic<bool> readerDone{false}, writerFailed{false};
+    std::mutex mutex;
+    std::condition_variable ready;
+    uint64_t bytesWritten = 0;
+
+    std::thread writer([&] {
+        for (;;) {
+            const uint64_t next = consumed.load(std::memory_order_relaxed);
+            if (produced.load(std::memory_order_acquire) == next) {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] {
+                    return produced.load(std::memory_order_acquire) != next ||
+                           readerDone.load(std::memory_order_acquire);
+                });
+                if (produced.load(std::memory_order_acquire) == next) return;
+            }
+
+            const Slot &slot = slots[next % slots.size()];
+            sink.write(reinterpret_cast<const char *>(slot.data.data()),
+                       static_cast<std::streamsize>(slot.length));
+            if (!sink) {
+                writerFailed.store(true, std::memory_order_release);
+                return;
+            }
+            bytesWritten += slot.length;
+            consumed.store(next + 1, std::memory_order_release);
+        }
+    });
+
+    SpiStreamStats stats;
+    std::exception_ptr readError;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(options.durationMs);
+
+    try {
+        while (!writerFailed.load(std::memory_order_acquire)) {
+            if (options.totalBytes && stats.bytesCaptured >= options.totalBytes) break;
+            if (options.durationMs && Clock::now() >= deadline) break;
+
+            size_t want = options.chunkSize;
+            if (options.totalBytes)
+                want = static_cast<size_t>(
+                    std::min<uint64_t>(want, options.totalBytes - stats.bytesCaptured));
+
+            const uint64_t index = produced.load(std::memory_order_relaxed);
+            const bool full = index - consumed.load(std::memory_order_acquire) >= slots.size();
+            Slot *slot = full ? nullptr : &slots[index % slots.size()];
+            uint8_t *target = slot ? slot->data.data() : scratch.data();
+
+            const size_t got = device.spiMasterSingleRead(ByteSpan(target, want), true);
+            ++stats.chunks;
+            stats.bytesCaptured += got;
+            if (got < want) ++stats.shortChunks;
+            if (got == 0) break; // устройство перестало отдавать данные
+
+            if (!slot) {
+                ++stats.droppedChunks;
+                continue;
+            }
+            slot->length = got;
+            produced.store(index + 1, std::memory_order_release);
+            { std::lock_guard<std::mutex> lock(mutex); }
+            ready.notify_one();
+        }
+    } catch (...) {
+        readError = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readerDone.store(true, std::memory_order_release);
+    }
+    ready.notify_one();
+    writer.join();
+    sink.flush();
+
+    stats.bytesWritten = bytesWritten;
+    stats.elapsedUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+
+    if (readError) std::rethrow_exception(readError);
+    if (writerFailed.load() || !sink) throw std::runtime_error("write to output failed");
+    return stats;
+}
+
+SpiStreamStats SpiStreamCapture::run(FTDevice &device, ByteSpan out,
+                                     const SpiStreamOptions &options) {
+    using Clock = std::chrono::steady_clock;
+
+    if (options.chunkSize == 0) throw std::invalid_argument("chunk size must be positive");
+    const uint64_t total = options.totalBytes ? std::min<uint64_t>(options.totalBytes, out.size())
+                                              : out.size();
+
+    SpiStreamStats stats;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(options.durationMs);
+    while (stats.bytesCaptured < total) {
+        if (options.durationMs && Clock::now() >= deadline) break;
+        const size_t want =
+            static_cast<size_t>(std::min<uint64_t>(options.chunkSize, total - stats.bytesCaptured));
+        const size_t got = device.spiMasterSingleRead(
+            out.subspan(static_cast<size_t>(stats.bytesCaptured), want), true);
+        ++stats.chunks;
+        stats.bytesCaptured += got;
+        if (got < want) ++stats.shortChunks;
+        if (got == 0) break; // устройство перестало отдавать данные
+    }
+    stats.bytesWritten = stats.bytesCaptured;
+    stats.elapsedUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    return stats;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Параметры потокового захвата SPI
+ *
+ * @note  Захват останавливается по первому достигнутому ограничению: totalBytes
+ *        или durationMs (0 — ограничение не задано; хотя бы одно должно быть задано).
+ */
+struct SpiStreamOptions {
+    size_t chunkSize = 4096;  ///< Размер одного чтения spiMasterSingleRead, байт
+    uint64_t totalBytes = 0;  ///< Сколько байт захватить (0 — без ограничения)
+    uint64_t durationMs = 0;  ///< Длительность захвата, мс (0 — без ограничения)
+    size_t bufferCount = 8;   ///< Число предвыделенных буферов в кольце
+};
+
+/**
+ * @brief Итог потокового захвата
+ */
+struct SpiStreamStats {
+    uint64_t bytesCaptured = 0; ///< Прочитано с SPI (включая отброшенные чанки)
+    uint64_t bytesWritten = 0;  ///< Записано в приёмник
+    uint64_t chunks = 0;        ///< Выполнено чтений
+    uint64_t shortChunks = 0;   ///< Чтения, вернувшие меньше запрошенного
+    uint64_t droppedChunks = 0; ///< Чанки, отброшенные из-за заполненного кольца
+    uint64_t elapsedUs = 0;     ///< Время от первого чтения до записи последнего чанка, мкс
+
+    /// Устойчивая скорость записи в приёмник, МБ/с
+    double megabytesPerSecond() const {
+        return elapsedUs ? static_cast<double>(bytesWritten) / static_cast<double>(elapsedUs) : 0.0;
+    }
+};
+
+/**
+ * @brief Непрерывный захват SPI в двоичный поток с отдельным потоком записи
+ *
+ * Вызывающий поток в цикле читает spiMasterSingleRead в кольцо из bufferCount
+ * предвыделенных буферов, фоновый поток записывает заполненные буферы в приёмник.
+ * Чтение по USB и запись на диск перекрываются; если приёмник не успевает и свободных
+ * буферов нет, чанк всё равно читается (чтобы не прерывать поток с АЦП) во
+ * вспомогательный буфер и учитывается как отброшенный.
+ */
+class SpiStreamCapture {
+public:
+    /**
+     * @brief Выполнить захват
+     * @param device Устройство в режиме SPI Master
+     * @param sink Приёмник двоичных данных (например, std::ofstream в режиме binary)
+     * @param options Параметры захвата
+     * @return Статистика захвата
+     * @throw std::invalid_argument При некорректных параметрах
+     * @throw std::runtime_error При ошибке устройства или записи в приёмник
+     */
+    static SpiStreamStats run(FTDevice &device, std::ostream &sink, const SpiStreamOptions &options);
+
+    /**
+     * @brief Захват прямо в буфер назначения (обычно отображённый в память файл)
+     * @param device Устройство в режиме SPI Master
+     * @param out Буфер назначения; totalBytes ограничивается его размером
+     * @param options Параметры захвата (bufferCount не используется)
+     * @return Статистика захвата; данные — первые bytesWritten байт out
+     * @throw std::invalid_argument При некорректных параметрах
+     * @throw std::runtime_error При ошибке устройства
+     *
+     * @note  Чанки читаются по месту, без кольца и потока записи: копий нет, отброшенных
+     *        чанков не бывает, запись на диск выполняет ядро по грязным страницам.
+     */
+    static SpiStreamStats run(FTDevice &device, ByteSpan out, const SpiStreamOptions &options);
+};
@@ -0,0 +1,215 @@
+#include "engine/TraceReplay.hpp"
+#include "engine/Pacing.hpp"
+#include "ft4222/ft4222_trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using ft4222stats::Op;
+
+/**
+ * Выполнить запись на устройстве.
+ * Прочитанные данные и значения (для операций, возвращающих байт) — в got, в той же
+ * форме, в какой их сохраняет запись. Возвращает true, если операция завершилась
+ * неуспешно без исключения (неполное чтение в фазе пакета).
+ */
+bool issue(FTDevice &device, const ft4222trace::Record &r, std::vector<uint8_t> &got) {
+    const auto addr = static_cast<uint8_t>(r.address);
+    const bool batch = (r.flags & ft4222trace::FlagBatch) != 0;
+    got.clear();
+
+    switch (r.op) {
+    case Op::I2CInit:
+        device.initI2CMaster(static_cast<FTDevice::I2CSpeed>(r.param));
+        return false;
+    case Op::I2CWrite:
+        device.i2cMasterWrite(addr, r.write, static_cast<uint8_t>(r.param));
+        return false;
+    case Op::I2CRead: {
+        got.resize(r.value);
+        got.resize(device.i2cMasterRead(addr, got, static_cast<uint8_t>(r.param)));
+        return batch && got.size() != r.value;
+    }
+    case Op::I2CReadRegister:
+        got.resize(r.value);
+        got.resize(device.i2cReadRegister(addr, r.write, got));
+        return false;
+    case Op::I2CStatus:
+        got.push_back(device.i2cMasterGetStatus());
+        return false;
+    case Op::I2CResetBus:
+        device.i2cMasterResetBus();
+        return false;
+    case Op::I2CScan:
+        got = device.scanI2CBus(addr, static_cast<uint8_t>(r.param),
+                                static_cast<uint8_t>(r.param >> 8));
+        return false;
+    case Op::I2CScanFast: {
+        I2CScanOptions opt;
+        opt.writeProbe = (r.param & (1u << 8)) != 0;
+        opt.fastClock = (r.param & (1u << 9)) != 0;
+        for (const auto &d : device.scanI2CBusFast(addr, static_cast<uint8_t>(r.param), opt).devices)
+            got.push_back(d.address);
+        return false;
+    }
+    case Op::SpiInit: {
+        ft4222trace::SpiInitConfig spi;
+        if (!ft4222trace::parseSpiInitParam(r.param, spi))
+            throw std::runtime_error("invalid spi_init parameters in trace");
+        device.initSPIMaster(spi.mode, static_cast<FTDevice::SPIClockDivider>(spi.divider), spi.cpol,
+                             spi.cpha);
+        return false;
+    }
+    case Op::SpiRead:
+        got.resize(r.value);
+        got.resize(device.spiMasterSingleRead(ByteSpan(got), r.param != 0));
+        return false;
+    case Op::SpiWrite:
+        device.spiMasterSingleWrite(r.write, r.param != 0);
+        return false;
+    case Op::SpiXfer:
+        got.resize(r.write.size());
+        got.resize(device.spiMasterSingleReadWrite(got, r.write, r.param != 0));
+        return false;
+    case Op::SpiMultiXfer: {
+        const ConstByteSpan write(r.write);
+        got.resize(r.value);
+        got.resize(device.spiMasterMultiReadWrite(got, write.subspan(0, r.address),
+                                                  write.subspan(r.address), r.param));
+        return false;
+    }
+    case Op::GpioInit: {
+        const auto dir = [&](unsigned bit) { return (r.param >> bit) & 1u ? GPIO_OUTPUT : GPIO_INPUT; };
+        device.initGPIO(dir(0), dir(1), dir(2), dir(3));
+        return false;
+    }
+    case Op::GpioRead:
+        if (r.address == ft4222trace::kAllGpioPorts)
+            got.push_back(device.readGPIOPorts());
+        else
+            got.push_back(device.readGPIO(static_cast<GPIO_Port>(r.address)) ? 1 : 0);
+        return false;
+    case Op::GpioWrite:
+        if (r.address == ft4222trace::kAllGpioPorts)
+            device.writeGPIOPorts(static_cast<uint8_t>(r.param), static_cast<uint8_t>(r.param >> 8));
+        else
+            device.writeGPIO(static_cast<GPIO_Port>(r.address), r.param != 0);
+        return false;
+    case Op::UsbRead:
+        got.resize(r.value);
+        got.resize(device.read(ByteSpan(got), r.param));
+        return false;
+    case Op::UsbWrite:
+        device.write(ConstByteSpan(r.write), r.param);
+        return false;
+    case Op::ResetChip:
+        device.resetChip();
+        return false;
+    case Op::SetClock: {
+        FT4222_ClockRate rate = SYS_CLK_60;
+        if (!ft4222trace::parseClockParam(r.param, rate))
+            throw std::runtime_error("invalid system clock in trace");
+        device.setClockRate(rate);
+        return false;
+    }
+    default:
+        throw std::logic_error("operation is not replayable");
+    }
+}
+
+bool replayable(Op op) {
+    return op != Op::Open && op != Op::Close && op != Op::I2CBatch && op < Op::Count;
+}
+
+// Операции, у которых запись хранит результат в value, а не в данных чтения
+bool valueResult(Op op) {
+    return op == Op::I2CStatus || op == Op::GpioRead;
+}
+
+std::string hexByte(uint8_t b) {
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "0x%02X", b);
+    return buf;
+}
+
+std::string describeDiff(const std::vector<uint8_t> &expected, const std::vector<uint8_t> &got) {
+    if (expected.size() != got.size())
+        return "got " + std::to_string(got.size()) + " byte(s), expected " +
+               std::to_string(expected.size());
+    size_t i = 0;
+    while (expected[i] == got[i]) ++i;
+    return "data differs at byte " + std::to_string(i) + ": expected " + hexByte(expected[i]) +
+           ", got " + hexByte(got[i]);
+}
+
+} // namespace
+
+TraceReplayStats TraceReplayer::run(FTDevice &device, std::istream &trace,
+                                    const TraceReplayOptions &options) {
+    if (!options.maxSpeed && !(options.speed > 0))
+        throw std::invalid_argument("replay speed must be positive");
+
+    ft4222trace::Reader reader(trace);
+    ft4222trace::Record r;
+    std::vector<uint8_t> got;
+    std::vector<uint8_t> valueBuffer;
+    TraceReplayStats stats;
+
+    const auto start = Clock::now();
+    for (uint64_t index = 0; reader.next(r); ++index) {
+        ++stats.records;
+        if (!replayable(r.op)) {
+            ++stats.skipped;
+            continue;
+        }
+
+        if (!options.maxSpeed) {
+            const auto deadline = start + std::chrono::nanoseconds(static_cast<int64_t>(
+                                              static_cast<double>(r.timeNs) / options.speed));
+            waitUntil(deadline);
+            const auto lateUs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - deadline)
+                    .count());
+            if (lateUs > stats.maxLateUs) stats.maxLateUs = lateUs;
+        }
+
+        bool failed = false;
+        std::string error;
+        try {
+            failed = issue(device, r, got);
+        } catch (const std::exception &ex) {
+            failed = true;
+            error = ex.what();
+            ++stats.errors;
+        }
+        ++stats.replayed;
+
+        const bool recordedFailed = (r.flags & ft4222trace::FlagError) != 0;
+        std::string what;
+        if (failed != recordedFailed) {
+            what = recordedFailed ? "recorded failure, replay succeeded"
+                                  : "replay failed: " + (error.empty() ? "incomplete read" : error);
+        } else if (!failed) {
+            const std::vector<uint8_t> *want = &r.read;
+            if (valueResult(r.op)) {
+                valueBuffer.assign(1, static_cast<uint8_t>(r.value));
+                want = &valueBuffer;
+            }
+            if (got != *want) what = describeDiff(*want, got);
+        }
+
+        if (!what.empty()) {
+            ++stats.mismatches;
+            if (stats.reported.size() < TraceReplayStats::kMaxReported)
+                stats.reported.push_back({index, r.op, std::move(what)});
+        }
+    }
+    stats.elapsedUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    return stats;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_stats.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Параметры воспроизведения трассы
+ */
+struct TraceReplayOptions {
+    bool maxSpeed = false; ///< Без пауз между записями
+    double speed = 1.0;    ///< Множитель скорости относительно записи (2 — вдвое быстрее)
+};
+
+/**
+ * @brief Расхождение воспроизведения с записью
+ */
+struct TraceMismatch {
+    uint64_t index = 0; ///< Номер записи в трассе (с нуля)
+    ft4222stats::Op op = ft4222stats::Op::Count;
+    std::string what;   ///< Описание: "data differs at byte 3: expected 0x12, got 0x34" и т.п.
+};
+
+/**
+ * @brief Итог воспроизведения трассы
+ */
+struct TraceReplayStats {
+    static constexpr size_t kMaxReported = 16;
+
+    uint64_t records = 0;    ///< Прочитано записей
+    uint64_t replayed = 0;   ///< Выполнено операций
+    uint64_t skipped = 0;    ///< Пропущено записей (операции, которые не воспроизводятся)
+    uint64_t errors = 0;     ///< Операций, завершившихся исключением при воспроизведении
+    uint64_t mismatches = 0; ///< Операций, разошедшихся с записью по результату или данным
+    uint64_t elapsedUs = 0;  ///< Общее время, мкс
+    uint64_t maxLateUs = 0;  ///< Наибольшее опоздание операции относительно расписания, мкс
+    std::vector<TraceMismatch> reported; ///< Первые kMaxReported расхождений
+};
+
+/**
+ * @brief Воспроизведение двоичной трассы (ft4222trace) на устройстве
+ *
+ * Каждая запись повторяется тем же методом FTDevice с теми же адресом, флагами и
+ * данными записи. Расхождением считается другой исход (ошибка / успех) или другие
+ * прочитанные данные и значения (статус I2C, уровни GPIO, найденные адреса).
+ * Фазы пакетов (FlagBatch) повторяются одиночными транзакциями; неполное чтение в
+ * такой фазе считается ошибкой, как в I2CBatchResult.
+ *
+ * @note  open/close и сами пакеты в трассе не воспроизводятся (учитываются в skipped):
+ *        устройство открывается вызывающей стороной.
+ */
+class TraceReplayer {
+public:
+    /**
+     * @brief Воспроизвести трассу
+     * @param device Открытое устройство
+     * @param trace Поток файла трассы (binary)
+     * @param options Параметры воспроизведения
+     * @return Статистика
+     * @throw std::invalid_argument При неположительной скорости
+     * @throw std::runtime_error Если файл не является трассой или повреждён
+     */
+    static TraceReplayStats run(FTDevice &device, std::istream &trace,
+                                const TraceReplayOptions &options = {});
+};
@@ -1,7 +1,10 @@
 #include "ft4222.hpp"
+#include "ft4222_stats.hpp"
+#include "ft4222_trace.hpp"
 
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iomanip>
 #include <limits>
@@ -18,10 +21,41 @@
 struct FTDevice::Impl {
     FT_HANDLE ftHandle = nullptr; ///< Хэндл открытого FTDI-устройства
     FT4222_ClockRate clockRate = SYS_CLK_60; ///< Текущая системная частота
-    Mode currentMode = Mode::Unknown; ///< Текущий режим работы
+    StateWord state; ///< Открыто ли устройство, режим и поколение (читается без мьютекса)
+    I2CSpeed i2cSpeed = I2CSpeed::S400K; ///< Скорость, заданная последним initI2CMaster
+    FT4222_SPIMode spiMode = SPI_IO_SINGLE; ///< Линии SPI, заданные последним initSPIMaster
+    SPIClockDivider spiDivider = SPIClockDivider::DIV_512; ///< Делитель последнего initSPIMaster
+    FT4222_SPICPOL spiPolarity = CLK_IDLE_LOW; ///< Полярность последнего initSPIMaster
+    FT4222_SPICPHA spiPhase = CLK_LEADING; ///< Фаза последнего initSPIMaster
+    uint8_t gpioDirs = 0; ///< Направления последнего initGPIO (бит n — вывод n на выход)
+    FT4222_ClockRate modeClock = SYS_CLK_60; ///< Системная частота на момент последнего init*
+    bool clockKnown = false; ///< clockRate задана setClockRate (до этого частота чипа неизвестна)
+    std::vector<uint8_t> spiWriteScratch; ///< Буфер сборки фаз multi-I/O записи
     bool isFt4222 = false; ///< Флаг, что это именно FT4222
     uint32_t openedIndex = std::numeric_limits<uint32_t>::max(); ///< Индекс открытого устройства
+    std::atomic<uint32_t> chipVersion{0}; ///< Версия чипа, прочитанная при открытии
+    std::atomic<uint32_t> dllVersion{0}; ///< Версия LibFT4222, прочитанная при открытии
+    std::atomic<bool> versionKnown{false}; ///< chipVersion/dllVersion действительны
+    std::atomic<uint8_t> chipMode{0}; ///< Режим чипа (DCNF), прочитанный при открытии
     std::mutex deviceMutex; ///< Мьютекс для потокобезопасности
+
+    Mode mode() const noexcept { return state.load().mode; }
+
+    // Версии и режим чипа не меняются, пока устройство открыто: читаются один раз под
+    // deviceMutex, после чего устройство публикуется открытым
+    void attach() {
+        FT4222_Version version;
+        const bool known = FT4222_GetVersion(ftHandle, &version) == FT4222_OK;
+        if (known) {
+            chipVersion.store(version.chipVersion, std::memory_order_relaxed);
+            dllVersion.store(version.dllVersion, std::memory_order_relaxed);
+        }
+        versionKnown.store(known, std::memory_order_relaxed);
+        uint8 dcnf = 0;
+        chipMode.store(FT4222_GetChipMode(ftHandle, &dcnf) == FT4222_OK ? dcnf : 0,
+                       std::memory_order_relaxed);
+        state.publish(true, Mode::Unknown);
+    }
 };
 
 // DeviceEnumerator
@@ -82,18 +116,20 @@ std::vector<DeviceInfo> DeviceEnumerator::listDevices() {
     return out;
 }
 
-void DeviceEnumerator::printDevices() {
-    auto devices = listDevices();
+void DeviceEnumerator::printDevices(std::ostream &os) {
+    printDevices(listDevices(), os);
+}
 
+void DeviceEnumerator::printDevices(const std::vector<DeviceInfo> &devices, std::ostream &os) {
     if (devices.empty()) {
-        std::cout << "FT4222 устройства не найдены" << std::endl;
+        os << "FT4222 устройства не найдены" << std::endl;
         return;
     }
 
-    std::cout << "Найдено FT4222 устройств: " << devices.size() << std::endl;
+    os << "Найдено FT4222 устройств: " << devices.size() << std::endl;
 
     for (const auto &dev : devices) {
-        std::cout
+        os
             << std::endl
             << "Index      : " << dev.index << "\n"
             << "Serial     : " << dev.serial << "\n"
@@ -106,18 +142,43 @@ namespace {
 
 void checkFT4222Status(FT4222_STATUS status, const std::string &operation) {
     if (status != FT4222_OK) {
+        ft4222stats::OpScope::noteStatus(static_cast<int>(status));
         std::ostringstream oss;
         oss << operation << " failed with FT4222_STATUS: " << status;
         throw std::runtime_error(oss.str());
     }
 }
 
+// Неуспешный итог варианта без исключений: вызов учитывается как ошибка в статистике
+// и в трассе (trace — nullptr, пока устройство не захвачено)
+I2CResult i2cFailure(ft4222stats::OpScope &stat, ft4222trace::Scope *trace, I2CError error,
+                     const char *what, FT4222_STATUS status = FT4222_OK) noexcept {
+    const int code = status == FT4222_OK ? -1 : static_cast<int>(status);
+    stat.fail(code);
+    if (trace) trace->fail(code);
+    I2CResult r;
+    r.error = error;
+    r.status = status;
+    r.what = what;
+    return r;
+}
+
 void checkFTStatus(FT_STATUS status, const std::string &operation) {
     if (status != FT_OK) {
+        ft4222stats::OpScope::noteStatus(static_cast<int>(status));
         throw FtException(operation + " failed", status);
     }
 }
 
+// Снять CS после прерванной многочанковой передачи. Пустую транзакцию LibFT4222 не
+// выполняет, поэтому CS снимается чтением одного байта с isEndTransaction.
+void endSpiTransaction(FT_HANDLE handle) {
+    uint8 dummy = 0;
+    uint16 bytesRead = 0;
+    checkFT4222Status(FT4222_SPIMaster_SingleRead(handle, &dummy, 1, &bytesRead, TRUE),
+                      "FT4222_SPIMaster_SingleRead");
+}
+
 } // namespace
 
 // Конструкторы и деструктор
@@ -130,7 +191,9 @@ void checkFTStatus(FT_STATUS status, const std::string &operation) {
  * Исходный объект становится невалидным (pimpl = nullptr).
  */
 FTDevice::FTDevice(FTDevice &&other) noexcept
-    : pimpl(std::move(other.pimpl)), m_logger(std::move(other.m_logger)) {}
+    : pimpl(std::move(other.pimpl)), m_logger(std::move(other.m_logger)),
+      m_logLevel(other.m_logLevel), m_trace(std::move(other.m_trace)),
+      m_i2cRecovery(other.m_i2cRecovery) {}
 
 /**
  * @brief Оператор присваивания перемещением
@@ -144,6 +207,9 @@ FTDevice &FTDevice::operator=(FTDevice &&other) noexcept {
         close();
         pimpl = std::move(other.pimpl);
         m_logger = std::move(other.m_logger);
+        m_logLevel = other.m_logLevel;
+        m_trace = std::move(other.m_trace);
+        m_i2cRecovery = other.m_i2cRecovery;
     }
     return *this;
 }
@@ -184,7 +250,7 @@ FTDevice::~FTDevice() {
         close(); // Пытаемся корректно закрыть устройство
     }
     catch (...) {
-        log("Exception in destructor while closing device");
+        log(LogLevel::Error, "Exception in destructor while closing device");
     }
 }
 
@@ -201,6 +267,7 @@ FTDevice::~FTDevice() {
  *       проверка типа устройства, получение информации о версии.
  */
 void FTDevice::open(uint32_t index) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
     if (!pimpl) pimpl = std::make_unique<Impl>();
 
     if (isOpen()) {
@@ -233,18 +300,14 @@ void FTDevice::open(uint32_t index) {
 
     pimpl->isFt4222 = true;
     pimpl->openedIndex = index;
+    pimpl->attach();
 
-    // Получаем версию библиотеки и чипа для отладки
-    FT4222_Version version;
-    FT4222_STATUS ft4222Status = FT4222_GetVersion(pimpl->ftHandle, &version);
-    if (ft4222Status == FT4222_OK) {
-        std::ostringstream oss;
-        oss << "FT4222 Chip: 0x" << std::hex << version.chipVersion
-            << ", Lib: 0x" << version.dllVersion << std::dec;
-        log(oss.str());
+    // Версия библиотеки и чипа для отладки
+    if (pimpl->versionKnown.load(std::memory_order_relaxed)) {
+        log(LogLevel::Info, [&] { return "FT4222 " + getVersionString(); });
     }
 
-    log("Device opened index=" + std::to_string(index));
+    log(LogLevel::Info, [&] { return "Device opened index=" + std::to_string(index); });
 }
 
 /**
@@ -257,6 +320,7 @@ void FTDevice::open(uint32_t index) {
  * известен точный серийный номер конкретного устройства.
  */
 void FTDevice::openBySerial(const std::string &serialNumber) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
     if (!pimpl) pimpl = std::make_unique<Impl>();
 
     if (isOpen()) {
@@ -272,7 +336,37 @@ void FTDevice::openBySerial(const std::string &serialNumber) {
     checkFTStatus(status, "FT_OpenEx by serial");
 
     pimpl->isFt4222 = true;
-    log("Device opened by serial: " + serialNumber);
+    pimpl->attach();
+    log(LogLevel::Info, [&] { return "Device opened by serial: " + serialNumber; });
+}
+
+/**
+ * @brief Открыть устройство по Location ID
+ * @param locationId Идентификатор местоположения устройства
+ * @throw std::runtime_error Если устройство уже открыто
+ * @throw FtException При ошибке открытия
+ *
+ * Используется вместе с DeviceCache: Location ID из снимка списка остаётся
+ * действительным, даже если индексы FTDI сдвинулись.
+ */
+void FTDevice::openByLocation(uint32_t locationId) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
+    if (!pimpl) pimpl = std::make_unique<Impl>();
+
+    if (isOpen()) {
+        throw std::runtime_error("Device is already open");
+    }
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+
+    FT_STATUS status = FT_OpenEx(reinterpret_cast<PVOID>(static_cast<uintptr_t>(locationId)),
+                                 FT_OPEN_BY_LOCATION,
+                                 &pimpl->ftHandle);
+    checkFTStatus(status, "FT_OpenEx by location");
+
+    pimpl->isFt4222 = true;
+    pimpl->attach();
+    log(LogLevel::Info, [&] { return "Device opened by location: " + std::to_string(locationId); });
 }
 
 /**
@@ -283,6 +377,7 @@ void FTDevice::openBySerial(const std::string &serialNumber) {
  */
 void FTDevice::close() noexcept {
     if (!pimpl || !pimpl->ftHandle) return; // Уже закрыто
+    ft4222stats::OpScope stat(ft4222stats::Op::Close);
 
     try {
         std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
@@ -294,20 +389,19 @@ void FTDevice::close() noexcept {
 
         // Закрываем хэндл FTDI
         FT_STATUS status = FT_Close(pimpl->ftHandle);
-        if (status != FT_OK && m_logger) {
-            log("FT_Close failed with status: " + std::to_string(status));
+        if (status != FT_OK) {
+            log(LogLevel::Error, [&] { return "FT_Close failed with status: " + std::to_string(status); });
         }
 
         // Сбрасываем состояние
+        pimpl->state.publish(false, Mode::Unknown);
         pimpl->ftHandle = nullptr;
-        pimpl->currentMode = Mode::Unknown;
+        pimpl->clockKnown = false;
         pimpl->isFt4222 = false;
-        log("Device closed");
+        log(LogLevel::Info, "Device closed");
     }
     catch (...) {
-        if (m_logger) {
-            log("Exception during close");
-        }
+        log(LogLevel::Error, "Exception during close");
     }
 }
 
@@ -316,7 +410,52 @@ void FTDevice::close() noexcept {
  * @return true если устройство открыто и это FT4222
  */
 bool FTDevice::isOpen() const noexcept {
-    return pimpl && pimpl->ftHandle != nullptr && pimpl->isFt4222;
+    return pimpl && pimpl->state.load().open;
+}
+
+FTDevice::State FTDevice::state() const noexcept {
+    return pimpl ? pimpl->state.load() : State{};
+}
+
+/**
+ * @brief Подключить запись трассы транзакций
+ * @param recorder Запись трассы (nullptr — отключить)
+ *
+ * Методы устройства читают m_trace под deviceMutex, поэтому замена под тем же
+ * мьютексом дожидается завершения текущей операции.
+ */
+void FTDevice::setTraceRecorder(std::shared_ptr<ft4222trace::Recorder> recorder) {
+    if (!pimpl) pimpl = std::make_unique<Impl>();
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    m_trace = std::move(recorder);
+}
+
+std::shared_ptr<ft4222trace::Recorder> FTDevice::traceRecorder() const {
+    if (!pimpl) return nullptr;
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    return m_trace;
+}
+
+/**
+ * @brief Задать политику восстановления I2C
+ * @param policy Политика (maxRetries == 0 — без восстановления)
+ *
+ * Политика читается I2C-методами под deviceMutex, поэтому меняется под ним же.
+ */
+void FTDevice::setI2CRecoveryPolicy(const I2CRecoveryPolicy &policy) {
+    if (!pimpl) pimpl = std::make_unique<Impl>();
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    m_i2cRecovery = policy;
+}
+
+I2CRecoveryPolicy FTDevice::i2cRecoveryPolicy() const {
+    if (!pimpl) return m_i2cRecovery;
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    return m_i2cRecovery;
 }
 
 // I2C Master функции
@@ -324,126 +463,260 @@ bool FTDevice::isOpen() const noexcept {
 /**
  * @brief Инициализировать устройство в режиме I2C Master
  * @param speed Скорость шины I2C
+ * @param force Инициализировать, даже если конфигурация не изменилась
+ * @return true, если вызывался FT4222_I2CMaster_Init
  * @throw std::runtime_error Если устройство не открыто или ошибка инициализации
  *
  * @note  Устанавливает устройство в режим I2C ведущего с указанной скоростью.
  *        После инициализации можно выполнять операции чтения/записи на шине I2C.
  */
-void FTDevice::initI2CMaster(I2CSpeed speed) const {
+bool FTDevice::initI2CMaster(I2CSpeed speed, bool force) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CInit);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CInit, 0, static_cast<uint32_t>(speed));
+
+    // Та же конфигурация уже действует — повторный Init только сбросил бы контроллер
+    if (!force && pimpl->mode() == Mode::I2C_Master && pimpl->i2cSpeed == speed &&
+        pimpl->modeClock == pimpl->clockRate) {
+        log(LogLevel::Debug, "I2C Master already initialized, skipping");
+        return false;
+    }
 
     // Инициализируем I2C Master с указанной скоростью
     FT4222_STATUS status = FT4222_I2CMaster_Init(pimpl->ftHandle,
                                                  static_cast<uint32>(speed));
     checkFT4222Status(status, "FT4222_I2CMaster_Init");
 
-    pimpl->currentMode = Mode::I2C_Master; // Устанавливаем текущий режим
+    pimpl->state.setMode(Mode::I2C_Master); // Устанавливаем текущий режим
+    pimpl->i2cSpeed = speed;
+    pimpl->modeClock = pimpl->clockRate;
 
-    std::ostringstream oss;
-    oss << "I2C Master initialized at " << static_cast<int>(speed) << " kbps";
-    log(oss.str());
+    log(LogLevel::Info, [&] {
+        return "I2C Master initialized at " + std::to_string(static_cast<int>(speed)) + " kbps";
+    });
+    return true;
 }
 
 /**
- * @brief Записать данные на шину I2C
+ * @brief Записать данные на шину I2C без исключений
  * @param deviceAddress 7-битный адрес устройства
  * @param data Данные для передачи
  * @param flag Флаги транзакции
- * @throw std::runtime_error При ошибках устройства или неполной передаче
+ * @return Итог: I2CError::Incomplete, если устройство подтвердило не все байты
  *
  * @note  Выполняет запись данных на шину I2C с указанным адресом устройства.
  *        Флаг определяет условия начала/окончания транзакции.
  */
-void FTDevice::i2cMasterWrite(uint8_t deviceAddress, const std::vector<uint8_t> &data,
-                              uint8_t flag) const {
-    if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master) {
-        throw std::runtime_error("Device not in I2C Master mode");
+I2CResult FTDevice::tryI2CWrite(uint8_t deviceAddress, ConstByteSpan data, uint8_t flag) const noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CWrite, data.size());
+    if (!isOpen()) return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master) {
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
     }
 
-    if (data.empty()) return; // Нет данных для записи
+    if (data.empty()) return {}; // Нет данных для записи
+    if (data.size() > I2C_MAX_TRANSFER) {
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C write longer than 65535 bytes");
+    }
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CWrite, deviceAddress, flag);
+    trace.write(data);
 
     uint16 bytesWritten = 0;
-    // Выполняем запись на шину I2C
-    FT4222_STATUS status = FT4222_I2CMaster_WriteEx(pimpl->ftHandle,
-                                                    deviceAddress,
-                                                    flag,
-                                                    const_cast<uint8*>(data.data()),
-                                                    static_cast<uint16>(data.size()),
-                                                    &bytesWritten);
+    FT4222_STATUS status = FT4222_OK;
+    uint8_t controller = 0;
+    // Выполняем запись на шину I2C (LibFT4222 не изменяет буфер, const_cast безопасен)
+    retryI2C(status, [&] {
+        status = FT4222_I2CMaster_WriteEx(pimpl->ftHandle,
+                                          deviceAddress,
+                                          flag,
+                                          const_cast<uint8*>(data.data()),
+                                          static_cast<uint16>(data.size()),
+                                          &bytesWritten);
+        return status == FT4222_OK && bytesWritten == data.size();
+    }, &controller);
 
-    checkFT4222Status(status, "FT4222_I2CMaster_WriteEx");
+    if (status != FT4222_OK) {
+        I2CResult r = i2cFailure(stat, &trace, I2CError::Device, "FT4222_I2CMaster_WriteEx", status);
+        r.controllerStatus = controller;
+        return r;
+    }
 
     // Проверяем, что переданы все данные
     if (bytesWritten != data.size()) {
-        std::ostringstream oss;
-        oss << "I2C Master Write incomplete. Written: " << bytesWritten
-            << "/" << data.size() << " bytes";
-        throw std::runtime_error(oss.str());
+        I2CResult r = i2cFailure(stat, &trace, I2CError::Incomplete, "I2C Master Write");
+        r.bytes = bytesWritten;
+        r.controllerStatus = controller;
+        return r;
     }
 
     // Логируем успешную операцию
-    std::ostringstream oss;
-    oss << "I2C Write to 0x" << std::hex << static_cast<int>(deviceAddress)
-        << std::dec << ": " << bytesWritten << " bytes, flag=0x"
-        << std::hex << static_cast<int>(flag) << std::dec;
-    log(oss.str());
+    log(LogLevel::Debug, [&] {
+        std::ostringstream oss;
+        oss << "I2C Write to 0x" << std::hex << static_cast<int>(deviceAddress)
+            << std::dec << ": " << bytesWritten << " bytes, flag=0x"
+            << std::hex << static_cast<int>(flag) << std::dec;
+        return oss.str();
+    });
+    I2CResult r;
+    r.bytes = bytesWritten;
+    return r;
 }
 
 /**
- * @brief Прочитать данные с шины I2C
+ * @brief Прочитать данные с шины I2C в буфер вызывающей стороны без исключений
  * @param deviceAddress 7-битный адрес устройства
- * @param bytesToRead Количество байт для чтения
+ * @param buffer Буфер назначения
  * @param flag Флаги транзакции
- * @return Вектор прочитанных данных
- * @throw std::runtime_error При ошибках устройства
+ * @return Итог; bytes — фактически прочитано
  *
  * @note Выполняет чтение данных с шины I2C с указанного устройства.
- *       Возвращает фактически прочитанные данные (может быть меньше запрошенного).
+ *       Может прочитать меньше, чем buffer.size(), — это не ошибка.
  */
-std::vector<uint8_t> FTDevice::i2cMasterRead(uint8_t deviceAddress, size_t bytesToRead,
-                                             uint8_t flag) {
-    if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master) {
-        throw std::runtime_error("Device not in I2C Master mode");
+I2CResult FTDevice::tryI2CRead(uint8_t deviceAddress, ByteSpan buffer, uint8_t flag) noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CRead, buffer.size());
+    if (!isOpen()) return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master) {
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
     }
 
-    if (bytesToRead == 0) return {}; // Нет данных для чтения
+    if (buffer.empty()) return {}; // Нет данных для чтения
+    if (buffer.size() > I2C_MAX_TRANSFER) {
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C read longer than 65535 bytes");
+    }
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CRead, deviceAddress, flag);
+    trace.value(static_cast<uint32_t>(buffer.size()));
 
-    std::vector<uint8_t> buffer(bytesToRead);
     uint16 bytesRead = 0;
+    FT4222_STATUS status = FT4222_OK;
+    I2CResult r;
+
+    // Выполняем чтение с шины I2C; короткое чтение без сбоя шины не повторяется
+    retryI2C(status, [&] {
+        status = FT4222_I2CMaster_ReadEx(pimpl->ftHandle,
+                                         deviceAddress,
+                                         flag,
+                                         buffer.data(),
+                                         static_cast<uint16>(buffer.size()),
+                                         &bytesRead);
+        return status == FT4222_OK && bytesRead == buffer.size();
+    }, &r.controllerStatus);
 
-    // Выполняем чтение с шины I2C
-    const FT4222_STATUS status = FT4222_I2CMaster_ReadEx(pimpl->ftHandle,
-                                                         deviceAddress,
-                                                         flag,
-                                                         buffer.data(),
-                                                         static_cast<uint16>(bytesToRead),
-                                                         &bytesRead);
-
-    checkFT4222Status(status, "FT4222_I2CMaster_ReadEx");
+    if (status != FT4222_OK) {
+        const uint8_t controller = r.controllerStatus;
+        r = i2cFailure(stat, &trace, I2CError::Device, "FT4222_I2CMaster_ReadEx", status);
+        r.controllerStatus = controller;
+        return r;
+    }
+    trace.read(buffer.subspan(0, bytesRead));
 
-    // Если прочитано не все, уменьшаем размер буфера
-    if (bytesRead != bytesToRead) {
-        buffer.resize(bytesRead);
-        log("I2C Read incomplete: " + std::to_string(bytesRead) + "/" +
-            std::to_string(bytesToRead) + " bytes");
+    if (bytesRead != buffer.size()) {
+        log(LogLevel::Debug, [&] {
+            return "I2C Read incomplete: " + std::to_string(bytesRead) + "/" +
+                   std::to_string(buffer.size()) + " bytes";
+        });
     }
 
     // Логируем успешную операцию
-    std::ostringstream oss;
-    oss << "I2C Read from 0x" << std::hex << static_cast<int>(deviceAddress)
-        << std::dec << ": " << bytesRead << " bytes, flag=0x"
-        << std::hex << static_cast<int>(flag) << std::dec;
-    log(oss.str());
+    log(LogLevel::Debug, [&] {
+        std::ostringstream oss;
+        oss << "I2C Read from 0x" << std::hex << static_cast<int>(deviceAddress)
+            << std::dec << ": " << bytesRead << " bytes, flag=0x"
+            << std::hex << static_cast<int>(flag) << std::dec;
+        return oss.str();
+    });
+
+    r.bytes = bytesRead;
+    return r;
+}
 
-    return buffer;
+/**
+ * @brief Прочитать регистр устройства с повторным START без исключений
+ * @param deviceAddress 7-битный адрес устройства
+ * @param regBytes Номер регистра
+ * @param buffer Буфер назначения
+ * @return Итог: I2CError::Incomplete при неполной записи номера регистра, иначе
+ *         bytes — фактически прочитано
+ *
+ * Фаза записи завершается без STOP (флаг START), чтение начинается с Repeated START
+ * и завершается STOP. Обе фазы выполняются под одним захватом мьютекса, поэтому
+ * между ними не вклинятся другие транзакции этого устройства.
+ */
+I2CResult FTDevice::tryI2CReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes,
+                                       ByteSpan buffer) noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CReadRegister, buffer.size());
+    if (!isOpen()) return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master) {
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
+    }
+
+    if (buffer.empty()) return {};
+    if (buffer.size() > I2C_MAX_TRANSFER || regBytes.size() > I2C_MAX_TRANSFER) {
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C read longer than 65535 bytes");
+    }
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CReadRegister, deviceAddress);
+    trace.write(regBytes);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+
+    // Повтор восстанавливает обе фазы: после сброса шины Repeated START без записи невозможен
+    uint16 bytesWritten = 0;
+    uint16 bytesRead = 0;
+    const char *phase = "FT4222_I2CMaster_WriteEx";
+    FT4222_STATUS status = FT4222_OK;
+    uint8_t controller = 0;
+    retryI2C(status, [&] {
+        bytesRead = 0;
+        phase = "FT4222_I2CMaster_WriteEx";
+        status = FT4222_I2CMaster_WriteEx(pimpl->ftHandle,
+                                          deviceAddress,
+                                          START,
+                                          const_cast<uint8*>(regBytes.data()),
+                                          static_cast<uint16>(regBytes.size()),
+                                          &bytesWritten);
+        if (status != FT4222_OK || bytesWritten != regBytes.size()) return false;
+
+        phase = "FT4222_I2CMaster_ReadEx";
+        status = FT4222_I2CMaster_ReadEx(pimpl->ftHandle,
+                                         deviceAddress,
+                                         Repeated_START | STOP,
+                                         buffer.data(),
+                                         static_cast<uint16>(buffer.size()),
+                                         &bytesRead);
+        return status == FT4222_OK && bytesRead == buffer.size();
+    }, &controller);
+
+    if (status != FT4222_OK) {
+        I2CResult r = i2cFailure(stat, &trace, I2CError::Device, phase, status);
+        r.controllerStatus = controller;
+        return r;
+    }
+    if (bytesWritten != regBytes.size()) {
+        I2CResult r = i2cFailure(stat, &trace, I2CError::Incomplete, "I2C register address write");
+        r.bytes = bytesWritten;
+        r.controllerStatus = controller;
+        return r;
+    }
+    trace.read(buffer.subspan(0, bytesRead));
+
+    log(LogLevel::Debug, [&] {
+        std::ostringstream oss;
+        oss << "I2C register read from 0x" << std::hex << static_cast<int>(deviceAddress)
+            << std::dec << ": reg " << regBytes.size() << " byte(s), " << bytesRead << "/"
+            << buffer.size() << " bytes";
+        return oss.str();
+    });
+
+    I2CResult r;
+    r.bytes = bytesRead;
+    r.controllerStatus = controller;
+    return r;
 }
 
 /**
@@ -454,16 +727,19 @@ std::vector<uint8_t> FTDevice::i2cMasterRead(uint8_t deviceAddress, size_t bytes
  * Возвращает текущее состояние шины I2C (занята/свободна, ошибки и т.д.).
  */
 uint8_t FTDevice::i2cMasterGetStatus() {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CStatus);
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master) {
+    if (pimpl->mode() != Mode::I2C_Master) {
         throw std::runtime_error("Device not in I2C Master mode");
     }
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CStatus);
 
     uint8 status = 0;
     FT4222_STATUS ftStatus = FT4222_I2CMaster_GetStatus(pimpl->ftHandle, &status);
     checkFT4222Status(ftStatus, "FT4222_I2CMaster_GetStatus");
+    trace.value(status);
 
     return status;
 }
@@ -476,17 +752,53 @@ uint8_t FTDevice::i2cMasterGetStatus() {
  * или необходимости восстановления после ошибок.
  */
 void FTDevice::i2cMasterResetBus() {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CResetBus);
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master) {
+    if (pimpl->mode() != Mode::I2C_Master) {
         throw std::runtime_error("Device not in I2C Master mode");
     }
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CResetBus);
 
     FT4222_STATUS status = FT4222_I2CMaster_ResetBus(pimpl->ftHandle);
     checkFT4222Status(status, "FT4222_I2CMaster_ResetBus");
 
-    log("I2C bus reset");
+    log(LogLevel::Info, "I2C bus reset");
+}
+
+// Примитивы восстановления I2C (вызываются под мьютексом из retryI2C)
+
+bool FTDevice::i2cControllerStatusLocked(uint8_t &controllerStatus) const {
+    uint8 status = 0;
+    if (FT4222_I2CMaster_GetStatus(pimpl->ftHandle, &status) != FT4222_OK) return false;
+    controllerStatus = status;
+    return true;
+}
+
+bool FTDevice::i2cResetBusLocked() const {
+    return FT4222_I2CMaster_ResetBus(pimpl->ftHandle) == FT4222_OK;
+}
+
+// Сброс чипа возвращает частоту и режим по умолчанию: восстанавливаем их без переоткрытия
+bool FTDevice::i2cResetChipLocked() const {
+    if (FT4222_ChipReset(pimpl->ftHandle) != FT4222_OK) {
+        pimpl->state.setMode(Mode::Unknown);
+        return false;
+    }
+    if (pimpl->clockKnown && FT4222_SetClock(pimpl->ftHandle, pimpl->clockRate) != FT4222_OK) {
+        pimpl->clockRate = SYS_CLK_60; // чип остался на частоте после сброса
+        pimpl->clockKnown = false;
+        pimpl->state.setMode(Mode::Unknown);
+        return false;
+    }
+    if (FT4222_I2CMaster_Init(pimpl->ftHandle, static_cast<uint32>(pimpl->i2cSpeed)) != FT4222_OK) {
+        pimpl->state.setMode(Mode::Unknown);
+        return false;
+    }
+    pimpl->modeClock = pimpl->clockRate;
+    pimpl->state.touch();
+    return true;
 }
 
 /**
@@ -495,8 +807,9 @@ void FTDevice::i2cMasterResetBus() {
 std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress,
                                           uint8_t endAddress,
                                           uint8_t flag) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CScan);
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master) {
+    if (pimpl->mode() != Mode::I2C_Master) {
         throw std::runtime_error("Device not in I2C Master mode");
     }
 
@@ -505,6 +818,8 @@ std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress,
     std::vector<uint8_t> found;
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CScan, startAddress,
+                                endAddress | static_cast<uint32_t>(flag) << 8);
 
     for (uint16_t addr = startAddress; addr <= endAddress; ++addr) {
         uint8_t dummy = 0;
@@ -520,20 +835,24 @@ std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress,
                                                        &bytesRead);
 
         if (status != FT4222_OK) {
-            std::ostringstream oss;
-            oss << "I2C scan status @0x" << std::hex << static_cast<int>(addr)
-                << " status=" << std::dec << status;
-            log(oss.str());
+            log(LogLevel::Trace, [&] {
+                std::ostringstream oss;
+                oss << "I2C scan status @0x" << std::hex << static_cast<int>(addr)
+                    << " status=" << std::dec << status;
+                return oss.str();
+            });
             continue;
         }
 
         // Проверяем флаги контроллера: если адрес или данные не подтверждены, считаем что устройства нет
         status = FT4222_I2CMaster_GetStatus(pimpl->ftHandle, &controllerStatus);
         if (status != FT4222_OK) {
-            std::ostringstream oss;
-            oss << "I2C get status failed @0x" << std::hex << static_cast<int>(addr)
-                << " status=" << std::dec << status;
-            log(oss.str());
+            log(LogLevel::Trace, [&] {
+                std::ostringstream oss;
+                oss << "I2C get status failed @0x" << std::hex << static_cast<int>(addr)
+                    << " status=" << std::dec << status;
+                return oss.str();
+            });
             continue;
         }
 
@@ -542,24 +861,201 @@ std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress,
 
         if (!addrNack && !dataNack) {
             found.push_back(static_cast<uint8_t>(addr));
-            if (m_logger) {
+            log(LogLevel::Trace, [&] {
                 std::ostringstream oss;
                 oss << "I2C ACK @ 0x" << std::hex << static_cast<int>(addr);
-                log(oss.str());
-            }
+                return oss.str();
+            });
         }
-        else if (m_logger) {
-            std::ostringstream oss;
-            oss << "I2C NACK @ 0x" << std::hex << static_cast<int>(addr)
-                << " ctrl=0x" << static_cast<int>(controllerStatus);
-            log(oss.str());
+        else {
+            log(LogLevel::Trace, [&] {
+                std::ostringstream oss;
+                oss << "I2C NACK @ 0x" << std::hex << static_cast<int>(addr)
+                    << " ctrl=0x" << static_cast<int>(controllerStatus);
+                return oss.str();
+            });
         }
     }
 
-    log("I2C scan finished, found " + std::to_string(found.size()) + " device(s)");
+    log(LogLevel::Debug, [&] {
+        return "I2C scan finished, found " + std::to_string(found.size()) + " device(s)";
+    });
+    trace.read(found);
     return found;
 }
 
+/**
+ * @brief Быстро просканировать шину I2C с замером времени опроса
+ *
+ * Чтение одного байта (START+ADDR+R ... STOP) само по себе показывает NACK адреса:
+ * при ошибке или нулевом sizeTransferred адрес отбрасывается без дополнительного
+ * запроса статуса. Статус контроллера запрашивается только для «кандидатов», поэтому
+ * на пустых адресах выполняется одна транзакция USB вместо двух.
+ * Опрос записью (writeProbe) — для устройств, у которых чтение меняет состояние.
+ * LibFT4222 не выполняет WriteEx без данных (нулевой буфер отвергается), поэтому
+ * передаётся один байт kI2CWriteProbeByte: у регистровых устройств он задаёт указатель
+ * регистра, но содержимое не меняет. NACK адреса виден по sizeTransferred == 0, как при
+ * чтении.
+ */
+I2CScanResult FTDevice::scanI2CBusFast(uint8_t startAddress,
+                                       uint8_t endAddress,
+                                       const I2CScanOptions &options) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CScanFast);
+    using Clock = std::chrono::steady_clock;
+
+    if (!isOpen()) throw std::runtime_error("Device not open");
+    if (pimpl->mode() != Mode::I2C_Master) {
+        throw std::runtime_error("Device not in I2C Master mode");
+    }
+
+    if (startAddress > endAddress) std::swap(startAddress, endAddress);
+
+    I2CScanResult result;
+    const auto sweepStart = Clock::now();
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CScanFast, startAddress,
+                                endAddress | (options.writeProbe ? 1u << 8 : 0) |
+                                    (options.fastClock ? 1u << 9 : 0));
+
+    const I2CSpeed originalSpeed = pimpl->i2cSpeed;
+    const bool switchClock = options.fastClock && originalSpeed != I2CSpeed::S1M;
+    if (switchClock) {
+        checkFT4222Status(FT4222_I2CMaster_Init(pimpl->ftHandle,
+                                                static_cast<uint32>(I2CSpeed::S1M)),
+                          "FT4222_I2CMaster_Init");
+    }
+
+    for (uint16_t addr = startAddress; addr <= endAddress; ++addr) {
+        const auto probeStart = Clock::now();
+        bool candidate = false;
+
+        if (options.writeProbe) {
+            uint8 probe = kI2CWriteProbeByte;
+            uint16 bytesWritten = 0;
+            const FT4222_STATUS status = FT4222_I2CMaster_WriteEx(pimpl->ftHandle,
+                                                                  static_cast<uint8>(addr),
+                                                                  START_AND_STOP,
+                                                                  &probe,
+                                                                  1,
+                                                                  &bytesWritten);
+            candidate = status == FT4222_OK && bytesWritten != 0;
+        }
+        else {
+            uint8_t dummy = 0;
+            uint16 bytesRead = 0;
+            const FT4222_STATUS status = FT4222_I2CMaster_ReadEx(pimpl->ftHandle,
+                                                                 static_cast<uint8>(addr),
+                                                                 START_AND_STOP,
+                                                                 &dummy,
+                                                                 1,
+                                                                 &bytesRead);
+            candidate = status == FT4222_OK && bytesRead != 0;
+        }
+
+        bool ack = false;
+        if (candidate) {
+            uint8 controllerStatus = 0;
+            const FT4222_STATUS status = FT4222_I2CMaster_GetStatus(pimpl->ftHandle,
+                                                                    &controllerStatus);
+            ack = status == FT4222_OK && !I2CM_ADDRESS_NACK(controllerStatus) &&
+                  !I2CM_DATA_NACK(controllerStatus);
+        }
+
+        const auto probeUs = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - probeStart)
+                .count());
+        ++result.probed;
+        result.maxProbeUs = std::max(result.maxProbeUs, probeUs);
+
+        if (ack) {
+            result.devices.push_back({static_cast<uint8_t>(addr), probeUs});
+        }
+    }
+
+    if (switchClock) {
+        checkFT4222Status(FT4222_I2CMaster_Init(pimpl->ftHandle,
+                                                static_cast<uint32>(originalSpeed)),
+                          "FT4222_I2CMaster_Init");
+    }
+
+    result.elapsedUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sweepStart).count());
+
+    std::vector<uint8_t> foundAddresses;
+    if (m_trace) {
+        for (const auto &d : result.devices) foundAddresses.push_back(d.address);
+        trace.read(foundAddresses);
+    }
+
+    log(LogLevel::Debug, [&] {
+        std::ostringstream oss;
+        oss << "I2C fast scan finished, found " << result.devices.size() << " device(s) in "
+            << result.elapsedUs << " us";
+        return oss.str();
+    });
+    return result;
+}
+
+/**
+ * @brief Выполнить пакет I2C-операций за один захват устройства
+ *
+ * Каждая операция выполняется как WriteEx (если есть данные записи) и затем ReadEx
+ * (если задана длина чтения) с флагами своей фазы. Ошибка отдельной фазы не прерывает
+ * пакет, а фиксируется в статусе операции; лог формируется один раз на пакет.
+ */
+void FTDevice::runI2CBatch(const I2CBatch &batch, I2CBatchResult &result) {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CBatch);
+    if (!isOpen()) throw std::runtime_error("Device not open");
+    if (pimpl->mode() != Mode::I2C_Master) {
+        throw std::runtime_error("Device not in I2C Master mode");
+    }
+
+    result.prepare(batch);
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    const uint64_t traceStart = m_trace ? m_trace->nowNs() : 0;
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const I2CBatch::Op &op = batch.ops()[i];
+        I2CBatchResult::OpStatus &st = result.ops[i];
+
+        st.ok = retryI2C(st.status, [&] {
+            st.written = 0;
+            st.read = 0;
+            if (op.writeLength != 0) {
+                st.status = FT4222_I2CMaster_WriteEx(pimpl->ftHandle,
+                                                     op.address,
+                                                     op.flag,
+                                                     const_cast<uint8*>(batch.writeData().data() +
+                                                                        op.writeOffset),
+                                                     op.writeLength,
+                                                     &st.written);
+                if (st.status != FT4222_OK || st.written != op.writeLength) return false;
+            }
+
+            if (op.readLength != 0) {
+                st.status = FT4222_I2CMaster_ReadEx(pimpl->ftHandle,
+                                                    op.address,
+                                                    op.readFlag,
+                                                    result.data.data() + st.readOffset,
+                                                    op.readLength,
+                                                    &st.read);
+                return st.status == FT4222_OK && st.read == op.readLength;
+            }
+            return true;
+        });
+        if (!st.ok) ++result.failed;
+    }
+
+    traceI2CBatch(batch, result, traceStart);
+
+    log(LogLevel::Debug, [&] {
+        return "I2C batch: " + std::to_string(batch.size()) + " op(s), " +
+               std::to_string(result.failed) + " failed";
+    });
+}
+
 // SPI Master функции
 
 /**
@@ -568,16 +1064,39 @@ std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress,
  * @param clockDiv Делитель частоты
  * @param polarity Полярность тактового сигнала
  * @param phase Фаза тактового сигнала
+ * @param force Инициализировать, даже если конфигурация не изменилась
+ * @return true, если вызывалась LibFT4222
  * @throw std::runtime_error При ошибках устройства
  *
  * Настраивает устройство как SPI ведущий с указанными параметрами.
  * По умолчанию используется одиночный режим, делитель 512, стандартные полярность и фаза.
  */
-void FTDevice::initSPIMaster(FT4222_SPIMode mode, SPIClockDivider clockDiv,
-                             FT4222_SPICPOL polarity, FT4222_SPICPHA phase) {
+bool FTDevice::initSPIMaster(FT4222_SPIMode mode, SPIClockDivider clockDiv,
+                             FT4222_SPICPOL polarity, FT4222_SPICPHA phase, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiInit);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiInit, 0,
+                             ft4222trace::spiInitParam(mode, static_cast<FT4222_SPIClock>(clockDiv),
+                                                       polarity, phase));
+
+    const bool sameClock = !force && pimpl->mode() == Mode::SPI_Master &&
+                           pimpl->spiDivider == clockDiv && pimpl->spiPolarity == polarity &&
+                           pimpl->spiPhase == phase && pimpl->modeClock == pimpl->clockRate;
+    if (sameClock && pimpl->spiMode == mode) {
+        log(LogLevel::Debug, "SPI Master already initialized, skipping");
+        return false;
+    }
+    if (sameClock) {
+        // Меняется только число линий данных
+        FT4222_STATUS status = FT4222_SPIMaster_SetLines(pimpl->ftHandle, mode);
+        checkFT4222Status(status, "FT4222_SPIMaster_SetLines");
+        pimpl->spiMode = mode;
+        pimpl->state.touch();
+        log(LogLevel::Info, "SPI Master lines changed");
+        return true;
+    }
 
     // Инициализируем SPI Master
     FT4222_STATUS status = FT4222_SPIMaster_Init(pimpl->ftHandle,
@@ -588,76 +1107,96 @@ void FTDevice::initSPIMaster(FT4222_SPIMode mode, SPIClockDivider clockDiv,
                                                  0x01); // ssoMap: только CS0 активен
     checkFT4222Status(status, "FT4222_SPIMaster_Init");
 
-    pimpl->currentMode = Mode::SPI_Master;
-    log("SPI Master initialized");
+    pimpl->state.setMode(Mode::SPI_Master);
+    pimpl->spiMode = mode;
+    pimpl->spiDivider = clockDiv;
+    pimpl->spiPolarity = polarity;
+    pimpl->spiPhase = phase;
+    pimpl->modeClock = pimpl->clockRate;
+    log(LogLevel::Info, "SPI Master initialized");
+    return true;
 }
 
 /**
- * @brief Прочитать данные через SPI (без записи)
- * @param bytesToRead Количество байт для чтения
+ * @brief Прочитать данные через SPI (без записи) в буфер вызывающей стороны
+ * @param buffer Буфер назначения
  * @param endTransaction Завершить транзакцию после чтения
- * @return Вектор прочитанных данных
+ * @return Количество фактически прочитанных байт
  * @throw std::runtime_error При ошибках устройства
  *
  * Выполняет только чтение по SPI. Полезно для устройств, которые
  * самостоятельно инициируют передачу данных.
  */
-std::vector<uint8_t> FTDevice::spiMasterSingleRead(size_t bytesToRead, bool endTransaction) {
+size_t FTDevice::spiMasterSingleRead(ByteSpan buffer, bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiRead, buffer.size());
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master) {
+    if (pimpl->mode() != Mode::SPI_Master) {
         throw std::runtime_error("Device not in SPI Master mode");
     }
 
-    if (bytesToRead == 0) return {};
+    if (buffer.empty()) return 0;
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-
-    std::vector<uint8_t> buffer(bytesToRead);
-    uint16 bytesRead = 0;
-
-    // Выполняем чтение по SPI
-    FT4222_STATUS status = FT4222_SPIMaster_SingleRead(pimpl->ftHandle,
-                                                       buffer.data(),
-                                                       static_cast<uint16>(bytesToRead),
-                                                       &bytesRead,
-                                                       endTransaction ? TRUE : FALSE);
-    checkFT4222Status(status, "FT4222_SPIMaster_SingleRead");
-
-    if (bytesRead != bytesToRead) {
-        buffer.resize(bytesRead); // Корректируем размер при неполном чтении
-    }
-
-    log("SPI SingleRead: " + std::to_string(bytesRead) + " bytes");
-    return buffer;
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiRead, 0, endTransaction);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+
+    // Выполняем чтение по SPI (чанками, если буфер больше SPI_MAX_CHUNK)
+    const size_t bytesRead = transferSpiChunked(
+        buffer.size(), endTransaction, [&](size_t offset, size_t length, bool end) {
+            uint16 chunkRead = 0;
+            const FT4222_STATUS status = FT4222_SPIMaster_SingleRead(pimpl->ftHandle,
+                                                                     buffer.data() + offset,
+                                                                     static_cast<uint16>(length),
+                                                                     &chunkRead,
+                                                                     end ? TRUE : FALSE);
+            checkFT4222Status(status, "FT4222_SPIMaster_SingleRead");
+            return static_cast<size_t>(chunkRead);
+        },
+        [&] { endSpiTransaction(pimpl->ftHandle); });
+
+    trace.read(buffer.subspan(0, bytesRead));
+
+    log(LogLevel::Debug, [&] { return "SPI SingleRead: " + std::to_string(bytesRead) + " bytes"; });
+    return bytesRead;
 }
 
 /**
  * @brief Записать данные через SPI (без чтения)
  * @param data Данные для записи
  * @param endTransaction Завершить транзакцию после записи
+ * @return Количество записанных байт
  * @throw std::runtime_error При ошибках устройства или неполной записи
  *
  * Выполняет только запись по SPI. Полезно для конфигурации устройств
  * или передачи команд без ожидания ответа.
  */
-void FTDevice::spiMasterSingleWrite(const std::vector<uint8_t> &data, bool endTransaction) {
+size_t FTDevice::spiMasterSingleWrite(ConstByteSpan data, bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiWrite, data.size());
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master) {
+    if (pimpl->mode() != Mode::SPI_Master) {
         throw std::runtime_error("Device not in SPI Master mode");
     }
 
-    if (data.empty()) return;
+    if (data.empty()) return 0;
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-
-    uint16 bytesWritten = 0;
-    // Выполняем запись по SPI
-    FT4222_STATUS status = FT4222_SPIMaster_SingleWrite(pimpl->ftHandle,
-                                                        const_cast<uint8*>(data.data()),
-                                                        static_cast<uint16>(data.size()),
-                                                        &bytesWritten,
-                                                        endTransaction ? TRUE : FALSE);
-    checkFT4222Status(status, "FT4222_SPIMaster_SingleWrite");
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiWrite, 0, endTransaction);
+    trace.write(data);
+
+    // Выполняем запись по SPI (чанками, если данные больше SPI_MAX_CHUNK)
+    const size_t bytesWritten = transferSpiChunked(
+        data.size(), endTransaction, [&](size_t offset, size_t length, bool end) {
+            uint16 chunkWritten = 0;
+            const FT4222_STATUS status = FT4222_SPIMaster_SingleWrite(
+                pimpl->ftHandle,
+                const_cast<uint8*>(data.data() + offset),
+                static_cast<uint16>(length),
+                &chunkWritten,
+                end ? TRUE : FALSE);
+            checkFT4222Status(status, "FT4222_SPIMaster_SingleWrite");
+            return static_cast<size_t>(chunkWritten);
+        },
+        [&] { endSpiTransaction(pimpl->ftHandle); });
 
     // Проверяем полную запись
     if (bytesWritten != data.size()) {
@@ -666,46 +1205,113 @@ void FTDevice::spiMasterSingleWrite(const std::vector<uint8_t> &data, bool endTr
             std::to_string(data.size()) + " bytes");
     }
 
-    log("SPI SingleWrite: " + std::to_string(bytesWritten) + " bytes");
+    log(LogLevel::Debug, [&] { return "SPI SingleWrite: " + std::to_string(bytesWritten) + " bytes"; });
+    return bytesWritten;
 }
 
 /**
  * @brief Одновременная запись и чтение по SPI
+ * @param readBuffer Буфер для принятых данных
  * @param writeData Данные для записи
  * @param endTransaction Завершить транзакцию после операции
- * @return Вектор прочитанных данных
+ * @return Количество переданных байт
  * @throw std::runtime_error При ошибках устройства
+ * @throw std::invalid_argument Если readBuffer меньше writeData
  *
  * Выполняет полнодуплексную операцию SPI: одновременно запись и чтение.
- * Размер возвращаемых данных равен размеру передаваемых данных.
+ * Принимается столько же байт, сколько передаётся.
  */
-std::vector<uint8_t> FTDevice::spiMasterSingleReadWrite(const std::vector<uint8_t> &writeData,
-                                                        bool endTransaction) {
+size_t FTDevice::spiMasterSingleReadWrite(ByteSpan readBuffer, ConstByteSpan writeData,
+                                          bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiXfer, readBuffer.size());
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master) {
+    if (pimpl->mode() != Mode::SPI_Master) {
         throw std::runtime_error("Device not in SPI Master mode");
     }
+    if (readBuffer.size() < writeData.size()) {
+        throw std::invalid_argument("SPI read buffer is smaller than write data");
+    }
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiXfer, 0, endTransaction);
+    trace.write(writeData);
+
+    // Выполняем одновременную запись и чтение (чанками, если данные больше SPI_MAX_CHUNK)
+    const size_t bytesTransferred = transferSpiChunked(
+        writeData.size(), endTransaction, [&](size_t offset, size_t length, bool end) {
+            uint16 chunkTransferred = 0;
+            const FT4222_STATUS status = FT4222_SPIMaster_SingleReadWrite(
+                pimpl->ftHandle,
+                readBuffer.data() + offset,
+                const_cast<uint8*>(writeData.data() + offset),
+                static_cast<uint16>(length),
+                &chunkTransferred,
+                end ? TRUE : FALSE);
+            checkFT4222Status(status, "FT4222_SPIMaster_SingleReadWrite");
+            return static_cast<size_t>(chunkTransferred);
+        },
+        [&] { endSpiTransaction(pimpl->ftHandle); });
+
+    trace.read(readBuffer.subspan(0, bytesTransferred));
+
+    log(LogLevel::Debug, [&] {
+        return "SPI SingleReadWrite: " + std::to_string(bytesTransferred) + " bytes";
+    });
+    return bytesTransferred;
+}
 
-    std::vector<uint8_t> readBuffer(writeData.size());
-    uint16 bytesTransferred = 0;
-
-    // Выполняем одновременную запись и чтение
-    FT4222_STATUS status = FT4222_SPIMaster_SingleReadWrite(pimpl->ftHandle,
-                                                            readBuffer.data(),
-                                                            const_cast<uint8*>(writeData.data()),
-                                                            static_cast<uint16>(writeData.size()),
-                                                            &bytesTransferred,
-                                                            endTransaction ? TRUE : FALSE);
-    checkFT4222Status(status, "FT4222_SPIMaster_SingleReadWrite");
-
-    if (bytesTransferred != writeData.size()) {
-        readBuffer.resize(bytesTransferred); // Корректируем размер
+/**
+ * @brief Транзакция multi-I/O (Dual/Quad SPI)
+ * @param readBuffer Буфер фазы чтения
+ * @param singleWrite Фаза по одной линии (команда/адрес)
+ * @param multiWrite Данные по 2/4 линиям
+ * @param dummyCycles Число dummy-тактов
+ * @return Количество прочитанных байт
+ *
+ * FT4222_SPIMaster_MultiReadWrite берёт обе фазы записи из одного буфера, поэтому
+ * команда, dummy-байты и данные собираются в буфер Impl, переиспользуемый между вызовами.
+ */
+size_t FTDevice::spiMasterMultiReadWrite(ByteSpan readBuffer, ConstByteSpan singleWrite,
+                                         ConstByteSpan multiWrite, unsigned dummyCycles) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiMultiXfer, singleWrite.size() + multiWrite.size() + readBuffer.size());
+    if (!isOpen()) throw std::runtime_error("Device not open");
+    if (pimpl->mode() != Mode::SPI_Master) {
+        throw std::runtime_error("Device not in SPI Master mode");
     }
 
-    log("SPI SingleReadWrite: " + std::to_string(bytesTransferred) + " bytes");
-    return readBuffer;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    // spiMode меняет initSPIMaster под тем же мьютексом
+    const size_t dummyBytes = spiMultiDummyBytes(pimpl->spiMode, singleWrite.size(),
+                                                 multiWrite.size(), readBuffer.size(),
+                                                 dummyCycles);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiMultiXfer,
+                                static_cast<uint16_t>(singleWrite.size()), dummyCycles);
+    trace.write(singleWrite, multiWrite);
+    trace.value(static_cast<uint32_t>(readBuffer.size()));
+
+    std::vector<uint8_t> &scratch = pimpl->spiWriteScratch;
+    scratch.assign(singleWrite.begin(), singleWrite.end());
+    scratch.resize(singleWrite.size() + dummyBytes, 0x00);
+    scratch.insert(scratch.end(), multiWrite.begin(), multiWrite.end());
+
+    uint32 bytesRead = 0;
+    const FT4222_STATUS status = FT4222_SPIMaster_MultiReadWrite(
+        pimpl->ftHandle,
+        readBuffer.data(),
+        scratch.data(),
+        static_cast<uint8>(singleWrite.size()),
+        static_cast<uint16>(dummyBytes + multiWrite.size()),
+        static_cast<uint16>(readBuffer.size()),
+        &bytesRead);
+    checkFT4222Status(status, "FT4222_SPIMaster_MultiReadWrite");
+    trace.read(readBuffer.subspan(0, bytesRead));
+
+    log(LogLevel::Debug, [&] {
+        return "SPI MultiReadWrite: single " + std::to_string(singleWrite.size()) + ", multi " +
+               std::to_string(dummyBytes + multiWrite.size()) + ", read " +
+               std::to_string(bytesRead) + " bytes";
+    });
+    return bytesRead;
 }
 
 // GPIO функции
@@ -716,22 +1322,37 @@ std::vector<uint8_t> FTDevice::spiMasterSingleReadWrite(const std::vector<uint8_
  * @param dir1 Направление вывода 1 (GPIO1)
  * @param dir2 Направление вывода 2 (GPIO2)
  * @param dir3 Направление вывода 3 (GPIO3)
+ * @param force Инициализировать, даже если направления не изменились
+ * @return true, если вызывался FT4222_GPIO_Init
  * @throw std::runtime_error При ошибках устройства
  *
  * Настраивает направление (вход/выход) для каждого из четырех GPIO выводов.
  * По умолчанию все выводы настроены как входы.
  */
-void FTDevice::initGPIO(GPIO_Dir dir0, GPIO_Dir dir1, GPIO_Dir dir2, GPIO_Dir dir3) {
+bool FTDevice::initGPIO(GPIO_Dir dir0, GPIO_Dir dir1, GPIO_Dir dir2, GPIO_Dir dir3, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioInit);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
+    const uint8_t dirMask = (dir0 == GPIO_OUTPUT ? 1u : 0u) | (dir1 == GPIO_OUTPUT ? 2u : 0u) |
+                            (dir2 == GPIO_OUTPUT ? 4u : 0u) | (dir3 == GPIO_OUTPUT ? 8u : 0u);
+
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioInit, 0, dirMask);
+
+    if (!force && pimpl->mode() == Mode::GPIO && pimpl->gpioDirs == dirMask) {
+        log(LogLevel::Debug, "GPIO already initialized, skipping");
+        return false;
+    }
 
     GPIO_Dir dirs[4] = {dir0, dir1, dir2, dir3};
     FT4222_STATUS status = FT4222_GPIO_Init(pimpl->ftHandle, dirs);
     checkFT4222Status(status, "FT4222_GPIO_Init");
 
-    pimpl->currentMode = Mode::GPIO;
-    log("GPIO initialized");
+    pimpl->state.setMode(Mode::GPIO);
+    pimpl->gpioDirs = dirMask;
+    pimpl->modeClock = pimpl->clockRate;
+    log(LogLevel::Info, "GPIO initialized");
+    return true;
 }
 
 /**
@@ -741,13 +1362,16 @@ void FTDevice::initGPIO(GPIO_Dir dir0, GPIO_Dir dir1, GPIO_Dir dir2, GPIO_Dir di
  * @throw std::runtime_error При ошибках устройства
  */
 bool FTDevice::readGPIO(GPIO_Port port) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioRead);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioRead, static_cast<uint16_t>(port));
 
     BOOL value = FALSE;
     FT4222_STATUS status = FT4222_GPIO_Read(pimpl->ftHandle, port, &value);
     checkFT4222Status(status, "FT4222_GPIO_Read");
+    trace.value(value != FALSE);
 
     return value != FALSE;
 }
@@ -762,121 +1386,185 @@ bool FTDevice::readGPIO(GPIO_Port port) {
  * Вывод должен быть предварительно настроен как выход.
  */
 void FTDevice::writeGPIO(GPIO_Port port, bool value) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioWrite);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioWrite, static_cast<uint16_t>(port), value);
 
     FT4222_STATUS status = FT4222_GPIO_Write(pimpl->ftHandle, port,
                                              value ? TRUE : FALSE);
     checkFT4222Status(status, "FT4222_GPIO_Write");
 
-    std::ostringstream oss;
-    oss << "GPIO Port" << static_cast<int>(port) << " set to "
-        << (value ? "HIGH" : "LOW");
-    log(oss.str());
+    log(LogLevel::Debug, [&] {
+        return "GPIO Port" + std::to_string(static_cast<int>(port)) + " set to " +
+               (value ? "HIGH" : "LOW");
+    });
+}
+
+/**
+ * @brief Прочитать все GPIO выводы
+ * @return Маска уровней (бит n — GPIOn)
+ * @throw std::runtime_error При ошибках устройства
+ *
+ * LibFT4222 читает выводы по одному, поэтому это по-прежнему четыре вызова
+ * FT4222_GPIO_Read, но под одной блокировкой и без строк журнала.
+ */
+uint8_t FTDevice::readGPIOPorts() {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioRead);
+    if (!isOpen()) throw std::runtime_error("Device not open");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioRead, ft4222trace::kAllGpioPorts);
+
+    uint8_t levels = 0;
+    for (int p = 0; p < 4; ++p) {
+        BOOL value = FALSE;
+        FT4222_STATUS status = FT4222_GPIO_Read(pimpl->ftHandle, static_cast<GPIO_Port>(p), &value);
+        checkFT4222Status(status, "FT4222_GPIO_Read");
+        if (value != FALSE) levels |= static_cast<uint8_t>(1u << p);
+    }
+    trace.value(levels);
+    return levels;
+}
+
+/**
+ * @brief Установить уровни выбранных GPIO выводов
+ * @param mask Выводы, которые нужно изменить (бит n — GPIOn)
+ * @param values Новые уровни (бит n — GPIOn)
+ * @throw std::runtime_error При ошибках устройства
+ */
+void FTDevice::writeGPIOPorts(uint8_t mask, uint8_t values) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioWrite);
+    if (!isOpen()) throw std::runtime_error("Device not open");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioWrite, ft4222trace::kAllGpioPorts,
+                                mask | static_cast<uint32_t>(values) << 8);
+
+    for (int p = 0; p < 4; ++p) {
+        if (!(mask & (1u << p))) continue;
+        FT4222_STATUS status = FT4222_GPIO_Write(pimpl->ftHandle, static_cast<GPIO_Port>(p),
+                                                 (values & (1u << p)) ? TRUE : FALSE);
+        checkFT4222Status(status, "FT4222_GPIO_Write");
+    }
 }
 
 // Общие функции
 
 /**
- * @brief Прочитать данные через интерфейс D2XX
- * @param bytesToRead Количество байт для чтения
+ * @brief Прочитать данные через интерфейс D2XX в буфер вызывающей стороны
+ * @param buffer Буфер назначения
  * @param timeoutMs Таймаут операции в миллисекундах
- * @return Вектор прочитанных данных
+ * @return Количество фактически прочитанных байт
  * @throw std::runtime_error Если устройство не открыто
  * @throw FtException При ошибке чтения
  *
  * Использует низкоуровневый FT_Read для чтения сырых данных.
  * Подходит для обмена данными в нестандартных режимах.
  */
-std::vector<uint8_t> FTDevice::read(size_t bytesToRead, unsigned int timeoutMs) {
+size_t FTDevice::read(ByteSpan buffer, unsigned int timeoutMs) {
+    ft4222stats::OpScope stat(ft4222stats::Op::UsbRead, buffer.size());
     if (!isOpen()) throw std::runtime_error("Device not open");
 
-    if (bytesToRead == 0) return {};
+    if (buffer.empty()) return 0;
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::UsbRead, 0, timeoutMs);
+    trace.value(static_cast<uint32_t>(buffer.size()));
 
-    std::vector<uint8_t> buffer(bytesToRead);
     DWORD bytesRead = 0;
 
     // Устанавливаем таймаут чтения
     FT_SetTimeouts(pimpl->ftHandle, timeoutMs, timeoutMs);
 
     FT_STATUS status = FT_Read(pimpl->ftHandle, buffer.data(),
-                               static_cast<DWORD>(bytesToRead), &bytesRead);
+                               static_cast<DWORD>(buffer.size()), &bytesRead);
     checkFTStatus(status, "FT_Read");
+    trace.read(buffer.subspan(0, bytesRead));
 
-    if (bytesRead != bytesToRead) {
-        buffer.resize(bytesRead); // Корректируем размер при неполном чтении
-        log("Read partial: " + std::to_string(bytesRead) + "/" +
-            std::to_string(bytesToRead) + " bytes");
-    }
-    else {
-        log("Read " + std::to_string(bytesRead) + " bytes");
-    }
+    log(LogLevel::Debug, [&] {
+        if (bytesRead != buffer.size()) {
+            return "Read partial: " + std::to_string(bytesRead) + "/" +
+                   std::to_string(buffer.size()) + " bytes";
+        }
+        return "Read " + std::to_string(bytesRead) + " bytes";
+    });
 
-    return buffer;
+    return bytesRead;
 }
 
 /**
  * @brief Записать данные через интерфейс D2XX
  * @param data Данные для записи
  * @param timeoutMs Таймаут операции в миллисекундах
+ * @return Количество записанных байт
  * @throw std::runtime_error Если устройство не открыто
  * @throw FtException При ошибке записи или неполной передаче
  *
  * Использует низкоуровневый FT_Write для записи сырых данных.
- * Создает копию данных для обхода ограничений константности FT_Write.
+ * FT_Write принимает неконстантный указатель, но буфер не изменяет,
+ * поэтому данные передаются без копирования.
  */
-void FTDevice::write(const std::vector<uint8_t> &data, unsigned int timeoutMs) {
+size_t FTDevice::write(ConstByteSpan data, unsigned int timeoutMs) {
+    ft4222stats::OpScope stat(ft4222stats::Op::UsbWrite, data.size());
     if (!isOpen()) throw std::runtime_error("Device not open");
-    if (data.empty()) return;
+    if (data.empty()) return 0;
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::UsbWrite, 0, timeoutMs);
+    trace.write(data);
 
     DWORD bytesWritten = 0;
 
     // Устанавливаем таймаут записи
     FT_SetTimeouts(pimpl->ftHandle, timeoutMs, timeoutMs);
 
-    // Создаем неконстантную копию данных (требование FT_Write)
-    std::vector<uint8_t> writeBuffer = data;
-
     FT_STATUS status = FT_Write(pimpl->ftHandle,
-                                writeBuffer.data(),
+                                const_cast<uint8_t *>(data.data()),
                                 static_cast<DWORD>(data.size()),
                                 &bytesWritten);
 
     // Проверяем успешность записи
     if (status != FT_OK || bytesWritten != data.size()) {
+        trace.status(static_cast<int>(status));
         std::ostringstream oss;
         oss << "Write failed. Written: " << bytesWritten
             << "/" << data.size() << " bytes";
         throw FtException(oss.str(), status);
     }
 
-    log("Write " + std::to_string(bytesWritten) + " bytes");
+    log(LogLevel::Debug, [&] { return "Write " + std::to_string(bytesWritten) + " bytes"; });
+    return bytesWritten;
 }
 
 /**
  * @brief Установить системную частоту FT4222
  * @param clkRate Значение частоты
+ * @param force Установить, даже если эта частота уже задана
+ * @return true, если вызывался FT4222_SetClock
  * @throw std::runtime_error Если устройство не открыто
  *
  * Изменяет системную частоту FT4222, что влияет на скорость
  * всех интерфейсов (I2C, SPI) и максимальную производительность.
  */
-void FTDevice::setClockRate(FT4222_ClockRate clkRate) {
+bool FTDevice::setClockRate(FT4222_ClockRate clkRate, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SetClock);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SetClock, 0, ft4222trace::clockParam(clkRate));
+    if (!force && pimpl->clockKnown && pimpl->clockRate == clkRate) return false;
 
     FT4222_STATUS status = FT4222_SetClock(pimpl->ftHandle, clkRate);
     checkFT4222Status(status, "FT4222_SetClock");
 
     pimpl->clockRate = clkRate; // Сохраняем текущую частоту
+    pimpl->clockKnown = true;
+    pimpl->state.touch();
 
-    log("Clock rate set to " + std::to_string(static_cast<int>(clkRate)));
+    log(LogLevel::Info, [&] { return "Clock rate set to " + std::to_string(static_cast<int>(clkRate)); });
+    return true;
 }
 
 /**
@@ -897,14 +1585,20 @@ FT4222_ClockRate FTDevice::getClockRate() const {
  * в исходное состояние, все настройки сбрасываются.
  */
 void FTDevice::resetChip() {
+    ft4222stats::OpScope stat(ft4222stats::Op::ResetChip);
     if (!isOpen()) throw std::runtime_error("Device not open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::ResetChip);
 
     FT4222_STATUS status = FT4222_ChipReset(pimpl->ftHandle);
     checkFT4222Status(status, "FT4222_ChipReset");
+    // Сброс возвращает настройки по умолчанию: сохранённая конфигурация недействительна
+    pimpl->state.setMode(Mode::Unknown);
+    pimpl->clockRate = SYS_CLK_60;
+    pimpl->clockKnown = false;
 
-    log("Chip reset");
+    log(LogLevel::Info, "Chip reset");
 }
 
 /**
@@ -912,18 +1606,11 @@ void FTDevice::resetChip() {
  * @return Строка формата "Chip: 0xXXXX, Lib: 0xYYYY" или пустая строка
  */
 std::string FTDevice::getVersionString() const {
-    if (!isOpen() || !pimpl->isFt4222) return "";
-
-    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-
-    FT4222_Version version;
-    FT4222_STATUS status = FT4222_GetVersion(pimpl->ftHandle, &version);
-
-    if (status != FT4222_OK) return "";
+    if (!isOpen() || !pimpl->versionKnown.load(std::memory_order_relaxed)) return "";
 
     std::ostringstream oss;
-    oss << "Chip: 0x" << std::hex << version.chipVersion
-        << ", Lib: 0x" << version.dllVersion << std::dec;
+    oss << "Chip: 0x" << std::hex << pimpl->chipVersion.load(std::memory_order_relaxed)
+        << ", Lib: 0x" << pimpl->dllVersion.load(std::memory_order_relaxed) << std::dec;
     return oss.str();
 }
 
@@ -931,8 +1618,8 @@ std::string FTDevice::getVersionString() const {
  * @brief Получить текущий режим работы устройства
  * @return Текущий режим или Mode::Unknown
  */
-FTDevice::Mode FTDevice::getDeviceMode() const {
-    return pimpl ? pimpl->currentMode : Mode::Unknown;
+FTDevice::Mode FTDevice::getDeviceMode() const noexcept {
+    return pimpl ? pimpl->mode() : Mode::Unknown;
 }
 
 /**
@@ -943,25 +1630,7 @@ FTDevice::Mode FTDevice::getDeviceMode() const {
  * какие интерфейсы доступны в текущем режиме.
  */
 uint8_t FTDevice::getChipMode() const {
-    if (!isOpen() || !pimpl->isFt4222) return 0;
-
-    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-
-    uint8 chipMode = 0;
-    FT4222_STATUS status = FT4222_GetChipMode(pimpl->ftHandle, &chipMode);
+    if (!isOpen()) return 0;
 
-    if (status != FT4222_OK) return 0;
-
-    return chipMode;
-}
-
-/**
- * @brief Записать сообщение в лог
- * @param s Сообщение для логирования
- *
- * Вызывает функцию-логгер, если она установлена.
- * Игнорирует вызовы, если логгер не установлен (nullptr).
- */
-void FTDevice::log(const std::string &s) const {
-    if (m_logger) m_logger(s);
+    return pimpl->chipMode.load(std::memory_order_relaxed);
 }
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "ft4222/ft4222_span.hpp"
+
 #ifdef TWI_MOCK_FT4222
 #include "ft4222/ft4222_types.hpp"
 #else
@@ -14,6 +19,10 @@
 #include "libft4222.h"
 #endif
 
+namespace ft4222trace {
+class Recorder;
+}
+
 /**
  * @brief Структура с информацией об обнаруженном FTDI-устройстве
  *
@@ -28,6 +37,204 @@ struct DeviceInfo {
     uint32_t flags;          ///< Флаги состояния устройства
 };
 
+/**
+ * @brief Результат быстрого сканирования шины I2C
+ *
+ * @note  Помимо списка ответивших адресов хранит время опроса каждого адреса
+ *        и общее время прохода, чтобы можно было отслеживать регрессии скорости.
+ */
+struct I2CScanResult {
+    /// Устройство, ответившее ACK
+    struct Device {
+        uint8_t address;    ///< 7-битный адрес устройства
+        uint32_t latencyUs; ///< Время опроса адреса, мкс
+    };
+
+    std::vector<Device> devices; ///< Ответившие устройства в порядке возрастания адреса
+    uint32_t probed = 0;         ///< Количество опрошенных адресов
+    uint32_t maxProbeUs = 0;     ///< Максимальное время опроса одного адреса, мкс
+    uint64_t elapsedUs = 0;      ///< Общее время сканирования (включая смену частоты), мкс
+};
+
+/// Байт данных опроса записью: LibFT4222 не выполняет WriteEx без данных
+constexpr uint8_t kI2CWriteProbeByte = 0x00;
+
+/**
+ * @brief Параметры быстрого сканирования шины I2C
+ */
+struct I2CScanOptions {
+    bool writeProbe = false; ///< Опрашивать записью одного байта kI2CWriteProbeByte вместо чтения
+    bool fastClock = true;   ///< На время сканирования переключить шину на 1 МГц
+};
+
+/**
+ * @brief Пакет I2C-операций для выполнения за один захват устройства
+ *
+ * @note  Операции ставятся в очередь заранее, а затем выполняются подряд методом
+ *        FTDevice::runI2CBatch: мьютекс устройства захватывается один раз, проверки
+ *        режима не повторяются, а все прочитанные байты складываются в один буфер.
+ *        Данные для записи всех операций хранятся в общем буфере пакета.
+ */
+class I2CBatch {
+public:
+    /// Описание одной операции пакета
+    struct Op {
+        uint8_t address;      ///< 7-битный адрес устройства
+        uint8_t flag;         ///< Флаги транзакции фазы записи
+        uint8_t readFlag;     ///< Флаги транзакции фазы чтения
+        size_t writeOffset;   ///< Смещение данных записи в общем буфере пакета
+        uint16_t writeLength; ///< Количество байт для записи (0 - без фазы записи)
+        uint16_t readLength;  ///< Количество байт для чтения (0 - без фазы чтения)
+    };
+
+    /**
+     * @brief Добавить операцию записи
+     * @param address 7-битный адрес устройства
+     * @param data Данные для передачи (копируются в пакет)
+     * @param flag Флаги транзакции (по умолчанию START|STOP = 0x06)
+     */
+    void write(uint8_t address, ConstByteSpan data, uint8_t flag = 0x06);
+
+    /**
+     * @brief Добавить операцию чтения
+     * @param address 7-битный адрес устройства
+     * @param length Количество байт для чтения
+     * @param flag Флаги транзакции (по умолчанию START|STOP = 0x06)
+     */
+    void read(uint8_t address, uint16_t length, uint8_t flag = 0x06);
+
+    /**
+     * @brief Добавить операцию «запись, затем чтение» (например, номер регистра + данные)
+     * @param address 7-битный адрес устройства
+     * @param data Данные фазы записи (копируются в пакет)
+     * @param readLength Количество байт фазы чтения
+     * @param flag Флаги транзакции для обеих фаз (по умолчанию START|STOP = 0x06)
+     */
+    void writeRead(uint8_t address, ConstByteSpan data, uint16_t readLength, uint8_t flag = 0x06);
+
+    /**
+     * @brief Добавить чтение регистра с повторным START (START+W reg, Sr+R data, STOP)
+     * @param address 7-битный адрес устройства
+     * @param regBytes Номер регистра (один или несколько байт, копируются в пакет)
+     * @param readLength Количество байт для чтения
+     */
+    void readRegister(uint8_t address, ConstByteSpan regBytes, uint16_t readLength);
+
+    /// Удалить все операции (ёмкость буферов сохраняется)
+    void clear() noexcept;
+
+    size_t size() const noexcept { return m_ops.size(); }
+    bool empty() const noexcept { return m_ops.empty(); }
+    const std::vector<Op> &ops() const noexcept { return m_ops; }
+    const std::vector<uint8_t> &writeData() const noexcept { return m_writeData; }
+    /// Суммарное количество байт, которое прочитают все операции
+    size_t totalReadLength() const noexcept { return m_readTotal; }
+
+private:
+    void add(uint8_t address, ConstByteSpan data, uint16_t readLength, uint8_t flag,
+             uint8_t readFlag);
+
+    std::vector<Op> m_ops;
+    std::vector<uint8_t> m_writeData;
+    size_t m_readTotal = 0;
+};
+
+/**
+ * @brief Результат выполнения пакета I2C-операций
+ */
+struct I2CBatchResult {
+    /// Статус одной операции
+    struct OpStatus {
+        bool ok = false;                  ///< Операция выполнена полностью
+        FT4222_STATUS status = FT4222_OK; ///< Код LibFT4222 последней выполненной фазы
+        uint16_t written = 0;             ///< Записано байт
+        uint16_t read = 0;                ///< Прочитано байт
+        size_t readOffset = 0;            ///< Смещение прочитанных данных в data
+    };
+
+    std::vector<uint8_t> data;   ///< Прочитанные данные всех операций подряд
+    std::vector<OpStatus> ops;   ///< Статусы в порядке операций пакета
+    size_t failed = 0;           ///< Количество неуспешных операций
+
+    /**
+     * @brief Подготовить буферы под пакет (без лишних выделений при повторном использовании)
+     * @param batch Пакет, который будет выполнен
+     */
+    void prepare(const I2CBatch &batch);
+
+    /// Прочитанные данные операции с индексом i
+    ConstByteSpan readData(size_t i) const {
+        return ConstByteSpan(data.data() + ops[i].readOffset, ops[i].read);
+    }
+};
+
+/**
+ * @brief Класс сбоя I2C-транзакции
+ */
+enum class I2CFault : uint8_t {
+    Nack,      ///< Адрес или данные не подтверждены — ответ устройства, повтор не поможет
+    Transient, ///< Сбой обмена с адаптером или контроллера без признаков NACK — повторить
+    BusStuck,  ///< Шина занята или потерян арбитраж (ведомый держит SDA) — сбросить шину
+    Fatal      ///< Ошибка вызова (режим, параметры, хэндл) — повторять бессмысленно
+};
+
+/**
+ * @brief Классифицировать неудавшуюся I2C-транзакцию
+ * @param status Код LibFT4222 (FT4222_OK — вызов прошёл, но переданы не все байты)
+ * @param controllerStatus Статус контроллера I2CM_* после транзакции (0 — неизвестен)
+ * @return Класс сбоя
+ */
+I2CFault classifyI2CFault(FT4222_STATUS status, uint8_t controllerStatus) noexcept;
+
+/**
+ * @brief Политика восстановления I2C без переоткрытия устройства
+ *
+ * После неудачной транзакции (кроме сканирования) запрашивается статус контроллера и
+ * сбой классифицируется classifyI2CFault. NACK и ошибки вызова возвращаются сразу, как
+ * без политики; при BusStuck шина сбрасывается FT4222_I2CMaster_ResetBus, со второй
+ * неудачи подряд (при resetChip) — сбросом чипа с повторной инициализацией I2C, после
+ * чего транзакция повторяется целиком с паузой backoffUs, удваиваемой на каждой попытке.
+ *
+ * @note  Повтор заново передаёт всю транзакцию: запись, прерванная на середине, может
+ *        дойти до устройства дважды. По умолчанию повторы выключены.
+ */
+struct I2CRecoveryPolicy {
+    unsigned maxRetries = 0;      ///< Повторов на транзакцию (0 — без восстановления)
+    unsigned backoffUs = 200;     ///< Пауза перед первым повтором, мкс
+    unsigned maxBackoffUs = 5000; ///< Предел паузы, мкс
+    bool resetBus = true;         ///< Сбрасывать шину при BusStuck
+    bool resetChip = false;       ///< Сбрасывать чип, если сбой повторился после восстановления
+
+    bool enabled() const noexcept { return maxRetries != 0; }
+};
+
+/**
+ * @brief Причина неуспеха I2C-операции без исключений
+ */
+enum class I2CError : uint8_t {
+    None,
+    Incomplete,     ///< Запись подтверждена не полностью (NACK адреса или данных)
+    Device,         ///< LibFT4222 вернула ошибку, код — в I2CResult::status
+    NotOpen,        ///< Устройство не открыто
+    WrongMode,      ///< Устройство не в режиме I2C Master
+    InvalidArgument ///< Длина больше FTDevice::I2C_MAX_TRANSFER
+};
+
+/**
+ * @brief Итог I2C-операции без исключений (FTDevice::tryI2C*)
+ *
+ * @note  Короткое чтение — не ошибка: bytes меньше запрошенного, как у бросающего API.
+ */
+struct I2CResult {
+    I2CError error = I2CError::None;
+    FT4222_STATUS status = FT4222_OK; ///< Код LibFT4222 последнего вызова
+    size_t bytes = 0;                 ///< Прочитано байт; при Incomplete — записано
+    uint8_t controllerStatus = 0;     ///< Статус I2CM_*, если запрашивался восстановлением (иначе 0)
+    const char *what = nullptr;       ///< Строковая константа: вызов LibFT4222 или причина ошибки
+
+    bool ok() const noexcept { return error == I2CError::None; }
+};
+
 /**
  * @brief Исключение для ошибок FTDI с сохранением кода статуса
  *
@@ -63,7 +270,19 @@ public:
      */
     static std::vector<DeviceInfo> listDevices();
 
-    static void printDevices();
+    /**
+     * @brief Вывести список FT4222-устройств в человекочитаемом виде
+     * @param os Поток вывода (по умолчанию stdout)
+     * @throw FtException При ошибке получения списка устройств
+     */
+    static void printDevices(std::ostream &os = std::cout);
+
+    /**
+     * @brief Вывести уже полученный список устройств (без повторного перечисления)
+     * @param devices Список, например снимок DeviceCache
+     * @param os Поток вывода
+     */
+    static void printDevices(const std::vector<DeviceInfo> &devices, std::ostream &os);
 };
 
 /**
@@ -78,6 +297,20 @@ public:
     /// Тип функции-логгера для вывода отладочной информации
     using Logger = std::function<void(const std::string &)>;
 
+    /**
+     * @brief Уровни детализации лога
+     *
+     * @note  Сообщение уровня L выводится, если L <= текущего уровня и логгер задан.
+     *        Текст сообщения формируется только для включённых уровней.
+     */
+    enum class LogLevel {
+        Off,   ///< Лог отключен
+        Error, ///< Ошибки, не приводящие к исключению (например, сбой FT_Close)
+        Info,  ///< Открытие/закрытие устройства, инициализация режимов
+        Debug, ///< Каждая транзакция I2C/SPI/GPIO
+        Trace  ///< Подробности внутри операций (каждый адрес при сканировании)
+    };
+
     /**
      * @brief Режимы работы FT4222
      *
@@ -93,6 +326,19 @@ public:
         GPIO ///< Режим общего назначения ввода/вывода
     };
 
+    /**
+     * @brief Снимок состояния устройства (см. state())
+     *
+     * @note  generation растёт при каждом открытии, закрытии и смене конфигурации
+     *        (init*, setClockRate, resetChip, сброс чипа восстановлением I2C): разные
+     *        значения в двух снимках — устройство между ними перенастроили.
+     */
+    struct State {
+        bool open = false;         ///< Устройство открыто
+        Mode mode = Mode::Unknown; ///< Текущий режим
+        uint32_t generation = 0;   ///< Поколение конфигурации
+    };
+
     /**
      * @brief Режимы работы GPIO выводов
      *
@@ -175,6 +421,17 @@ public:
      */
     void openBySerial(const std::string &serialNumber);
 
+    /**
+     * @brief Открыть устройство по Location ID (порт USB-хаба)
+     * @param locationId Идентификатор местоположения из DeviceInfo::locationId
+     * @throw std::runtime_error Если устройство уже открыто
+     * @throw FtException При ошибке открытия устройства
+     *
+     * @note  В отличие от индекса, Location ID не меняется при подключении и
+     *        отключении других адаптеров, поэтому его можно брать из кэша списка.
+     */
+    void openByLocation(uint32_t locationId);
+
     /**
      * @brief Закрыть устройство и освободить ресурсы
      *
@@ -188,6 +445,16 @@ public:
      */
     bool isOpen() const noexcept;
 
+    /**
+     * @brief Получить снимок состояния без блокировки
+     * @return Открыто ли устройство, режим и поколение конфигурации
+     *
+     * @note  Одно атомарное чтение, без мьютекса устройства: не ждёт операции в полёте
+     *        (например, длинного SPI-потока в другом потоке). isOpen() и getDeviceMode()
+     *        читают этот же снимок.
+     */
+    State state() const noexcept;
+
     // Общие операции чтения/записи
 
     /**
@@ -200,6 +467,16 @@ public:
      */
     std::vector<uint8_t> read(size_t bytesToRead, unsigned int timeoutMs = 1000);
 
+    /**
+     * @brief Прочитать данные через интерфейс D2XX в буфер вызывающей стороны
+     * @param buffer Буфер назначения (читается до buffer.size() байт)
+     * @param timeoutMs Таймаут операции в миллисекундах
+     * @return Количество фактически прочитанных байт
+     * @throw std::runtime_error Если устройство не открыто
+     * @throw FtException При ошибке чтения
+     */
+    size_t read(ByteSpan buffer, unsigned int timeoutMs = 1000);
+
     /**
      * @brief Записать данные в устройство через интерфейс D2XX
      * @param data Данные для записи
@@ -209,15 +486,42 @@ public:
      */
     void write(const std::vector<uint8_t> &data, unsigned int timeoutMs = 1000);
 
+    /**
+     * @brief Записать данные через интерфейс D2XX без промежуточного копирования
+     * @param data Данные для записи
+     * @param timeoutMs Таймаут операции в миллисекундах
+     * @return Количество записанных байт (всегда data.size() при успехе)
+     * @throw std::runtime_error Если устройство не открыто
+     * @throw FtException При ошибке записи или неполной передаче
+     */
+    size_t write(ConstByteSpan data, unsigned int timeoutMs = 1000);
+
     // Функции I2C Master режима
 
     /**
      * @brief Инициализировать устройство в режиме I2C Master
      * @param speed Скорость шины I2C
+     * @param force Инициализировать, даже если эта конфигурация уже действует
+     * @return true, если LibFT4222 вызывалась; false — устройство уже в I2C Master
+     *         на этой скорости при той же системной частоте
      * @throw std::runtime_error Если устройство не открыто
      * @throw std::runtime_error При ошибке инициализации
      */
-    void initI2CMaster(I2CSpeed speed = I2CSpeed::S400K) const;
+    bool initI2CMaster(I2CSpeed speed = I2CSpeed::S400K, bool force = false) const;
+
+    /**
+     * @brief Инициализировать I2C Master на самой высокой частоте SCL не выше maxHz
+     * @param maxHz Предельная частота шины, Гц (60 кГц .. 3,4 МГц; больше — ограничивается)
+     * @param force Передаётся в setClockRate / initI2CMaster
+     * @return Достигнутая частота SCL по модели ft4222clock::planI2C, Гц
+     * @throw std::invalid_argument Если maxHz ниже 60 кГц
+     * @throw std::runtime_error Если устройство не открыто или при ошибке инициализации
+     *
+     * @note  Системная частота и период таймера подбираются ft4222clock::planI2C; при
+     *        необходимости меняется системная частота чипа (общая для всех интерфейсов).
+     *        Скорость не ограничена значениями I2CSpeed.
+     */
+    uint32_t initI2CMasterHz(uint32_t maxHz, bool force = false);
 
     /**
      * @brief Записать данные на шину I2C
@@ -226,10 +530,23 @@ public:
      * @param flag Флаги транзакции (по умолчанию 0x02 - START)
      * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
      * @throw std::runtime_error При ошибке записи или неполной передаче
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
      */
     void i2cMasterWrite(uint8_t deviceAddress, const std::vector<uint8_t> &data,
                         uint8_t flag = 0x02) const;
 
+    /**
+     * @brief Записать данные на шину I2C из буфера вызывающей стороны
+     * @param deviceAddress 7-битный адрес устройства-получателя
+     * @param data Данные для передачи
+     * @param flag Флаги транзакции (по умолчанию 0x02 - START)
+     * @return Количество записанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     * @throw std::runtime_error При ошибке записи или неполной передаче
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
+     */
+    size_t i2cMasterWrite(uint8_t deviceAddress, ConstByteSpan data, uint8_t flag = 0x02) const;
+
     /**
      * @brief Прочитать данные с шины I2C
      * @param deviceAddress 7-битный адрес устройства-отправителя
@@ -238,10 +555,82 @@ public:
      * @return Вектор прочитанных байт
      * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
      * @throw std::runtime_error При ошибке чтения
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
      */
     std::vector<uint8_t> i2cMasterRead(uint8_t deviceAddress, size_t bytesToRead,
                                        uint8_t flag = 0x02);
 
+    /**
+     * @brief Прочитать данные с шины I2C в буфер вызывающей стороны
+     * @param deviceAddress 7-битный адрес устройства-отправителя
+     * @param buffer Буфер назначения (читается buffer.size() байт)
+     * @param flag Флаги транзакции (по умолчанию 0x02 - START)
+     * @return Количество фактически прочитанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     * @throw std::runtime_error При ошибке чтения
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
+     */
+    size_t i2cMasterRead(uint8_t deviceAddress, ByteSpan buffer, uint8_t flag = 0x02);
+
+    /**
+     * @brief Прочитать регистр устройства за одну транзакцию с повторным START
+     * @param deviceAddress 7-битный адрес устройства
+     * @param regBytes Номер регистра (один или несколько байт, старший первым)
+     * @param bytesToRead Количество байт для чтения
+     * @return Вектор прочитанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     * @throw std::runtime_error При ошибке записи номера регистра или чтения
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
+     *
+     * @note Выполняет START + ADDR+W + regBytes, затем Repeated START + ADDR+R + данные
+     *       и STOP в одной захваченной секции, без освобождения шины между фазами.
+     */
+    std::vector<uint8_t> i2cReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes,
+                                         size_t bytesToRead);
+
+    /**
+     * @brief Прочитать регистр устройства в буфер вызывающей стороны
+     * @param deviceAddress 7-битный адрес устройства
+     * @param regBytes Номер регистра (один или несколько байт, старший первым)
+     * @param buffer Буфер назначения (читается buffer.size() байт)
+     * @return Количество фактически прочитанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     * @throw std::runtime_error При ошибке записи номера регистра или чтения
+     * @throw std::invalid_argument Если длина больше I2C_MAX_TRANSFER
+     */
+    size_t i2cReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes, ByteSpan buffer);
+
+    // Варианты без исключений для циклов, где NACK и короткое чтение — обычный результат.
+    // Бросающие методы выше — обёртки над ними. Логгер, если задан, не должен бросать.
+
+    /**
+     * @brief Записать данные на шину I2C без исключений
+     * @param deviceAddress 7-битный адрес устройства-получателя
+     * @param data Данные для передачи
+     * @param flag Флаги транзакции
+     * @return Итог; bytes — записано байт
+     */
+    I2CResult tryI2CWrite(uint8_t deviceAddress, ConstByteSpan data, uint8_t flag = 0x02) const noexcept;
+
+    /**
+     * @brief Прочитать данные с шины I2C без исключений
+     * @param deviceAddress 7-битный адрес устройства-отправителя
+     * @param buffer Буфер назначения
+     * @param flag Флаги транзакции
+     * @return Итог; bytes — прочитано байт (0 при NACK адреса)
+     */
+    I2CResult tryI2CRead(uint8_t deviceAddress, ByteSpan buffer, uint8_t flag = 0x02) noexcept;
+
+    /**
+     * @brief Прочитать регистр с повторным START без исключений
+     * @param deviceAddress 7-битный адрес устройства
+     * @param regBytes Номер регистра
+     * @param buffer Буфер назначения
+     * @return Итог; Incomplete — номер регистра не подтверждён, bytes — прочитано байт
+     */
+    I2CResult tryI2CReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes,
+                                 ByteSpan buffer) noexcept;
+
     /**
      * @brief Получить статус шины I2C
      * @return Байт состояния шины I2C
@@ -271,6 +660,43 @@ public:
                                     uint8_t endAddress = 0x77,
                                     uint8_t flag = 0x06) const;
 
+    /**
+     * @brief Быстро просканировать шину I2C с замером времени опроса каждого адреса
+     * @param startAddress Первый проверяемый адрес (по умолчанию 0x03)
+     * @param endAddress Последний проверяемый адрес (по умолчанию 0x77)
+     * @param options Способ опроса и управление частотой шины
+     * @return Ответившие адреса, время опроса каждого и общее время прохода
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     *
+     * @note В отличие от scanI2CBus статус контроллера запрашивается только тогда,
+     *       когда результат ReadEx не позволяет сразу отбросить адрес, а строки лога
+     *       для неответивших адресов не формируются. При fastClock шина временно
+     *       переключается на 1 МГц, исходная скорость I2CSpeed восстанавливается
+     *       после сканирования.
+     */
+    I2CScanResult scanI2CBusFast(uint8_t startAddress = 0x03,
+                                 uint8_t endAddress = 0x77,
+                                 const I2CScanOptions &options = {}) const;
+
+    /**
+     * @brief Выполнить пакет I2C-операций за один захват устройства
+     * @param batch Пакет операций
+     * @param result Результат; буферы переиспользуются между вызовами
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     *
+     * @note Ошибка отдельной операции не прерывает пакет: её код сохраняется
+     *       в result.ops[i], а операция учитывается в result.failed.
+     */
+    void runI2CBatch(const I2CBatch &batch, I2CBatchResult &result);
+
+    /**
+     * @brief Выполнить пакет I2C-операций и вернуть новый результат
+     * @param batch Пакет операций
+     * @return Прочитанные данные и статусы операций
+     * @throw std::runtime_error Если устройство не открыто или не в режиме I2C
+     */
+    I2CBatchResult runI2CBatch(const I2CBatch &batch);
+
     // Функции SPI Master режима
 
     /**
@@ -279,12 +705,58 @@ public:
      * @param clockDiv Делитель частоты SPI
      * @param polarity Полярность тактового сигнала
      * @param phase Фаза тактового сигнала
+     * @param force Инициализировать заново, даже если эта конфигурация уже действует
+     * @return true, если LibFT4222 вызывалась; false — конфигурация уже действует
      * @throw std::runtime_error Если устройство не открыто
+     *
+     * @note  Если отличается только mode, а делитель, полярность, фаза и системная
+     *        частота прежние, выполняется один FT4222_SPIMaster_SetLines вместо
+     *        повторной инициализации.
      */
-    void initSPIMaster(FT4222_SPIMode mode = SPI_IO_SINGLE,
+    bool initSPIMaster(FT4222_SPIMode mode = SPI_IO_SINGLE,
                        SPIClockDivider clockDiv = SPIClockDivider::DIV_512,
                        FT4222_SPICPOL polarity = CLK_IDLE_LOW,
-                       FT4222_SPICPHA phase = CLK_LEADING);
+                       FT4222_SPICPHA phase = CLK_LEADING, bool force = false);
+
+    /**
+     * @brief Инициализировать SPI Master на самой высокой частоте SCLK не выше maxHz
+     * @param maxHz Предельная частота ведомого, Гц (не ниже 24 МГц / 512)
+     * @param mode Режим работы SPI (одиночный/двойной/четверной)
+     * @param polarity Полярность тактового сигнала
+     * @param phase Фаза тактового сигнала
+     * @param force Передаётся в setClockRate / initSPIMaster
+     * @return Достигнутая частота SCLK, Гц
+     * @throw std::invalid_argument Если maxHz ниже минимальной частоты SCLK
+     * @throw std::runtime_error Если устройство не открыто или при ошибке инициализации
+     *
+     * @note  Пара «системная частота — делитель» берётся из таблицы ft4222clock::kSpiTable,
+     *        построенной при компиляции; при равной SCLK текущая системная частота
+     *        сохраняется. Иначе частота чипа меняется (общая для всех интерфейсов).
+     */
+    uint32_t initSPIMasterHz(uint32_t maxHz, FT4222_SPIMode mode = SPI_IO_SINGLE,
+                             FT4222_SPICPOL polarity = CLK_IDLE_LOW,
+                             FT4222_SPICPHA phase = CLK_LEADING, bool force = false);
+
+    /**
+     * @brief Максимальная длина одной I2C-транзакции
+     *
+     * @note  Длина в FT4222_I2CMaster_WriteEx / ReadEx — uint16. I2C-методы не делят
+     *        передачу на части (STOP посреди чтения EEPROM сбросил бы его указатель,
+     *        а посреди записи — начал бы цикл записи), поэтому более длинные буферы
+     *        отклоняются; последовательные чтения больших объёмов — I2CEeprom.
+     */
+    static constexpr size_t I2C_MAX_TRANSFER = 0xFFFF;
+
+    /**
+     * @brief Максимальный размер одного вызова SPI в LibFT4222
+     *
+     * @note  Длина транзакции LibFT4222 — uint16, поэтому передачи большего размера
+     *        функции spiMasterSingle* прозрачно делят на чанки с удержанием CS
+     *        (endTransaction=false до последнего чанка). Размер кратен пакету USB 2.0 HS
+     *        (512 байт) при любой FT4222_ClockRate: ни один чанк кроме последнего не
+     *        заканчивается коротким пакетом.
+     */
+    static constexpr size_t SPI_MAX_CHUNK = 127 * 512;
 
     /**
      * @brief Прочитать данные через SPI (без одновременной записи)
@@ -295,6 +767,15 @@ public:
      */
     std::vector<uint8_t> spiMasterSingleRead(size_t bytesToRead, bool endTransaction = true);
 
+    /**
+     * @brief Прочитать данные через SPI в буфер вызывающей стороны
+     * @param buffer Буфер назначения (читается buffer.size() байт)
+     * @param endTransaction Завершить транзакцию (освободить CS)
+     * @return Количество фактически прочитанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме SPI
+     */
+    size_t spiMasterSingleRead(ByteSpan buffer, bool endTransaction = true);
+
     /**
      * @brief Записать данные через SPI (без одновременного чтения)
      * @param data Данные для записи
@@ -304,6 +785,16 @@ public:
      */
     void spiMasterSingleWrite(const std::vector<uint8_t> &data, bool endTransaction = true);
 
+    /**
+     * @brief Записать данные через SPI из буфера вызывающей стороны
+     * @param data Данные для записи
+     * @param endTransaction Завершить транзакцию (освободить CS)
+     * @return Количество записанных байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме SPI
+     * @throw std::runtime_error При неполной записи
+     */
+    size_t spiMasterSingleWrite(ConstByteSpan data, bool endTransaction = true);
+
     /**
      * @brief Одновременная запись и чтение через SPI (full-duplex)
      * @param writeData Данные для записи
@@ -314,6 +805,50 @@ public:
     std::vector<uint8_t> spiMasterSingleReadWrite(const std::vector<uint8_t> &writeData,
                                                   bool endTransaction = true);
 
+    /**
+     * @brief Full-duplex обмен по SPI с буферами вызывающей стороны
+     * @param readBuffer Буфер для принятых данных (не меньше writeData.size())
+     * @param writeData Данные для записи
+     * @param endTransaction Завершить транзакцию (освободить CS)
+     * @return Количество переданных (и принятых) байт
+     * @throw std::runtime_error Если устройство не открыто или не в режиме SPI
+     * @throw std::invalid_argument Если readBuffer меньше writeData
+     */
+    size_t spiMasterSingleReadWrite(ByteSpan readBuffer, ConstByteSpan writeData,
+                                    bool endTransaction = true);
+
+    /**
+     * @brief Транзакция multi-I/O (Dual/Quad SPI): команда по одной линии, затем данные по 2/4
+     * @param singleWrite Фаза команды/адреса по одной линии (до 15 байт)
+     * @param multiWrite Данные, передаваемые по 2/4 линиям после dummy-тактов
+     * @param readLength Сколько байт прочитать по 2/4 линиям в конце транзакции
+     * @param dummyCycles Число dummy-тактов между фазами (перед multiWrite/чтением)
+     * @return Прочитанные байты
+     * @throw std::runtime_error Если устройство не в режиме SPI Master dual/quad
+     * @throw std::invalid_argument При недопустимых длинах или числе dummy-тактов
+     */
+    std::vector<uint8_t> spiMasterMultiReadWrite(const std::vector<uint8_t> &singleWrite,
+                                                 const std::vector<uint8_t> &multiWrite,
+                                                 size_t readLength,
+                                                 unsigned dummyCycles = 0);
+
+    /**
+     * @brief Транзакция multi-I/O с буферами вызывающей стороны
+     * @param readBuffer Буфер фазы чтения (читается readBuffer.size() байт, может быть пустым)
+     * @param singleWrite Фаза команды/адреса по одной линии (до 15 байт)
+     * @param multiWrite Данные, передаваемые по 2/4 линиям
+     * @param dummyCycles Число dummy-тактов между фазами
+     * @return Количество прочитанных байт
+     * @throw std::runtime_error Если устройство не в режиме SPI Master dual/quad
+     * @throw std::invalid_argument При недопустимых длинах или числе dummy-тактов
+     *
+     * @note  LibFT4222 передаёт dummy-такты как нулевые байты в начале multi-фазы, поэтому
+     *        их число должно быть кратно 4 (dual) или 2 (quad). CS освобождается в конце
+     *        каждого вызова, поэтому multi-фазы ограничены 65535 байтами без разбиения.
+     */
+    size_t spiMasterMultiReadWrite(ByteSpan readBuffer, ConstByteSpan singleWrite,
+                                   ConstByteSpan multiWrite, unsigned dummyCycles = 0);
+
     // Функции GPIO режима
 
     /**
@@ -322,10 +857,12 @@ public:
      * @param dir1 Направление вывода 1
      * @param dir2 Направление вывода 2
      * @param dir3 Направление вывода 3
+     * @param force Инициализировать, даже если эти направления уже заданы
+     * @return true, если LibFT4222 вызывалась; false — GPIO уже с этими направлениями
      * @throw std::runtime_error Если устройство не открыто
      */
-    void initGPIO(GPIO_Dir dir0 = GPIO_INPUT, GPIO_Dir dir1 = GPIO_INPUT,
-                  GPIO_Dir dir2 = GPIO_INPUT, GPIO_Dir dir3 = GPIO_INPUT);
+    bool initGPIO(GPIO_Dir dir0 = GPIO_INPUT, GPIO_Dir dir1 = GPIO_INPUT,
+                  GPIO_Dir dir2 = GPIO_INPUT, GPIO_Dir dir3 = GPIO_INPUT, bool force = false);
 
     /**
      * @brief Прочитать состояние GPIO вывода
@@ -343,14 +880,39 @@ public:
      */
     void writeGPIO(GPIO_Port port, bool value);
 
+    /**
+     * @brief Прочитать все четыре GPIO вывода за один захват устройства
+     * @return Битовая маска уровней: бит n — GPIOn
+     * @throw std::runtime_error Если устройство не открыто
+     * @throw FtException При ошибке LibFT4222
+     *
+     * @note  В отличие от четырёх вызовов readGPIO, мьютекс берётся один раз и
+     *        без журналирования каждого чтения — для циклов выборки.
+     */
+    uint8_t readGPIOPorts();
+
+    /**
+     * @brief Установить уровни нескольких GPIO выводов за один захват устройства
+     * @param mask Какие выводы менять: бит n — GPIOn
+     * @param values Уровни для выводов из mask: бит n — GPIOn
+     * @throw std::runtime_error Если устройство не открыто
+     * @throw FtException При ошибке LibFT4222
+     */
+    void writeGPIOPorts(uint8_t mask, uint8_t values);
+
     // Управление настройками устройства
 
     /**
      * @brief Установить системную частоту FT4222
      * @param clkRate Значение частоты из FT4222_ClockRate
+     * @param force Установить, даже если эта частота уже задана через setClockRate
+     * @return true, если LibFT4222 вызывалась
      * @throw std::runtime_error Если устройство не открыто
+     *
+     * @note  Делители I2C и SPI считаются от системной частоты, поэтому после её смены
+     *        следующий init* выполняется, даже если параметры не изменились.
      */
-    void setClockRate(FT4222_ClockRate clkRate);
+    bool setClockRate(FT4222_ClockRate clkRate, bool force = false);
 
     /**
      * @brief Получить текущую системную частоту FT4222
@@ -369,6 +931,8 @@ public:
     /**
      * @brief Получить строку с версиями чипа и библиотеки
      * @return Строка вида "Chip: 0xXXXX, Lib: 0xYYYY" или пустая строка
+     *
+     * @note  Версии запоминаются при открытии, поэтому вызов не ждёт мьютекса устройства.
      */
     std::string getVersionString() const;
 
@@ -376,25 +940,232 @@ public:
      * @brief Получить текущий режим работы устройства
      * @return Текущий режим или Mode::Unknown
      */
-    Mode getDeviceMode() const;
+    Mode getDeviceMode() const noexcept;
 
     /**
      * @brief Получить режим работы чипа (конфигурацию выводов)
      * @return Байт режима чипа или 0 при ошибке
+     *
+     * @note  Режим задаётся выводами DCNF и запоминается при открытии.
      */
     uint8_t getChipMode() const;
 
+    // Логирование
+
+    /**
+     * @brief Установить функцию-логгер
+     * @param logger Функция для логирования (nullptr для отключения)
+     */
+    void setLogger(Logger logger);
+
+    /**
+     * @brief Установить уровень детализации лога
+     * @param level Максимальный выводимый уровень (LogLevel::Off отключает лог)
+     */
+    void setLogLevel(LogLevel level) noexcept { m_logLevel = level; }
+
+    /**
+     * @brief Получить текущий уровень детализации лога
+     */
+    LogLevel getLogLevel() const noexcept { return m_logLevel; }
+
+    /**
+     * @brief Задать политику восстановления I2C-транзакций
+     * @param policy Политика; maxRetries == 0 выключает восстановление
+     *
+     * @note  Действует на i2cMasterWrite, i2cMasterRead, i2cReadRegister и операции
+     *        runI2CBatch; события восстановления учитываются в ft4222stats::recovery().
+     */
+    void setI2CRecoveryPolicy(const I2CRecoveryPolicy &policy);
+
+    /// Текущая политика восстановления I2C
+    I2CRecoveryPolicy i2cRecoveryPolicy() const;
+
+    /**
+     * @brief Подключить запись двоичной трассы транзакций
+     * @param recorder Запись трассы (nullptr — отключить)
+     *
+     * @note  Замена выполняется под мьютексом устройства, поэтому после возврата
+     *        операции в полёте уже не пишут в прежнюю трассу и её можно остановить.
+     */
+    void setTraceRecorder(std::shared_ptr<ft4222trace::Recorder> recorder);
+
+    /// Текущая запись трассы (nullptr, если не подключена)
+    std::shared_ptr<ft4222trace::Recorder> traceRecorder() const;
+
+    /**
+     * @brief Проверить, будет ли выведено сообщение указанного уровня
+     * @param level Уровень сообщения
+     * @return true если логгер задан и уровень включен
+     */
+    bool logEnabled(LogLevel level) const noexcept {
+        return level != LogLevel::Off && level <= m_logLevel && m_logger;
+    }
+
 private:
+    // Состояние в одном атомарном слове: бит 0 — открыто, биты 8..15 — режим, старшие
+    // 32 бита — поколение. Пишется под deviceMutex, читается без блокировок.
+    class StateWord {
+    public:
+        State load() const noexcept {
+            const uint64_t w = m_word.load(std::memory_order_acquire);
+            return {(w & 1u) != 0, static_cast<Mode>((w >> 8) & 0xFF), static_cast<uint32_t>(w >> 32)};
+        }
+
+        void publish(bool open, Mode mode) noexcept {
+            const uint64_t generation = (m_word.load(std::memory_order_relaxed) >> 32) + 1;
+            m_word.store(generation << 32 | static_cast<uint64_t>(mode) << 8 | (open ? 1u : 0u),
+                         std::memory_order_release);
+        }
+
+        void setMode(Mode mode) noexcept { publish(load().open, mode); }
+
+        /// Новое поколение без смены режима (изменились частота или параметры режима)
+        void touch() noexcept {
+            const State s = load();
+            publish(s.open, s.mode);
+        }
+
+    private:
+        std::atomic<uint64_t> m_word{0};
+    };
+
     // Структура для сокрытия деталей реализации (Pimpl идиома)
     struct Impl;
     std::unique_ptr<Impl> pimpl;
     Logger m_logger; ///< Функция для логирования (может быть nullptr)
+    LogLevel m_logLevel = LogLevel::Debug; ///< Текущий уровень детализации лога
+    std::shared_ptr<ft4222trace::Recorder> m_trace; ///< Запись трассы (читается под deviceMutex)
+    I2CRecoveryPolicy m_i2cRecovery; ///< Политика восстановления I2C (читается под deviceMutex)
 
     // Внутренние вспомогательные методы
 
     /**
-     * @brief Записать сообщение в лог
-     * @param s Сообщение для логирования
+     * @brief Записать в лог сообщение, сформированное по требованию
+     * @param level Уровень сообщения
+     * @param makeMessage Функция без аргументов, возвращающая текст сообщения
+     *
+     * @note  makeMessage вызывается только если уровень включен, поэтому при
+     *        выключенном логе стоимость вызова — одна проверка.
+     */
+    template <typename MakeMessage>
+    void log(LogLevel level, MakeMessage &&makeMessage) const {
+        if (logEnabled(level)) m_logger(makeMessage());
+    }
+
+    /**
+     * @brief Записать в лог готовое сообщение без форматирования
+     * @param level Уровень сообщения
+     * @param message Текст сообщения
+     */
+    void log(LogLevel level, const char *message) const;
+
+    /**
+     * @brief Проверить параметры multi-I/O транзакции
+     * @param mode Текущий режим линий SPI
+     * @param singleLength Длина фазы по одной линии
+     * @param multiWriteLength Длина multi-фазы записи (без dummy)
+     * @param readLength Длина фазы чтения
+     * @param dummyCycles Число dummy-тактов
+     * @return Число dummy-байт, которыми dummy-такты кодируются в multi-фазе
+     */
+    static size_t spiMultiDummyBytes(FT4222_SPIMode mode, size_t singleLength,
+                                     size_t multiWriteLength, size_t readLength,
+                                     unsigned dummyCycles);
+
+    /**
+     * @brief Разбить передачу SPI на чанки не больше SPI_MAX_CHUNK
+     * @param total Длина передачи
+     * @param endTransaction Снять CS после последнего чанка
+     * @param transfer Один чанк: transfer(offset, length, end) возвращает число переданных байт
+     * @param closeTransaction Снять CS, оставленный незавершённым чанком (без данных вызывающего)
+     * @return Число переданных байт; короткий чанк завершает передачу
+     *
+     * @note  CS удерживается между чанками, end передаётся только последнему. Если
+     *        передача прервалась на промежуточном чанке (короткий ответ или исключение),
+     *        а вызывающий просил endTransaction, вызывается closeTransaction — иначе CS
+     *        остался бы выбранным до следующей операции. Ошибка closeTransaction после
+     *        исключения не заменяет исходное исключение.
+     */
+    template <typename Transfer, typename CloseTransaction>
+    static size_t transferSpiChunked(size_t total, bool endTransaction, Transfer &&transfer,
+                                     CloseTransaction &&closeTransaction) {
+        size_t done = 0;
+        bool open = false; // CS выбран чанком без end
+        try {
+            while (done < total) {
+                const size_t length = std::min(total - done, SPI_MAX_CHUNK);
+                const bool end = done + length == total && endTransaction;
+                open = !end;
+                const size_t n = transfer(done, length, end);
+                done += n;
+                if (n != length) break;
+            }
+        } catch (...) {
+            if (open && endTransaction) {
+                try {
+                    closeTransaction();
+                } catch (...) {
+                }
+            }
+            throw;
+        }
+        if (open && endTransaction && done != total) closeTransaction();
+        return done;
+    }
+
+    /**
+     * @brief Записать фазы выполненного пакета в трассу
+     * @param batch Пакет
+     * @param result Результат выполнения
+     * @param startNs Время начала пакета по часам трассы
+     *
+     * @note  Вызывается под мьютексом устройства; без подключённой трассы ничего не делает.
+     */
+    void traceI2CBatch(const I2CBatch &batch, const I2CBatchResult &result,
+                       uint64_t startNs) const;
+
+    /**
+     * @brief Выполнить I2C-транзакцию с восстановлением по политике
+     * @param status Код LibFT4222 последней попытки (заполняет attempt)
+     * @param attempt Одна попытка; возвращает true, если транзакция прошла полностью
+     * @param controllerStatus Куда сохранить статус контроллера, если он запрашивался
+     * @return true, если последняя попытка прошла
+     *
+     * @note  Вызывается под мьютексом устройства. Без политики — ровно одна попытка.
      */
-    void log(const std::string &s) const;
+    template <typename Attempt>
+    bool retryI2C(FT4222_STATUS &status, Attempt &&attempt,
+                  uint8_t *controllerStatus = nullptr) const {
+        for (unsigned n = 0;; ++n) {
+            if (attempt()) {
+                if (n != 0) noteI2CRecovered();
+                return true;
+            }
+            if (!recoverI2C(status, n, controllerStatus)) return false;
+        }
+    }
+
+    /**
+     * @brief Восстановить шину после неудачной попытки, если политика это допускает
+     * @param status Код LibFT4222 неудачной попытки
+     * @param attempt Номер неудачной попытки, начиная с 0
+     * @param controllerStatus Куда сохранить запрошенный статус контроллера (может быть nullptr)
+     * @return true — выполнено восстановление и пауза, транзакцию нужно повторить
+     */
+    bool recoverI2C(FT4222_STATUS status, unsigned attempt, uint8_t *controllerStatus) const;
+
+    static void noteI2CRecovered() noexcept;
+
+    // Примитивы восстановления, реализуемые бэкендом; вызываются под мьютексом устройства
+    // и возвращают false при собственной ошибке вместо исключения
+
+    /// Запросить статус контроллера I2C
+    bool i2cControllerStatusLocked(uint8_t &controllerStatus) const;
+
+    /// Сбросить шину I2C (девять тактов SCL и STOP)
+    bool i2cResetBusLocked() const;
+
+    /// Сбросить чип и восстановить системную частоту и режим I2C Master
+    bool i2cResetChipLocked() const;
 };
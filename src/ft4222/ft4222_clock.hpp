@@ -0,0 +1,146 @@
+#pragma once
+
+// Планировщик частот FT4222 (constexpr, оба бэкенда): подбор системной частоты и
+// делителя SPI или периода таймера I2C под требуемую частоту шины.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef TWI_MOCK_FT4222
+#include "ft4222/ft4222_types.hpp"
+#else
+#include "ftd2xx.h"
+#include "libft4222.h"
+#endif
+
+namespace ft4222clock {
+
+/// Системные частоты FT4222 в порядке возрастания
+constexpr std::array<FT4222_ClockRate, 4> kClockRates = {SYS_CLK_24, SYS_CLK_48, SYS_CLK_60,
+                                                         SYS_CLK_80};
+
+/// Делители SCLK SPI Master в порядке возрастания
+constexpr std::array<FT4222_SPIClock, 9> kSpiDividers = {
+    CLK_DIV_2,  CLK_DIV_4,   CLK_DIV_8,   CLK_DIV_16, CLK_DIV_32,
+    CLK_DIV_64, CLK_DIV_128, CLK_DIV_256, CLK_DIV_512};
+
+constexpr uint32_t systemClockHz(FT4222_ClockRate rate) {
+    switch (rate) {
+    case SYS_CLK_24: return 24'000'000;
+    case SYS_CLK_48: return 48'000'000;
+    case SYS_CLK_80: return 80'000'000;
+    default: return 60'000'000;
+    }
+}
+
+constexpr uint32_t spiDividerValue(FT4222_SPIClock div) {
+    for (size_t i = 0; i < kSpiDividers.size(); ++i)
+        if (kSpiDividers[i] == div) return 2u << i;
+    return 512;
+}
+
+/// Пара «системная частота — делитель» и получаемая частота SCLK
+struct SpiClockPlan {
+    FT4222_ClockRate clock = SYS_CLK_60;
+    FT4222_SPIClock divider = CLK_DIV_512;
+    uint32_t hz = 0;
+};
+
+/// Все 36 сочетаний по убыванию SCLK; при равной SCLK — по убыванию системной частоты
+constexpr std::array<SpiClockPlan, kClockRates.size() * kSpiDividers.size()> makeSpiTable() {
+    std::array<SpiClockPlan, kClockRates.size() * kSpiDividers.size()> table{};
+    size_t n = 0;
+    for (auto clock : kClockRates)
+        for (auto div : kSpiDividers)
+            table[n++] = {clock, div, systemClockHz(clock) / spiDividerValue(div)};
+    // Сортировка вставками: std::sort не constexpr в C++17
+    for (size_t i = 1; i < table.size(); ++i) {
+        const SpiClockPlan item = table[i];
+        size_t j = i;
+        for (; j > 0 && (table[j - 1].hz < item.hz ||
+                         (table[j - 1].hz == item.hz &&
+                          systemClockHz(table[j - 1].clock) < systemClockHz(item.clock)));
+             --j)
+            table[j] = table[j - 1];
+        table[j] = item;
+    }
+    return table;
+}
+
+constexpr auto kSpiTable = makeSpiTable();
+constexpr uint32_t kSpiMaxHz = kSpiTable.front().hz; ///< 80 МГц / 2
+constexpr uint32_t kSpiMinHz = kSpiTable.back().hz;  ///< 24 МГц / 512
+
+/**
+ * @brief Самая высокая частота SCLK не выше maxHz
+ * @param maxHz Предельная частота ведомого, Гц (не ниже kSpiMinHz)
+ * @param current Текущая системная частота — при равной SCLK выбирается она, чтобы не
+ *        менять частоту чипа без нужды
+ * @return План; при maxHz < kSpiMinHz — самая медленная пара (hz больше maxHz)
+ */
+constexpr SpiClockPlan planSpi(uint32_t maxHz, FT4222_ClockRate current = SYS_CLK_60) {
+    for (size_t i = 0; i < kSpiTable.size(); ++i) {
+        if (kSpiTable[i].hz > maxHz) continue;
+        for (size_t j = i; j < kSpiTable.size() && kSpiTable[j].hz == kSpiTable[i].hz; ++j)
+            if (kSpiTable[j].clock == current) return kSpiTable[j];
+        return kSpiTable[i];
+    }
+    return kSpiTable.back();
+}
+
+/**
+ * @brief Частота I2C Master при системной частоте и периоде таймера
+ *
+ * Модель контроллера I2C FT4222 (AN_329): SCL = f_sys / (8 · (TP + 1)), TP = 1..127.
+ * LibFT4222 вычисляет TP из частоты в кбит/с, переданной FT4222_I2CMaster_Init,
+ * с округлением в сторону меньшей частоты.
+ */
+constexpr uint32_t i2cHz(FT4222_ClockRate clock, uint32_t timerPeriod) {
+    return systemClockHz(clock) / (8 * (timerPeriod + 1));
+}
+
+constexpr uint32_t kI2CMinTimerPeriod = 1;
+constexpr uint32_t kI2CMaxTimerPeriod = 127;
+constexpr uint32_t kI2CMinHz = 60'000;    ///< Нижняя граница FT4222_I2CMaster_Init, 60 кбит/с
+constexpr uint32_t kI2CMaxHz = 3'400'000; ///< High-speed mode, 3,4 Мбит/с
+
+struct I2CClockPlan {
+    FT4222_ClockRate clock = SYS_CLK_60;
+    uint32_t timerPeriod = 0;
+    uint32_t hz = 0;
+    /// Значение для FT4222_I2CMaster_Init: частота в кбит/с с округлением вниз, чтобы
+    /// LibFT4222 не выбрала период короче расчётного
+    constexpr uint32_t kbps() const { return hz / 1000; }
+};
+
+/**
+ * @brief Самая высокая частота SCL не выше maxHz
+ * @param maxHz Предельная частота, Гц (ограничивается kI2CMaxHz)
+ * @param current Предпочитаемая системная частота при равной SCL
+ * @return План; hz == 0, если ни одно сочетание не укладывается в [kI2CMinHz, maxHz]
+ */
+constexpr I2CClockPlan planI2C(uint32_t maxHz, FT4222_ClockRate current = SYS_CLK_60) {
+    if (maxHz > kI2CMaxHz) maxHz = kI2CMaxHz;
+    I2CClockPlan best;
+    for (auto clock : kClockRates) {
+        // Наименьший TP, при котором SCL не выше maxHz
+        uint32_t tp = systemClockHz(clock) / (8 * maxHz);
+        if (tp > 0 && i2cHz(clock, tp - 1) <= maxHz) --tp;
+        if (tp < kI2CMinTimerPeriod) tp = kI2CMinTimerPeriod;
+        while (tp <= kI2CMaxTimerPeriod && i2cHz(clock, tp) > maxHz) ++tp;
+        if (tp > kI2CMaxTimerPeriod) continue;
+        const uint32_t hz = i2cHz(clock, tp);
+        if (hz < kI2CMinHz) continue;
+        if (hz > best.hz || (hz == best.hz && clock == current)) best = {clock, tp, hz};
+    }
+    return best;
+}
+
+static_assert(kSpiMaxHz == 40'000'000 && kSpiMinHz == 46'875);
+static_assert(planSpi(20'000'000, SYS_CLK_60).hz == 20'000'000);
+static_assert(planSpi(10'000'000, SYS_CLK_60).clock == SYS_CLK_80);
+static_assert(planI2C(400'000).hz == 400'000);
+static_assert(planI2C(1'000'000, SYS_CLK_80).clock == SYS_CLK_80);
+
+} // namespace ft4222clock
@@ -0,0 +1,335 @@
+// Backend-independent parts of FTDevice (linked with both ft4222.cpp and ft4222_mock.cpp).
+
+#include "ft4222.hpp"
+#include "ft4222_clock.hpp"
+#include "ft4222_stats.hpp"
+#include "ft4222_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Логирование
+
+void FTDevice::setLogger(Logger logger) {
+    m_logger = std::move(logger);
+}
+
+void FTDevice::log(LogLevel level, const char *message) const {
+    if (logEnabled(level)) m_logger(message);
+}
+
+namespace {
+
+// Исключение из итога try*-метода с тем же текстом, что у прежнего бросающего API
+[[noreturn]] void throwI2CResult(const I2CResult &r, size_t expected) {
+    switch (r.error) {
+    case I2CError::InvalidArgument:
+        throw std::invalid_argument(r.what);
+    case I2CError::Device:
+        throw std::runtime_error(std::string(r.what) + " failed with FT4222_STATUS: " +
+                                 std::to_string(r.status));
+    case I2CError::Incomplete:
+        throw std::runtime_error(std::string(r.what) + " incomplete. Written: " +
+                                 std::to_string(r.bytes) + "/" + std::to_string(expected) + " bytes");
+    default:
+        throw std::runtime_error(r.what ? r.what : "I2C operation failed");
+    }
+}
+
+} // namespace
+
+// Бросающие I2C-методы — обёртки над вариантами без исключений
+
+size_t FTDevice::i2cMasterWrite(uint8_t deviceAddress, ConstByteSpan data, uint8_t flag) const {
+    const I2CResult r = tryI2CWrite(deviceAddress, data, flag);
+    if (!r.ok()) throwI2CResult(r, data.size());
+    return r.bytes;
+}
+
+size_t FTDevice::i2cMasterRead(uint8_t deviceAddress, ByteSpan buffer, uint8_t flag) {
+    const I2CResult r = tryI2CRead(deviceAddress, buffer, flag);
+    if (!r.ok()) throwI2CResult(r, buffer.size());
+    return r.bytes;
+}
+
+size_t FTDevice::i2cReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes, ByteSpan buffer) {
+    const I2CResult r = tryI2CReadRegister(deviceAddress, regBytes, buffer);
+    if (!r.ok()) throwI2CResult(r, regBytes.size());
+    return r.bytes;
+}
+
+// Векторные варианты операций — тонкие обёртки над перегрузками с буфером вызывающей стороны
+
+std::vector<uint8_t> FTDevice::read(size_t bytesToRead, unsigned int timeoutMs) {
+    std::vector<uint8_t> buffer(bytesToRead);
+    buffer.resize(read(ByteSpan(buffer), timeoutMs));
+    return buffer;
+}
+
+void FTDevice::write(const std::vector<uint8_t> &data, unsigned int timeoutMs) {
+    write(ConstByteSpan(data), timeoutMs);
+}
+
+void FTDevice::i2cMasterWrite(uint8_t deviceAddress, const std::vector<uint8_t> &data,
+                              uint8_t flag) const {
+    i2cMasterWrite(deviceAddress, ConstByteSpan(data), flag);
+}
+
+std::vector<uint8_t> FTDevice::i2cMasterRead(uint8_t deviceAddress, size_t bytesToRead,
+                                             uint8_t flag) {
+    std::vector<uint8_t> buffer(bytesToRead);
+    buffer.resize(i2cMasterRead(deviceAddress, ByteSpan(buffer), flag));
+    return buffer;
+}
+
+std::vector<uint8_t> FTDevice::i2cReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes,
+                                               size_t bytesToRead) {
+    std::vector<uint8_t> buffer(bytesToRead);
+    buffer.resize(i2cReadRegister(deviceAddress, regBytes, ByteSpan(buffer)));
+    return buffer;
+}
+
+std::vector<uint8_t> FTDevice::spiMasterSingleRead(size_t bytesToRead, bool endTransaction) {
+    std::vector<uint8_t> buffer(bytesToRead);
+    buffer.resize(spiMasterSingleRead(ByteSpan(buffer), endTransaction));
+    return buffer;
+}
+
+void FTDevice::spiMasterSingleWrite(const std::vector<uint8_t> &data, bool endTransaction) {
+    spiMasterSingleWrite(ConstByteSpan(data), endTransaction);
+}
+
+std::vector<uint8_t> FTDevice::spiMasterSingleReadWrite(const std::vector<uint8_t> &writeData,
+                                                        bool endTransaction) {
+    std::vector<uint8_t> readBuffer(writeData.size());
+    readBuffer.resize(spiMasterSingleReadWrite(ByteSpan(readBuffer), ConstByteSpan(writeData),
+                                               endTransaction));
+    return readBuffer;
+}
+
+std::vector<uint8_t> FTDevice::spiMasterMultiReadWrite(const std::vector<uint8_t> &singleWrite,
+                                                       const std::vector<uint8_t> &multiWrite,
+                                                       size_t readLength, unsigned dummyCycles) {
+    std::vector<uint8_t> readBuffer(readLength);
+    readBuffer.resize(spiMasterMultiReadWrite(ByteSpan(readBuffer), ConstByteSpan(singleWrite),
+                                              ConstByteSpan(multiWrite), dummyCycles));
+    return readBuffer;
+}
+
+size_t FTDevice::spiMultiDummyBytes(FT4222_SPIMode mode, size_t singleLength,
+                                    size_t multiWriteLength, size_t readLength,
+                                    unsigned dummyCycles) {
+    if (mode != SPI_IO_DUAL && mode != SPI_IO_QUAD)
+        throw std::runtime_error("SPI multi-I/O transfer requires dual or quad mode");
+    if (singleLength > 15)
+        throw std::invalid_argument("SPI single-line phase is limited to 15 bytes");
+
+    // За один такт по 2 (dual) или 4 (quad) линиям передаётся 2 или 4 бита
+    const unsigned lines = mode == SPI_IO_DUAL ? 2 : 4;
+    if (dummyCycles * lines % 8 != 0)
+        throw std::invalid_argument("SPI dummy cycles must be a multiple of " +
+                                    std::to_string(8 / lines) + " in this mode");
+    const size_t dummyBytes = dummyCycles * lines / 8;
+
+    if (dummyBytes + multiWriteLength > std::numeric_limits<uint16_t>::max() ||
+        readLength > std::numeric_limits<uint16_t>::max())
+        throw std::invalid_argument("SPI multi-I/O phases are limited to 65535 bytes");
+    if (singleLength + dummyBytes + multiWriteLength == 0 && readLength == 0)
+        throw std::invalid_argument("SPI multi-I/O transfer is empty");
+    return dummyBytes;
+}
+
+// Планировщик частот: системная частота меняется только если план требует другой
+
+uint32_t FTDevice::initI2CMasterHz(uint32_t maxHz, bool force) {
+    const auto plan = ft4222clock::planI2C(maxHz, getClockRate());
+    if (plan.hz == 0)
+        throw std::invalid_argument("I2C clock below " + std::to_string(ft4222clock::kI2CMinHz) + " Hz");
+    setClockRate(plan.clock, force);
+    initI2CMaster(static_cast<I2CSpeed>(plan.kbps()), force);
+    log(LogLevel::Info, [&] {
+        return "I2C clock plan: " + std::to_string(plan.hz) + " Hz (requested " + std::to_string(maxHz) +
+               ", timer period " + std::to_string(plan.timerPeriod) + ")";
+    });
+    return plan.hz;
+}
+
+uint32_t FTDevice::initSPIMasterHz(uint32_t maxHz, FT4222_SPIMode mode, FT4222_SPICPOL polarity,
+                                   FT4222_SPICPHA phase, bool force) {
+    if (maxHz < ft4222clock::kSpiMinHz)
+        throw std::invalid_argument("SPI clock below " + std::to_string(ft4222clock::kSpiMinHz) + " Hz");
+    const auto plan = ft4222clock::planSpi(maxHz, getClockRate());
+    setClockRate(plan.clock, force);
+    initSPIMaster(mode, static_cast<SPIClockDivider>(plan.divider), polarity, phase, force);
+    log(LogLevel::Info, [&] {
+        return "SPI clock plan: " + std::to_string(plan.hz) + " Hz (requested " + std::to_string(maxHz) +
+               ", divider " + std::to_string(ft4222clock::spiDividerValue(plan.divider)) + ")";
+    });
+    return plan.hz;
+}
+
+// I2CBatch
+
+void I2CBatch::add(uint8_t address, ConstByteSpan data, uint16_t readLength, uint8_t flag,
+                   uint8_t readFlag) {
+    if (data.size() > std::numeric_limits<uint16_t>::max())
+        throw std::invalid_argument("I2C batch write is longer than 65535 bytes");
+    Op op;
+    op.address = address;
+    op.flag = flag;
+    op.readFlag = readFlag;
+    op.writeOffset = m_writeData.size();
+    op.writeLength = static_cast<uint16_t>(data.size());
+    op.readLength = readLength;
+    m_writeData.insert(m_writeData.end(), data.begin(), data.end());
+    m_ops.push_back(op);
+    m_readTotal += readLength;
+}
+
+void I2CBatch::write(uint8_t address, ConstByteSpan data, uint8_t flag) {
+    add(address, data, 0, flag, flag);
+}
+
+void I2CBatch::read(uint8_t address, uint16_t length, uint8_t flag) {
+    add(address, ConstByteSpan(), length, flag, flag);
+}
+
+void I2CBatch::writeRead(uint8_t address, ConstByteSpan data, uint16_t readLength, uint8_t flag) {
+    add(address, data, readLength, flag, flag);
+}
+
+void I2CBatch::readRegister(uint8_t address, ConstByteSpan regBytes, uint16_t readLength) {
+    add(address, regBytes, readLength, START, Repeated_START | STOP);
+}
+
+void I2CBatch::clear() noexcept {
+    m_ops.clear();
+    m_writeData.clear();
+    m_readTotal = 0;
+}
+
+void I2CBatchResult::prepare(const I2CBatch &batch) {
+    data.resize(batch.totalReadLength());
+    ops.assign(batch.size(), OpStatus{});
+    failed = 0;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ops[i].readOffset = offset;
+        offset += batch.ops()[i].readLength;
+    }
+}
+
+// Трасса: пакет раскладывается на фазы I2CWrite / I2CRead с флагом FlagBatch, чтобы
+// воспроизведение повторяло их по одной; время у всех фаз — время начала пакета
+void FTDevice::traceI2CBatch(const I2CBatch &batch, const I2CBatchResult &result,
+                             uint64_t startNs) const {
+    ft4222trace::Recorder *recorder = m_trace.get();
+    if (!recorder) return;
+
+    ft4222trace::RecordHeader h;
+    h.timeNs = startNs;
+    const uint64_t duration = recorder->nowNs() - startNs;
+    h.durationNs = duration > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<uint32_t>(duration);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const I2CBatch::Op &op = batch.ops()[i];
+        const I2CBatchResult::OpStatus &st = result.ops[i];
+        h.address = op.address;
+        h.value = 0;
+
+        bool writeOk = true;
+        if (op.writeLength != 0) {
+            // При фазе чтения status уже относится к ней: полная запись означает, что она прошла
+            writeOk = st.written == op.writeLength && (op.readLength != 0 || st.ok);
+            h.op = ft4222stats::Op::I2CWrite;
+            h.param = op.flag;
+            h.flags = ft4222trace::FlagBatch | (writeOk ? 0 : ft4222trace::FlagError);
+            h.status = writeOk ? 0 : static_cast<int32_t>(st.status);
+            recorder->record(h, ConstByteSpan(batch.writeData().data() + op.writeOffset,
+                                              op.writeLength),
+                             {}, {});
+        }
+
+        if (writeOk && op.readLength != 0) {
+            const bool readOk = st.ok;
+            h.op = ft4222stats::Op::I2CRead;
+            h.param = op.readFlag;
+            h.value = op.readLength;
+            h.flags = ft4222trace::FlagBatch | (readOk ? 0 : ft4222trace::FlagError);
+            h.status = readOk ? 0 : static_cast<int32_t>(st.status);
+            recorder->record(h, {}, {}, ConstByteSpan(result.data.data() + st.readOffset, st.read));
+        }
+    }
+}
+
+// Восстановление I2C
+
+I2CFault classifyI2CFault(FT4222_STATUS status, uint8_t controllerStatus) noexcept {
+    // Сбои обмена с адаптером: сам вызов корректен, повтор может пройти
+    const bool transientStatus = status == FT4222_IO_ERROR || status == FT4222_OTHER_ERROR ||
+                                 status == FT4222_FAILED_TO_WRITE_DEVICE ||
+                                 status == FT4222_FAILED_TO_READ_DEVICE;
+    if (status != FT4222_OK && !transientStatus) return I2CFault::Fatal;
+    if (I2CM_ARB_LOST(controllerStatus) || I2CM_BUS_BUSY(controllerStatus)) return I2CFault::BusStuck;
+    if (I2CM_ADDRESS_NACK(controllerStatus) || I2CM_DATA_NACK(controllerStatus)) return I2CFault::Nack;
+    if (transientStatus || I2CM_ERROR(controllerStatus)) return I2CFault::Transient;
+    // Вызов прошёл, контроллер без ошибок, но передано меньше — устройство прервало обмен
+    return I2CFault::Nack;
+}
+
+bool FTDevice::recoverI2C(FT4222_STATUS status, unsigned attempt, uint8_t *controllerStatus) const {
+    const I2CRecoveryPolicy &policy = m_i2cRecovery;
+    if (!policy.enabled()) return false;
+
+    uint8_t controller = 0;
+    if (!i2cControllerStatusLocked(controller)) controller = 0;
+    if (controllerStatus) *controllerStatus = controller;
+    const I2CFault fault = classifyI2CFault(status, controller);
+    if (fault == I2CFault::Nack || fault == I2CFault::Fatal) return false;
+    if (attempt >= policy.maxRetries) {
+        ft4222stats::noteRecovery(ft4222stats::RecoveryEvent::Exhausted);
+        log(LogLevel::Info, [&] {
+            return "I2C recovery exhausted after " + std::to_string(attempt) + " retries (status " +
+                   std::to_string(status) + ", controller " + std::to_string(controller) + ")";
+        });
+        return false;
+    }
+
+    // Первый раз — сброс шины; если сбой повторился, сброс шины уже не помог
+    const char *action = "retry";
+    if (policy.resetChip && attempt > 0) {
+        ft4222stats::noteRecovery(ft4222stats::RecoveryEvent::ChipReset);
+        action = i2cResetChipLocked() ? "chip reset" : "chip reset failed";
+    } else if (fault == I2CFault::BusStuck && policy.resetBus) {
+        ft4222stats::noteRecovery(ft4222stats::RecoveryEvent::BusReset);
+        action = i2cResetBusLocked() ? "bus reset" : "bus reset failed";
+    }
+    ft4222stats::noteRecovery(ft4222stats::RecoveryEvent::Retry);
+
+    const unsigned shift = std::min(attempt, 16u);
+    const uint64_t backoff = std::min<uint64_t>(static_cast<uint64_t>(policy.backoffUs) << shift,
+                                                policy.maxBackoffUs);
+    log(LogLevel::Info, [&] {
+        return std::string("I2C recovery: ") + (fault == I2CFault::BusStuck ? "bus stuck" : "transient") +
+               " (status " + std::to_string(status) + ", controller " + std::to_string(controller) +
+               "), " + action + ", retry " + std::to_string(attempt + 1) + "/" +
+               std::to_string(policy.maxRetries) + " in " + std::to_string(backoff) + " us";
+    });
+    if (backoff != 0) std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+    return true;
+}
+
+void FTDevice::noteI2CRecovered() noexcept {
+    ft4222stats::noteRecovery(ft4222stats::RecoveryEvent::Recovered);
+}
+
+I2CBatchResult FTDevice::runI2CBatch(const I2CBatch &batch) {
+    I2CBatchResult result;
+    runI2CBatch(batch, result);
+    return result;
+}
@@ -1,51 +1,557 @@
 // Stub FT4222 backend for CI / builds without LibFT4222 (no real hardware access).
 
 #include "ft4222.hpp"
+#include "ft4222_clock.hpp"
+#include "ft4222_mock.hpp"
+#include "ft4222_stats.hpp"
+#include "ft4222_trace.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Контроллер I2C после транзакции: IDLE, при NACK адреса — ещё ERROR | ADDRESS_NACK,
+// при зависшей шине — ERROR | BUS_BUSY
+constexpr uint8_t kI2CIdle = 0x20;
+constexpr uint8_t kI2CAddressNack = 0x20 | 0x02 | 0x04;
+constexpr uint8_t kI2CBusStuck = 0x20 | 0x02 | 0x40;
+
+// Неуспешный итог варианта без исключений (trace — nullptr, пока устройство не захвачено)
+I2CResult i2cFailure(ft4222stats::OpScope &stat, ft4222trace::Scope *trace, I2CError error,
+                     const char *what, FT4222_STATUS status = FT4222_OK) noexcept {
+    const int code = status == FT4222_OK ? -1 : static_cast<int>(status);
+    stat.fail(code);
+    if (trace)
+        trace->fail(code);
+    I2CResult r;
+    r.error = error;
+    r.status = status;
+    r.what = what;
+    return r;
+}
+
+std::mutex g_configMutex;
+bool g_configLoaded = false;
+ft4222mock::Config g_config;
+
+// Ожидание с точностью в единицы микросекунд: короткие интервалы (типичные для
+// одной транзакции USB) выдерживаются активным ожиданием, длинные — sleep + добор
+void waitFor(uint64_t ns) {
+    if (ns == 0)
+        return;
+    const auto deadline = Clock::now() + std::chrono::nanoseconds(ns);
+    if (ns > 2'000'000)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns - 1'000'000));
+    while (Clock::now() < deadline) {
+    }
+}
+
+// Имитируемое I2C-устройство: регистровый файл с автоинкрементом указателя; при заданной
+// странице запись заворачивается внутри неё, при заданном цикле записи устройство после
+// записи данных не подтверждает адрес (по этому признаку EEPROM опрашивают ACK polling)
+struct I2CTarget {
+    std::vector<uint8_t> registers;
+    size_t pointer = 0;
+    size_t pageSize = 0;
+    uint32_t writeCycleUs = 0;
+    Clock::time_point busyUntil{};
+
+    size_t pointerWidth() const { return registers.size() > 256 ? 2 : 1; }
+
+    bool busy() const { return writeCycleUs != 0 && Clock::now() < busyUntil; }
+
+    void setPointer(ConstByteSpan bytes) {
+        size_t value = 0;
+        for (uint8_t b : bytes)
+            value = (value << 8) | b;
+        pointer = registers.empty() ? 0 : value % registers.size();
+    }
+
+    // Первые pointerWidth() байт записи — адрес регистра, остальные пишутся по указателю
+    void write(ConstByteSpan data) {
+        const size_t width = std::min(pointerWidth(), data.size());
+        setPointer(data.subspan(0, width));
+        for (size_t i = width; i < data.size() && !registers.empty(); ++i) {
+            registers[pointer] = data[i];
+            if (pageSize != 0)
+                pointer = pointer - pointer % pageSize + (pointer + 1) % pageSize;
+            else
+                pointer = (pointer + 1) % registers.size();
+        }
+        if (data.size() > width && writeCycleUs != 0)
+            busyUntil = Clock::now() + std::chrono::microseconds(writeCycleUs);
+    }
+
+    void read(ByteSpan buffer) {
+        for (auto &b : buffer) {
+            if (registers.empty()) {
+                b = 0xFF;
+                continue;
+            }
+            b = registers[pointer];
+            pointer = (pointer + 1) % registers.size();
+        }
+    }
+};
+
+// Имитируемая SPI NOR flash. Кадр — байты между выбором кристалла и снятием CS
+// (endTransaction): первый байт — команда, затем 3 байта адреса и данные. Команды,
+// меняющие массив, выполняются только после WREN и при снятии CS, на время
+// программирования / стирания взводят WIP; пока WIP взведён, принимается только RDSR.
+struct SpiFlash {
+    static constexpr uint8_t kJedecId[3] = {0xEF, 0x40, 0x18};
+
+    std::vector<uint8_t> memory;
+    uint32_t programUs = 0;
+    uint32_t eraseUs = 0;
+    Clock::time_point busyUntil{};
+    bool writeEnabled = false;
+
+    // Текущий кадр
+    size_t frameBytes = 0;
+    uint8_t opcode = 0;
+    bool accepted = false;
+    uint32_t address = 0;
+    bool programmed = false;
+
+    bool present() const { return !memory.empty(); }
+
+    bool busy() const { return Clock::now() < busyUntil; }
+
+    uint8_t status() const { return (busy() ? 0x01 : 0x00) | (writeEnabled ? 0x02 : 0x00); }
+
+    uint8_t exchange(uint8_t in) {
+        const size_t pos = frameBytes++;
+        if (pos == 0) {
+            opcode = in;
+            accepted = opcode == 0x05 || !busy();
+            address = 0;
+            programmed = false;
+            return 0xFF;
+        }
+        if (!accepted)
+            return 0xFF;
+        if (opcode == 0x05)
+            return status();
+        if (opcode == 0x9F)
+            return kJedecId[(pos - 1) % 3];
+        if (opcode != 0x03 && opcode != 0x02 && opcode != 0x20 && opcode != 0xD8)
+            return 0xFF;
+        if (pos <= 3) {
+            address = (address << 8) | in;
+            if (pos == 3)
+                address %= static_cast<uint32_t>(memory.size());
+            return 0xFF;
+        }
+        if (opcode == 0x03) {
+            const uint8_t b = memory[address];
+            address = (address + 1) % static_cast<uint32_t>(memory.size());
+            return b;
+        }
+        if (opcode == 0x02 && writeEnabled) {
+            // Программирование только сбрасывает биты; адрес заворачивается внутри страницы
+            memory[address] &= in;
+            address = (address & ~0xFFu) | ((address + 1) & 0xFFu);
+            programmed = true;
+        }
+        return 0xFF;
+    }
+
+    // Fast Read Dual/Quad Output (0x3B/0x6B): команда и адрес по одной линии, 8 dummy-тактов,
+    // данные по 2/4 линиям. Кадр целиком, CS снимается в конце. Возвращает false, если
+    // команда не распознана; при другом числе dummy-тактов ведущий читает не те такты (0xFF).
+    bool multiOutputRead(const uint8_t *single, size_t singleLength, unsigned dummyCycles,
+                         unsigned lines, uint8_t *out, size_t length) {
+        frameBytes = 0;
+        if (singleLength != 4 || (single[0] != 0x3B && single[0] != 0x6B) ||
+            lines != (single[0] == 0x3B ? 2u : 4u) || busy())
+            return false;
+        uint32_t from = (uint32_t{single[1]} << 16 | uint32_t{single[2]} << 8 | single[3]) %
+                        static_cast<uint32_t>(memory.size());
+        for (size_t i = 0; i < length; ++i) {
+            out[i] = dummyCycles == 8 ? memory[from] : 0xFF;
+            from = (from + 1) % static_cast<uint32_t>(memory.size());
+        }
+        return true;
+    }
+
+    void erase(uint32_t from, size_t size) {
+        std::fill(memory.begin() + from, memory.begin() + from + size, 0xFF);
+        busyUntil = Clock::now() + std::chrono::microseconds(eraseUs);
+    }
+
+    void deselect() {
+        const size_t bytes = frameBytes;
+        frameBytes = 0;
+        if (bytes == 0 || !accepted)
+            return;
+        switch (opcode) {
+        case 0x06:
+            writeEnabled = true;
+            return;
+        case 0x04:
+            writeEnabled = false;
+            return;
+        case 0x02:
+            if (programmed)
+                busyUntil = Clock::now() + std::chrono::microseconds(programUs);
+            break;
+        case 0x20:
+        case 0xD8: {
+            if (!writeEnabled || bytes < 4)
+                return;
+            const uint32_t size = std::min<uint32_t>(opcode == 0x20 ? 0x1000 : 0x10000,
+                                                     static_cast<uint32_t>(memory.size()));
+            erase(address - address % size, size);
+            break;
+        }
+        case 0xC7:
+        case 0x60:
+            if (!writeEnabled)
+                return;
+            erase(0, memory.size());
+            break;
+        default:
+            return;
+        }
+        writeEnabled = false;
+    }
+};
+
+} // namespace
+
+namespace ft4222mock {
+
+std::vector<uint8_t> patternRegisters(size_t size) {
+    std::vector<uint8_t> regs(size);
+    for (size_t i = 0; i < size; ++i)
+        regs[i] = static_cast<uint8_t>(i & 0xFF);
+    return regs;
+}
+
+Config configFromEnvironment() {
+    Config cfg;
+    if (const char *env = std::getenv("TWI_MOCK_USB_LATENCY_US")) {
+        char *end = nullptr;
+        const unsigned long us = std::strtoul(env, &end, 10);
+        if (end != env && us <= 1'000'000)
+            cfg.usbLatencyUs = static_cast<uint32_t>(us);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_BUS_TIMING"))
+        cfg.busTiming = std::strcmp(env, "0") != 0 && *env != '\0';
+    if (const char *env = std::getenv("TWI_MOCK_I2C")) {
+        std::istringstream iss(env);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+            char *end = nullptr;
+            const unsigned long addr = std::strtoul(item.c_str(), &end, 0);
+            if (end == item.c_str() || addr > 0x7F)
+                continue;
+            unsigned long size = 256;
+            if (*end == ':') {
+                const char *sizeStr = end + 1;
+                size = std::strtoul(sizeStr, &end, 0);
+                if (end == sizeStr || size > 65536)
+                    continue;
+            }
+            cfg.i2cTargets[static_cast<uint8_t>(addr)] = patternRegisters(size);
+        }
+    }
+    if (const char *env = std::getenv("TWI_MOCK_I2C_PAGE")) {
+        char *end = nullptr;
+        const unsigned long page = std::strtoul(env, &end, 10);
+        if (end != env && page <= 4096)
+            cfg.i2cPageSize = static_cast<uint16_t>(page);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_I2C_WRITE_CYCLE_US")) {
+        char *end = nullptr;
+        const unsigned long us = std::strtoul(env, &end, 10);
+        if (end != env && us <= 1'000'000)
+            cfg.i2cWriteCycleUs = static_cast<uint32_t>(us);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_CHIP_MODE")) {
+        char *end = nullptr;
+        const unsigned long mode = std::strtoul(env, &end, 10);
+        if (end != env && mode <= 3)
+            cfg.chipMode = static_cast<uint8_t>(mode);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_SPI_FLASH")) {
+        char *end = nullptr;
+        const unsigned long size = std::strtoul(env, &end, 0);
+        // 3-байтовый адрес: не больше 16 МБ
+        if (end != env && size <= 0x1000000)
+            cfg.spiFlashSize = static_cast<uint32_t>(size);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_SPI_FLASH_PROGRAM_US")) {
+        char *end = nullptr;
+        const unsigned long us = std::strtoul(env, &end, 10);
+        if (end != env && us <= 1'000'000)
+            cfg.spiFlashProgramUs = static_cast<uint32_t>(us);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_SPI_FLASH_ERASE_US")) {
+        char *end = nullptr;
+        const unsigned long us = std::strtoul(env, &end, 10);
+        if (end != env && us <= 10'000'000)
+            cfg.spiFlashEraseUs = static_cast<uint32_t>(us);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_I2C_STUCK")) {
+        if (std::strcmp(env, "bus") == 0)
+            cfg.i2cStuck = I2CStuck::Bus;
+        else if (std::strcmp(env, "chip") == 0)
+            cfg.i2cStuck = I2CStuck::Chip;
+    }
+    if (const char *env = std::getenv("TWI_MOCK_I2C_GLITCHES")) {
+        char *end = nullptr;
+        const unsigned long n = std::strtoul(env, &end, 10);
+        if (end != env && n <= 1'000'000)
+            cfg.i2cGlitches = static_cast<uint32_t>(n);
+    }
+    if (const char *env = std::getenv("TWI_MOCK_SPI_CHUNK_LIMIT")) {
+        char *end = nullptr;
+        const unsigned long n = std::strtoul(env, &end, 10);
+        if (end != env && n <= FTDevice::SPI_MAX_CHUNK)
+            cfg.spiChunkLimit = static_cast<uint32_t>(n);
+    }
+    return cfg;
+}
+
+void setConfig(const Config &cfg) {
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    g_config = cfg;
+    g_configLoaded = true;
+}
+
+Config config() {
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    if (!g_configLoaded) {
+        g_config = configFromEnvironment();
+        g_configLoaded = true;
+    }
+    return g_config;
+}
+
+} // namespace ft4222mock
 
 struct FTDevice::Impl {
-    bool open = false;
+    FTDevice::StateWord state; // пишется под deviceMutex, читается без блокировок
     std::string serial;
     uint32_t index = std::numeric_limits<uint32_t>::max();
     FT4222_ClockRate clockRate = SYS_CLK_60;
-    mutable FTDevice::Mode currentMode = FTDevice::Mode::Unknown;
+    mutable FTDevice::I2CSpeed i2cSpeed = FTDevice::I2CSpeed::S400K;
+    FTDevice::SPIClockDivider spiDivider = FTDevice::SPIClockDivider::DIV_512;
+    FT4222_SPIMode spiMode = SPI_IO_SINGLE;
+    FT4222_SPICPOL spiPolarity = CLK_IDLE_LOW;
+    FT4222_SPICPHA spiPhase = CLK_LEADING;
+    uint8_t gpioDirs = 0;
+    FT4222_ClockRate modeClock = SYS_CLK_60; // системная частота на момент последнего init*
+    bool clockKnown = false;
     std::mutex deviceMutex;
     bool gpioOut[4] = {};
+
+    // Модель времени и шины (снимок ft4222mock::config() на момент open)
+    uint32_t usbLatencyUs = 0;
+    bool busTiming = false;
+    std::map<uint8_t, I2CTarget> i2cTargets;
+    uint8_t i2cStatus = kI2CIdle;
+    ft4222mock::I2CStuck i2cStuck = ft4222mock::I2CStuck::None;
+    uint32_t i2cGlitches = 0;
+    uint32_t spiChunkLimit = 0;
+    uint8_t chipMode = 3;
+    SpiFlash spiFlash;
+
+    FTDevice::Mode mode() const noexcept {
+        return state.load().mode;
+    }
+
+    void attach() {
+        const ft4222mock::Config cfg = ft4222mock::config();
+        usbLatencyUs = cfg.usbLatencyUs;
+        chipMode = cfg.chipMode;
+        busTiming = cfg.busTiming;
+        i2cTargets.clear();
+        for (const auto &t : cfg.i2cTargets) {
+            I2CTarget &target = i2cTargets[t.first];
+            target.registers = t.second;
+            target.pageSize = cfg.i2cPageSize;
+            target.writeCycleUs = cfg.i2cWriteCycleUs;
+        }
+        i2cStuck = cfg.i2cStuck;
+        i2cGlitches = cfg.i2cGlitches;
+        spiChunkLimit = cfg.spiChunkLimit;
+        i2cStatus = i2cStuck == ft4222mock::I2CStuck::None ? kI2CIdle : kI2CBusStuck;
+        spiFlash = SpiFlash{};
+        spiFlash.memory.assign(std::min<uint32_t>(cfg.spiFlashSize, 0x1000000), 0xFF);
+        spiFlash.programUs = cfg.spiFlashProgramUs;
+        spiFlash.eraseUs = cfg.spiFlashEraseUs;
+    }
+
+    // Одна транзакция USB плюс (при busTiming) время на шине
+    void transaction(uint64_t busNs = 0) const {
+        waitFor(static_cast<uint64_t>(usbLatencyUs) * 1000 + (busTiming ? busNs : 0));
+    }
+
+    // START + (адрес + bytes байт по 9 бит с ACK) + STOP на текущей скорости
+    uint64_t i2cFrameNs(size_t bytes, I2CSpeed speed) const {
+        const uint64_t bits = 2 + 9 * (1 + static_cast<uint64_t>(bytes));
+        return bits * 1'000'000 / static_cast<uint64_t>(speed);
+    }
+
+    uint64_t i2cFrameNs(size_t bytes) const { return i2cFrameNs(bytes, i2cSpeed); }
+
+    // SCLK = системная частота / делитель (2..512)
+    uint64_t spiBytesNs(size_t bytes) const {
+        const uint64_t div = ft4222clock::spiDividerValue(static_cast<FT4222_SPIClock>(spiDivider));
+        return static_cast<uint64_t>(bytes) * 8 * div * 1000 /
+               (ft4222clock::systemClockHz(clockRate) / 1'000'000);
+    }
+
+    // Один чанк SPI (одна транзакция USB): обмен по MOSI/MISO с имитируемой flash
+    // (mosi == nullptr — передаются 0xFF); без flash на MISO нули. end — снятие CS после
+    // последнего байта. Возвращает число переданных байт (меньше при spiChunkLimit).
+    size_t spiChunk(const uint8_t *mosi, uint8_t *miso, size_t bytes, bool end) {
+        if (spiChunkLimit != 0)
+            bytes = std::min<size_t>(bytes, spiChunkLimit);
+        transaction(spiBytesNs(bytes));
+        for (size_t i = 0; i < bytes; ++i) {
+            const uint8_t b = spiFlash.present() ? spiFlash.exchange(mosi ? mosi[i] : 0xFF) : 0;
+            if (miso)
+                miso[i] = b;
+        }
+        if (end)
+            spiFlash.deselect();
+        return bytes;
+    }
+
+    // Снятие CS после прерванной передачи — чтение одного байта, как в реальном бэкенде
+    void spiEndTransaction() {
+        uint8_t dummy = 0;
+        spiChunk(nullptr, &dummy, 1, true);
+    }
+
+    // Сбой USB до выхода на шину: одна транзакция, код LibFT4222 вместо FT4222_OK
+    FT4222_STATUS i2cGlitch() {
+        if (i2cGlitches == 0)
+            return FT4222_OK;
+        --i2cGlitches;
+        transaction();
+        return FT4222_FAILED_TO_READ_DEVICE;
+    }
+
+    void resetI2CBus() {
+        transaction();
+        if (i2cStuck == ft4222mock::I2CStuck::Bus)
+            i2cStuck = ft4222mock::I2CStuck::None;
+        i2cStatus = i2cStuck == ft4222mock::I2CStuck::None ? kI2CIdle : kI2CBusStuck;
+    }
+
+    // Устройство, подтверждающее адрес; nullptr при NACK (нет устройства или идёт цикл
+    // записи) и на зависшей шине. Обновляет статус контроллера.
+    I2CTarget *addressI2C(uint8_t address) {
+        if (i2cStuck != ft4222mock::I2CStuck::None) {
+            i2cStatus = kI2CBusStuck;
+            return nullptr;
+        }
+        auto it = i2cTargets.find(address);
+        if (it != i2cTargets.end() && it->second.busy())
+            it = i2cTargets.end();
+        i2cStatus = it == i2cTargets.end() ? kI2CAddressNack : kI2CIdle;
+        return it == i2cTargets.end() ? nullptr : &it->second;
+    }
+
+    // Запись одной транзакцией, как FT4222_I2CMaster_WriteEx: пустой буфер (nullptr или
+    // 0 байт) библиотека отвергает без обращения к шине, при NACK адреса written == 0
+    FT4222_STATUS i2cWriteEx(uint8_t address, const uint8_t *data, uint16_t size, I2CSpeed speed,
+                             uint16_t &written) {
+        written = 0;
+        if (!data || size == 0)
+            return FT4222_INVALID_PARAMETER;
+        I2CTarget *target = addressI2C(address);
+        transaction(i2cFrameNs(target ? size : 0, speed));
+        if (!target)
+            return FT4222_OK;
+        target->write(ConstByteSpan(data, size));
+        written = size;
+        return FT4222_OK;
+    }
 };
 
+// Количество имитируемых адаптеров задаётся переменной окружения TWI_MOCK_DEVICES (по умолчанию 1).
+// В режимах чипа 0–2 адаптер даёт несколько интерфейсов с буквой в серийном номере и
+// описании, как LibFT4222 ("FT4222 A", "FT4222 B", ...).
 std::vector<DeviceInfo> DeviceEnumerator::listDevices() {
-    DeviceInfo mock;
-    mock.index = 0;
-    mock.serial = "MOCK0001";
-    mock.description = "FT4222 mock device (no LibFT4222)";
-    mock.locationId = 0;
-    mock.flags = 0;
-    return {mock};
+    unsigned count = 1; // не больше 64 — серийный номер укладывается в 4 цифры
+    if (const char *env = std::getenv("TWI_MOCK_DEVICES")) {
+        char *end = nullptr;
+        const unsigned long n = std::strtoul(env, &end, 10);
+        if (end != env && n <= 64)
+            count = static_cast<unsigned>(n);
+    }
+    static const unsigned kInterfaces[4] = {2, 4, 4, 1};
+    const unsigned interfaces = kInterfaces[ft4222mock::config().chipMode & 3];
+
+    std::vector<DeviceInfo> out;
+    out.reserve(count * interfaces);
+    for (unsigned i = 0; i < count; ++i) {
+        for (unsigned n = 0; n < interfaces; ++n) {
+            char serial[16];
+            std::snprintf(serial, sizeof(serial), "MOCK%04u", i + 1);
+            DeviceInfo mock;
+            mock.index = static_cast<uint32_t>(out.size());
+            mock.serial = serial;
+            mock.description = "FT4222 mock device (no LibFT4222)";
+            if (interfaces > 1) {
+                const char letter = static_cast<char>('A' + n);
+                mock.serial += letter;
+                mock.description = std::string("FT4222 ") + letter + " (mock)";
+            }
+            mock.locationId = mock.index;
+            mock.flags = 0;
+            out.push_back(mock);
+        }
+    }
+    return out;
 }
 
-void DeviceEnumerator::printDevices() {
-    std::cout << "Mock mode: LibFT4222 is not linked. Showing a placeholder device.\n";
-    std::cout << "Install FTDI LibFT4222 for real hardware (see README).\n\n";
-    for (const auto &dev : listDevices()) {
-        std::cout << "Index      : " << dev.index << "\n"
-                  << "Serial     : " << dev.serial << "\n"
-                  << "Description: " << dev.description << "\n"
-                  << "LocationId : " << dev.locationId << "\n\n";
+void DeviceEnumerator::printDevices(std::ostream &os) {
+    printDevices(listDevices(), os);
+}
+
+void DeviceEnumerator::printDevices(const std::vector<DeviceInfo> &devices, std::ostream &os) {
+    os << "Mock mode: LibFT4222 is not linked. Showing a placeholder device.\n";
+    os << "Install FTDI LibFT4222 for real hardware (see README).\n\n";
+    for (const auto &dev : devices) {
+        os << "Index      : " << dev.index << "\n"
+           << "Serial     : " << dev.serial << "\n"
+           << "Description: " << dev.description << "\n"
+           << "LocationId : " << dev.locationId << "\n\n";
     }
 }
 
 FTDevice::FTDevice(FTDevice &&other) noexcept
-    : pimpl(std::move(other.pimpl)), m_logger(std::move(other.m_logger)) {}
+    : pimpl(std::move(other.pimpl)), m_logger(std::move(other.m_logger)),
+      m_logLevel(other.m_logLevel), m_trace(std::move(other.m_trace)),
+      m_i2cRecovery(other.m_i2cRecovery) {}
 
 FTDevice &FTDevice::operator=(FTDevice &&other) noexcept {
     if (this != &other) {
         close();
         pimpl = std::move(other.pimpl);
         m_logger = std::move(other.m_logger);
+        m_logLevel = other.m_logLevel;
+        m_trace = std::move(other.m_trace);
+        m_i2cRecovery = other.m_i2cRecovery;
     }
     return *this;
 }
@@ -65,181 +571,687 @@ FTDevice::~FTDevice() {
     try {
         close();
     } catch (...) {
-        log("Exception in destructor while closing device");
+        log(LogLevel::Error, "Exception in destructor while closing device");
     }
 }
 
 void FTDevice::open(uint32_t index) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
     if (!pimpl)
         pimpl = std::make_unique<Impl>();
     if (isOpen())
         throw std::runtime_error("Device is already open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-    pimpl->open = true;
     pimpl->index = index;
     pimpl->serial.clear();
-    pimpl->currentMode = Mode::Unknown;
-    log("Mock device opened index=" + std::to_string(index));
+    pimpl->attach();
+    pimpl->state.publish(true, Mode::Unknown);
+    log(LogLevel::Info, [&] { return "Mock device opened index=" + std::to_string(index); });
 }
 
 void FTDevice::openBySerial(const std::string &serialNumber) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
     if (!pimpl)
         pimpl = std::make_unique<Impl>();
     if (isOpen())
         throw std::runtime_error("Device is already open");
 
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-    pimpl->open = true;
     pimpl->serial = serialNumber;
-    pimpl->currentMode = Mode::Unknown;
-    log("Mock device opened serial=" + serialNumber);
+    pimpl->attach();
+    pimpl->state.publish(true, Mode::Unknown);
+    log(LogLevel::Info, [&] { return "Mock device opened serial=" + serialNumber; });
+}
+
+// В mock Location ID совпадает с индексом (см. listDevices)
+void FTDevice::openByLocation(uint32_t locationId) {
+    ft4222stats::OpScope stat(ft4222stats::Op::Open);
+    if (!pimpl)
+        pimpl = std::make_unique<Impl>();
+    if (isOpen())
+        throw std::runtime_error("Device is already open");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    pimpl->index = locationId;
+    pimpl->serial.clear();
+    pimpl->attach();
+    pimpl->state.publish(true, Mode::Unknown);
+    log(LogLevel::Info, [&] { return "Mock device opened location=" + std::to_string(locationId); });
 }
 
 void FTDevice::close() noexcept {
-    if (!pimpl || !pimpl->open)
+    if (!isOpen())
         return;
+    ft4222stats::OpScope stat(ft4222stats::Op::Close);
     std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
-    pimpl->open = false;
-    pimpl->currentMode = Mode::Unknown;
-    log("Mock device closed");
+    pimpl->state.publish(false, Mode::Unknown);
+    pimpl->clockKnown = false;
+    log(LogLevel::Info, "Mock device closed");
 }
 
 bool FTDevice::isOpen() const noexcept {
-    return pimpl && pimpl->open;
+    return pimpl && pimpl->state.load().open;
+}
+
+FTDevice::State FTDevice::state() const noexcept {
+    return pimpl ? pimpl->state.load() : State{};
+}
+
+void FTDevice::setTraceRecorder(std::shared_ptr<ft4222trace::Recorder> recorder) {
+    if (!pimpl)
+        pimpl = std::make_unique<Impl>();
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    m_trace = std::move(recorder);
 }
 
-std::vector<uint8_t> FTDevice::read(size_t bytesToRead, unsigned int) {
+std::shared_ptr<ft4222trace::Recorder> FTDevice::traceRecorder() const {
+    if (!pimpl)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    return m_trace;
+}
+
+void FTDevice::setI2CRecoveryPolicy(const I2CRecoveryPolicy &policy) {
+    if (!pimpl)
+        pimpl = std::make_unique<Impl>();
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    m_i2cRecovery = policy;
+}
+
+I2CRecoveryPolicy FTDevice::i2cRecoveryPolicy() const {
+    if (!pimpl)
+        return m_i2cRecovery;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    return m_i2cRecovery;
+}
+
+size_t FTDevice::read(ByteSpan buffer, unsigned int timeoutMs) {
+    ft4222stats::OpScope stat(ft4222stats::Op::UsbRead, buffer.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    return std::vector<uint8_t>(bytesToRead, 0);
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::UsbRead, 0, timeoutMs);
+    pimpl->transaction();
+    std::fill(buffer.begin(), buffer.end(), 0);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+    trace.read(buffer);
+    return buffer.size();
 }
 
-void FTDevice::write(const std::vector<uint8_t> &data, unsigned int) {
+size_t FTDevice::write(ConstByteSpan data, unsigned int timeoutMs) {
+    ft4222stats::OpScope stat(ft4222stats::Op::UsbWrite, data.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
     if (data.empty())
-        return;
-    log("Mock write " + std::to_string(data.size()) + " bytes");
+        return 0;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::UsbWrite, 0, timeoutMs);
+    trace.write(data);
+    pimpl->transaction();
+    log(LogLevel::Debug, [&] { return "Mock write " + std::to_string(data.size()) + " bytes"; });
+    return data.size();
 }
 
-void FTDevice::initI2CMaster(I2CSpeed speed) const {
+bool FTDevice::initI2CMaster(I2CSpeed speed, bool force) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CInit);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    pimpl->currentMode = Mode::I2C_Master;
-    log("Mock I2C init " + std::to_string(static_cast<int>(speed)) + " kbps");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CInit, 0, static_cast<uint32_t>(speed));
+    if (!force && pimpl->mode() == Mode::I2C_Master && pimpl->i2cSpeed == speed &&
+        pimpl->modeClock == pimpl->clockRate)
+        return false;
+    pimpl->transaction();
+    pimpl->state.setMode(Mode::I2C_Master);
+    pimpl->i2cSpeed = speed;
+    pimpl->modeClock = pimpl->clockRate;
+    log(LogLevel::Info,
+        [&] { return "Mock I2C init " + std::to_string(static_cast<int>(speed)) + " kbps"; });
+    return true;
 }
 
-void FTDevice::i2cMasterWrite(uint8_t deviceAddress, const std::vector<uint8_t> &data,
-                              uint8_t) const {
+I2CResult FTDevice::tryI2CWrite(uint8_t deviceAddress, ConstByteSpan data, uint8_t flag) const noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CWrite, data.size());
     if (!isOpen())
-        throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master)
-        throw std::runtime_error("Device not in I2C Master mode");
+        return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master)
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
     if (data.empty())
-        return;
-    std::ostringstream oss;
-    oss << "Mock I2C write addr=0x" << std::hex << static_cast<int>(deviceAddress) << std::dec
-        << " len=" << data.size();
-    log(oss.str());
+        return {};
+    if (data.size() > I2C_MAX_TRANSFER)
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C write longer than 65535 bytes");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CWrite, deviceAddress, flag);
+    trace.write(data);
+    I2CTarget *target = nullptr;
+    FT4222_STATUS status = FT4222_OK;
+    uint8_t controller = 0;
+    retryI2C(status, [&] {
+        status = pimpl->i2cGlitch();
+        if (status != FT4222_OK)
+            return false;
+        target = pimpl->addressI2C(deviceAddress);
+        pimpl->transaction(pimpl->i2cFrameNs(target ? data.size() : 0));
+        return target != nullptr;
+    }, &controller);
+    if (status != FT4222_OK || !target) {
+        // Как LibFT4222: без ошибки USB транзакция успешна, но не передано ни одного байта
+        I2CResult r = status != FT4222_OK
+                          ? i2cFailure(stat, &trace, I2CError::Device, "FT4222_I2CMaster_WriteEx", status)
+                          : i2cFailure(stat, &trace, I2CError::Incomplete, "I2C Master Write");
+        r.controllerStatus = controller;
+        return r;
+    }
+    target->write(data);
+
+    log(LogLevel::Debug, [&] {
+        std::ostringstream oss;
+        oss << "Mock I2C write addr=0x" << std::hex << static_cast<int>(deviceAddress) << std::dec
+            << " len=" << data.size();
+        return oss.str();
+    });
+    I2CResult r;
+    r.bytes = data.size();
+    return r;
 }
 
-std::vector<uint8_t> FTDevice::i2cMasterRead(uint8_t deviceAddress, size_t bytesToRead, uint8_t) {
+I2CResult FTDevice::tryI2CRead(uint8_t deviceAddress, ByteSpan buffer, uint8_t flag) noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CRead, buffer.size());
     if (!isOpen())
-        throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master)
-        throw std::runtime_error("Device not in I2C Master mode");
-    log("Mock I2C read addr=0x" + std::to_string(deviceAddress));
-    return std::vector<uint8_t>(bytesToRead, 0);
+        return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master)
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
+    if (buffer.empty())
+        return {};
+    if (buffer.size() > I2C_MAX_TRANSFER)
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C read longer than 65535 bytes");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CRead, deviceAddress, flag);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+    I2CTarget *target = nullptr;
+    FT4222_STATUS status = FT4222_OK;
+    I2CResult r;
+    retryI2C(status, [&] {
+        status = pimpl->i2cGlitch();
+        if (status != FT4222_OK)
+            return false;
+        target = pimpl->addressI2C(deviceAddress);
+        pimpl->transaction(pimpl->i2cFrameNs(target ? buffer.size() : 0));
+        return target != nullptr;
+    }, &r.controllerStatus);
+    if (status != FT4222_OK) {
+        const uint8_t controller = r.controllerStatus;
+        r = i2cFailure(stat, &trace, I2CError::Device, "FT4222_I2CMaster_ReadEx", status);
+        r.controllerStatus = controller;
+        return r;
+    }
+    log(LogLevel::Debug, [&] { return "Mock I2C read addr=0x" + std::to_string(deviceAddress); });
+    if (!target)
+        return r;
+    target->read(buffer);
+    trace.read(buffer);
+    r.bytes = buffer.size();
+    return r;
+}
+
+I2CResult FTDevice::tryI2CReadRegister(uint8_t deviceAddress, ConstByteSpan regBytes,
+                                       ByteSpan buffer) noexcept {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CReadRegister, buffer.size());
+    if (!isOpen())
+        return i2cFailure(stat, nullptr, I2CError::NotOpen, "Device not open");
+    if (pimpl->mode() != Mode::I2C_Master)
+        return i2cFailure(stat, nullptr, I2CError::WrongMode, "Device not in I2C Master mode");
+    if (buffer.empty())
+        return {};
+    if (buffer.size() > I2C_MAX_TRANSFER || regBytes.size() > I2C_MAX_TRANSFER)
+        return i2cFailure(stat, nullptr, I2CError::InvalidArgument, "I2C read longer than 65535 bytes");
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CReadRegister, deviceAddress);
+    trace.write(regBytes);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+    I2CTarget *target = nullptr;
+    FT4222_STATUS status = FT4222_OK;
+    uint8_t controller = 0;
+    retryI2C(status, [&] {
+        status = pimpl->i2cGlitch();
+        if (status != FT4222_OK)
+            return false;
+        target = pimpl->addressI2C(deviceAddress);
+        pimpl->transaction(pimpl->i2cFrameNs(target ? regBytes.size() : 0));
+        return target != nullptr;
+    }, &controller);
+    if (status != FT4222_OK || !target) {
+        I2CResult r = status != FT4222_OK
+                          ? i2cFailure(stat, &trace, I2CError::Device, "FT4222_I2CMaster_WriteEx", status)
+                          : i2cFailure(stat, &trace, I2CError::Incomplete, "I2C register address write");
+        r.controllerStatus = controller;
+        return r;
+    }
+    target->setPointer(regBytes);
+    pimpl->transaction(pimpl->i2cFrameNs(buffer.size()));
+    target->read(buffer);
+    trace.read(buffer);
+
+    log(LogLevel::Debug, [&] {
+        return "Mock I2C register read addr=0x" + std::to_string(deviceAddress) + " reg bytes=" +
+               std::to_string(regBytes.size());
+    });
+    I2CResult r;
+    r.bytes = buffer.size();
+    return r;
 }
 
 uint8_t FTDevice::i2cMasterGetStatus() {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CStatus);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    return 0;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CStatus);
+    pimpl->transaction();
+    trace.value(pimpl->i2cStatus);
+    return pimpl->i2cStatus;
 }
 
 void FTDevice::i2cMasterResetBus() {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CResetBus);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    log("Mock I2C bus reset");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CResetBus);
+    pimpl->resetI2CBus();
+    log(LogLevel::Info, "Mock I2C bus reset");
+}
+
+bool FTDevice::i2cControllerStatusLocked(uint8_t &controllerStatus) const {
+    pimpl->transaction();
+    controllerStatus = pimpl->i2cStatus;
+    return true;
+}
+
+bool FTDevice::i2cResetBusLocked() const {
+    pimpl->resetI2CBus();
+    return true;
 }
 
+// Сброс, SetClock и I2CMaster_Init — три транзакции; режим и частота сохраняются
+bool FTDevice::i2cResetChipLocked() const {
+    pimpl->transaction();
+    pimpl->transaction();
+    pimpl->transaction();
+    pimpl->i2cStuck = ft4222mock::I2CStuck::None;
+    pimpl->i2cStatus = kI2CIdle;
+    pimpl->modeClock = pimpl->clockRate;
+    pimpl->state.touch();
+    return true;
+}
+
+// Повторяет стоимость реального scanI2CBus: ReadEx 1 байта и GetStatus на каждый адрес
 std::vector<uint8_t> FTDevice::scanI2CBus(uint8_t startAddress, uint8_t endAddress,
-                                          uint8_t) const {
+                                          uint8_t flag) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CScan);
+    if (!isOpen())
+        throw std::runtime_error("Device not open");
+    if (pimpl->mode() != Mode::I2C_Master)
+        throw std::runtime_error("Device not in I2C Master mode");
+    if (startAddress > endAddress)
+        std::swap(startAddress, endAddress);
+
+    std::vector<uint8_t> found;
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CScan, startAddress,
+                                endAddress | static_cast<uint32_t>(flag) << 8);
+    for (uint16_t addr = startAddress; addr <= endAddress; ++addr) {
+        const bool ack = pimpl->addressI2C(static_cast<uint8_t>(addr)) != nullptr;
+        pimpl->transaction(pimpl->i2cFrameNs(ack ? 1 : 0));
+        pimpl->transaction();
+        if (ack)
+            found.push_back(static_cast<uint8_t>(addr));
+    }
+    log(LogLevel::Debug, [&] {
+        return "Mock I2C scan finished, found " + std::to_string(found.size()) + " device(s)";
+    });
+    trace.read(found);
+    return found;
+}
+
+// Повторяет стоимость реального scanI2CBusFast: GetStatus только для кандидатов,
+// переключение на 1 МГц — две транзакции Init
+I2CScanResult FTDevice::scanI2CBusFast(uint8_t startAddress, uint8_t endAddress,
+                                       const I2CScanOptions &options) const {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CScanFast);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::I2C_Master)
+    if (pimpl->mode() != Mode::I2C_Master)
         throw std::runtime_error("Device not in I2C Master mode");
     if (startAddress > endAddress)
         std::swap(startAddress, endAddress);
-    (void)startAddress;
-    (void)endAddress;
-    log("Mock I2C scan (no devices)");
-    return {};
+
+    I2CScanResult result;
+    const auto sweepStart = Clock::now();
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::I2CScanFast, startAddress,
+                                endAddress | (options.writeProbe ? 1u << 8 : 0) |
+                                    (options.fastClock ? 1u << 9 : 0));
+    const bool switchClock = options.fastClock && pimpl->i2cSpeed != I2CSpeed::S1M;
+    const I2CSpeed speed = switchClock ? I2CSpeed::S1M : pimpl->i2cSpeed;
+    if (switchClock)
+        pimpl->transaction();
+
+    for (uint16_t addr = startAddress; addr <= endAddress; ++addr) {
+        const auto probeStart = Clock::now();
+        bool ack = false;
+        if (options.writeProbe) {
+            const uint8_t probe[1] = {kI2CWriteProbeByte};
+            uint16_t written = 0;
+            ack = pimpl->i2cWriteEx(static_cast<uint8_t>(addr), probe, 1, speed, written) == FT4222_OK &&
+                  written == 1;
+        } else {
+            ack = pimpl->addressI2C(static_cast<uint8_t>(addr)) != nullptr;
+            pimpl->transaction(pimpl->i2cFrameNs(ack ? 1 : 0, speed));
+        }
+        if (ack)
+            pimpl->transaction();
+
+        const auto probeUs = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - probeStart)
+                .count());
+        ++result.probed;
+        result.maxProbeUs = std::max(result.maxProbeUs, probeUs);
+        if (ack)
+            result.devices.push_back({static_cast<uint8_t>(addr), probeUs});
+    }
+
+    if (switchClock)
+        pimpl->transaction();
+    result.elapsedUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sweepStart).count());
+    std::vector<uint8_t> foundAddresses;
+    if (m_trace) {
+        for (const auto &d : result.devices) foundAddresses.push_back(d.address);
+        trace.read(foundAddresses);
+    }
+    log(LogLevel::Debug, [&] {
+        return "Mock I2C fast scan finished, found " + std::to_string(result.devices.size()) +
+               " device(s)";
+    });
+    return result;
+}
+
+void FTDevice::runI2CBatch(const I2CBatch &batch, I2CBatchResult &result) {
+    ft4222stats::OpScope stat(ft4222stats::Op::I2CBatch);
+    if (!isOpen())
+        throw std::runtime_error("Device not open");
+    if (pimpl->mode() != Mode::I2C_Master)
+        throw std::runtime_error("Device not in I2C Master mode");
+
+    result.prepare(batch);
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    const uint64_t traceStart = m_trace ? m_trace->nowNs() : 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const I2CBatch::Op &op = batch.ops()[i];
+        I2CBatchResult::OpStatus &st = result.ops[i];
+
+        st.ok = retryI2C(st.status, [&] {
+            st.written = 0;
+            st.read = 0;
+            st.status = pimpl->i2cGlitch();
+            if (st.status != FT4222_OK)
+                return false;
+
+            if (op.writeLength != 0) {
+                I2CTarget *target = pimpl->addressI2C(op.address);
+                pimpl->transaction(pimpl->i2cFrameNs(target ? op.writeLength : 0));
+                if (!target)
+                    return false;
+                target->write(ConstByteSpan(batch.writeData().data() + op.writeOffset,
+                                            op.writeLength));
+                st.written = op.writeLength;
+            }
+
+            if (op.readLength != 0) {
+                I2CTarget *target = pimpl->addressI2C(op.address);
+                pimpl->transaction(pimpl->i2cFrameNs(target ? op.readLength : 0));
+                if (!target)
+                    return false;
+                target->read(ByteSpan(result.data.data() + st.readOffset, op.readLength));
+                st.read = op.readLength;
+            }
+            return true;
+        });
+        if (!st.ok)
+            ++result.failed;
+    }
+    traceI2CBatch(batch, result, traceStart);
+    log(LogLevel::Debug, [&] {
+        return "Mock I2C batch: " + std::to_string(batch.size()) + " op(s), " +
+               std::to_string(result.failed) + " failed";
+    });
+}
+
+bool FTDevice::initSPIMaster(FT4222_SPIMode mode, SPIClockDivider clockDiv, FT4222_SPICPOL cpol,
+                             FT4222_SPICPHA cpha, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiInit);
+    if (!isOpen())
+        throw std::runtime_error("Device not open");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiInit, 0,
+                             ft4222trace::spiInitParam(mode, static_cast<FT4222_SPIClock>(clockDiv),
+                                                       cpol, cpha));
+    const bool sameClock = !force && pimpl->mode() == Mode::SPI_Master &&
+                           pimpl->spiDivider == clockDiv && pimpl->spiPolarity == cpol &&
+                           pimpl->spiPhase == cpha && pimpl->modeClock == pimpl->clockRate;
+    if (sameClock && pimpl->spiMode == mode)
+        return false;
+    // Смена только числа линий — один вызов SetLines, как и полная инициализация
+    pimpl->transaction();
+    pimpl->state.setMode(Mode::SPI_Master);
+    pimpl->spiDivider = clockDiv;
+    pimpl->spiMode = mode;
+    pimpl->spiPolarity = cpol;
+    pimpl->spiPhase = cpha;
+    pimpl->modeClock = pimpl->clockRate;
+    log(LogLevel::Info, sameClock ? "Mock SPI lines changed" : "Mock SPI initialized");
+    return true;
 }
 
-void FTDevice::initSPIMaster(FT4222_SPIMode, SPIClockDivider, FT4222_SPICPOL, FT4222_SPICPHA) {
+size_t FTDevice::spiMasterSingleRead(ByteSpan buffer, bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiRead, buffer.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    pimpl->currentMode = Mode::SPI_Master;
-    log("Mock SPI initialized");
+    if (pimpl->mode() != Mode::SPI_Master)
+        throw std::runtime_error("Device not in SPI Master mode");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiRead, 0, endTransaction);
+    trace.value(static_cast<uint32_t>(buffer.size()));
+    const size_t bytesRead = transferSpiChunked(
+        buffer.size(), endTransaction,
+        [&](size_t offset, size_t length, bool end) {
+            return pimpl->spiChunk(nullptr, buffer.data() + offset, length, end);
+        },
+        [&] { pimpl->spiEndTransaction(); });
+    trace.read(buffer.subspan(0, bytesRead));
+    return bytesRead;
 }
 
-std::vector<uint8_t> FTDevice::spiMasterSingleRead(size_t bytesToRead, bool) {
+size_t FTDevice::spiMasterSingleWrite(ConstByteSpan data, bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiWrite, data.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master)
+    if (pimpl->mode() != Mode::SPI_Master)
         throw std::runtime_error("Device not in SPI Master mode");
-    return std::vector<uint8_t>(bytesToRead, 0);
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiWrite, 0, endTransaction);
+    trace.write(data);
+    const size_t bytesWritten = transferSpiChunked(
+        data.size(), endTransaction,
+        [&](size_t offset, size_t length, bool end) {
+            return pimpl->spiChunk(data.data() + offset, nullptr, length, end);
+        },
+        [&] { pimpl->spiEndTransaction(); });
+    if (bytesWritten != data.size())
+        throw std::runtime_error("SPI Write incomplete: " + std::to_string(bytesWritten) + "/" +
+                                 std::to_string(data.size()) + " bytes");
+    log(LogLevel::Debug, [&] { return "Mock SPI write " + std::to_string(data.size()) + " bytes"; });
+    return bytesWritten;
 }
 
-void FTDevice::spiMasterSingleWrite(const std::vector<uint8_t> &data, bool) {
+size_t FTDevice::spiMasterSingleReadWrite(ByteSpan readBuffer, ConstByteSpan writeData,
+                                         bool endTransaction) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiXfer, readBuffer.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master)
+    if (pimpl->mode() != Mode::SPI_Master)
         throw std::runtime_error("Device not in SPI Master mode");
-    log("Mock SPI write " + std::to_string(data.size()) + " bytes");
+    if (readBuffer.size() < writeData.size())
+        throw std::invalid_argument("SPI read buffer is smaller than write data");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiXfer, 0, endTransaction);
+    trace.write(writeData);
+    const size_t bytesTransferred = transferSpiChunked(
+        writeData.size(), endTransaction,
+        [&](size_t offset, size_t length, bool end) {
+            return pimpl->spiChunk(writeData.data() + offset, readBuffer.data() + offset,
+                                   length, end);
+        },
+        [&] { pimpl->spiEndTransaction(); });
+    trace.read(readBuffer.subspan(0, bytesTransferred));
+    return bytesTransferred;
 }
 
-std::vector<uint8_t> FTDevice::spiMasterSingleReadWrite(const std::vector<uint8_t> &writeData,
-                                                        bool) {
+size_t FTDevice::spiMasterMultiReadWrite(ByteSpan readBuffer, ConstByteSpan singleWrite,
+                                         ConstByteSpan multiWrite, unsigned dummyCycles) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SpiMultiXfer, singleWrite.size() + multiWrite.size() + readBuffer.size());
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    if (pimpl->currentMode != Mode::SPI_Master)
+    if (pimpl->mode() != Mode::SPI_Master)
         throw std::runtime_error("Device not in SPI Master mode");
-    return std::vector<uint8_t>(writeData.size(), 0);
+
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    // spiMode меняет initSPIMaster под тем же мьютексом
+    const size_t dummyBytes = spiMultiDummyBytes(pimpl->spiMode, singleWrite.size(),
+                                                 multiWrite.size(), readBuffer.size(),
+                                                 dummyCycles);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SpiMultiXfer,
+                                static_cast<uint16_t>(singleWrite.size()), dummyCycles);
+    trace.write(singleWrite, multiWrite);
+    trace.value(static_cast<uint32_t>(readBuffer.size()));
+    // Multi-фаза идёт по 2/4 линиям: время на шине делится на число линий
+    const unsigned lines = pimpl->spiMode == SPI_IO_DUAL ? 2 : 4;
+    const uint64_t busNs =
+        pimpl->spiBytesNs(singleWrite.size()) +
+        pimpl->spiBytesNs(dummyBytes + multiWrite.size() + readBuffer.size()) / lines;
+    pimpl->transaction(busNs);
+    // Фаза записи multi-I/O не меняет flash; без распознанной команды линии данных
+    // подтянуты (0xFF), без flash на шине — нули
+    if (!pimpl->spiFlash.present())
+        std::fill(readBuffer.begin(), readBuffer.end(), 0);
+    else if (!pimpl->spiFlash.multiOutputRead(singleWrite.data(), singleWrite.size(),
+                                              static_cast<unsigned>((dummyBytes + multiWrite.size()) * 8 / lines),
+                                              lines,
+                                              readBuffer.data(), readBuffer.size()))
+        std::fill(readBuffer.begin(), readBuffer.end(), 0xFF);
+    trace.read(readBuffer);
+    log(LogLevel::Debug, [&] {
+        return "Mock SPI multi transfer: read " + std::to_string(readBuffer.size()) + " bytes";
+    });
+    return readBuffer.size();
 }
 
-void FTDevice::initGPIO(GPIO_Dir, GPIO_Dir, GPIO_Dir, GPIO_Dir) {
+bool FTDevice::initGPIO(GPIO_Dir gpio0, GPIO_Dir gpio1, GPIO_Dir gpio2, GPIO_Dir gpio3, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioInit);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    pimpl->currentMode = Mode::GPIO;
-    log("Mock GPIO initialized");
+    const uint8_t dirMask = (gpio0 == GPIO_OUTPUT ? 1u : 0u) | (gpio1 == GPIO_OUTPUT ? 2u : 0u) |
+                            (gpio2 == GPIO_OUTPUT ? 4u : 0u) | (gpio3 == GPIO_OUTPUT ? 8u : 0u);
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioInit, 0, dirMask);
+    if (!force && pimpl->mode() == Mode::GPIO && pimpl->gpioDirs == dirMask)
+        return false;
+    pimpl->transaction();
+    pimpl->state.setMode(Mode::GPIO);
+    pimpl->gpioDirs = dirMask;
+    pimpl->modeClock = pimpl->clockRate;
+    log(LogLevel::Info, "Mock GPIO initialized");
+    return true;
 }
 
 bool FTDevice::readGPIO(GPIO_Port port) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioRead);
     if (!isOpen())
         throw std::runtime_error("Device not open");
     const auto p = static_cast<int>(port);
     if (p < 0 || p > 3)
         throw std::runtime_error("Invalid GPIO port");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioRead, static_cast<uint16_t>(p));
+    pimpl->transaction();
+    trace.value(pimpl->gpioOut[p]);
     return pimpl->gpioOut[p];
 }
 
 void FTDevice::writeGPIO(GPIO_Port port, bool value) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioWrite);
     if (!isOpen())
         throw std::runtime_error("Device not open");
     const auto p = static_cast<int>(port);
     if (p < 0 || p > 3)
         throw std::runtime_error("Invalid GPIO port");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioWrite, static_cast<uint16_t>(p), value);
+    pimpl->transaction();
     pimpl->gpioOut[p] = value;
 }
 
-void FTDevice::setClockRate(FT4222_ClockRate clkRate) {
+uint8_t FTDevice::readGPIOPorts() {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioRead);
+    if (!isOpen())
+        throw std::runtime_error("Device not open");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioRead, ft4222trace::kAllGpioPorts);
+    uint8_t levels = 0;
+    for (int p = 0; p < 4; ++p) {
+        pimpl->transaction();
+        if (pimpl->gpioOut[p])
+            levels |= static_cast<uint8_t>(1u << p);
+    }
+    trace.value(levels);
+    return levels;
+}
+
+void FTDevice::writeGPIOPorts(uint8_t mask, uint8_t values) {
+    ft4222stats::OpScope stat(ft4222stats::Op::GpioWrite);
     if (!isOpen())
         throw std::runtime_error("Device not open");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::GpioWrite, ft4222trace::kAllGpioPorts,
+                                mask | static_cast<uint32_t>(values) << 8);
+    for (int p = 0; p < 4; ++p) {
+        if (!(mask & (1u << p)))
+            continue;
+        pimpl->transaction();
+        pimpl->gpioOut[p] = (values & (1u << p)) != 0;
+    }
+}
+
+bool FTDevice::setClockRate(FT4222_ClockRate clkRate, bool force) {
+    ft4222stats::OpScope stat(ft4222stats::Op::SetClock);
+    if (!isOpen())
+        throw std::runtime_error("Device not open");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::SetClock, 0, ft4222trace::clockParam(clkRate));
+    if (!force && pimpl->clockKnown && pimpl->clockRate == clkRate)
+        return false;
+    pimpl->transaction();
     pimpl->clockRate = clkRate;
+    pimpl->clockKnown = true;
+    pimpl->state.touch();
+    return true;
 }
 
 FT4222_ClockRate FTDevice::getClockRate() const {
@@ -249,10 +1261,17 @@ FT4222_ClockRate FTDevice::getClockRate() const {
 }
 
 void FTDevice::resetChip() {
+    ft4222stats::OpScope stat(ft4222stats::Op::ResetChip);
     if (!isOpen())
         throw std::runtime_error("Device not open");
-    pimpl->currentMode = Mode::Unknown;
-    log("Mock chip reset");
+    std::lock_guard<std::mutex> lock(pimpl->deviceMutex);
+    ft4222trace::Scope trace(m_trace.get(), ft4222stats::Op::ResetChip);
+    pimpl->i2cStuck = ft4222mock::I2CStuck::None;
+    pimpl->i2cStatus = kI2CIdle;
+    pimpl->state.setMode(Mode::Unknown);
+    pimpl->clockRate = SYS_CLK_60;
+    pimpl->clockKnown = false;
+    log(LogLevel::Info, "Mock chip reset");
 }
 
 std::string FTDevice::getVersionString() const {
@@ -261,15 +1280,10 @@ std::string FTDevice::getVersionString() const {
     return "Chip: mock, Lib: mock";
 }
 
-FTDevice::Mode FTDevice::getDeviceMode() const {
-    return pimpl ? pimpl->currentMode : Mode::Unknown;
+FTDevice::Mode FTDevice::getDeviceMode() const noexcept {
+    return pimpl ? pimpl->mode() : Mode::Unknown;
 }
 
 uint8_t FTDevice::getChipMode() const {
-    return isOpen() ? 0 : 0;
-}
-
-void FTDevice::log(const std::string &s) const {
-    if (m_logger)
-        m_logger(s);
+    return isOpen() ? pimpl->chipMode : 0;
 }
@@ -0,0 +1,109 @@
+#pragma once
+
+// Модель mock-бэкенда (только для сборки с TWI_MOCK_FT4222): задержки USB и шины,
+// имитируемые I2C-устройства с регистровыми файлами.
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ft4222mock {
+
+/**
+ * @brief Параметры имитации
+ *
+ * @note  По умолчанию (без переменных окружения) задержки нулевые и на шине нет
+ *        устройств — поведение совпадает с прежним «мгновенным» mock.
+ *
+ * Переменные окружения, читаемые при первом обращении к конфигурации:
+ * - TWI_MOCK_USB_LATENCY_US — задержка одной транзакции USB, мкс;
+ * - TWI_MOCK_BUS_TIMING=1 — добавлять время передачи по шине (I2C/SPI);
+ * - TWI_MOCK_I2C — список отвечающих адресов "0x50,0x68:16" (адрес[:размер регистров]);
+ * - TWI_MOCK_I2C_PAGE — размер страницы записи EEPROM, байт;
+ * - TWI_MOCK_I2C_WRITE_CYCLE_US — длительность цикла записи EEPROM, мкс;
+ * - TWI_MOCK_CHIP_MODE — режим чипа 0–3 (число USB-интерфейсов каждого адаптера);
+ * - TWI_MOCK_SPI_FLASH — объём SPI NOR flash на шине SPI, байт (0x100000 и т.п.);
+ * - TWI_MOCK_SPI_FLASH_PROGRAM_US / TWI_MOCK_SPI_FLASH_ERASE_US — время программирования
+ *   страницы и стирания сектора/блока, мкс;
+ * - TWI_MOCK_I2C_STUCK=bus|chip — шина I2C зависла (см. I2CStuck);
+ * - TWI_MOCK_I2C_GLITCHES — число первых I2C-транзакций, завершающихся сбоем USB;
+ * - TWI_MOCK_SPI_CHUNK_LIMIT — не больше стольких байт за один чанк SPI (короткий ответ).
+ */
+
+/// Имитация зависшей шины I2C
+enum class I2CStuck : uint8_t {
+    None,
+    Bus, ///< Ведомый держит SDA: транзакции не проходят до сброса шины
+    Chip ///< Завис контроллер адаптера: сброс шины не помогает, только сброс чипа
+};
+
+struct Config {
+    uint32_t usbLatencyUs = 0; ///< Задержка одной транзакции USB (round-trip), мкс
+    bool busTiming = false;    ///< Учитывать время передачи битов по шине
+
+    /// Адреса I2C, подтверждающие обращение (ACK), и начальное содержимое их регистров.
+    /// До 256 байт указатель регистра однобайтовый, больше — двухбайтовый (big-endian).
+    std::map<uint8_t, std::vector<uint8_t>> i2cTargets;
+
+    /// Страница записи EEPROM: данные заворачиваются внутри страницы, как у 24Cxx (0 — без страниц)
+    uint16_t i2cPageSize = 0;
+
+    /// Цикл записи EEPROM: после записи данных устройство не подтверждает адрес, мкс
+    uint32_t i2cWriteCycleUs = 0;
+
+    /// Режим чипа (CFG0/CFG1): в режимах 0–2 каждый адаптер перечисляется несколькими
+    /// интерфейсами ("MOCK0001A", "MOCK0001B", ...), в режиме 3 — одним, без буквы
+    uint8_t chipMode = 3;
+
+    /// SPI NOR flash (команды 25-й серии: 0x9F, 0x05, 0x06, 0x04, 0x03, 0x02, 0x20, 0xD8,
+    /// 0xC7/0x60; в режимах dual/quad — 0x3B/0x6B с 8 dummy-тактами; 3-байтовый адрес,
+    /// страница 256 байт). 0 — устройства нет, чтение даёт нули.
+    uint32_t spiFlashSize = 0;
+
+    /// Время программирования страницы: всё это время бит WIP регистра статуса взведён, мкс
+    uint32_t spiFlashProgramUs = 0;
+
+    /// Время стирания сектора 4 КБ или блока 64 КБ (и всего кристалла), мкс
+    uint32_t spiFlashEraseUs = 0;
+
+    /// Зависание шины с момента open: I2C-транзакции не передают ни байта, контроллер
+    /// сообщает ERROR | BUS_BUSY
+    I2CStuck i2cStuck = I2CStuck::None;
+
+    /// Первые N I2C-транзакций после open завершаются сбоем USB (FT4222_FAILED_TO_READ_DEVICE)
+    uint32_t i2cGlitches = 0;
+
+    /// Чанк SPI передаёт не больше стольких байт и возвращает короткий счётчик, как
+    /// LibFT4222 при обрыве обмена (0 — без ограничения)
+    uint32_t spiChunkLimit = 0;
+};
+
+/**
+ * @brief Задать конфигурацию имитации
+ * @param config Новая конфигурация
+ *
+ * @note  Применяется к устройствам, открытым после вызова; у каждого устройства
+ *        собственная копия регистровых файлов.
+ */
+void setConfig(const Config &config);
+
+/**
+ * @brief Получить текущую конфигурацию имитации
+ * @return Копия конфигурации (при первом вызове — прочитанная из окружения)
+ */
+Config config();
+
+/**
+ * @brief Построить конфигурацию из переменных окружения
+ * @return Конфигурация; отсутствующие или некорректные переменные дают значения по умолчанию
+ */
+Config configFromEnvironment();
+
+/**
+ * @brief Регистровый файл «по умолчанию»: байт i содержит (i & 0xFF)
+ * @param size Размер файла в байтах
+ * @return Заполненный регистровый файл
+ */
+std::vector<uint8_t> patternRegisters(size_t size = 256);
+
+} // namespace ft4222mock
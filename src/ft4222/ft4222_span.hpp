@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Невладеющее представление непрерывного буфера (аналог std::span для C++17)
+ *
+ * @note  Используется в перегрузках FTDevice, работающих с буфером вызывающей стороны
+ *        без выделения памяти. Неявно строится из std::vector и C-массива;
+ *        BasicSpan<T> неявно приводится к BasicSpan<const T>.
+ */
+template <typename T>
+class BasicSpan {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+
+    constexpr BasicSpan() noexcept = default;
+
+    constexpr BasicSpan(T *data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+    template <size_t N>
+    constexpr BasicSpan(T (&array)[N]) noexcept : m_data(array), m_size(N) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    BasicSpan(std::vector<U> &v) noexcept : m_data(v.data()), m_size(v.size()) {}
+
+    template <typename U,
+              typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+    BasicSpan(const std::vector<U> &v) noexcept : m_data(v.data()), m_size(v.size()) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr BasicSpan(const BasicSpan<U> &other) noexcept
+        : m_data(other.data()), m_size(other.size()) {}
+
+    constexpr T *data() const noexcept { return m_data; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+    constexpr T *begin() const noexcept { return m_data; }
+    constexpr T *end() const noexcept { return m_data + m_size; }
+    constexpr T &operator[](size_t i) const noexcept { return m_data[i]; }
+
+    /**
+     * @brief Получить часть буфера
+     * @param offset Смещение от начала (не больше size())
+     * @param count Длина (обрезается до конца буфера)
+     */
+    constexpr BasicSpan subspan(size_t offset, size_t count = static_cast<size_t>(-1)) const noexcept {
+        const size_t rest = m_size - offset;
+        return BasicSpan(m_data + offset, count < rest ? count : rest);
+    }
+
+private:
+    T *m_data = nullptr;
+    size_t m_size = 0;
+};
+
+using ByteSpan = BasicSpan<uint8_t>;            ///< Изменяемый буфер байт
+using ConstByteSpan = BasicSpan<const uint8_t>; ///< Буфер байт только для чтения
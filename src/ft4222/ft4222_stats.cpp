@@ -0,0 +1,211 @@
+#include "ft4222/ft4222_stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace ft4222stats {
+
+namespace {
+
+// Коды ошибок: FT_STATUS 0..31 и FT4222_STATUS 1000..1031, последний слот — прочие/без кода
+constexpr size_t kStatusSlots = 65;
+constexpr size_t kOtherSlot = kStatusSlots - 1;
+
+size_t statusSlot(int status) noexcept {
+    if (status >= 0 && status < 32) return static_cast<size_t>(status);
+    if (status >= 1000 && status < 1032) return static_cast<size_t>(32 + status - 1000);
+    return kOtherSlot;
+}
+
+int slotStatus(size_t slot) noexcept {
+    if (slot < 32) return static_cast<int>(slot);
+    if (slot < kOtherSlot) return static_cast<int>(1000 + slot - 32);
+    return -1;
+}
+
+struct OpCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::array<std::atomic<uint64_t>, kStatusSlots> byStatus{};
+    LatencyHistogram latency;
+};
+
+OpCounters g_ops[static_cast<size_t>(Op::Count)];
+std::array<std::atomic<uint64_t>, 5> g_recovery{};
+
+thread_local OpScope *t_current = nullptr;
+
+uint64_t nowNs() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+unsigned highestBit(uint64_t v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+    unsigned n = 0;
+    while (v >>= 1) ++n;
+    return n;
+#endif
+}
+
+} // namespace
+
+const char *opName(Op op) noexcept {
+    static const char *const names[] = {
+        "open",       "close",         "i2c_init",   "i2c_write",  "i2c_read",
+        "i2c_read_reg", "i2c_status",  "i2c_reset",  "i2c_scan",   "i2c_scan_fast",
+        "i2c_batch",  "spi_init",      "spi_read",   "spi_write",  "spi_xfer",
+        "spi_mxfer",  "gpio_init",     "gpio_read",  "gpio_write", "usb_read",
+        "usb_write",  "reset_chip",    "set_clock",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Op::Count),
+                  "opName table out of sync with Op");
+    const auto i = static_cast<size_t>(op);
+    return i < static_cast<size_t>(Op::Count) ? names[i] : "?";
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t ns) noexcept {
+    if (ns < kSub) return static_cast<size_t>(ns);
+    const unsigned msb = highestBit(ns);
+    if (msb > kMaxExponent) return kBuckets - 1;
+    const unsigned shift = msb - kSubBits;
+    return (msb - kSubBits + 1) * kSub + static_cast<size_t>((ns >> shift) & (kSub - 1));
+}
+
+uint64_t LatencyHistogram::bucketLower(size_t bucket) noexcept {
+    if (bucket < kSub) return bucket;
+    const unsigned msb = static_cast<unsigned>(bucket / kSub) + kSubBits - 1;
+    return static_cast<uint64_t>(kSub + bucket % kSub) << (msb - kSubBits);
+}
+
+std::vector<uint64_t> LatencyHistogram::counts() const {
+    std::vector<uint64_t> out(kBuckets);
+    for (size_t i = 0; i < kBuckets; ++i) out[i] = buckets_[i].load(std::memory_order_relaxed);
+    return out;
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto &b : buckets_) b.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::quantile(const std::vector<uint64_t> &counts, double q) noexcept {
+    uint64_t total = 0;
+    for (const uint64_t c : counts) total += c;
+    if (total == 0) return 0;
+
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+        seen += counts[b];
+        if (seen < rank) continue;
+        const uint64_t lower = bucketLower(b);
+        const uint64_t upper = b + 1 < kBuckets ? bucketLower(b + 1) : lower + lower / kSub;
+        return lower + (upper - lower) / 2;
+    }
+    return bucketLower(counts.size() - 1);
+}
+
+std::vector<OpSnapshot> snapshot() {
+    std::vector<OpSnapshot> out;
+    for (size_t i = 0; i < static_cast<size_t>(Op::Count); ++i) {
+        const OpCounters &c = g_ops[i];
+        const uint64_t calls = c.calls.load(std::memory_order_relaxed);
+        if (calls == 0) continue;
+
+        OpSnapshot s;
+        s.op = static_cast<Op>(i);
+        s.calls = calls;
+        s.errors = c.errors.load(std::memory_order_relaxed);
+        s.bytes = c.bytes.load(std::memory_order_relaxed);
+        s.totalNs = c.totalNs.load(std::memory_order_relaxed);
+        s.maxNs = c.maxNs.load(std::memory_order_relaxed);
+        const auto counts = c.latency.counts();
+        // Середина корзины может оказаться больше реального максимума
+        s.p50Ns = std::min(LatencyHistogram::quantile(counts, 0.50), s.maxNs);
+        s.p90Ns = std::min(LatencyHistogram::quantile(counts, 0.90), s.maxNs);
+        s.p99Ns = std::min(LatencyHistogram::quantile(counts, 0.99), s.maxNs);
+        for (size_t slot = 0; slot < kStatusSlots; ++slot) {
+            const uint64_t n = c.byStatus[slot].load(std::memory_order_relaxed);
+            if (n) s.errorsByStatus.emplace_back(slotStatus(slot), n);
+        }
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+void reset() noexcept {
+    for (auto &c : g_ops) {
+        c.calls.store(0, std::memory_order_relaxed);
+        c.errors.store(0, std::memory_order_relaxed);
+        c.bytes.store(0, std::memory_order_relaxed);
+        c.totalNs.store(0, std::memory_order_relaxed);
+        c.maxNs.store(0, std::memory_order_relaxed);
+        for (auto &s : c.byStatus) s.store(0, std::memory_order_relaxed);
+        c.latency.reset();
+    }
+    for (auto &r : g_recovery) r.store(0, std::memory_order_relaxed);
+}
+
+void noteRecovery(RecoveryEvent event) noexcept {
+    g_recovery[static_cast<size_t>(event)].fetch_add(1, std::memory_order_relaxed);
+}
+
+RecoverySnapshot recovery() noexcept {
+    const auto get = [](RecoveryEvent e) {
+        return g_recovery[static_cast<size_t>(e)].load(std::memory_order_relaxed);
+    };
+    RecoverySnapshot s;
+    s.retries = get(RecoveryEvent::Retry);
+    s.busResets = get(RecoveryEvent::BusReset);
+    s.chipResets = get(RecoveryEvent::ChipReset);
+    s.recovered = get(RecoveryEvent::Recovered);
+    s.exhausted = get(RecoveryEvent::Exhausted);
+    return s;
+}
+
+OpScope::OpScope(Op op, uint64_t bytes) noexcept
+    : op_(op), bytes_(bytes), exceptions_(std::uncaught_exceptions()), startNs_(nowNs()),
+      outer_(t_current) {
+    t_current = this;
+}
+
+OpScope::~OpScope() {
+    const uint64_t elapsed = nowNs() - startNs_;
+    t_current = outer_;
+
+    OpCounters &c = g_ops[static_cast<size_t>(op_)];
+    c.calls.fetch_add(1, std::memory_order_relaxed);
+    c.totalNs.fetch_add(elapsed, std::memory_order_relaxed);
+    uint64_t prevMax = c.maxNs.load(std::memory_order_relaxed);
+    while (elapsed > prevMax &&
+           !c.maxNs.compare_exchange_weak(prevMax, elapsed, std::memory_order_relaxed)) {
+    }
+    c.latency.record(elapsed);
+
+    if (failed_ || std::uncaught_exceptions() > exceptions_) {
+        c.errors.fetch_add(1, std::memory_order_relaxed);
+        c.byStatus[statusSlot(status_)].fetch_add(1, std::memory_order_relaxed);
+    } else {
+        c.bytes.fetch_add(bytes_, std::memory_order_relaxed);
+    }
+}
+
+void OpScope::noteStatus(int status) noexcept {
+    if (t_current) t_current->status_ = status;
+}
+
+int OpScope::currentStatus() noexcept {
+    return t_current ? t_current->status_ : -1;
+}
+
+} // namespace ft4222stats
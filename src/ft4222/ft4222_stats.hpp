@@ -0,0 +1,195 @@
+#pragma once
+
+// Встроенная статистика операций FTDevice (оба бэкенда): число вызовов, байты,
+// ошибки по кодам FT_STATUS / FT4222_STATUS и лог-линейная гистограмма латентности.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ft4222stats {
+
+/// Тип операции FTDevice
+enum class Op : uint8_t {
+    Open,
+    Close,
+    I2CInit,
+    I2CWrite,
+    I2CRead,
+    I2CReadRegister,
+    I2CStatus,
+    I2CResetBus,
+    I2CScan,
+    I2CScanFast,
+    I2CBatch,
+    SpiInit,
+    SpiRead,
+    SpiWrite,
+    SpiXfer,
+    SpiMultiXfer,
+    GpioInit,
+    GpioRead,
+    GpioWrite,
+    UsbRead,
+    UsbWrite,
+    ResetChip,
+    SetClock,
+    Count
+};
+
+/// Короткое имя операции ("i2c_read", "spi_xfer", ...)
+const char *opName(Op op) noexcept;
+
+/**
+ * @brief Гистограмма латентности без блокировок
+ *
+ * Лог-линейная шкала: до 16 нс — по наносекунде на корзину, дальше каждая октава
+ * делится на 16 корзин (погрешность квантиля не больше 1/16 ≈ 6%). Диапазон — до
+ * ~18 минут, большие значения попадают в последнюю корзину. Запись — один
+ * fetch_add с relaxed-порядком.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBits = 4;
+    static constexpr unsigned kSub = 1u << kSubBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr size_t kBuckets = (kMaxExponent - kSubBits + 2) * kSub;
+
+    /// Номер корзины для значения, нс
+    static size_t bucketFor(uint64_t ns) noexcept;
+
+    /// Нижняя граница корзины, нс
+    static uint64_t bucketLower(size_t bucket) noexcept;
+
+    /// Учесть одно значение, нс
+    void record(uint64_t ns) noexcept {
+        buckets_[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Копия счётчиков корзин
+    std::vector<uint64_t> counts() const;
+
+    /// Обнулить счётчики
+    void reset() noexcept;
+
+    /**
+     * @brief Квантиль по снимку счётчиков
+     * @param counts Снимок counts()
+     * @param q Квантиль 0..1
+     * @return Середина корзины, содержащей квантиль, нс (0 для пустой гистограммы)
+     */
+    static uint64_t quantile(const std::vector<uint64_t> &counts, double q) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+};
+
+/// Снимок статистики одной операции
+struct OpSnapshot {
+    Op op = Op::Count;
+    uint64_t calls = 0;   ///< Завершённых вызовов (успешных и с ошибкой)
+    uint64_t errors = 0;  ///< Вызовов, завершившихся исключением или неуспешным итогом try*
+    uint64_t bytes = 0;   ///< Байт в успешных вызовах
+    uint64_t totalNs = 0; ///< Суммарное время, нс
+    uint64_t maxNs = 0;   ///< Максимальное время, нс
+    uint64_t p50Ns = 0;
+    uint64_t p90Ns = 0;
+    uint64_t p99Ns = 0;
+
+    /// Ошибки по коду FT_STATUS / FT4222_STATUS; код -1 — ошибка без кода
+    /// (NACK, неполная передача и т.п.) или с нестандартным кодом
+    std::vector<std::pair<int, uint64_t>> errorsByStatus;
+};
+
+/**
+ * @brief Снимок статистики
+ * @return Операции, вызывавшиеся хотя бы раз, в порядке Op
+ */
+std::vector<OpSnapshot> snapshot();
+
+/// Обнулить всю статистику
+void reset() noexcept;
+
+/// Событие восстановления I2C (FTDevice::setI2CRecoveryPolicy)
+enum class RecoveryEvent : uint8_t {
+    Retry,     ///< Транзакция повторена
+    BusReset,  ///< Шина сброшена
+    ChipReset, ///< Чип сброшен
+    Recovered, ///< Транзакция прошла после повтора
+    Exhausted  ///< Транзакция не прошла за все разрешённые повторы
+};
+
+/// Счётчики событий восстановления I2C
+struct RecoverySnapshot {
+    uint64_t retries = 0;
+    uint64_t busResets = 0;
+    uint64_t chipResets = 0;
+    uint64_t recovered = 0;
+    uint64_t exhausted = 0;
+
+    bool empty() const noexcept { return retries == 0 && busResets == 0 && chipResets == 0; }
+};
+
+/// Учесть событие восстановления
+void noteRecovery(RecoveryEvent event) noexcept;
+
+/// Снимок счётчиков восстановления (обнуляются вместе со статистикой операций в reset())
+RecoverySnapshot recovery() noexcept;
+
+/**
+ * @brief Замер одной операции (RAII)
+ *
+ * Создаётся первой строкой метода FTDevice. В деструкторе время вызова попадает в
+ * гистограмму; если метод выходит исключением или отметил ошибку fail() (варианты без
+ * исключений), вызов считается ошибкой, а код статуса, отмеченный noteStatus() или
+ * fail() внутри этого замера, — в разбивку по кодам.
+ *
+ * @note  Статистика общая для процесса (все экземпляры FTDevice), счётчики — атомарные.
+ */
+class OpScope {
+public:
+    /**
+     * @param op Тип операции
+     * @param bytes Объём данных, учитываемый при успешном завершении
+     */
+    explicit OpScope(Op op, uint64_t bytes = 0) noexcept;
+    ~OpScope();
+
+    OpScope(const OpScope &) = delete;
+    OpScope &operator=(const OpScope &) = delete;
+
+    /// Уточнить объём данных (например, фактически прочитанный)
+    void setBytes(uint64_t bytes) noexcept { bytes_ = bytes; }
+
+    /**
+     * @brief Учесть вызов как ошибку без исключения
+     * @param status Код FT_STATUS / FT4222_STATUS (-1 — без кода)
+     */
+    void fail(int status = -1) noexcept {
+        failed_ = true;
+        status_ = status;
+    }
+
+    /**
+     * @brief Отметить код ошибки драйвера для текущего замера этого потока
+     * @param status Код FT_STATUS или FT4222_STATUS
+     */
+    static void noteStatus(int status) noexcept;
+
+    /// Код, отмеченный в текущем замере этого потока (-1, если не отмечен или замера нет)
+    static int currentStatus() noexcept;
+
+private:
+    Op op_;
+    uint64_t bytes_;
+    int status_ = -1;
+    bool failed_ = false;
+    int exceptions_;
+    uint64_t startNs_;
+    OpScope *outer_;
+};
+
+} // namespace ft4222stats
@@ -0,0 +1,235 @@
+#include "ft4222/ft4222_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace ft4222trace {
+
+namespace {
+
+uint64_t steadyNs() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+template <typename T>
+void storeLE(uint8_t *out, T value) noexcept {
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+}
+
+template <typename T>
+T loadLE(const uint8_t *in) noexcept {
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return static_cast<T>(v);
+}
+
+size_t roundUpPow2(size_t v) {
+    size_t p = 1024;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+// Период сброса кольца в файл, если производитель не разбудил поток раньше
+constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+
+} // namespace
+
+Recorder::Recorder(const std::string &path, size_t ringBytes)
+    : m_path(path), m_file(path, std::ios::binary | std::ios::trunc),
+      m_ring(new uint8_t[roundUpPow2(ringBytes)]), m_mask(roundUpPow2(ringBytes) - 1),
+      m_startNs(steadyNs()) {
+    if (!m_file) throw std::runtime_error("Cannot open trace file " + path);
+
+    uint8_t header[kFileHeaderSize];
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    storeLE<uint32_t>(header + 8, kVersion);
+    storeLE<uint32_t>(header + 12, static_cast<uint32_t>(kFileHeaderSize));
+    storeLE<uint64_t>(header + 16, static_cast<uint64_t>(
+                                       std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           std::chrono::system_clock::now().time_since_epoch())
+                                           .count()));
+    m_file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    m_flusher = std::thread([this] { flushLoop(); });
+}
+
+Recorder::~Recorder() {
+    try {
+        stop();
+    } catch (...) {
+    }
+}
+
+uint64_t Recorder::nowNs() const noexcept {
+    return steadyNs() - m_startNs;
+}
+
+void Recorder::put(uint64_t pos, const void *data, size_t size) noexcept {
+    if (size == 0) return;
+    const auto *src = static_cast<const uint8_t *>(data);
+    const size_t offset = static_cast<size_t>(pos) & m_mask;
+    const size_t first = std::min(size, m_mask + 1 - offset);
+    std::memcpy(m_ring.get() + offset, src, first);
+    if (first < size) std::memcpy(m_ring.get(), src + first, size - first);
+}
+
+void Recorder::record(const RecordHeader &h, ConstByteSpan write, ConstByteSpan writeTail,
+                      ConstByteSpan read) noexcept {
+    if (m_stopped.load(std::memory_order_relaxed)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const size_t writeLength = write.size() + writeTail.size();
+    const size_t total = kRecordHeaderSize + writeLength + read.size();
+    const size_t capacity = m_mask + 1;
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t used = head - m_tail.load(std::memory_order_acquire);
+    if (total > capacity - used) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_cv.notify_one();
+        return;
+    }
+
+    uint8_t hdr[kRecordHeaderSize];
+    storeLE<uint32_t>(hdr + 0, static_cast<uint32_t>(total - 4));
+    storeLE<uint64_t>(hdr + 4, h.timeNs);
+    storeLE<uint32_t>(hdr + 12, h.durationNs);
+    hdr[16] = static_cast<uint8_t>(h.op);
+    hdr[17] = h.flags;
+    storeLE<uint16_t>(hdr + 18, h.address);
+    storeLE<uint32_t>(hdr + 20, h.param);
+    storeLE<uint32_t>(hdr + 24, static_cast<uint32_t>(h.status));
+    storeLE<uint32_t>(hdr + 28, h.value);
+    storeLE<uint32_t>(hdr + 32, static_cast<uint32_t>(writeLength));
+    storeLE<uint32_t>(hdr + 36, static_cast<uint32_t>(read.size()));
+
+    uint64_t pos = head;
+    put(pos, hdr, sizeof(hdr));
+    pos += sizeof(hdr);
+    put(pos, write.data(), write.size());
+    pos += write.size();
+    put(pos, writeTail.data(), writeTail.size());
+    pos += writeTail.size();
+    put(pos, read.data(), read.size());
+    m_head.store(head + total, std::memory_order_release);
+    m_recorded.fetch_add(1, std::memory_order_relaxed);
+
+    // Будить поток сброса только при заметном заполнении — иначе он проснётся сам
+    if (used + total > capacity / 2) m_cv.notify_one();
+}
+
+void Recorder::drain() {
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (head == tail) return;
+
+    const size_t size = static_cast<size_t>(head - tail);
+    // После ошибки записи файл уже неполный: кольцо только освобождается
+    if (!m_writeFailed.load(std::memory_order_relaxed)) {
+        const size_t offset = static_cast<size_t>(tail) & m_mask;
+        const size_t first = std::min(size, m_mask + 1 - offset);
+        m_file.write(reinterpret_cast<const char *>(m_ring.get() + offset),
+                     static_cast<std::streamsize>(first));
+        if (first < size)
+            m_file.write(reinterpret_cast<const char *>(m_ring.get()),
+                         static_cast<std::streamsize>(size - first));
+        // flush — чтобы ошибка диска проявилась сейчас, а не при закрытии
+        if (m_file.flush())
+            m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+        else
+            m_writeFailed.store(true, std::memory_order_relaxed);
+    }
+    m_tail.store(head, std::memory_order_release);
+}
+
+void Recorder::flushLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopRequested) {
+        m_cv.wait_for(lock, kFlushInterval);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void Recorder::stop() {
+    if (m_stopped.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_cv.notify_one();
+    if (m_flusher.joinable()) m_flusher.join();
+    drain();
+    m_file.close();
+    if (!m_file) m_writeFailed.store(true, std::memory_order_relaxed);
+    if (writeFailed())
+        throw std::runtime_error("Trace file write failed: " + m_path + " is truncated after " +
+                                 std::to_string(bytesWritten()) + " bytes");
+}
+
+Scope::~Scope() {
+    if (!m_recorder) return;
+    const uint64_t duration = m_recorder->nowNs() - m_header.timeNs;
+    m_header.durationNs = duration > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<uint32_t>(duration);
+    if (m_failed || std::uncaught_exceptions() > m_exceptions) {
+        m_header.flags |= FlagError;
+        if (!m_statusSet) m_header.status = ft4222stats::OpScope::currentStatus();
+        m_read = {};
+    }
+    m_recorder->record(m_header, m_write, m_writeTail, m_read);
+}
+
+Reader::Reader(std::istream &in) : m_in(in) {
+    uint8_t header[kFileHeaderSize];
+    if (!m_in.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+        std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+        throw std::runtime_error("not a twi-scanner trace file");
+    if (loadLE<uint32_t>(header + 8) != kVersion)
+        throw std::runtime_error("unsupported trace version " +
+                                 std::to_string(loadLE<uint32_t>(header + 8)));
+    const auto headerSize = loadLE<uint32_t>(header + 12);
+    if (headerSize < kFileHeaderSize) throw std::runtime_error("corrupt trace header");
+    m_in.ignore(static_cast<std::streamsize>(headerSize - kFileHeaderSize));
+    m_startWallNs = loadLE<uint64_t>(header + 16);
+}
+
+bool Reader::next(Record &r) {
+    uint8_t hdr[kRecordHeaderSize];
+    m_in.read(reinterpret_cast<char *>(hdr), 4);
+    if (m_in.gcount() == 0) return false;
+    if (m_in.gcount() != 4) throw std::runtime_error("truncated trace record");
+
+    const auto size = loadLE<uint32_t>(hdr);
+    if (size < kRecordHeaderSize - 4) throw std::runtime_error("corrupt trace record");
+    if (!m_in.read(reinterpret_cast<char *>(hdr + 4), kRecordHeaderSize - 4))
+        throw std::runtime_error("truncated trace record");
+
+    r.timeNs = loadLE<uint64_t>(hdr + 4);
+    r.durationNs = loadLE<uint32_t>(hdr + 12);
+    r.op = static_cast<ft4222stats::Op>(hdr[16]);
+    r.flags = hdr[17];
+    r.address = loadLE<uint16_t>(hdr + 18);
+    r.param = loadLE<uint32_t>(hdr + 20);
+    r.status = static_cast<int32_t>(loadLE<uint32_t>(hdr + 24));
+    r.value = loadLE<uint32_t>(hdr + 28);
+    const auto writeLength = loadLE<uint32_t>(hdr + 32);
+    const auto readLength = loadLE<uint32_t>(hdr + 36);
+    if (static_cast<uint64_t>(writeLength) + readLength != size - (kRecordHeaderSize - 4))
+        throw std::runtime_error("corrupt trace record");
+
+    r.write.resize(writeLength);
+    r.read.resize(readLength);
+    if (!m_in.read(reinterpret_cast<char *>(r.write.data()), writeLength) ||
+        !m_in.read(reinterpret_cast<char *>(r.read.data()), readLength))
+        throw std::runtime_error("truncated trace record");
+    return true;
+}
+
+} // namespace ft4222trace
@@ -0,0 +1,286 @@
+#pragma once
+
+// Двоичная трасса транзакций FTDevice (оба бэкенда): запись через кольцевой буфер
+// устройства с фоновым сбросом в файл и последовательное чтение для воспроизведения.
+
+#include "ft4222/ft4222_clock.hpp"
+#include "ft4222/ft4222_span.hpp"
+#include "ft4222/ft4222_stats.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ft4222trace {
+
+/**
+ * Формат файла (little-endian):
+ *
+ *   заголовок: "TWITRC1\0", u32 version = 2, u32 размер заголовка (24),
+ *              u64 время начала записи (system_clock, нс с эпохи)
+ *   запись:    u32 size (байт после этого поля), u64 timeNs (от начала), u32 durationNs,
+ *              u8 op (ft4222stats::Op), u8 flags, u16 address, u32 param, i32 status,
+ *              u32 value, u32 writeLength, u32 readLength, данные записи, данные чтения
+ *
+ * Смысл address / param / value зависит от операции (см. TraceReplayer): например, для
+ * i2c_read — адрес, флаг транзакции и запрошенная длина; для gpio_read — порт (0xFF —
+ * все) и прочитанные уровни.
+ *
+ * Параметры spi_init и set_clock записываются физическими величинами (spiInitParam,
+ * clockParam), а не значениями перечислений: в LibFT4222 и в mock они различаются, а
+ * трасса воспроизводится на любом бэкенде. Версия 1 хранила перечисления и не читается.
+ */
+constexpr char kMagic[8] = {'T', 'W', 'I', 'T', 'R', 'C', '1', '\0'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kFileHeaderSize = 24;
+constexpr size_t kRecordHeaderSize = 40;
+
+/// Значение address для операций GPIO над всеми выводами сразу (readGPIOPorts / writeGPIOPorts)
+constexpr uint16_t kAllGpioPorts = 0xFF;
+
+/**
+ * @brief Переносимый param записи spi_init
+ * @return Биты 0..7 — число линий данных (1, 2, 4), бит 8 — CPOL, бит 9 — CPHA,
+ *         биты 16..31 — делитель SCLK (2..512)
+ */
+constexpr uint32_t spiInitParam(FT4222_SPIMode mode, FT4222_SPIClock divider, FT4222_SPICPOL cpol,
+                                FT4222_SPICPHA cpha) {
+    const uint32_t lines = mode == SPI_IO_QUAD ? 4 : mode == SPI_IO_DUAL ? 2 : 1;
+    return lines | (cpol == CLK_IDLE_HIGH ? 1u << 8 : 0) | (cpha == CLK_TRAILING ? 1u << 9 : 0) |
+           ft4222clock::spiDividerValue(divider) << 16;
+}
+
+/// Настройка SPI, восстановленная из spiInitParam на текущем бэкенде
+struct SpiInitConfig {
+    FT4222_SPIMode mode = SPI_IO_SINGLE;
+    FT4222_SPIClock divider = CLK_DIV_512;
+    FT4222_SPICPOL cpol = CLK_IDLE_LOW;
+    FT4222_SPICPHA cpha = CLK_LEADING;
+};
+
+/// Разобрать spiInitParam; false — число линий или делитель недопустимы
+constexpr bool parseSpiInitParam(uint32_t param, SpiInitConfig &out) {
+    switch (param & 0xFF) {
+    case 1: out.mode = SPI_IO_SINGLE; break;
+    case 2: out.mode = SPI_IO_DUAL; break;
+    case 4: out.mode = SPI_IO_QUAD; break;
+    default: return false;
+    }
+    out.cpol = (param >> 8) & 1u ? CLK_IDLE_HIGH : CLK_IDLE_LOW;
+    out.cpha = (param >> 9) & 1u ? CLK_TRAILING : CLK_LEADING;
+    for (const FT4222_SPIClock div : ft4222clock::kSpiDividers) {
+        if (ft4222clock::spiDividerValue(div) == param >> 16) {
+            out.divider = div;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Переносимый param записи set_clock — системная частота, Гц
+constexpr uint32_t clockParam(FT4222_ClockRate rate) { return ft4222clock::systemClockHz(rate); }
+
+/// Разобрать clockParam; false — частота не из ряда FT4222
+constexpr bool parseClockParam(uint32_t hz, FT4222_ClockRate &out) {
+    for (const FT4222_ClockRate rate : ft4222clock::kClockRates) {
+        if (ft4222clock::systemClockHz(rate) == hz) {
+            out = rate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Флаги записи
+enum RecordFlags : uint8_t {
+    FlagError = 0x01, ///< Операция завершилась исключением
+    FlagBatch = 0x02, ///< Фаза операции из FTDevice::runI2CBatch
+};
+
+/// Поля записи без данных
+struct RecordHeader {
+    uint64_t timeNs = 0;     ///< Начало операции от начала трассы, нс
+    uint32_t durationNs = 0; ///< Длительность (насыщается на ~4.3 с), нс
+    ft4222stats::Op op = ft4222stats::Op::Count;
+    uint8_t flags = 0;
+    uint16_t address = 0;
+    uint32_t param = 0;
+    int32_t status = 0; ///< Код FT_STATUS / FT4222_STATUS, -1 — ошибка без кода
+    uint32_t value = 0;
+};
+
+/// Запись, прочитанная из файла
+struct Record : RecordHeader {
+    std::vector<uint8_t> write; ///< Переданные данные
+    std::vector<uint8_t> read;  ///< Полученные данные
+};
+
+/**
+ * @brief Запись трассы одного устройства
+ *
+ * Производитель — методы FTDevice, которые вызывают record() под мьютексом устройства,
+ * поэтому кольцо однопроизводительное: запись — memcpy и одна release-публикация
+ * индекса, без блокировок и выделений памяти. Фоновый поток периодически (и при
+ * заполнении кольца наполовину) сбрасывает накопленное в файл. Если кольцо
+ * переполнено, запись отбрасывается и учитывается в dropped(). Ошибка записи в файл
+ * запоминается: дальнейшие данные отбрасываются, а stop() сообщает о ней исключением.
+ *
+ * @note  Один Recorder подключается к одному FTDevice (FTDevice::setTraceRecorder).
+ */
+class Recorder {
+public:
+    static constexpr size_t kDefaultRingBytes = 4 * 1024 * 1024;
+
+    /**
+     * @brief Создать файл трассы и запустить поток сброса
+     * @param path Путь к файлу (перезаписывается)
+     * @param ringBytes Размер кольца (округляется вверх до степени двойки)
+     * @throw std::runtime_error Если файл не удалось открыть
+     */
+    explicit Recorder(const std::string &path, size_t ringBytes = kDefaultRingBytes);
+
+    /// Вызывает stop()
+    ~Recorder();
+
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+
+    /**
+     * @brief Сбросить остаток кольца и закрыть файл
+     * @throw std::runtime_error Если запись в файл или его закрытие не удались
+     *        (трасса неполная)
+     *
+     * @note  Повторные вызовы ничего не делают; записи после stop() отбрасываются.
+     */
+    void stop();
+
+    /// Время от начала трассы, нс
+    uint64_t nowNs() const noexcept;
+
+    /**
+     * @brief Добавить запись (вызывается производителем)
+     * @param header Поля записи
+     * @param write Данные записи
+     * @param writeTail Продолжение данных записи (например, multi-фаза SPI)
+     * @param read Полученные данные
+     */
+    void record(const RecordHeader &header, ConstByteSpan write, ConstByteSpan writeTail,
+                ConstByteSpan read) noexcept;
+
+    const std::string &path() const noexcept { return m_path; }
+    uint64_t recorded() const noexcept { return m_recorded.load(std::memory_order_relaxed); }
+    uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const noexcept { return m_bytesWritten.load(std::memory_order_relaxed); }
+    /// Запись в файл не удалась (трасса обрезана на bytesWritten())
+    bool writeFailed() const noexcept { return m_writeFailed.load(std::memory_order_relaxed); }
+
+private:
+    void put(uint64_t pos, const void *data, size_t size) noexcept;
+    void drain();
+    void flushLoop();
+
+    std::string m_path;
+    std::ofstream m_file;
+    std::unique_ptr<uint8_t[]> m_ring;
+    size_t m_mask;
+    uint64_t m_startNs;
+
+    alignas(64) std::atomic<uint64_t> m_head{0}; ///< Пишет производитель
+    alignas(64) std::atomic<uint64_t> m_tail{0}; ///< Пишет поток сброса
+
+    std::atomic<uint64_t> m_recorded{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_bytesWritten{0};
+    std::atomic<bool> m_stopped{false};
+    std::atomic<bool> m_writeFailed{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopRequested = false;
+    std::thread m_flusher;
+};
+
+/**
+ * @brief Запись одной операции FTDevice (RAII)
+ *
+ * Создаётся после захвата мьютекса устройства; при выключенной трассе (recorder ==
+ * nullptr) все методы — одна проверка указателя. Данные передаются до выхода из
+ * метода; в деструкторе запись уходит в кольцо с флагом ошибки, если метод выходит
+ * исключением (код статуса берётся из текущего ft4222stats::OpScope).
+ */
+class Scope {
+public:
+    Scope(Recorder *recorder, ft4222stats::Op op, uint16_t address = 0, uint32_t param = 0) noexcept
+        : m_recorder(recorder) {
+        if (!m_recorder) return;
+        m_header.op = op;
+        m_header.address = address;
+        m_header.param = param;
+        m_header.timeNs = m_recorder->nowNs();
+        m_exceptions = std::uncaught_exceptions();
+    }
+
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    void write(ConstByteSpan data, ConstByteSpan tail = {}) noexcept {
+        m_write = data;
+        m_writeTail = tail;
+    }
+    void read(ConstByteSpan data) noexcept { m_read = data; }
+    void value(uint32_t v) noexcept { m_header.value = v; }
+    void status(int s) noexcept { m_header.status = s; m_statusSet = true; }
+    /// Отметить запись как ошибку без исключения (варианты try*)
+    void fail(int s) noexcept {
+        m_failed = true;
+        status(s);
+    }
+
+private:
+    Recorder *m_recorder;
+    RecordHeader m_header;
+    ConstByteSpan m_write, m_writeTail, m_read;
+    int m_exceptions = 0;
+    bool m_statusSet = false;
+    bool m_failed = false;
+};
+
+/**
+ * @brief Последовательное чтение файла трассы
+ */
+class Reader {
+public:
+    /**
+     * @param in Поток файла трассы (binary)
+     * @throw std::runtime_error Если заголовок не распознан
+     */
+    explicit Reader(std::istream &in);
+
+    /**
+     * @brief Прочитать следующую запись
+     * @param record Приёмник (буферы переиспользуются)
+     * @return false в конце файла
+     * @throw std::runtime_error Если запись обрезана или повреждена
+     */
+    bool next(Record &record);
+
+    /// Время начала записи трассы (system_clock, нс с эпохи)
+    uint64_t startWallNs() const noexcept { return m_startWallNs; }
+
+private:
+    std::istream &m_in;
+    uint64_t m_startWallNs = 0;
+};
+
+} // namespace ft4222trace
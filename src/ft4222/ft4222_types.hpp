@@ -9,6 +9,14 @@ inline constexpr FT_STATUS FT_OK = 0;
 
 using FT4222_STATUS = uint32_t;
 inline constexpr FT4222_STATUS FT4222_OK = 0;
+inline constexpr FT4222_STATUS FT4222_INVALID_HANDLE = 1;
+inline constexpr FT4222_STATUS FT4222_DEVICE_NOT_OPENED = 3;
+inline constexpr FT4222_STATUS FT4222_IO_ERROR = 4;
+inline constexpr FT4222_STATUS FT4222_INVALID_PARAMETER = 6;
+inline constexpr FT4222_STATUS FT4222_FAILED_TO_WRITE_DEVICE = 10;
+inline constexpr FT4222_STATUS FT4222_OTHER_ERROR = 18;
+inline constexpr FT4222_STATUS FT4222_IS_NOT_I2C_MODE = 1004;
+inline constexpr FT4222_STATUS FT4222_FAILED_TO_READ_DEVICE = 1011;
 
 enum FT4222_SPIMode : int {
     SPI_IO_SINGLE = 0,
@@ -56,3 +64,19 @@ enum GPIO_Port : int {
     GPIO_PORT2 = 2,
     GPIO_PORT3 = 3,
 };
+
+enum I2C_MasterFlag : int {
+    NONE = 0x80,
+    START = 0x02,
+    Repeated_START = 0x03,
+    STOP = 0x04,
+    START_AND_STOP = 0x06,
+};
+
+#define I2CM_CONTROLLER_BUSY(status) (((status) & 0x01) != 0)
+#define I2CM_ERROR(status) (((status) & 0x02) != 0)
+#define I2CM_ADDRESS_NACK(status) (((status) & 0x04) != 0)
+#define I2CM_DATA_NACK(status) (((status) & 0x08) != 0)
+#define I2CM_ARB_LOST(status) (((status) & 0x10) != 0)
+#define I2CM_IDLE(status) (((status) & 0x20) != 0)
+#define I2CM_BUS_BUSY(status) (((status) & 0x40) != 0)
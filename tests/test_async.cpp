@@ -0,0 +1,58 @@
+#include "engine/AsyncDevice.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+int main() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(256);
+    ft4222mock::setConfig(cfg);
+
+    FTDevice dev(0);
+    dev.initI2CMaster(FTDevice::I2CSpeed::S400K);
+
+    std::vector<int> order;
+    {
+        // Маленькая очередь: отправка упирается в backpressure, порядок сохраняется
+        AsyncDevice async(dev, 4);
+        std::vector<std::future<std::vector<uint8_t>>> reads;
+        for (int i = 0; i < 64; ++i)
+            reads.push_back(async.submitI2CReadRegister(0x50, {static_cast<uint8_t>(i)}, 1));
+        for (int i = 0; i < 64; ++i) {
+            const auto data = reads[i].get();
+            assert(data.size() == 1 && data[0] == i);
+        }
+
+        // Ошибка устройства приходит через future
+        auto nack = async.submitI2CWrite(0x51, {0x00});
+        bool threw = false;
+        try {
+            nack.get();
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+
+        // Callback-и выполняются в порядке отправки
+        for (int i = 0; i < 16; ++i) {
+            async.post([i](FTDevice &) { return i; },
+                       [&order](int v, std::exception_ptr error) {
+                           assert(!error);
+                           order.push_back(v);
+                       });
+        }
+        async.flush();
+        assert(async.pending() == 0 && order.size() == 16);
+        for (int i = 0; i < 16; ++i) assert(order[i] == i);
+
+        // Операции, оставшиеся в очереди, выполняются до остановки потока
+        for (int i = 0; i < 8; ++i)
+            async.post([](FTDevice &) {}, [&order](std::exception_ptr) { order.push_back(-1); });
+    }
+    assert(order.size() == 24);
+    std::cout << "test_async: OK\n";
+    return 0;
+}
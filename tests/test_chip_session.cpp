@@ -0,0 +1,103 @@
+#include "engine/ChipSession.hpp"
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename E, typename F>
+bool throws(F &&f) {
+    try {
+        f();
+    } catch (const E &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(256);
+    cfg.usbLatencyUs = 50;
+
+    // Режим 3: один интерфейс на чип, без буквы
+    ft4222mock::setConfig(cfg);
+    setenv("TWI_MOCK_DEVICES", "2", 1);
+    {
+        const auto chips = ChipSession::groupChips(DeviceEnumerator::listDevices());
+        assert(chips.size() == 2 && chips[0].serial == "MOCK0001");
+        assert(chips[1].interfaces.size() == 1 && chips[1].interfaces[0].index == 1);
+    }
+
+    // Режим 1: A, B, C — SPI на SS0O..SS2O, D — GPIO
+    cfg.chipMode = 1;
+    ft4222mock::setConfig(cfg);
+    const auto devices = DeviceEnumerator::listDevices();
+    assert(devices.size() == 8 && devices[5].serial == "MOCK0002B");
+    assert(ChipSession::interfaceLetter(devices[5]) == 'B');
+    const auto chips = ChipSession::groupChips(devices);
+    assert(chips.size() == 2 && chips[1].serial == "MOCK0002");
+    assert(chips[1].interfaces.size() == 4 && chips[1].interfaces[3].index == 7);
+
+    ChipSession session;
+    session.openBySerial("MOCK0002C");
+    assert(session.isOpen() && session.size() == 4 && session.chipMode() == 1);
+    assert(session.chip().serial == "MOCK0002");
+    assert(throws<std::runtime_error>([&] { session.open(chips[0]); }));
+
+    // I2C на A и SPI на B одновременно из двух потоков, без повторной инициализации
+    FTDevice &i2c = session.i2c(FTDevice::I2CSpeed::S1M);
+    FTDevice &spi = session.spi(1, SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_4);
+    assert(&i2c == &session.at(0) && &spi == &session.at(1));
+    std::thread i2cThread([&] {
+        const uint8_t reg[1] = {0x10};
+        for (int i = 0; i < 100; ++i) {
+            FTDevice &d = session.i2c(FTDevice::I2CSpeed::S1M);
+            assert(d.i2cReadRegister(0x50, reg, 2)[1] == 0x11);
+        }
+    });
+    std::thread spiThread([&] {
+        const std::vector<uint8_t> tx(64, 0xA5);
+        for (int i = 0; i < 100; ++i) {
+            FTDevice &d = session.spi(1, SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_4);
+            assert(d.spiMasterSingleReadWrite(tx).size() == tx.size());
+        }
+    });
+    i2cThread.join();
+    spiThread.join();
+    assert(session.modeSwitches() == 0);
+    assert(i2c.getDeviceMode() == FTDevice::Mode::I2C_Master);
+    assert(spi.getDeviceMode() == FTDevice::Mode::SPI_Master);
+
+    FTDevice &gpio = session.gpio(GPIO_OUTPUT);
+    assert(&gpio == &session.at(3) && gpio.getDeviceMode() == FTDevice::Mode::GPIO);
+    assert(throws<std::out_of_range>([&] { session.spi(3); }));
+
+    // SPI на SS0O делит интерфейс A с I2C — это переключение режима
+    session.spi(0);
+    session.i2c(FTDevice::I2CSpeed::S1M);
+    assert(session.modeSwitches() == 2);
+
+    session.close();
+    assert(!session.isOpen());
+    assert(throws<std::runtime_error>([&] { session.i2c(); }));
+    assert(throws<std::runtime_error>([&] { session.openBySerial("MOCK0009"); }));
+
+    // Режим 2: GPIO нет
+    cfg.chipMode = 2;
+    ft4222mock::setConfig(cfg);
+    session.open(ChipSession::groupChips(DeviceEnumerator::listDevices())[0]);
+    assert(session.spi(3).getDeviceMode() == FTDevice::Mode::SPI_Master);
+    assert(throws<std::out_of_range>([&] { session.gpio(); }));
+
+    std::cout << "All chip session tests passed.\n";
+    return 0;
+}
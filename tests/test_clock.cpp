@@ -0,0 +1,59 @@
+#include "ft4222/ft4222_clock.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+using namespace ft4222clock;
+
+// Перебор всех пар: план не выше предела и никакая пара не даёт больше
+static void testSpiOptimal() {
+    for (uint32_t target = kSpiMinHz; target <= 60'000'000; target = target * 5 / 4 + 1) {
+        const SpiClockPlan plan = planSpi(target, SYS_CLK_60);
+        assert(plan.hz <= target);
+        assert(plan.hz == systemClockHz(plan.clock) / spiDividerValue(plan.divider));
+        for (auto clock : kClockRates)
+            for (auto div : kSpiDividers) {
+                const uint32_t hz = systemClockHz(clock) / spiDividerValue(div);
+                assert(hz > target || hz <= plan.hz);
+            }
+    }
+}
+
+static void testSpiKeepsCurrentClock() {
+    // 30 МГц: 60/2 — единственный вариант; 12 МГц: 24/2 и 48/4
+    assert(planSpi(30'000'000, SYS_CLK_80).clock == SYS_CLK_60);
+    assert(planSpi(12'000'000, SYS_CLK_48).clock == SYS_CLK_48);
+    assert(planSpi(12'000'000, SYS_CLK_48).divider == CLK_DIV_4);
+    assert(planSpi(12'000'000, SYS_CLK_24).divider == CLK_DIV_2);
+    // Без совпадения с текущей — более высокая системная частота
+    assert(planSpi(12'000'000, SYS_CLK_80).clock == SYS_CLK_48);
+    // Выше максимума — самая быстрая пара; ниже минимума — самая медленная
+    assert(planSpi(100'000'000).hz == kSpiMaxHz);
+    assert(planSpi(1000).hz == kSpiMinHz);
+}
+
+static void testI2C() {
+    for (uint32_t target = kI2CMinHz; target <= 4'000'000; target = target * 9 / 8 + 1) {
+        const I2CClockPlan plan = planI2C(target, SYS_CLK_60);
+        assert(plan.hz != 0 && plan.hz <= target && plan.hz <= kI2CMaxHz);
+        assert(plan.timerPeriod >= kI2CMinTimerPeriod && plan.timerPeriod <= kI2CMaxTimerPeriod);
+        assert(plan.hz == i2cHz(plan.clock, plan.timerPeriod));
+        for (auto clock : kClockRates)
+            for (uint32_t tp = kI2CMinTimerPeriod; tp <= kI2CMaxTimerPeriod; ++tp) {
+                const uint32_t hz = i2cHz(clock, tp);
+                assert(hz > target || hz > kI2CMaxHz || hz <= plan.hz);
+            }
+    }
+    assert(planI2C(100'000, SYS_CLK_60).hz == 100'000 && planI2C(100'000, SYS_CLK_60).clock == SYS_CLK_60);
+    assert(planI2C(400'000).kbps() == 400);
+    assert(planI2C(kI2CMinHz - 1).hz == 0);
+}
+
+int main() {
+    testSpiOptimal();
+    testSpiKeepsCurrentClock();
+    testI2C();
+    std::cout << "All clock planner tests passed.\n";
+    return 0;
+}
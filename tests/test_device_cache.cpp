@@ -0,0 +1,167 @@
+#include "engine/DeviceCache.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+DeviceInfo makeDevice(const char *serial, uint32_t location) {
+    DeviceInfo d;
+    d.serial = serial;
+    d.description = "FT4222";
+    d.index = location;
+    d.locationId = location;
+    d.flags = 0;
+    return d;
+}
+
+// Управляемый источник списка вместо FT_CreateDeviceInfoList
+struct FakeBus {
+    std::mutex mutex;
+    std::vector<DeviceInfo> devices;
+
+    DeviceCache::Lister lister() {
+        return [this] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return devices;
+        };
+    }
+
+    void set(std::vector<DeviceInfo> list) {
+        std::lock_guard<std::mutex> lock(mutex);
+        devices = std::move(list);
+    }
+};
+
+} // namespace
+
+int main() {
+    using namespace std::chrono_literals;
+
+    // Свежий снимок: повторные обращения и поиск по номеру без перечисления
+    {
+        FakeBus bus;
+        bus.set({makeDevice("A1", 0x11), makeDevice("B2", 0x12)});
+        DeviceCache cache(60s, bus.lister());
+
+        assert(cache.devices().size() == 2);
+        assert(cache.enumerations() == 1);
+        assert(cache.devices().size() == 2);
+        const auto hit = cache.findBySerial("B2");
+        assert(hit && hit->locationId == 0x12);
+        assert(cache.findByLocation(0x11)->serial == "A1");
+        assert(cache.enumerations() == 1);
+
+        // Промах: одно перечисление, затем найден новый адаптер
+        bus.set({makeDevice("A1", 0x11), makeDevice("B2", 0x12), makeDevice("C3", 0x13)});
+        assert(cache.findBySerial("C3"));
+        assert(cache.enumerations() == 2);
+        assert(!cache.findBySerial("ZZ"));
+        assert(cache.enumerations() == 3);
+
+        // Принудительное обновление и события добавления/удаления
+        bus.set({makeDevice("A1", 0x11), makeDevice("D4", 0x14)});
+        const auto events = cache.refresh();
+        size_t added = 0, removed = 0;
+        for (const auto &ev : events) {
+            if (ev.type == DeviceCache::Event::Type::Added) {
+                assert(ev.info.serial == "D4");
+                ++added;
+            } else {
+                assert(ev.info.serial == "B2" || ev.info.serial == "C3");
+                ++removed;
+            }
+        }
+        assert(added == 1 && removed == 2);
+    }
+
+    // Нулевой TTL: каждое обращение перечитывает список
+    {
+        FakeBus bus;
+        bus.set({makeDevice("A1", 1)});
+        DeviceCache cache(0ms, bus.lister());
+        cache.devices();
+        cache.devices();
+        assert(cache.enumerations() == 2);
+        cache.setTtl(60s);
+        cache.devices();
+        assert(cache.enumerations() == 2);
+    }
+
+    // Наблюдатель замечает подключение и отключение
+    {
+        FakeBus bus;
+        bus.set({makeDevice("A1", 1)});
+        DeviceCache cache(60s, bus.lister());
+
+        std::mutex eventsMutex;
+        std::vector<DeviceCache::Event> seen;
+        cache.startWatcher(5ms, [&](const DeviceCache::Event &ev) {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            seen.push_back(ev);
+        });
+        assert(cache.watching());
+
+        auto waitFor = [&](size_t count) {
+            for (int i = 0; i < 400; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(eventsMutex);
+                    if (seen.size() >= count) return true;
+                }
+                std::this_thread::sleep_for(5ms);
+            }
+            return false;
+        };
+
+        while (cache.enumerations() == 0) std::this_thread::sleep_for(1ms);
+        bus.set({makeDevice("A1", 1), makeDevice("B2", 2)});
+        assert(waitFor(1));
+        bus.set({makeDevice("B2", 2)});
+        assert(waitFor(2));
+
+        cache.stopWatcher();
+        assert(!cache.watching());
+        {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            assert(seen[0].type == DeviceCache::Event::Type::Added && seen[0].info.serial == "B2");
+            assert(seen[1].type == DeviceCache::Event::Type::Removed && seen[1].info.serial == "A1");
+        }
+        // Кэш актуален без истечения TTL
+        const auto list = cache.devices();
+        assert(list.size() == 1 && list[0].serial == "B2");
+    }
+
+    // Событие перечисления из вызывающего потока доставляется в потоке наблюдателя
+    {
+        FakeBus bus;
+        bus.set({makeDevice("A1", 1)});
+        DeviceCache cache(60s, bus.lister());
+        cache.devices();
+
+        std::mutex eventsMutex;
+        std::vector<std::thread::id> threads;
+        cache.startWatcher(20ms, [&](const DeviceCache::Event &) {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            threads.push_back(std::this_thread::get_id());
+        });
+        bus.set({makeDevice("A1", 1), makeDevice("B2", 2)});
+        assert(cache.findBySerial("B2"));
+        for (int i = 0; i < 400; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(eventsMutex);
+                if (!threads.empty()) break;
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        cache.stopWatcher();
+        assert(threads.size() == 1 && threads[0] != std::this_thread::get_id());
+    }
+
+    std::cout << "All device cache tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "engine/I2CEeprom.hpp"
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+#include "ft4222/ft4222_stats.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename F>
+bool throwsWith(F &&f, const std::string &text) {
+    try {
+        f();
+    } catch (const std::exception &ex) {
+        return std::string(ex.what()).find(text) != std::string::npos;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    // 24C512: 64 КБ, двухбайтовый адрес, страница 64; 24C04: два блока по 256 на 0x54/0x55
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(65536);
+    cfg.i2cTargets[0x54] = ft4222mock::patternRegisters(256);
+    cfg.i2cTargets[0x55] = std::vector<uint8_t>(256, 0xEE);
+    cfg.i2cPageSize = 64;
+    cfg.i2cWriteCycleUs = 300;
+    ft4222mock::setConfig(cfg);
+
+    FTDevice dev(0);
+    dev.initI2CMaster(FTDevice::I2CSpeed::S1M);
+
+    // Длина одной транзакции ограничена uint16 LibFT4222
+    std::vector<uint8_t> huge(FTDevice::I2C_MAX_TRANSFER + 1);
+    assert(throwsWith([&] { dev.i2cMasterRead(0x50, ByteSpan(huge)); }, "65535"));
+
+    // Чтение всего объёма: транзакции по I2C_MAX_TRANSFER байт
+    {
+        I2CEeprom eeprom(dev, 0x50, {2, 64});
+        std::vector<uint8_t> all(65536);
+        const auto st = eeprom.read(0, all);
+        assert(st.bytes == 65536 && st.transfers == 2);
+        assert(all == ft4222mock::patternRegisters(65536));
+    }
+
+    // Однобайтовый адрес: блоки по 256 выбираются битами адреса устройства
+    {
+        I2CEeprom eeprom(dev, 0x54, {1, 16});
+        std::vector<uint8_t> two(16);
+        const auto st = eeprom.read(0xF8, two);
+        assert(st.transfers == 2 && two[0] == 0xF8 && two[7] == 0xFF && two[8] == 0xEE);
+    }
+
+    // Запись через границы страниц: первая неполная страница, затем полные
+    {
+        I2CEeprom eeprom(dev, 0x50, {2, 64});
+        std::vector<uint8_t> data(200);
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(0xFF - i);
+        ft4222stats::reset();
+        const auto st = eeprom.write(0x3F0, data);
+        assert(st.bytes == 200 && st.pages == 4);
+        assert(st.polls > st.pages && st.maxCycleUs >= 300);
+        // ACK polling — однобайтовые чтения; NACK занятого EEPROM не считается ошибкой
+        for (const auto &op : ft4222stats::snapshot()) {
+            if (op.op == ft4222stats::Op::I2CRead) assert(op.calls == st.polls && op.errors == 0);
+            if (op.op == ft4222stats::Op::I2CWrite) assert(op.calls == st.pages && op.errors == 0);
+        }
+        assert(st.verifyUs > 0);
+
+        std::vector<uint8_t> around(202);
+        eeprom.read(0x3EF, around);
+        assert(around[0] == 0xEF && around[201] == static_cast<uint8_t>(0x3F0 + 200));
+        assert(std::vector<uint8_t>(around.begin() + 1, around.end() - 1) == data);
+    }
+
+    // Страница больше настоящей — EEPROM заворачивает запись, сверка это находит
+    {
+        I2CEeprom eeprom(dev, 0x50, {2, 128});
+        const std::vector<uint8_t> data(128, 0x42);
+        assert(throwsWith([&] { eeprom.write(0x1000, data); }, "verify failed at 0x1040"));
+    }
+
+    // Цикл записи дольше таймаута
+    {
+        cfg.i2cWriteCycleUs = 200000;
+        ft4222mock::setConfig(cfg);
+        FTDevice slow(0);
+        slow.initI2CMaster();
+        I2CEeprom eeprom(slow, 0x50, {2, 64});
+        const std::vector<uint8_t> data(4, 0x00);
+        assert(throwsWith([&] { eeprom.write(0, data, false, 5); }, "write cycle"));
+    }
+
+    assert(throwsWith([&] { I2CEeprom(dev, 0x50, {3, 64}); }, "address width"));
+    assert(throwsWith([&] { I2CEeprom(dev, 0x50, {1, 24}); }, "page size"));
+
+    std::cout << "All EEPROM tests passed.\n";
+    return 0;
+}
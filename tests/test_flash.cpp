@@ -0,0 +1,202 @@
+#include "engine/Crc32.hpp"
+#include "engine/FlashPipeline.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/SpiFlash.hpp"
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> makeImage(size_t size) {
+    std::vector<uint8_t> image(size);
+    uint32_t x = 0x12345678;
+    for (auto &b : image) {
+        x = x * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(x >> 24);
+    }
+    return image;
+}
+
+template <typename F>
+bool throws(F &&f) {
+    try {
+        f();
+    } catch (const std::exception &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    // CRC-32: контрольное значение и подсчёт по кускам
+    {
+        const std::string check = "123456789";
+        const ConstByteSpan bytes(reinterpret_cast<const uint8_t *>(check.data()), check.size());
+        assert(crc32(bytes) == 0xCBF43926u);
+        assert(crc32(bytes.subspan(3), crc32(bytes.subspan(0, 3))) == 0xCBF43926u);
+        assert(crc32({}) == 0);
+        const auto big = makeImage(1000);
+        assert(crc32(ConstByteSpan(big).subspan(500), crc32(ConstByteSpan(big).subspan(0, 500))) ==
+               crc32(big));
+    }
+
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string path = (dir / "twi-scanner-test-flash.bin").string();
+    const auto image = makeImage(70000);
+
+    // Отображение файла: содержимое без копирования, пустой и отсутствующий файлы
+    {
+        std::ofstream(path, std::ios::binary)
+            .write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+        MappedFile mapped(path);
+        assert(mapped.size() == image.size());
+        assert(std::equal(image.begin(), image.end(), mapped.bytes().begin()));
+        MappedFile moved(std::move(mapped));
+        assert(moved.size() == image.size() && mapped.size() == 0 && mapped.bytes().empty());
+
+        const std::string empty = (dir / "twi-scanner-test-flash-empty.bin").string();
+        std::ofstream(empty, std::ios::binary | std::ios::trunc).close();
+        assert(MappedFile(empty).bytes().empty());
+        std::filesystem::remove(empty);
+        assert(throws([&] { MappedFile missing((dir / "twi-scanner-no-such-file").string()); }));
+        assert(throws([&] { MappedFile notFile(dir.string()); }));
+        assert(!MappedFile(path).writable());
+        assert(throws([&] { MappedFile(path).writableBytes(); }));
+    }
+
+    // Созданный файл: запись через отображение попадает в файл, truncate укорачивает
+    {
+        const std::string out = (dir / "twi-scanner-test-flash-out.bin").string();
+        {
+            MappedFile file = MappedFile::create(out, 4096);
+            assert(file.writable() && file.writableBytes().size() == 4096);
+            std::copy(image.begin(), image.begin() + 4096, file.writableBytes().begin());
+            file.truncate(1000);
+            assert(file.size() == 1000);
+        }
+        assert(std::filesystem::file_size(out) == 1000);
+        MappedFile back(out);
+        assert(std::equal(back.bytes().begin(), back.bytes().end(), image.begin()));
+        assert(MappedFile::create(out, 0).bytes().empty() && std::filesystem::file_size(out) == 0);
+        std::filesystem::remove(out);
+    }
+
+    ft4222mock::Config cfg;
+    cfg.spiFlashSize = 0x20000;
+    cfg.spiFlashProgramUs = 50;
+    cfg.spiFlashEraseUs = 200;
+    ft4222mock::setConfig(cfg);
+
+    // Команды кристалла: ID, стирание секторами и блоками, программирование, чтение
+    {
+        FTDevice dev(0);
+        dev.initSPIMaster();
+        SpiNorFlash flash(dev);
+        assert(flash.readJedecId() == 0xEF4018);
+        assert(flash.readStatus() == 0);
+
+        const auto er = flash.erase(0x1000, 0x1F000);
+        assert(er.sectors == 15 && er.blocks == 1 && er.polls >= 16);
+
+        const std::vector<uint8_t> data(image.begin(), image.begin() + 1000);
+        const auto wr = flash.program(0x0F80, data);
+        // 0x0F80..0x1367: неполная первая страница, три полных и неполная последняя
+        assert(wr.bytes == 1000 && wr.pages == 5 && wr.skippedPages == 0);
+        assert(wr.polls >= wr.pages);
+        std::vector<uint8_t> back(1000);
+        flash.read(0x0F80, back);
+        assert(back == data);
+
+        // Без стирания программирование только сбрасывает биты
+        flash.program(0x0F80, std::vector<uint8_t>(4, 0x0F));
+        flash.read(0x0F80, ByteSpan(back.data(), 4));
+        for (size_t i = 0; i < 4; ++i) assert(back[i] == (data[i] & 0x0F));
+
+        assert(throws([&] { flash.read(0xFFFFFF, ByteSpan(back.data(), 2)); }));
+    }
+
+    // Все чипы параллельно; на каждый чип один поток через интерфейс A
+    setenv("TWI_MOCK_DEVICES", "3", 1);
+    cfg.chipMode = 0;
+    ft4222mock::setConfig(cfg);
+    {
+        std::vector<uint8_t> withBlank = image;
+        std::fill(withBlank.begin() + 0x1000 - 0x100, withBlank.begin() + 0x1100 - 0x100, 0xFF);
+
+        assert(FlashPipeline::targets(DeviceEnumerator::listDevices()).size() == 3);
+        FlashOptions opt;
+        opt.offset = 0x100;
+        opt.verify = true;
+        opt.spiHz = 20'000'000;
+        const auto results = FlashPipeline::run(DeviceEnumerator::listDevices(), withBlank, opt);
+        assert(results.size() == 3);
+        assert(results.count("MOCK0001A") && results.count("MOCK0003A"));
+        for (const auto &r : results) {
+            const FlashResult &fr = r.second;
+            assert(fr.ok && fr.error.empty() && fr.verified);
+            assert(fr.jedecId == 0xEF4018 && fr.sclkHz <= 20'000'000);
+            assert(fr.write.bytes == withBlank.size() && fr.write.skippedPages == 1);
+            assert(fr.erase.sectors + fr.erase.blocks * 16 == 18);
+            assert(fr.bytesPerSecond() > 0);
+        }
+    }
+
+    // Образ не помещается в адресуемую область — ошибка на каждом адаптере, не исключение
+    {
+        FlashOptions opt;
+        opt.offset = 0xFFFF00;
+        const auto results = FlashPipeline::run(DeviceEnumerator::listDevices(), image, opt);
+        assert(results.size() == 3);
+        for (const auto &r : results)
+            assert(!r.second.ok && r.second.error.find("does not fit") != std::string::npos);
+    }
+
+    // Без стирания поверх записанных данных — расхождение при сверке с адресом
+    {
+        FTDevice dev(0);
+        dev.initSPIMaster();
+        SpiNorFlash(dev).program(0x10, std::vector<uint8_t>{0x00});
+        FlashOptions opt;
+        opt.erase = false;
+        opt.verify = true;
+        FlashResult r;
+        bool threw = false;
+        try {
+            FlashPipeline::flash(dev, std::vector<uint8_t>(64, 0xA5), opt, r);
+        } catch (const std::runtime_error &ex) {
+            threw = std::string(ex.what()).find("0x10: wrote 0xA5, read 0x00") != std::string::npos;
+        }
+        assert(threw && r.write.pages == 1 && !r.verified);
+
+        // Без стирания страницы из 0xFF не пропускаются: пропуск оставил бы старые данные
+        std::vector<uint8_t> blank(2 * SpiNorFlash::kPageSize, 0xFF);
+        blank[0] = 0x00;
+        opt.verify = false;
+        FlashPipeline::flash(dev, blank, opt, r);
+        assert(r.write.pages == 2 && r.write.skippedPages == 0);
+    }
+
+    // Кристалла нет — JEDEC ID из нулей
+    {
+        cfg.spiFlashSize = 0;
+        ft4222mock::setConfig(cfg);
+        const auto results = FlashPipeline::run(DeviceEnumerator::listDevices(), image);
+        for (const auto &r : results)
+            assert(!r.second.ok && r.second.error.find("no SPI flash") != std::string::npos);
+    }
+
+    std::filesystem::remove(path);
+    std::cout << "All flash tests passed.\n";
+    return 0;
+}
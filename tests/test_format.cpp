@@ -0,0 +1,72 @@
+#include "cli/ByteFormat.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void testHex() {
+    const std::vector<uint8_t> data = {0x00, 0x0F, 0xA5, 0xFF};
+    std::string s;
+    appendHex(s, data);
+    assert(s == "00 0F A5 FF ");
+    s.clear();
+    appendHex(s, data, false);
+    assert(s == "000FA5FF");
+}
+
+static void testModes() {
+    const std::vector<uint8_t> data = {0xDE, 0xAD, 0x0A};
+    std::string s;
+    formatBytes(s, OutputMode::Hex, "i2c_recv", "Read", data);
+    assert(s == "Read 3 bytes: DE AD 0A \n");
+
+    s.clear();
+    formatBytes(s, OutputMode::Raw, "i2c_recv", "Read", data);
+    assert(s == std::string("\xDE\xAD\x0A", 3));
+
+    s.clear();
+    formatBytes(s, OutputMode::Json, "spi_xfer", "Received", data);
+    assert(s == "{\"command\":\"spi_xfer\",\"bytes\":3,\"data\":\"DEAD0A\"}\n");
+
+    s.clear();
+    formatBytes(s, OutputMode::Hex, "spi_recv", "Read", {});
+    assert(s == "Read 0 bytes: \n");
+}
+
+static void testHexdump() {
+    std::vector<uint8_t> data(20);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(0x40 + i);
+    data[1] = 0x00;
+    std::string s;
+    appendHexdump(s, data, 0x100);
+    assert(s == "00000100  40 00 42 43 44 45 46 47  48 49 4A 4B 4C 4D 4E 4F  |@.BCDEFGHIJKLMNO|\n"
+                "00000110  50 51 52 53                                       |PQRS|\n");
+}
+
+static void testParseMode() {
+    OutputMode mode = OutputMode::Hex;
+    assert(parseOutputMode("hexdump", mode) && mode == OutputMode::Hexdump);
+    assert(std::string(outputModeName(mode)) == "hexdump");
+    assert(!parseOutputMode("binary", mode) && mode == OutputMode::Hexdump);
+}
+
+static void testPrintToStream() {
+    AppContext ctx;
+    std::ostringstream buffer;
+    ctx.output = &buffer;
+    ctx.outputMode = OutputMode::Json;
+    printBytes(ctx, "i2c_rr", "Read", std::vector<uint8_t>{0x12});
+    assert(buffer.str() == "{\"command\":\"i2c_rr\",\"bytes\":1,\"data\":\"12\"}\n");
+}
+
+int main() {
+    testHex();
+    testModes();
+    testHexdump();
+    testParseMode();
+    testPrintToStream();
+    std::cout << "All format tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "engine/GpioWave.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+bool parseFails(const std::string &text, const std::string &expectLine) {
+    std::istringstream in(text);
+    try {
+        GpioPattern::parse(in, "p.txt");
+    } catch (const std::invalid_argument &ex) {
+        return std::string(ex.what()).find("p.txt:" + expectLine + ":") == 0;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    // Разбор диаграммы: абсолютное и относительное время, единицы, пауза в конце
+    {
+        std::istringstream in("# reset sequence\n"
+                              "0      0=0 1=1\n"
+                              "+2ms   0=1      # release\n"
+                              "2500us 1=0\n"
+                              "5ms\n");
+        const auto p = GpioPattern::parse(in);
+        assert(p.steps.size() == 4);
+        assert(p.steps[0].atUs == 0 && p.steps[0].mask == 0x3 && p.steps[0].values == 0x2);
+        assert(p.steps[1].atUs == 2000 && p.steps[1].mask == 0x1 && p.steps[1].values == 0x1);
+        assert(p.steps[2].atUs == 2500 && p.steps[2].mask == 0x2 && p.steps[2].values == 0x0);
+        assert(p.steps[3].mask == 0);
+        assert(p.durationUs() == 5000);
+    }
+    assert(parseFails("0 0=1\n1ms 4=1\n", "2"));
+    assert(parseFails("10ms 0=1\n5ms 0=0\n", "2"));
+    assert(parseFails("\n\n1xs 0=1\n", "3"));
+
+    FTDevice dev(0);
+    dev.initGPIO(GPIO_OUTPUT, GPIO_OUTPUT, GPIO_OUTPUT, GPIO_OUTPUT);
+
+    // Запись нескольких выводов за раз и чтение маской (mock возвращает выставленные уровни)
+    dev.writeGPIOPorts(0xF, 0x5);
+    assert(dev.readGPIOPorts() == 0x5);
+    dev.writeGPIOPorts(0x2, 0x2);
+    assert(dev.readGPIOPorts() == 0x7);
+
+    // Воспроизведение: все шаги выполнены, итоговые уровни — по последним записям
+    {
+        std::istringstream in("0 0=0 1=0 2=0 3=0\n+1ms 3=1\n+1ms 0=1\n+1ms\n");
+        const auto pattern = GpioPattern::parse(in);
+        const auto st = GpioPlayer::run(dev, pattern, 3);
+        assert(st.steps == 12);
+        assert(st.elapsedUs >= 8000);
+        assert(dev.readGPIOPorts() == 0x9);
+    }
+
+    // Выборка по расписанию: частота близка к заданной, уровни упакованы по тетрадам
+    {
+        dev.writeGPIOPorts(0xF, 0xA);
+        GpioSampleOptions opt;
+        opt.rateHz = 2000;
+        opt.durationMs = 50;
+        const auto cap = GpioSampler::run(dev, opt);
+        assert(cap.size() >= 50 && cap.size() <= 101);
+        assert(cap.packed.size() == (cap.size() + 1) / 2);
+        for (size_t i = 0; i < cap.size(); ++i) assert(cap.levels(i) == 0xA);
+        for (size_t i = 1; i < cap.size(); ++i) assert(cap.timestampsUs[i] > cap.timestampsUs[i - 1]);
+
+        std::ostringstream file;
+        cap.write(file);
+        const std::string bytes = file.str();
+        assert(bytes.compare(0, 8, "TWIGPIO1") == 0);
+        assert(bytes.size() == 8 + 4 + 8 + cap.size() * 4 + cap.packed.size());
+    }
+
+    // Предел числа выборок
+    {
+        GpioSampleOptions opt;
+        opt.rateHz = 0;
+        opt.durationMs = 1000;
+        opt.maxSamples = 7;
+        assert(GpioSampler::run(dev, opt).size() == 7);
+    }
+
+    std::cout << "All GPIO wave tests passed.\n";
+    return 0;
+}
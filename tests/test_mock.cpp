@@ -0,0 +1,339 @@
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+#include "ft4222/ft4222_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Два ведомых: 256-байтная память на 0x50 и 16 регистров на 0x68
+static ft4222mock::Config baseConfig() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(256);
+    cfg.i2cTargets[0x68] = ft4222mock::patternRegisters(16);
+    return cfg;
+}
+
+static FTDevice openI2C(const ft4222mock::Config &cfg) {
+    ft4222mock::setConfig(cfg);
+    FTDevice dev(0);
+    dev.initI2CMaster(FTDevice::I2CSpeed::S400K);
+    return dev;
+}
+
+static uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+}
+
+static void testScanFindsConfiguredTargets() {
+    FTDevice dev = openI2C(baseConfig());
+    const auto found = dev.scanI2CBus(0x03, 0x77);
+    assert(found.size() == 2 && found[0] == 0x50 && found[1] == 0x68);
+    const I2CScanResult fast = dev.scanI2CBusFast();
+    assert(fast.devices.size() == 2 && fast.probed == 0x77 - 0x03 + 1);
+}
+
+// Опрос записью: один байт kI2CWriteProbeByte (пустую запись LibFT4222 не выполняет)
+// ставит указатель регистра, содержимое не меняется
+static void testFastScanWriteProbe() {
+    FTDevice dev = openI2C(baseConfig());
+    const uint8_t reg[1] = {0x05};
+    dev.i2cReadRegister(0x68, reg, 1);
+    I2CScanOptions opt;
+    opt.writeProbe = true;
+    const I2CScanResult probed = dev.scanI2CBusFast(0x03, 0x77, opt);
+    assert(probed.devices.size() == 2 && probed.devices[1].address == 0x68);
+    uint8_t next[2] = {};
+    assert(dev.i2cMasterRead(0x68, ByteSpan(next)) == 2);
+    assert(next[0] == kI2CWriteProbeByte && next[1] == 0x01);
+}
+
+// Чтение регистра с автоинкрементом и переносом по размеру файла
+static void testRegisterReadWraps() {
+    FTDevice dev = openI2C(baseConfig());
+    const uint8_t reg[1] = {0x0E};
+    const auto regs = dev.i2cReadRegister(0x68, reg, 4);
+    assert(regs.size() == 4 && regs[0] == 0x0E && regs[1] == 0x0F && regs[2] == 0x00);
+}
+
+// Запись: первый байт — указатель, далее данные
+static void testWriteSetsPointer() {
+    FTDevice dev = openI2C(baseConfig());
+    dev.i2cMasterWrite(0x50, std::vector<uint8_t>{0x10, 0xAA, 0xBB});
+    const uint8_t reg10[1] = {0x10};
+    const auto back = dev.i2cReadRegister(0x50, reg10, 3);
+    assert(back[0] == 0xAA && back[1] == 0xBB && back[2] == 0x12);
+}
+
+// NACK: запись бросает исключение, чтение возвращает 0 байт, статус показывает NACK
+static void testNack() {
+    FTDevice dev = openI2C(baseConfig());
+    bool threw = false;
+    try {
+        dev.i2cMasterWrite(0x51, std::vector<uint8_t>{0x00});
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert(threw);
+    assert(I2CM_ADDRESS_NACK(dev.i2cMasterGetStatus()));
+    uint8_t buf[2] = {};
+    assert(dev.i2cMasterRead(0x51, ByteSpan(buf)) == 0);
+}
+
+// Пакет: ошибка одной операции не прерывает остальные
+static void testBatchContinuesAfterError() {
+    FTDevice dev = openI2C(baseConfig());
+    I2CBatch batch;
+    const uint8_t reg0[1] = {0x00};
+    batch.readRegister(0x50, reg0, 2);
+    batch.read(0x22, 1);
+    const I2CBatchResult res = dev.runI2CBatch(batch);
+    assert(res.failed == 1 && res.ops[0].ok && !res.ops[1].ok);
+    assert(res.readData(0)[1] == 0x01);
+}
+
+// Модель времени: задержка USB накапливается на каждую транзакцию
+static void testUsbLatency() {
+    ft4222mock::Config cfg = baseConfig();
+    cfg.usbLatencyUs = 200;
+    FTDevice dev = openI2C(cfg);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i)
+        dev.i2cMasterWrite(0x50, std::vector<uint8_t>{0x00, 0x01});
+    assert(elapsedUs(t0) >= 2000);
+}
+
+// Повторный init с той же конфигурацией не обращается к устройству
+static void testInitSkipsUnchangedConfig() {
+    ft4222mock::Config cfg = baseConfig();
+    cfg.usbLatencyUs = 200;
+    FTDevice dev = openI2C(cfg);
+    assert(!dev.initI2CMaster(FTDevice::I2CSpeed::S400K));
+    assert(dev.initI2CMaster(FTDevice::I2CSpeed::S400K, true));
+    assert(dev.initI2CMaster(FTDevice::I2CSpeed::S1M));
+    assert(dev.setClockRate(SYS_CLK_80) && !dev.setClockRate(SYS_CLK_80));
+    // Делитель I2C считается от системной частоты — после её смены init выполняется снова
+    assert(dev.initI2CMaster(FTDevice::I2CSpeed::S1M));
+    assert(!dev.initI2CMaster(FTDevice::I2CSpeed::S1M));
+    assert(dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_4));
+    assert(!dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_4));
+    assert(dev.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_4));
+    assert(dev.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_4, CLK_IDLE_HIGH));
+    assert(dev.initGPIO(GPIO_OUTPUT) && !dev.initGPIO(GPIO_OUTPUT));
+    assert(dev.getDeviceMode() == FTDevice::Mode::GPIO);
+    const auto skip0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i)
+        dev.initGPIO(GPIO_OUTPUT);
+    assert(elapsedUs(skip0) < 2000);
+    // Сброс чипа возвращает системную частоту по умолчанию
+    dev.resetChip();
+    assert(dev.getClockRate() == SYS_CLK_60);
+    assert(dev.initGPIO(GPIO_OUTPUT));
+}
+
+// Планировщик частот: системная частота и делитель выбираются под предел ведомого
+static void testHzInit() {
+    FTDevice dev = openI2C(baseConfig());
+    assert(dev.initSPIMasterHz(20'000'000) == 20'000'000);
+    assert(dev.getClockRate() == SYS_CLK_80 && dev.getDeviceMode() == FTDevice::Mode::SPI_Master);
+    assert(dev.initI2CMasterHz(100'000) == 100'000);
+    assert(dev.getDeviceMode() == FTDevice::Mode::I2C_Master);
+    bool threw = false;
+    try {
+        dev.initSPIMasterHz(1000);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// Смена системной частоты — отдельная операция в статистике, в том числе из *Hz init
+static void testSetClockStats() {
+    FTDevice dev = openI2C(baseConfig());
+    ft4222stats::reset();
+    assert(dev.initSPIMasterHz(20'000'000) == 20'000'000);
+    assert(!dev.setClockRate(SYS_CLK_80));
+    FTDevice closed;
+    try {
+        closed.setClockRate(SYS_CLK_60);
+    } catch (const std::runtime_error &) {
+    }
+    bool seen = false;
+    for (const auto &op : ft4222stats::snapshot()) {
+        if (op.op != ft4222stats::Op::SetClock)
+            continue;
+        seen = true;
+        assert(op.calls == 3 && op.errors == 1);
+    }
+    assert(seen && std::string(ft4222stats::opName(ft4222stats::Op::SetClock)) == "set_clock");
+}
+
+// Снимок состояния: поколение растёт только при перенастройке
+static void testStateGeneration() {
+    FTDevice dev = openI2C(baseConfig());
+    const FTDevice::State before = dev.state();
+    assert(before.open && before.mode == FTDevice::Mode::I2C_Master);
+    assert(dev.initI2CMaster(FTDevice::I2CSpeed::S1M, true));
+    const uint32_t configured = dev.state().generation;
+    assert(configured == before.generation + 1);
+    assert(!dev.initI2CMaster(FTDevice::I2CSpeed::S1M) && dev.state().generation == configured);
+    // Смена только числа линий SPI — тоже перенастройка
+    assert(dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_4));
+    const uint32_t single = dev.state().generation;
+    assert(dev.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_4));
+    assert(dev.state().generation == single + 1);
+    dev.close();
+    assert(!dev.state().open && dev.state().mode == FTDevice::Mode::Unknown);
+    assert(dev.state().generation != configured && FTDevice().state().generation == 0);
+}
+
+// Состояние и версия читаются без мьютекса: не ждут длинного SPI-обмена в другом потоке
+static void testStateDoesNotWaitForTransfer() {
+    ft4222mock::Config cfg = baseConfig();
+    cfg.busTiming = true;
+    ft4222mock::setConfig(cfg);
+    FTDevice spi(0);
+    spi.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_512);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        spi.spiMasterSingleWrite(std::vector<uint8_t>(2048, 0xA5)); // ~140 мс на шине
+        done.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto r0 = std::chrono::steady_clock::now();
+    const FTDevice::State st = spi.state();
+    const std::string version = spi.getVersionString();
+    const uint64_t readUs = elapsedUs(r0);
+    const bool overlapped = !done.load();
+    writer.join();
+    assert(overlapped && readUs < 10000);
+    assert(st.open && st.mode == FTDevice::Mode::SPI_Master && !version.empty());
+}
+
+// Чанки SPI: длинная передача идёт несколькими транзакциями USB, CS держится между
+// чанками (чтение JEDEC ID продолжается во втором чанке), короткий промежуточный чанк
+// снимает CS перед возвратом
+static void testSpiChunking() {
+    static const uint8_t kJedecId[3] = {0xEF, 0x40, 0x18};
+    ft4222mock::Config cfg = baseConfig();
+    cfg.spiFlashSize = 0x100000;
+    cfg.usbLatencyUs = 3000;
+    ft4222mock::setConfig(cfg);
+    {
+        FTDevice dev(0);
+        dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_2);
+        const uint8_t rdid[1] = {0x9F};
+        dev.spiMasterSingleWrite(rdid, false);
+        std::vector<uint8_t> id(3 * FTDevice::SPI_MAX_CHUNK + 1);
+        const auto t0 = std::chrono::steady_clock::now();
+        assert(dev.spiMasterSingleRead(ByteSpan(id), true) == id.size());
+        assert(elapsedUs(t0) >= 4 * 3000);
+        for (size_t i : {size_t{0}, FTDevice::SPI_MAX_CHUNK, id.size() - 1})
+            assert(id[i] == kJedecId[i % 3]);
+    }
+
+    cfg.usbLatencyUs = 0;
+    cfg.spiChunkLimit = 1000;
+    ft4222mock::setConfig(cfg);
+    FTDevice dev(0);
+    dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_2);
+    const uint8_t rdid[1] = {0x9F};
+    dev.spiMasterSingleWrite(rdid, false);
+    std::vector<uint8_t> big(FTDevice::SPI_MAX_CHUNK + 3);
+    assert(dev.spiMasterSingleRead(ByteSpan(big), true) == 1000);
+    // Без снятия CS следующая команда попала бы в кадр 0x9F и вернула бы другие байты
+    const uint8_t tx[4] = {0x9F, 0x00, 0x00, 0x00};
+    uint8_t rx[4] = {};
+    assert(dev.spiMasterSingleReadWrite(ByteSpan(rx), tx, true) == 4);
+    assert(rx[0] == 0xFF && rx[1] == 0xEF && rx[2] == 0x40 && rx[3] == 0x18);
+
+    bool threw = false;
+    try {
+        dev.spiMasterSingleWrite(std::vector<uint8_t>(FTDevice::SPI_MAX_CHUNK + 1, 0x9F), true);
+    } catch (const std::runtime_error &ex) {
+        threw = std::string(ex.what()).find("incomplete") != std::string::npos;
+    }
+    assert(threw);
+    std::fill(std::begin(rx), std::end(rx), 0);
+    dev.spiMasterSingleReadWrite(ByteSpan(rx), tx, true);
+    assert(rx[1] == 0xEF && rx[2] == 0x40 && rx[3] == 0x18);
+}
+
+// Multi-I/O: dummy-такты кодируются байтами multi-фазы — 8 тактов это 2 байта в dual и
+// 4 в quad; flash (0x3B/0x6B) отдаёт данные только после ровно 8 тактов
+static std::vector<uint8_t> multiRead(FTDevice &dev, uint8_t opcode, unsigned dummyCycles) {
+    return dev.spiMasterMultiReadWrite({opcode, 0x00, 0x00, 0x00}, {}, 4, dummyCycles);
+}
+
+static void testSpiMultiIo() {
+    ft4222mock::Config cfg = baseConfig();
+    cfg.spiFlashSize = 0x10000;
+    ft4222mock::setConfig(cfg);
+    FTDevice dev(0);
+    dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_2);
+    dev.spiMasterSingleWrite(std::vector<uint8_t>{0x06});
+    dev.spiMasterSingleWrite(std::vector<uint8_t>{0x02, 0x00, 0x00, 0x00, 0x11, 0x22, 0x33, 0x44});
+    const std::vector<uint8_t> expected = {0x11, 0x22, 0x33, 0x44};
+
+    // Одна линия: multi-I/O недоступен
+    bool threw = false;
+    try {
+        multiRead(dev, 0x3B, 8);
+    } catch (const std::runtime_error &ex) {
+        threw = std::string(ex.what()).find("dual or quad") != std::string::npos;
+    }
+    assert(threw);
+
+    dev.initSPIMaster(SPI_IO_DUAL, FTDevice::SPIClockDivider::DIV_2);
+    assert(multiRead(dev, 0x3B, 8) == expected);
+    assert(multiRead(dev, 0x3B, 4) == std::vector<uint8_t>(4, 0xFF));
+    threw = false;
+    try {
+        multiRead(dev, 0x3B, 6);
+    } catch (const std::invalid_argument &ex) {
+        threw = std::string(ex.what()).find("multiple of 4") != std::string::npos;
+    }
+    assert(threw);
+
+    dev.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_2);
+    assert(multiRead(dev, 0x6B, 8) == expected);
+    assert(multiRead(dev, 0x6B, 6) == std::vector<uint8_t>(4, 0xFF));
+    // Dummy-такты можно передать и байтами multiWrite: 4 нулевых байта — те же 8 тактов
+    assert(dev.spiMasterMultiReadWrite({0x6B, 0x00, 0x00, 0x00}, std::vector<uint8_t>(4, 0x00), 4, 0) ==
+           expected);
+    threw = false;
+    try {
+        multiRead(dev, 0x6B, 3);
+    } catch (const std::invalid_argument &ex) {
+        threw = std::string(ex.what()).find("multiple of 2") != std::string::npos;
+    }
+    assert(threw);
+}
+
+int main() {
+    testScanFindsConfiguredTargets();
+    testFastScanWriteProbe();
+    testRegisterReadWraps();
+    testWriteSetsPointer();
+    testNack();
+    testBatchContinuesAfterError();
+    testUsbLatency();
+    testInitSkipsUnchangedConfig();
+    testHzInit();
+    testSetClockStats();
+    testStateGeneration();
+    testStateDoesNotWaitForTransfer();
+    testSpiChunking();
+    testSpiMultiIo();
+
+    std::cout << "test_mock: OK\n";
+    return 0;
+}
@@ -1,8 +1,10 @@
 #include "cli/ParseUtil.hpp"
 
 #include <cassert>
+#include <cstdio>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 static void testDecimal() {
     assert(parseNumber("42") == 42);
@@ -25,10 +27,72 @@ static void testEmptyThrows() {
     assert(threw);
 }
 
+static void testTryParse() {
+    unsigned long v = 0;
+    assert(tryParseNumber("42", v) && v == 42);
+    assert(tryParseNumber("0x1f", v) && v == 0x1F);
+    assert(tryParseNumber("ff", v) && v == 0xFF);
+    assert(!tryParseNumber("", v));
+    assert(!tryParseNumber("0x", v));
+    assert(!tryParseNumber("12 ", v));
+    assert(!tryParseNumber("99999999999999999999999", v));
+
+    bool threw = false;
+    try {
+        parseNumber("zz");
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+static void testByteTokens() {
+    std::vector<uint8_t> out;
+    // Прежняя семантика одиночных токенов: десятичные числа и короткий hex
+    assert(parseByteList("42 ff 0x10 7", out));
+    assert((out == std::vector<uint8_t>{42, 0xFF, 0x10, 7}));
+
+    out.clear();
+    assert(parseByteList("DEADBEEF 0x0102 de:ad:be:ef", out));
+    assert((out == std::vector<uint8_t>{0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x02, 0xDE, 0xAD, 0xBE, 0xEF}));
+
+    // Ошибка не оставляет частично разобранных байт
+    out.assign({1});
+    std::string error;
+    assert(!parseByteList("02 xyz", out, &error));
+    assert(out.size() == 1 && error == "Invalid byte: xyz");
+    assert(!parseByteList("abc", out));        // нечётное число цифр в блобе
+    assert(!parseByteList("de:ad:", out));     // пустой байт
+    assert(!parseByteList("1:234", out));      // больше двух цифр
+    assert(out.size() == 1);
+}
+
+static void testByteFile() {
+    const char *path = "test_parse_payload.bin";
+    {
+        std::FILE *f = std::fopen(path, "wb");
+        assert(f);
+        const unsigned char data[] = {0x00, 0x7F, 0x80, 0xFF};
+        std::fwrite(data, 1, sizeof(data), f);
+        std::fclose(f);
+    }
+    std::vector<uint8_t> out;
+    assert(parseByteList("aa @test_parse_payload.bin", out));
+    assert((out == std::vector<uint8_t>{0xAA, 0x00, 0x7F, 0x80, 0xFF}));
+    std::remove(path);
+
+    std::string error;
+    assert(!appendBytes("@missing-file.bin", out, &error));
+    assert(out.size() == 5 && !error.empty());
+}
+
 int main() {
     testDecimal();
     testHex();
     testEmptyThrows();
+    testTryParse();
+    testByteTokens();
+    testByteFile();
     std::cout << "test_parse: OK\n";
     return 0;
 }
@@ -0,0 +1,182 @@
+#include "engine/I2CPoll.hpp"
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+PollJob job(uint8_t address, std::vector<uint8_t> reg, uint16_t length, uint32_t periodUs) {
+    PollJob j;
+    j.address = address;
+    j.reg = std::move(reg);
+    j.length = length;
+    j.periodUs = periodUs;
+    return j;
+}
+
+// Опрос в течение ms с потреблением кольца в этом потоке
+PollStats pollFor(I2CPoller &poller, unsigned ms, std::vector<PollSample> &samples) {
+    const auto sink = [&](const PollSample &s) { samples.push_back(s); };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    poller.start();
+    while (std::chrono::steady_clock::now() < deadline) {
+        poller.drain(sink);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    const PollStats st = poller.stop();
+    poller.drain(sink);
+    return st;
+}
+
+template <typename F>
+bool throwsInvalid(F &&f) {
+    try {
+        f();
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x48] = ft4222mock::patternRegisters(256);
+    cfg.i2cTargets[0x68] = ft4222mock::patternRegisters(256);
+    ft4222mock::setConfig(cfg);
+
+    FTDevice dev(0);
+    dev.initI2CMaster(FTDevice::I2CSpeed::S400K);
+
+    // Проверка заданий
+    assert(throwsInvalid([&] { I2CPoller p(dev, {}); }));
+    assert(throwsInvalid([&] { I2CPoller p(dev, {job(0x48, {0x00}, 0, 1000)}); }));
+    assert(throwsInvalid([&] { I2CPoller p(dev, {job(0x48, {0x00}, 33, 1000)}); }));
+    assert(throwsInvalid([&] { I2CPoller p(dev, {job(0x48, {0x00}, 2, 0)}); }));
+    assert(throwsInvalid([&] { I2CPoller p(dev, {job(0x80, {0x00}, 2, 1000)}); }));
+
+    // Частоты 1 кГц и 100 Гц: слоты 100 Гц совпадают со слотами 1 кГц и идут тем же пакетом;
+    // отсутствующий адрес даёт выборки с ошибкой, не останавливая опрос
+    {
+        I2CPoller poller(dev, {job(0x68, {0x3B}, 6, 1000), job(0x48, {0x10}, 2, 10000),
+                               job(0x22, {}, 1, 10000)});
+        std::vector<PollSample> samples;
+        const PollStats st = pollFor(poller, 300, samples);
+        assert(!poller.running());
+
+        const auto &fast = st.jobs[0];
+        const auto &slow = st.jobs[1];
+        const auto &absent = st.jobs[2];
+        assert(fast.samples + fast.missed >= 250 && fast.samples + fast.missed <= 310);
+        assert(slow.samples >= 25 && slow.samples <= 31);
+        assert(fast.errors == 0 && slow.errors == 0 && absent.errors == absent.samples);
+        assert(fast.achievedHz > 500 && slow.achievedHz > 80 && slow.achievedHz < 110);
+        // Пакетов меньше, чем опросов: медленные задания ехали вместе с быстрым
+        assert(st.batches == fast.samples);
+        assert(samples.size() == fast.samples + slow.samples + absent.samples);
+
+        uint64_t lastTime = 0;
+        size_t slowSeen = 0;
+        for (const auto &s : samples) {
+            assert(s.timeUs >= lastTime);
+            lastTime = s.timeUs;
+            if (s.job == 0) assert(s.ok && s.length == 6 && s.data[0] == 0x3B && s.data[5] == 0x40);
+            if (s.job == 1) {
+                assert(s.ok && s.length == 2 && s.data[0] == 0x10 && s.data[1] == 0x11);
+                // Слот 10 мс: опрос не раньше начала слота (с учётом окна объединения)
+                assert(s.timeUs + 100 >= 10000 * slowSeen);
+                ++slowSeen;
+            }
+            if (s.job == 2) assert(!s.ok && s.length == 0);
+        }
+    }
+
+    // Медленная шина: слоты, прошедшие за время пакета, пропускаются, а не копятся
+    cfg.usbLatencyUs = 3000;
+    ft4222mock::setConfig(cfg);
+    {
+        FTDevice slow(0);
+        slow.initI2CMaster(FTDevice::I2CSpeed::S400K);
+        I2CPoller poller(slow, {job(0x48, {0x00}, 2, 1000)});
+        std::vector<PollSample> samples;
+        const PollStats st = pollFor(poller, 200, samples);
+        const auto &js = st.jobs[0];
+        assert(js.missed > 0 && js.achievedHz < 500);
+        assert(js.samples + js.missed >= 150 && js.samples + js.missed <= 215);
+        assert(js.maxLateUs < 10000);
+    }
+    cfg.usbLatencyUs = 0;
+    ft4222mock::setConfig(cfg);
+
+    // Кольцо без потребителя переполняется — выборки отбрасываются, опрос не блокируется
+    {
+        PollOptions opt;
+        opt.ringCapacity = 8;
+        I2CPoller poller(dev, {job(0x48, {0x00}, 1, 500)}, opt);
+        poller.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const PollStats st = poller.stop();
+        assert(st.jobs[0].dropped > 0 && st.jobs[0].samples == st.jobs[0].dropped + 8);
+        assert(poller.drain([](const PollSample &) {}) == 8);
+    }
+
+    // Ошибка устройства останавливает планировщик и выходит из stop()
+    {
+        FTDevice notI2C(0);
+        I2CPoller poller(notI2C, {job(0x48, {0x00}, 1, 1000)});
+        poller.start();
+        while (poller.running()) std::this_thread::yield();
+        bool threw = false;
+        try {
+            poller.stop();
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // Формат файлов
+    {
+        const std::vector<PollJob> jobs = {job(0x48, {0x00, 0x10}, 2, 1000), job(0x22, {}, 1, 1000)};
+        PollSample a;
+        a.timeUs = 1500;
+        a.lateUs = 7;
+        a.job = 0;
+        a.ok = true;
+        a.length = 2;
+        a.data[0] = 0xAB;
+        a.data[1] = 0x01;
+        PollSample b;
+        b.job = 1;
+
+        std::ostringstream csv;
+        PollWriter w(csv, PollFormat::Csv, jobs);
+        w.write(a);
+        w.write(b);
+        assert(csv.str() == "time_us,job,address,register,ok,late_us,data\n"
+                            "1500,0,0x48,0010,1,7,AB01\n"
+                            "0,1,0x22,,0,0,\n");
+
+        std::ostringstream bin;
+        PollWriter wb(bin, PollFormat::Binary, jobs);
+        wb.write(a);
+        const std::string s = bin.str();
+        // Заголовок: 8 + 4 + (1 + 1 + 2 + 2 + 4) + (1 + 1 + 0 + 2 + 4); запись: 16 + 2
+        assert(s.size() == 8 + 4 + 10 + 8 + 16 + 2);
+        assert(s.compare(0, 8, "TWIPOLL1") == 0 && s[8] == 2);
+        assert(static_cast<uint8_t>(s[30]) == 0xDC && s[31] == 0x05); // timeUs = 1500
+        assert(static_cast<uint8_t>(s[s.size() - 2]) == 0xAB);
+    }
+
+    std::cout << "All poll tests passed.\n";
+    return 0;
+}
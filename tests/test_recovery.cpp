@@ -0,0 +1,202 @@
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+#include "ft4222/ft4222_stats.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ft4222stats::recovery;
+
+std::string writeError(FTDevice &dev, uint8_t address) {
+    try {
+        dev.i2cMasterWrite(address, std::vector<uint8_t>{0x00, 0x5A});
+    } catch (const std::runtime_error &ex) {
+        return ex.what();
+    }
+    return {};
+}
+
+FTDevice openI2C(const ft4222mock::Config &cfg, const I2CRecoveryPolicy &policy = {}) {
+    ft4222mock::setConfig(cfg);
+    FTDevice dev(0);
+    dev.initI2CMaster(FTDevice::I2CSpeed::S400K);
+    dev.setI2CRecoveryPolicy(policy);
+    return dev;
+}
+
+} // namespace
+
+int main() {
+    // Классификация: NACK и ошибки вызова не повторяются, шина и сбои USB — повторяются
+    assert(classifyI2CFault(FT4222_OK, 0x20 | 0x02 | 0x04) == I2CFault::Nack);
+    assert(classifyI2CFault(FT4222_OK, 0x20 | 0x02 | 0x08) == I2CFault::Nack);
+    assert(classifyI2CFault(FT4222_OK, 0x20 | 0x02 | 0x40) == I2CFault::BusStuck);
+    assert(classifyI2CFault(FT4222_OK, 0x20 | 0x02 | 0x10) == I2CFault::BusStuck);
+    assert(classifyI2CFault(FT4222_FAILED_TO_READ_DEVICE, 0x20) == I2CFault::Transient);
+    assert(classifyI2CFault(FT4222_IO_ERROR, 0) == I2CFault::Transient);
+    assert(classifyI2CFault(FT4222_OK, 0x20 | 0x02) == I2CFault::Transient);
+    assert(classifyI2CFault(FT4222_IS_NOT_I2C_MODE, 0x20 | 0x40) == I2CFault::Fatal);
+    assert(classifyI2CFault(FT4222_INVALID_PARAMETER, 0) == I2CFault::Fatal);
+    assert(classifyI2CFault(FT4222_OK, 0x20) == I2CFault::Nack);
+
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(256);
+
+    I2CRecoveryPolicy policy;
+    policy.maxRetries = 3;
+    policy.backoffUs = 100;
+
+    // Без политики зависшая шина — исключение, пока её не сбросят вручную
+    cfg.i2cStuck = ft4222mock::I2CStuck::Bus;
+    {
+        FTDevice dev = openI2C(cfg);
+        assert(!dev.i2cRecoveryPolicy().enabled());
+        assert(!writeError(dev, 0x50).empty());
+        assert(dev.i2cMasterGetStatus() == (0x20 | 0x02 | 0x40));
+        dev.i2cMasterResetBus();
+        assert(writeError(dev, 0x50).empty());
+        assert(recovery().empty());
+    }
+
+    // С политикой — один сброс шины и повтор; политика переезжает вместе с устройством
+    ft4222stats::reset();
+    {
+        FTDevice opened = openI2C(cfg, policy);
+        FTDevice dev(std::move(opened));
+        assert(dev.i2cRecoveryPolicy().maxRetries == 3);
+        assert(writeError(dev, 0x50).empty());
+        const uint8_t reg[1] = {0x00};
+        assert(dev.i2cReadRegister(0x50, reg, 2)[0] == 0x5A);
+        const auto r = recovery();
+        assert(r.retries == 1 && r.busResets == 1 && r.chipResets == 0);
+        assert(r.recovered == 1 && r.exhausted == 0);
+    }
+
+    // Завис контроллер: сброс шины не помогает, со второй попытки — сброс чипа; режим
+    // и скорость I2C восстановлены без переоткрытия
+    cfg.i2cStuck = ft4222mock::I2CStuck::Chip;
+    ft4222stats::reset();
+    {
+        I2CRecoveryPolicy chip = policy;
+        chip.resetChip = true;
+        FTDevice dev = openI2C(cfg, chip);
+        std::vector<uint8_t> buf(4);
+        assert(dev.i2cMasterRead(0x50, buf) == 4);
+        assert(dev.getDeviceMode() == FTDevice::Mode::I2C_Master);
+        assert(!dev.initI2CMaster(FTDevice::I2CSpeed::S400K));
+        const auto r = recovery();
+        assert(r.retries == 2 && r.busResets == 1 && r.chipResets == 1 && r.recovered == 1);
+    }
+
+    // Без сброса чипа повторы исчерпываются — прежнее исключение
+    ft4222stats::reset();
+    {
+        FTDevice dev = openI2C(cfg, policy);
+        assert(writeError(dev, 0x50).find("incomplete") != std::string::npos);
+        const auto r = recovery();
+        assert(r.retries == 3 && r.busResets == 3 && r.recovered == 0 && r.exhausted == 1);
+    }
+
+    // Сбой USB: повтор без сброса шины; без политики — исключение с кодом LibFT4222
+    cfg.i2cStuck = ft4222mock::I2CStuck::None;
+    cfg.i2cGlitches = 2;
+    ft4222stats::reset();
+    {
+        FTDevice dev = openI2C(cfg);
+        assert(writeError(dev, 0x50).find("FT4222_STATUS: 1011") != std::string::npos);
+        dev.setI2CRecoveryPolicy(policy);
+        const uint8_t reg[1] = {0x10};
+        assert(dev.i2cReadRegister(0x50, reg, 2)[0] == 0x10);
+        const auto r = recovery();
+        assert(r.retries == 1 && r.busResets == 0 && r.recovered == 1);
+        for (const auto &op : ft4222stats::snapshot())
+            if (op.op == ft4222stats::Op::I2CWrite)
+                assert(op.errors == 1 && op.errorsByStatus[0].first == 1011);
+    }
+
+    // NACK не повторяется: отсутствующее устройство отвечает так же, как без политики
+    ft4222stats::reset();
+    cfg.i2cGlitches = 0;
+    {
+        FTDevice dev = openI2C(cfg, policy);
+        assert(writeError(dev, 0x51).find("incomplete") != std::string::npos);
+        std::vector<uint8_t> buf(2);
+        assert(dev.i2cMasterRead(0x51, buf) == 0);
+        assert(recovery().empty());
+    }
+
+    // Пакет: сбой одной операции восстанавливается, остальные не затронуты
+    cfg.i2cGlitches = 1;
+    ft4222stats::reset();
+    {
+        FTDevice dev = openI2C(cfg, policy);
+        I2CBatch batch;
+        const uint8_t reg[1] = {0x20};
+        batch.readRegister(0x50, reg, 2);
+        batch.read(0x22, 1);
+        batch.readRegister(0x50, reg, 1);
+        const auto result = dev.runI2CBatch(batch);
+        assert(result.failed == 1 && result.ops[0].ok && !result.ops[1].ok && result.ops[2].ok);
+        assert(result.ops[0].status == FT4222_OK && result.readData(0)[1] == 0x21);
+        assert(recovery().retries == 1 && recovery().recovered == 1);
+    }
+
+    // Пауза удваивается до предела: 1000 + 1500 + 1500 мкс
+    cfg.i2cGlitches = 3;
+    {
+        I2CRecoveryPolicy slow = policy;
+        slow.backoffUs = 1000;
+        slow.maxBackoffUs = 1500;
+        FTDevice dev = openI2C(cfg, slow);
+        const auto start = std::chrono::steady_clock::now();
+        assert(writeError(dev, 0x50).empty());
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(4000));
+    }
+
+    // Варианты без исключений: NACK, короткое чтение и сбой USB — итогом, счётчики ошибок те же
+    cfg.i2cGlitches = 1;
+    ft4222stats::reset();
+    {
+        FTDevice dev = openI2C(cfg);
+        const uint8_t data[2] = {0x00, 0x77};
+        auto r = dev.tryI2CWrite(0x50, data);
+        assert(r.error == I2CError::Device && r.status == FT4222_FAILED_TO_READ_DEVICE);
+        assert(std::string(r.what) == "FT4222_I2CMaster_WriteEx");
+        r = dev.tryI2CWrite(0x50, data);
+        assert(r.ok() && r.bytes == 2);
+
+        r = dev.tryI2CWrite(0x51, data);
+        assert(r.error == I2CError::Incomplete && r.bytes == 0 && r.status == FT4222_OK);
+        uint8_t buf[4] = {};
+        r = dev.tryI2CRead(0x51, buf);
+        assert(r.ok() && r.bytes == 0);
+        const uint8_t reg[1] = {0x00};
+        r = dev.tryI2CReadRegister(0x50, reg, buf);
+        assert(r.ok() && r.bytes == 4 && buf[0] == 0x77);
+        assert(dev.tryI2CReadRegister(0x51, reg, buf).error == I2CError::Incomplete);
+        assert(dev.tryI2CRead(0x50, ByteSpan(buf, 0)).ok());
+
+        std::vector<uint8_t> huge(FTDevice::I2C_MAX_TRANSFER + 1);
+        assert(dev.tryI2CWrite(0x50, huge).error == I2CError::InvalidArgument);
+
+        for (const auto &op : ft4222stats::snapshot()) {
+            if (op.op == ft4222stats::Op::I2CWrite) assert(op.calls == 4 && op.errors == 3);
+            if (op.op == ft4222stats::Op::I2CReadRegister) assert(op.errors == 1);
+            if (op.op == ft4222stats::Op::I2CRead) assert(op.errors == 0);
+        }
+
+        FTDevice closed(std::move(dev));
+        assert(dev.tryI2CRead(0x50, buf).error == I2CError::NotOpen);
+        closed.initSPIMaster();
+        assert(closed.tryI2CWrite(0x50, data).error == I2CError::WrongMode);
+    }
+
+    std::cout << "All recovery tests passed.\n";
+    return 0;
+}
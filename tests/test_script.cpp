@@ -0,0 +1,71 @@
+#include "cli/Script.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+static bool compileFails(const CommandRouter &router, const std::string &text, size_t line) {
+    std::istringstream in(text);
+    try {
+        ScriptPlan::compile(router, in, "t.twi");
+    } catch (const ScriptError &ex) {
+        return ex.line() == line;
+    }
+    return false;
+}
+
+int main() {
+    CommandRouter router;
+    int plain = 0, compiled = 0, compiles = 0, sum = 0;
+
+    router.registerCommand("plain", [&](AppContext &, std::istringstream &) { ++plain; });
+    router.registerCommand("add", [&](AppContext &, std::istringstream &iss) {
+        int v = 0;
+        iss >> v;
+        sum += v;
+    });
+    router.registerCompiler("add", [&](std::istringstream &iss) -> PreparedCommand {
+        int v = 0;
+        if (!(iss >> v)) throw std::invalid_argument("Usage: add <n>");
+        ++compiles;
+        return [&, v](AppContext &) {
+            ++compiled;
+            sum += v;
+        };
+    });
+
+    std::istringstream script("# header\n"
+                              "plain\n"
+                              "repeat 3 {\n"
+                              "    add 2   # comment\n"
+                              "    repeat 4 {\n"
+                              "        plain\n"
+                              "    }\n"
+                              "    repeat 0 {\n"
+                              "        add 100\n"
+                              "    }\n"
+                              "}\n");
+    const ScriptPlan plan = ScriptPlan::compile(router, script);
+    assert(plan.commandCount() == 4);
+    assert(compiles == 2); // аргументы разобраны один раз на строку
+
+    AppContext ctx;
+    plan.run(ctx);
+    assert(plain == 1 + 3 * 4);
+    assert(compiled == 3 && sum == 6);
+
+    // keepRunning останавливает выполнение после текущей команды
+    int steps = 0;
+    plan.run(ctx, [&] { return ++steps < 2; });
+    assert(steps == 2);
+
+    // Ошибки находятся при компиляции, с номером строки
+    assert(compileFails(router, "plain\nmissing 1\n", 2));
+    assert(compileFails(router, "add x\n", 1));
+    assert(compileFails(router, "repeat 2 {\nplain\n", 1));
+    assert(compileFails(router, "plain\n}\n", 2));
+    assert(compileFails(router, "repeat many {\n}\n", 1));
+
+    std::cout << "test_script: OK\n";
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "cli/Server.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+int connectTo(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    // Сервер поднимается в соседнем потоке: ждём, пока сокет начнёт принимать соединения
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        assert(fd >= 0);
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) return fd;
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    throw std::runtime_error("server did not start on " + path);
+}
+
+void sendText(int fd, const std::string &text) {
+    assert(::send(fd, text.data(), text.size(), 0) == static_cast<ssize_t>(text.size()));
+}
+
+// Прочитать ровно size байт; false — соединение закрыто раньше
+bool recvExact(int fd, std::string &out, size_t size) {
+    out.clear();
+    char buf[4096];
+    while (out.size() < size) {
+        const ssize_t n = ::recv(fd, buf, std::min(sizeof(buf), size - out.size()), 0);
+        if (n <= 0) return false;
+        out.append(buf, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+std::string recvLine(int fd) {
+    std::string line;
+    char c = 0;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n') line += c;
+    return line;
+}
+
+// Ответ JSON без поля elapsed_us, которое зависит от времени
+std::string recvJson(int fd) {
+    const std::string line = recvLine(fd);
+    const size_t elapsed = line.find(",\"elapsed_us\":");
+    assert(elapsed != std::string::npos && line.back() == '}');
+    return line.substr(0, elapsed) + "}";
+}
+
+struct BinaryReply {
+    bool ok = false;
+    std::string output;
+};
+
+BinaryReply recvBinary(int fd) {
+    std::string header;
+    assert(recvExact(fd, header, 5));
+    const auto *h = reinterpret_cast<const uint8_t *>(header.data());
+    const size_t len = h[0] | (h[1] << 8) | (h[2] << 16) | (static_cast<uint32_t>(h[3]) << 24);
+    BinaryReply reply;
+    reply.ok = h[4] == 1;
+    assert(recvExact(fd, reply.output, len));
+    return reply;
+}
+
+bool closedByPeer(int fd) {
+    char c = 0;
+    return ::recv(fd, &c, 1, 0) == 0;
+}
+
+} // namespace
+
+int main() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x68] = ft4222mock::patternRegisters(16);
+    ft4222mock::setConfig(cfg);
+
+    AppContext ctx;
+    ctx.device = FTDevice(0);
+    ctx.device.initI2CMaster(FTDevice::I2CSpeed::S400K);
+    ctx.mode = DeviceMode::I2C;
+
+    CommandRouter router;
+    router.registerCommand("rr", [](AppContext &c, std::istringstream &) {
+        const uint8_t reg[1] = {0x05};
+        c.out() << "reg " << static_cast<int>(c.device.i2cReadRegister(0x68, reg, 1)[0]) << "\n";
+    });
+    router.registerCommand("fail", [](AppContext &, std::istringstream &) {
+        throw std::runtime_error("boom \"quoted\"");
+    });
+    // Команды разных клиентов не должны выполняться одновременно
+    std::atomic<bool> inside{false};
+    std::atomic<bool> overlapped{false};
+    int counter = 0;
+    router.registerCommand("count", [&](AppContext &c, std::istringstream &) {
+        if (inside.exchange(true)) overlapped = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        c.out() << ++counter << "\n";
+        inside = false;
+    });
+
+    const std::string path = "/tmp/twi-scanner-test-server-" + std::to_string(::getpid()) + ".sock";
+    SessionServer server(router, ctx);
+    int exitCode = -1;
+    std::thread serverThread([&] { exitCode = server.run(path); });
+
+    // JSON: вывод команды экранирован, ошибка — ok:false с текстом исключения
+    const int fd = connectTo(path);
+    sendText(fd, "rr\n");
+    assert(recvJson(fd) == "{\"ok\":true,\"output\":\"reg 5\\n\"}");
+    sendText(fd, "fail\r\n");
+    assert(recvJson(fd) == "{\"ok\":false,\"output\":\"error: boom \\\"quoted\\\"\\n\"}");
+    sendText(fd, ".ping\n.ping\n");
+    assert(recvJson(fd) == "{\"ok\":true,\"output\":\"\"}");
+    assert(recvJson(fd) == "{\"ok\":true,\"output\":\"\"}");
+
+    // Строка, пришедшая несколькими recv, выполняется один раз целиком
+    sendText(fd, "r");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sendText(fd, "r\n");
+    assert(recvJson(fd) == "{\"ok\":true,\"output\":\"reg 5\\n\"}");
+
+    // Двоичный режим: длина LE + статус; .mode не даёт ответа
+    sendText(fd, ".mode binary\nrr\nfail\n.ping\n");
+    BinaryReply b = recvBinary(fd);
+    assert(b.ok && b.output == "reg 5\n");
+    b = recvBinary(fd);
+    assert(!b.ok && b.output.find("boom") != std::string::npos);
+    b = recvBinary(fd);
+    assert(b.ok && b.output.empty());
+    sendText(fd, ".mode json\n.ping\nquit\n");
+    assert(recvJson(fd) == "{\"ok\":true,\"output\":\"\"}");
+    assert(closedByPeer(fd));
+    ::close(fd);
+
+    // Несколько клиентов одновременно: все команды выполнены, по одной за раз
+    constexpr int kClients = 4;
+    constexpr int kCommands = 20;
+    std::vector<std::thread> clients;
+    std::atomic<int> replies{0};
+    for (int i = 0; i < kClients; ++i) {
+        clients.emplace_back([&] {
+            const int c = connectTo(path);
+            for (int n = 0; n < kCommands; ++n) {
+                sendText(c, "count\n");
+                if (recvLine(c).find("\"ok\":true") != std::string::npos) ++replies;
+            }
+            ::close(c);
+        });
+    }
+    for (auto &t : clients) t.join();
+    assert(replies == kClients * kCommands && counter == kClients * kCommands && !overlapped);
+
+    // Строка без '\n' длиннее предела: ответ-ошибка и закрытие соединения
+    const int flood = connectTo(path);
+    sendText(flood, std::string(SessionServer::kMaxLineBytes + 1, 'x'));
+    assert(recvJson(flood).find("\"ok\":false") != std::string::npos);
+    assert(closedByPeer(flood));
+    ::close(flood);
+
+    // .shutdown останавливает сервер и убирает файл сокета
+    const int admin = connectTo(path);
+    sendText(admin, ".shutdown\n");
+    assert(closedByPeer(admin));
+    ::close(admin);
+    serverThread.join();
+    assert(exitCode == 0 && ::access(path.c_str(), F_OK) != 0);
+
+    std::cout << "test_server: OK\n";
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "ft4222/ft4222_stats.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace ft4222stats;
+
+namespace {
+
+const OpSnapshot *find(const std::vector<OpSnapshot> &ops, Op op) {
+    for (const auto &s : ops)
+        if (s.op == op) return &s;
+    return nullptr;
+}
+
+} // namespace
+
+int main() {
+    // Шкала корзин непрерывна и монотонна, погрешность в пределах 1/16
+    for (uint64_t v : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456ull, 1ull << 39}) {
+        const size_t b = LatencyHistogram::bucketFor(v);
+        assert(LatencyHistogram::bucketLower(b) <= v);
+        assert(v < LatencyHistogram::bucketLower(b + 1));
+        assert(v - LatencyHistogram::bucketLower(b) <= v / 16);
+    }
+    for (size_t b = 1; b < LatencyHistogram::kBuckets; ++b)
+        assert(LatencyHistogram::bucketLower(b) > LatencyHistogram::bucketLower(b - 1));
+    assert(LatencyHistogram::bucketFor(~0ull) == LatencyHistogram::kBuckets - 1);
+
+    // Квантили: 90 значений ~1 мкс и 10 значений ~1 мс
+    {
+        LatencyHistogram h;
+        for (int i = 0; i < 90; ++i) h.record(1000);
+        for (int i = 0; i < 10; ++i) h.record(1000000);
+        const auto c = h.counts();
+        const uint64_t p50 = LatencyHistogram::quantile(c, 0.5);
+        const uint64_t p99 = LatencyHistogram::quantile(c, 0.99);
+        assert(p50 >= 960 && p50 <= 1040);
+        assert(p99 >= 960000 && p99 <= 1040000);
+        h.reset();
+        assert(LatencyHistogram::quantile(h.counts(), 0.5) == 0);
+    }
+
+    // Замеры: байты только для успешных вызовов, ошибки — по коду статуса
+    reset();
+    { OpScope s(Op::I2CRead, 4); }
+    { OpScope s(Op::I2CRead, 4); s.setBytes(2); }
+    try {
+        OpScope s(Op::I2CRead, 4);
+        OpScope::noteStatus(1011);
+        throw std::runtime_error("fail");
+    } catch (const std::runtime_error &) {
+    }
+    try {
+        OpScope s(Op::SpiWrite, 8);
+        throw std::runtime_error("incomplete");
+    } catch (const std::runtime_error &) {
+    }
+
+    const auto ops = snapshot();
+    assert(ops.size() == 2);
+    const OpSnapshot *rd = find(ops, Op::I2CRead);
+    assert(rd && rd->calls == 3 && rd->errors == 1 && rd->bytes == 6);
+    assert(rd->errorsByStatus.size() == 1 && rd->errorsByStatus[0].first == 1011);
+    assert(rd->p99Ns <= rd->maxNs);
+    const OpSnapshot *wr = find(ops, Op::SpiWrite);
+    assert(wr && wr->errors == 1 && wr->bytes == 0);
+    assert(wr->errorsByStatus.size() == 1 && wr->errorsByStatus[0].first == -1);
+
+    // Вложенный замер не перехватывает код внешнего
+    try {
+        OpScope outer(Op::I2CScan);
+        { OpScope inner(Op::I2CStatus); }
+        OpScope::noteStatus(4);
+        throw std::runtime_error("scan failed");
+    } catch (const std::runtime_error &) {
+    }
+    const auto after = snapshot();
+    const OpSnapshot *scan = find(after, Op::I2CScan);
+    assert(scan && scan->errorsByStatus[0].first == 4);
+
+    reset();
+    assert(snapshot().empty());
+
+    std::cout << "All stats tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "engine/SpiStream.hpp"
+#include "ft4222/ft4222_mock.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Приёмник с задержкой на каждую запись; после failAfter байт запись не проходит
+class SlowSink : public std::streambuf {
+public:
+    explicit SlowSink(std::chrono::microseconds delay,
+                      size_t failAfter = std::numeric_limits<size_t>::max())
+        : m_delay(delay), m_failAfter(failAfter) {}
+
+    size_t written() const { return m_written; }
+
+protected:
+    std::streamsize xsputn(const char *, std::streamsize n) override {
+        std::this_thread::sleep_for(m_delay);
+        if (m_written + static_cast<size_t>(n) > m_failAfter) return 0;
+        m_written += static_cast<size_t>(n);
+        return n;
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        const char ch = traits_type::to_char_type(c);
+        return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+    }
+
+private:
+    std::chrono::microseconds m_delay;
+    size_t m_failAfter;
+    size_t m_written = 0;
+};
+
+FTDevice openSpi(const ft4222mock::Config &cfg) {
+    ft4222mock::setConfig(cfg);
+    FTDevice dev(0);
+    dev.initSPIMaster(SPI_IO_SINGLE, FTDevice::SPIClockDivider::DIV_2);
+    return dev;
+}
+
+SpiStreamOptions bytes(uint64_t total, size_t chunk = 4096, size_t buffers = 8) {
+    SpiStreamOptions options;
+    options.totalBytes = total;
+    options.chunkSize = chunk;
+    options.bufferCount = buffers;
+    return options;
+}
+
+} // namespace
+
+int main() {
+    ft4222mock::Config cfg;
+
+    // Быстрый приёмник: всё прочитанное записано, последний чанк урезан по totalBytes
+    {
+        FTDevice dev = openSpi(cfg);
+        std::ostringstream out;
+        const SpiStreamStats st = SpiStreamCapture::run(dev, out, bytes(10000));
+        assert(st.chunks == 3 && st.shortChunks == 0 && st.droppedChunks == 0);
+        assert(st.bytesCaptured == 10000 && st.bytesWritten == 10000 && out.str().size() == 10000);
+        assert(out.str() == std::string(10000, '\0'));
+    }
+
+    // Короткие чанки: устройство отдаёт меньше запрошенного, захват продолжается до totalBytes
+    // (последний запрос — ровно остаток, он не короткий); буферов больше, чем чанков,
+    // поэтому отброшенных нет при любой скорости потока записи
+    cfg.spiChunkLimit = 1000;
+    {
+        FTDevice dev = openSpi(cfg);
+        std::ostringstream out;
+        const SpiStreamStats st = SpiStreamCapture::run(dev, out, bytes(10000, 4096, 16));
+        assert(st.chunks == 10 && st.shortChunks == 9 && st.droppedChunks == 0);
+        assert(st.bytesWritten == 10000 && out.str().size() == 10000);
+
+        std::vector<uint8_t> mapped(2500, 0xAA);
+        const SpiStreamStats direct = SpiStreamCapture::run(dev, ByteSpan(mapped), bytes(0));
+        assert(direct.chunks == 3 && direct.shortChunks == 2 && direct.bytesWritten == 2500);
+        assert(std::count(mapped.begin(), mapped.end(), 0) == 2500);
+    }
+    cfg.spiChunkLimit = 0;
+
+    // Медленный приёмник: кольцо заполняется, чтение не останавливается, лишние чанки
+    // отбрасываются; записанное плюс отброшенное равно прочитанному
+    cfg.usbLatencyUs = 100;
+    {
+        FTDevice dev = openSpi(cfg);
+        SlowSink slow(std::chrono::milliseconds(5));
+        std::ostream out(&slow);
+        const SpiStreamStats st = SpiStreamCapture::run(dev, out, bytes(64 * 1024, 1024, 2));
+        assert(st.bytesCaptured == 64 * 1024 && st.chunks == 64 && st.droppedChunks > 0);
+        assert(st.bytesWritten == (st.chunks - st.droppedChunks) * 1024);
+        assert(slow.written() == st.bytesWritten);
+    }
+
+    // Сбой приёмника: захват прерывается исключением, а не читает до конца
+    {
+        FTDevice dev = openSpi(cfg);
+        SlowSink failing(std::chrono::microseconds(0), 3 * 1024);
+        std::ostream out(&failing);
+        SpiStreamOptions options = bytes(0, 1024, 4);
+        options.durationMs = 10000;
+        const auto start = std::chrono::steady_clock::now();
+        bool threw = false;
+        try {
+            SpiStreamCapture::run(dev, out, options);
+        } catch (const std::runtime_error &ex) {
+            threw = std::string(ex.what()) == "write to output failed";
+        }
+        assert(threw && failing.written() == 3 * 1024);
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    }
+
+    // Параметры проверяются до первого чтения
+    {
+        FTDevice dev = openSpi(cfg);
+        std::ostringstream out;
+        bool threw = false;
+        try {
+            SpiStreamCapture::run(dev, out, bytes(1024, 1024, 1));
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try {
+            SpiStreamCapture::run(dev, out, bytes(0));
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+        assert(threw && out.str().empty());
+    }
+
+    std::cout << "test_stream: OK\n";
+    return 0;
+}
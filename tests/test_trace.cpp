@@ -0,0 +1,218 @@
+#include "engine/TraceReplay.hpp"
+#include "ft4222/ft4222.hpp"
+#include "ft4222/ft4222_mock.hpp"
+#include "ft4222/ft4222_trace.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using ft4222stats::Op;
+
+std::vector<ft4222trace::Record> readAll(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    ft4222trace::Reader reader(in);
+    std::vector<ft4222trace::Record> records;
+    ft4222trace::Record r;
+    while (reader.next(r)) records.push_back(r);
+    return records;
+}
+
+TraceReplayStats replay(const std::string &path, const TraceReplayOptions &options) {
+    FTDevice dev(0);
+    std::ifstream in(path, std::ios::binary);
+    return TraceReplayer::run(dev, in, options);
+}
+
+} // namespace
+
+int main() {
+    ft4222mock::Config cfg;
+    cfg.i2cTargets[0x50] = ft4222mock::patternRegisters(256);
+    ft4222mock::setConfig(cfg);
+
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "twi-scanner-test-trace.bin").string();
+
+    // Запись: каждая операция под мьютексом — одна запись, пакет — по записи на фазу
+    {
+        FTDevice dev(0);
+        auto rec = std::make_shared<ft4222trace::Recorder>(path);
+        dev.setTraceRecorder(rec);
+        assert(dev.traceRecorder() == rec);
+
+        dev.initI2CMaster(FTDevice::I2CSpeed::S400K);
+        assert(dev.scanI2CBus(0x40, 0x5F).size() == 1);
+        dev.i2cMasterWrite(0x50, std::vector<uint8_t>{0x10, 0xAA, 0xBB});
+        const uint8_t reg10[1] = {0x10};
+        assert(dev.i2cReadRegister(0x50, reg10, 3)[2] == 0x12);
+        bool threw = false;
+        try {
+            dev.i2cMasterWrite(0x51, std::vector<uint8_t>{0x00});
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+        dev.i2cMasterGetStatus();
+
+        I2CBatch batch;
+        const uint8_t reg0[1] = {0x00};
+        batch.readRegister(0x50, reg0, 2);
+        batch.read(0x22, 1);
+        assert(dev.runI2CBatch(batch).failed == 1);
+
+        // Пауза для проверки воспроизведения по исходному времени
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        dev.initGPIO(GPIO_OUTPUT, GPIO_OUTPUT, GPIO_INPUT, GPIO_INPUT);
+        dev.writeGPIOPorts(0x3, 0x2);
+        assert(dev.readGPIOPorts() == 0x2);
+
+        dev.setTraceRecorder(nullptr);
+        rec->stop();
+        assert(rec->recorded() == 12 && rec->dropped() == 0);
+        assert(rec->bytesWritten() == std::filesystem::file_size(path) - ft4222trace::kFileHeaderSize);
+    }
+
+    const auto records = readAll(path);
+    assert(records.size() == 12);
+    assert(records[0].op == Op::I2CInit && records[0].param == 400);
+    assert(records[1].op == Op::I2CScan && records[1].read == std::vector<uint8_t>{0x50});
+    assert(records[3].op == Op::I2CReadRegister && records[3].write == std::vector<uint8_t>{0x10});
+    assert((records[3].read == std::vector<uint8_t>{0xAA, 0xBB, 0x12}));
+    assert(records[4].op == Op::I2CWrite && (records[4].flags & ft4222trace::FlagError));
+    // Фазы пакета: запись номера регистра, чтение, чтение с NACK
+    assert(records[6].op == Op::I2CWrite && records[6].flags == ft4222trace::FlagBatch);
+    assert(records[7].op == Op::I2CRead && records[7].value == 2 && records[7].read.size() == 2);
+    assert(records[8].op == Op::I2CRead && records[8].address == 0x22 &&
+           records[8].flags == (ft4222trace::FlagBatch | ft4222trace::FlagError));
+    assert(records[10].op == Op::GpioWrite && records[10].address == ft4222trace::kAllGpioPorts);
+    assert(records[11].op == Op::GpioRead && records[11].value == 0x2);
+    for (size_t i = 1; i < records.size(); ++i) assert(records[i].timeNs >= records[i - 1].timeNs);
+
+    // Воспроизведение на свежем устройстве совпадает с записью, в том числе ошибки
+    {
+        TraceReplayOptions opt;
+        opt.maxSpeed = true;
+        const auto st = replay(path, opt);
+        assert(st.records == 12 && st.replayed == 12 && st.skipped == 0);
+        assert(st.mismatches == 0 && st.errors == 1);
+        assert(st.elapsedUs < 30000);
+    }
+
+    // По исходному времени — не быстрее записи
+    {
+        const auto st = replay(path, TraceReplayOptions{});
+        assert(st.mismatches == 0 && st.elapsedUs >= 30000);
+    }
+
+    // Другое содержимое регистров — расхождение данных
+    {
+        cfg.i2cTargets[0x50] = std::vector<uint8_t>(256, 0x00);
+        ft4222mock::setConfig(cfg);
+        TraceReplayOptions opt;
+        opt.maxSpeed = true;
+        const auto st = replay(path, opt);
+        assert(st.mismatches == 2 && st.reported.size() == 2);
+        assert(st.reported[0].index == 3 && st.reported[0].op == Op::I2CReadRegister);
+        assert(st.reported[0].what.find("byte 2") != std::string::npos);
+    }
+
+    // spi_init и set_clock пишутся физическими величинами, не значениями перечислений бэкенда
+    {
+        for (const FT4222_SPIClock div : ft4222clock::kSpiDividers) {
+            ft4222trace::SpiInitConfig spi;
+            assert(ft4222trace::parseSpiInitParam(
+                ft4222trace::spiInitParam(SPI_IO_DUAL, div, CLK_IDLE_HIGH, CLK_LEADING), spi));
+            assert(spi.divider == div && spi.mode == SPI_IO_DUAL && spi.cpol == CLK_IDLE_HIGH &&
+                   spi.cpha == CLK_LEADING);
+        }
+        ft4222trace::SpiInitConfig spi;
+        assert(!ft4222trace::parseSpiInitParam(3u | 4u << 16, spi));
+        assert(!ft4222trace::parseSpiInitParam(1u | 3u << 16, spi));
+        FT4222_ClockRate rate = SYS_CLK_60;
+        assert(!ft4222trace::parseClockParam(50'000'000, rate));
+
+        FTDevice dev(0);
+        auto rec = std::make_shared<ft4222trace::Recorder>(path);
+        dev.setTraceRecorder(rec);
+        assert(dev.initSPIMasterHz(20'000'000) == 20'000'000);
+        dev.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_4, CLK_IDLE_LOW, CLK_TRAILING);
+        dev.setTraceRecorder(nullptr);
+        rec->stop();
+
+        const auto spiRecords = readAll(path);
+        assert(spiRecords.size() == 3);
+        assert(spiRecords[0].op == Op::SetClock && spiRecords[0].param == 80'000'000);
+        assert(spiRecords[1].op == Op::SpiInit && spiRecords[1].param == (1u | 4u << 16));
+        assert(spiRecords[2].op == Op::SpiInit && spiRecords[2].param == (4u | 1u << 9 | 4u << 16));
+
+        // Воспроизведение восстанавливает системную частоту и настройку SPI
+        TraceReplayOptions opt;
+        opt.maxSpeed = true;
+        FTDevice target(0);
+        target.setClockRate(SYS_CLK_24);
+        std::ifstream in(path, std::ios::binary);
+        const auto st = TraceReplayer::run(target, in, opt);
+        assert(st.replayed == 3 && st.errors == 0 && st.mismatches == 0);
+        assert(target.getClockRate() == SYS_CLK_80 &&
+               target.getDeviceMode() == FTDevice::Mode::SPI_Master);
+        assert(!target.initSPIMaster(SPI_IO_QUAD, FTDevice::SPIClockDivider::DIV_4, CLK_IDLE_LOW,
+                                     CLK_TRAILING));
+    }
+
+    // Кольцо переполнено — запись отбрасывается, а не блокирует устройство
+    {
+        FTDevice dev(0);
+        auto rec = std::make_shared<ft4222trace::Recorder>(path, 4096);
+        dev.setTraceRecorder(rec);
+        dev.initSPIMaster();
+        dev.spiMasterSingleWrite(std::vector<uint8_t>(8192, 0x5A));
+        dev.spiMasterSingleWrite(std::vector<uint8_t>(16, 0x5A));
+        dev.setTraceRecorder(nullptr);
+        rec->stop();
+        assert(rec->recorded() == 2 && rec->dropped() == 1);
+        assert(readAll(path).size() == 2);
+    }
+
+    // Ошибка записи файла (диск полон): stop() сообщает о ней, а не о полной трассе
+    if (std::filesystem::exists("/dev/full")) {
+        FTDevice dev(0);
+        auto rec = std::make_shared<ft4222trace::Recorder>("/dev/full");
+        dev.setTraceRecorder(rec);
+        dev.initSPIMaster();
+        dev.spiMasterSingleWrite(std::vector<uint8_t>(64, 0x5A));
+        dev.setTraceRecorder(nullptr);
+        bool threw = false;
+        try {
+            rec->stop();
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw && rec->writeFailed() && rec->bytesWritten() == 0);
+        rec->stop();
+    }
+
+    // Не файл трассы
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a trace";
+        bool threw = false;
+        try {
+            readAll(path);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    std::filesystem::remove(path);
+    std::cout << "All trace tests passed.\n";
+    return 0;
+}